@@ -0,0 +1,126 @@
+// Channel throughput of the runtime, measured directly from C because the language does not
+// expose channels yet. Build against the runtime sources:
+//
+//   cc -O2 -Iruntime bench/channel.c runtime/bp_channel.c runtime/bp_green.c -lpthread -o channel_bench
+#define _POSIX_C_SOURCE 200809L
+
+#include "bp_runtime.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum {
+    PING_PONG_ROUNDS = 1000000,
+    FAN_IN_PRODUCERS = 8,
+    FAN_IN_MESSAGES = 1000000,
+    CAPACITY = 1024,
+};
+
+typedef struct {
+    bp_channel* ping;
+    bp_channel* pong;
+} ping_pong;
+
+typedef struct {
+    bp_channel* channel;
+    int64_t first;
+    int64_t count;
+} fan_in_producer;
+
+typedef struct {
+    bp_channel* channel;
+    int64_t expected;
+    int64_t sum;
+} fan_in_consumer;
+
+static double now_seconds(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+static void ping_player(void* argument) {
+    ping_pong* game = (ping_pong*)argument;
+    for (int64_t round = 0; round < PING_PONG_ROUNDS; round++) {
+        int64_t ball = round;
+        __bp_channel_send(game->ping, &ball);
+        __bp_channel_receive(game->pong, &ball);
+    }
+}
+
+static void pong_player(void* argument) {
+    ping_pong* game = (ping_pong*)argument;
+    for (int64_t round = 0; round < PING_PONG_ROUNDS; round++) {
+        int64_t ball;
+        __bp_channel_receive(game->ping, &ball);
+        __bp_channel_send(game->pong, &ball);
+    }
+}
+
+// One message in flight at a time: measures the latency of a hand-off, including parking.
+static void run_ping_pong(const char* name, uint32_t flags) {
+    ping_pong game = {
+        __bp_channel_create(1, sizeof(int64_t), flags),
+        __bp_channel_create(1, sizeof(int64_t), flags),
+    };
+    const double start = now_seconds();
+    __bp_green_start(0);
+    __bp_green_spawn(ping_player, &game);
+    __bp_green_spawn(pong_player, &game);
+    __bp_green_shutdown();
+    const double elapsed = now_seconds() - start;
+    printf("ping-pong %-6s %8.1f ns/round trip\n", name, elapsed * 1e9 / PING_PONG_ROUNDS);
+    __bp_channel_destroy(game.ping);
+    __bp_channel_destroy(game.pong);
+}
+
+static void produce(void* argument) {
+    fan_in_producer* producer = (fan_in_producer*)argument;
+    for (int64_t value = producer->first; value < producer->first + producer->count; value++) {
+        __bp_channel_send(producer->channel, &value);
+    }
+}
+
+static void consume(void* argument) {
+    fan_in_consumer* consumer = (fan_in_consumer*)argument;
+    for (int64_t received = 0; received < consumer->expected; received++) {
+        int64_t value;
+        __bp_channel_receive(consumer->channel, &value);
+        consumer->sum += value;
+    }
+}
+
+// Many producers into one consumer: measures contention on the tail.
+static void run_fan_in(void) {
+    bp_channel* channel = __bp_channel_create(CAPACITY, sizeof(int64_t), BP_CHANNEL_SINGLE_CONSUMER);
+    fan_in_producer producers[FAN_IN_PRODUCERS];
+    const int64_t share = FAN_IN_MESSAGES / FAN_IN_PRODUCERS;
+    fan_in_consumer consumer = {channel, share * FAN_IN_PRODUCERS, 0};
+
+    const double start = now_seconds();
+    __bp_green_start(0);
+    __bp_green_spawn(consume, &consumer);
+    for (int i = 0; i < FAN_IN_PRODUCERS; i++) {
+        producers[i] = (fan_in_producer){channel, share * i, share};
+        __bp_green_spawn(produce, &producers[i]);
+    }
+    __bp_green_shutdown();
+    const double elapsed = now_seconds() - start;
+
+    const int64_t total = share * FAN_IN_PRODUCERS;
+    if (consumer.sum != total * (total - 1) / 2) {
+        fprintf(stderr, "fan-in lost messages\n");
+        exit(1);
+    }
+    printf("fan-in %d:1    %8.1f ns/message\n", FAN_IN_PRODUCERS, elapsed * 1e9 / (double)total);
+    __bp_channel_destroy(channel);
+}
+
+int main(void) {
+    run_ping_pong("mpmc", 0);
+    run_ping_pong("spsc", BP_CHANNEL_SINGLE_PRODUCER | BP_CHANNEL_SINGLE_CONSUMER);
+    run_fan_in();
+    return 0;
+}
@@ -0,0 +1,198 @@
+// Lookup cost of the std.collections HashMap layouts, measured from C with i64 keys because
+// the language cannot instantiate the generic classes yet. "parallel" is the previous layout:
+// keys, values and a bool occupied array probed one slot at a time at a 0.75 load limit.
+// "grouped" is the current one: packed control bytes probed with the runtime's group match,
+// entries next to each other, at a 7/8 load limit. Build against the runtime sources:
+//
+//   cc -O2 -Iruntime bench/hashmap.c runtime/bp_hash.c -o hashmap_bench
+#define _POSIX_C_SOURCE 200809L
+
+#include "bp_runtime.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+enum {
+    MAX_KEY_COUNT = 1 << 20,
+    LOOKUPS_PER_SIZE = 1 << 23,
+};
+
+typedef struct {
+    int64_t* keys;
+    int64_t* values;
+    bool* occupied;
+    uint64_t mask;
+} parallel_table;
+
+typedef struct {
+    int64_t key;
+    int64_t value;
+} grouped_entry;
+
+typedef struct {
+    uint8_t* control;
+    grouped_entry* slots;
+    uint64_t groups;
+} grouped_table;
+
+static double now_seconds(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+// Keys are compared out of line, as a BluePrint map compares them through equals().
+__attribute__((noinline)) static bool keys_equal(int64_t left, int64_t right) {
+    return left == right;
+}
+
+static uint64_t table_capacity(uint64_t count, uint64_t numerator, uint64_t denominator) {
+    uint64_t capacity = BP_GROUP_WIDTH;
+    while (capacity * numerator < count * denominator) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+static void parallel_init(parallel_table* table, uint64_t count) {
+    const uint64_t capacity = table_capacity(count, 3, 4);
+    table->keys = calloc(capacity, sizeof(int64_t));
+    table->values = calloc(capacity, sizeof(int64_t));
+    table->occupied = calloc(capacity, sizeof(bool));
+    table->mask = capacity - 1;
+}
+
+static void parallel_put(parallel_table* table, int64_t key, int64_t value) {
+    uint64_t index = __bp_hash_mix((uint64_t)key) & table->mask;
+    while (table->occupied[index]) {
+        index = (index + 1) & table->mask;
+    }
+    table->keys[index] = key;
+    table->values[index] = value;
+    table->occupied[index] = true;
+}
+
+static bool parallel_get(const parallel_table* table, int64_t key, int64_t* value) {
+    uint64_t index = __bp_hash_mix((uint64_t)key) & table->mask;
+    while (table->occupied[index]) {
+        if (keys_equal(table->keys[index], key)) {
+            *value = table->values[index];
+            return true;
+        }
+        index = (index + 1) & table->mask;
+    }
+    return false;
+}
+
+static void grouped_init(grouped_table* table, uint64_t count) {
+    const uint64_t capacity = table_capacity(count, 7, 8);
+    table->control = aligned_alloc(BP_GROUP_WIDTH, capacity);
+    for (uint64_t i = 0; i < capacity; i++) {
+        table->control[i] = BP_CONTROL_EMPTY;
+    }
+    table->slots = calloc(capacity, sizeof(grouped_entry));
+    table->groups = capacity / BP_GROUP_WIDTH;
+}
+
+static void grouped_put(grouped_table* table, int64_t key, int64_t value) {
+    const uint64_t hash = __bp_hash_mix((uint64_t)key);
+    uint64_t group = (hash >> 7) & (table->groups - 1);
+    uint32_t free = __bp_group_match_free(table->control + group * BP_GROUP_WIDTH);
+    for (uint64_t probe = 1; free == 0; probe++) {
+        group = (group + probe) & (table->groups - 1);
+        free = __bp_group_match_free(table->control + group * BP_GROUP_WIDTH);
+    }
+    const uint64_t index = group * BP_GROUP_WIDTH + (uint64_t)__bp_group_first(free);
+    table->control[index] = (uint8_t)(hash & 0x7F);
+    table->slots[index] = (grouped_entry){key, value};
+}
+
+static bool grouped_get(const grouped_table* table, int64_t key, int64_t* value) {
+    const uint64_t hash = __bp_hash_mix((uint64_t)key);
+    const uint8_t tag = (uint8_t)(hash & 0x7F);
+    uint64_t group = (hash >> 7) & (table->groups - 1);
+    for (uint64_t probe = 1; probe <= table->groups; probe++) {
+        const uint8_t* control = table->control + group * BP_GROUP_WIDTH;
+        const uint32_t matches = __bp_group_match(control, tag);
+        for (int32_t bit = __bp_group_first(matches); bit < BP_GROUP_WIDTH; bit = __bp_group_next(matches, bit)) {
+            const grouped_entry* entry = &table->slots[group * BP_GROUP_WIDTH + (uint64_t)bit];
+            if (keys_equal(entry->key, key)) {
+                *value = entry->value;
+                return true;
+            }
+        }
+        if (__bp_group_match_empty(control)) {
+            return false;
+        }
+        group = (group + probe) & (table->groups - 1);
+    }
+    return false;
+}
+
+// Keys are odd multiples of a large odd constant; probing with key + 1 always misses.
+static int64_t key_at(uint64_t index) {
+    return (int64_t)((2 * index + 1) * UINT64_C(0x9E3779B97F4A7C15));
+}
+
+static void run_size(uint64_t key_count) {
+    parallel_table parallel;
+    grouped_table grouped;
+    parallel_init(&parallel, key_count);
+    grouped_init(&grouped, key_count);
+    for (uint64_t i = 0; i < key_count; i++) {
+        parallel_put(&parallel, key_at(i), (int64_t)i);
+        grouped_put(&grouped, key_at(i), (int64_t)i);
+    }
+
+    // Lookups in a shuffled order so the hardware prefetcher cannot follow the probes
+    uint64_t* order = malloc(key_count * sizeof(uint64_t));
+    for (uint64_t i = 0; i < key_count; i++) {
+        order[i] = i;
+    }
+    srand(1);
+    for (uint64_t i = key_count - 1; i > 0; i--) {
+        const uint64_t j = (uint64_t)rand() % (i + 1);
+        const uint64_t swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    const uint64_t rounds = LOOKUPS_PER_SIZE / key_count;
+    for (int miss = 0; miss < 2; miss++) {
+        for (int layout = 0; layout < 2; layout++) {
+            int64_t checksum = 0;
+            uint64_t found = 0;
+            const double start = now_seconds();
+            for (uint64_t round = 0; round < rounds; round++) {
+                for (uint64_t i = 0; i < key_count; i++) {
+                    const int64_t key = key_at(order[i]) + miss;
+                    int64_t value = 0;
+                    const bool hit = layout ? grouped_get(&grouped, key, &value) : parallel_get(&parallel, key, &value);
+                    found += hit;
+                    checksum += value;
+                }
+            }
+            const double elapsed = now_seconds() - start;
+            printf("%8llu keys  %-8s %-4s %6.1f ns/lookup  (found %llu, checksum %lld)\n", (unsigned long long)key_count,
+                layout ? "grouped" : "parallel", miss ? "miss" : "hit",
+                elapsed * 1e9 / (double)(rounds * key_count), (unsigned long long)found, (long long)checksum);
+        }
+    }
+
+    free(order);
+    free(parallel.keys);
+    free(parallel.values);
+    free(parallel.occupied);
+    free(grouped.control);
+    free(grouped.slots);
+}
+
+int main(void) {
+    for (uint64_t key_count = 1 << 12; key_count <= MAX_KEY_COUNT; key_count <<= 4) {
+        run_size(key_count);
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+// C reference for array_sort.bp
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(void) {
+    const int64_t count = 40000;
+    int64_t* values = malloc((size_t)count * sizeof(int64_t));
+    int64_t state = 42;
+    for (int64_t i = 0; i < count; i++) {
+        state = (state * 1103515245 + 12345) % 2147483648;
+        values[i] = state % 1000000;
+    }
+
+    int64_t sum = 0;
+    for (int64_t i = 0; i < count; i++) {
+        sum = sum + values[i];
+    }
+
+    for (int64_t i = 1; i < count; i++) {
+        const int64_t value = values[i];
+        int64_t j = i - 1;
+        while (j >= 0 && values[j] > value) {
+            values[j + 1] = values[j];
+            j = j - 1;
+        }
+        values[j + 1] = value;
+    }
+
+    bool sorted = true;
+    for (int64_t k = 0; k < count - 1; k++) {
+        sorted = sorted && values[k] <= values[k + 1];
+    }
+    printf("%" PRId64 "\n", sum);
+    printf("%" PRId64 "\n", values[0]);
+    printf("%" PRId64 "\n", values[count / 2]);
+    printf("%" PRId64 "\n", values[count - 1]);
+    printf("%s\n", sorted ? "true" : "false");
+    free(values);
+    return 0;
+}
@@ -0,0 +1,20 @@
+// C reference for float_loop.bp
+#include <inttypes.h>
+#include <stdio.h>
+
+int main(void) {
+    double pi = 0.0;
+    double sign = 4.0;
+    double denominator = 1.0;
+    float average = 0.0f;
+    const int64_t iterations = 50000000;
+    for (int64_t i = 0; i < iterations; i++) {
+        pi = pi + sign / denominator;
+        average = (float)(average + (pi - average) / 16.0);
+        sign = 0.0 - sign;
+        denominator = denominator + 2.0;
+    }
+    printf("%f\n", pi);
+    printf("%f\n", average);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// Fractions as a C programmer would write them for the fraction benchmarks: 32-bit
+// components, like fr64, reduced by Euclid's algorithm after every operation.
+#include <inttypes.h>
+#include <stdio.h>
+
+typedef struct {
+    int32_t numerator;
+    int32_t denominator;
+} fraction;
+
+static inline int64_t gcd(int64_t a, int64_t b) {
+    a = a < 0 ? -a : a;
+    b = b < 0 ? -b : b;
+    while (b != 0) {
+        const int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+static inline fraction reduce(int64_t numerator, int64_t denominator) {
+    if (denominator < 0) {
+        numerator = -numerator;
+        denominator = -denominator;
+    }
+    const int64_t divisor = gcd(numerator, denominator);
+    if (divisor > 1) {
+        numerator /= divisor;
+        denominator /= divisor;
+    }
+    return (fraction){(int32_t)numerator, (int32_t)denominator};
+}
+
+static inline fraction fraction_add(fraction a, fraction b) {
+    return reduce((int64_t)a.numerator * b.denominator + (int64_t)b.numerator * a.denominator, (int64_t)a.denominator * b.denominator);
+}
+
+static inline fraction fraction_sub(fraction a, fraction b) {
+    return reduce((int64_t)a.numerator * b.denominator - (int64_t)b.numerator * a.denominator, (int64_t)a.denominator * b.denominator);
+}
+
+static inline fraction fraction_mul(fraction a, fraction b) {
+    return reduce((int64_t)a.numerator * b.numerator, (int64_t)a.denominator * b.denominator);
+}
+
+static inline fraction fraction_div(fraction a, fraction b) {
+    return reduce((int64_t)a.numerator * b.denominator, (int64_t)a.denominator * b.numerator);
+}
+
+static inline void fraction_print(fraction value) {
+    printf("%" PRId32 "/%" PRId32 "\n", value.numerator, value.denominator);
+}
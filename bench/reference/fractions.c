@@ -0,0 +1,17 @@
+// C reference for fractions.bp
+#include "fraction.h"
+
+int main(void) {
+    fraction price = {7, 4};
+    const fraction rate = {3, 2};
+    const fraction fee = {1, 6};
+    fraction total = {0, 1};
+    const int64_t iterations = 20000000;
+    for (int64_t i = 0; i < iterations; i++) {
+        price = fraction_sub(fraction_add(fraction_div(fraction_mul(price, rate), rate), fee), fee);
+        total = fraction_sub(price, total);
+    }
+    fraction_print(price);
+    fraction_print(total);
+    return 0;
+}
@@ -0,0 +1,16 @@
+// C reference for int_loop.bp
+#include <inttypes.h>
+#include <stdio.h>
+
+int main(void) {
+    int64_t state = 12345;
+    int64_t sum = 0;
+    const int64_t iterations = 100000000;
+    for (int64_t i = 0; i < iterations; i++) {
+        state = (state * 1103515245 + 12345) % 2147483648;
+        sum = sum + state % 1000;
+    }
+    printf("%" PRId64 "\n", state);
+    printf("%" PRId64 "\n", sum);
+    return 0;
+}
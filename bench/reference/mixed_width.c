@@ -0,0 +1,22 @@
+// C reference for mixed_width.bp
+#include <inttypes.h>
+#include <stdio.h>
+
+int main(void) {
+    uint8_t small = 0;
+    int16_t medium = 0;
+    uint32_t large = 1;
+    int64_t total = 0;
+    const int32_t iterations = 100000000;
+    for (int32_t i = 0; i < iterations; i++) {
+        small = (uint8_t)(small + 7);
+        medium = (int16_t)(medium - 3);
+        large = large * 3 + small;
+        total = total + small + medium + large % 1000;
+    }
+    printf("%" PRIu8 "\n", small);
+    printf("%" PRId16 "\n", medium);
+    printf("%" PRIu32 "\n", large);
+    printf("%" PRId64 "\n", total);
+    return 0;
+}
@@ -0,0 +1,23 @@
+// C reference for printing.bp
+#include "fraction.h"
+
+int main(void) {
+    const int64_t lines = 1000000;
+    for (int64_t i = 0; i < lines; i++) {
+        printf("%" PRId64 "\n", i * 7919);
+    }
+
+    double value = 0.5;
+    for (int64_t i = 0; i < lines / 4; i++) {
+        printf("%f\n", value);
+        value = value + 1.25;
+    }
+
+    const fraction step = {1, 3};
+    fraction current = {0, 1};
+    for (int64_t i = 0; i < lines / 4; i++) {
+        current = fraction_add(current, step);
+        fraction_print(current);
+    }
+    return 0;
+}
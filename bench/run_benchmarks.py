@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Compiles every bench/*.bp program that has a C reference in bench/reference/ with the
+BluePrint compiler and with a C compiler at each -O level, runs both, and writes compile time,
+binary size and run time per program and level as JSON.
+
+Both executables of a program must print the same output; a mismatch is reported in the
+results and fails the run, since the timings would then not compare like with like.
+
+    python3 bench/run_benchmarks.py --compiler build/BluePrint --cc cc --output results.json
+"""
+
+import argparse
+import datetime
+import hashlib
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+
+BENCH_DIRECTORY = os.path.dirname(os.path.abspath(__file__))
+REFERENCE_DIRECTORY = os.path.join(BENCH_DIRECTORY, "reference")
+
+# Programs that compare code generation strategies are built once per variant, each with its
+# own compiler options; every other program is built once without extra options.
+VARIANTS = {
+    "fractions": {
+        "lazy": ["--fraction-normalization=lazy"],
+        "eager": ["--fraction-normalization=eager"],
+    },
+}
+
+
+def find_programs(selected):
+    programs = []
+    for entry in sorted(os.listdir(BENCH_DIRECTORY)):
+        name, extension = os.path.splitext(entry)
+        if extension != ".bp" or (selected and name not in selected):
+            continue
+        reference = os.path.join(REFERENCE_DIRECTORY, name + ".c")
+        if not os.path.exists(reference):
+            print(f"warning: {entry} has no C reference and is skipped", file=sys.stderr)
+            continue
+        programs.append((name, os.path.join(BENCH_DIRECTORY, entry), reference))
+    return programs
+
+
+def timed_command(command):
+    start = time.perf_counter()
+    completed = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    elapsed = time.perf_counter() - start
+    if completed.returncode != 0:
+        raise RuntimeError(f"{' '.join(command)} failed with exit code {completed.returncode}:\n"
+                           + completed.stderr.decode(errors="replace"))
+    return elapsed, completed.stdout
+
+
+def measure(compile_command, executable, repetitions):
+    compile_seconds, _ = timed_command(compile_command)
+    run_seconds = None
+    output_digest = None
+    # The fastest run is the least disturbed by the rest of the machine.
+    for _ in range(repetitions):
+        elapsed, output = timed_command([executable])
+        run_seconds = elapsed if run_seconds is None else min(run_seconds, elapsed)
+        output_digest = hashlib.sha256(output).hexdigest()
+    return {
+        "compile_seconds": round(compile_seconds, 6),
+        "binary_bytes": os.path.getsize(executable),
+        "run_seconds": round(run_seconds, 6),
+        "output_sha256": output_digest,
+    }
+
+
+def describe_revision():
+    try:
+        completed = subprocess.run(["git", "-C", BENCH_DIRECTORY, "describe", "--always", "--dirty", "--tags"],
+                                   stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, check=True)
+        return completed.stdout.decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return "unknown"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--compiler", required=True, help="BluePrint compiler executable")
+    parser.add_argument("--cc", default="cc", help="C compiler for the reference programs (default: cc)")
+    parser.add_argument("--output", required=True, help="path of the JSON results file")
+    parser.add_argument("--levels", default="O0,O1,O2,O3", help="comma-separated -O levels (default: O0,O1,O2,O3)")
+    parser.add_argument("--repetitions", type=int, default=3, help="runs per executable; the fastest counts (default: 3)")
+    parser.add_argument("--label", default=None, help="release or revision recorded in the results (default: git describe)")
+    parser.add_argument("programs", nargs="*", help="benchmark names to run (default: all)")
+    arguments = parser.parse_args()
+
+    levels = [level.strip() for level in arguments.levels.split(",") if level.strip()]
+    programs = find_programs(set(arguments.programs))
+    if not programs:
+        print("error: no benchmark programs found", file=sys.stderr)
+        return 1
+
+    results = []
+    mismatches = 0
+    with tempfile.TemporaryDirectory(prefix="blueprint-bench-") as work:
+        for name, source, reference in programs:
+            for level in levels:
+                stem = os.path.join(work, f"{name}-{level}")
+                c = measure([arguments.cc, "-" + level, "-o", stem + "-c", reference, "-lm"], stem + "-c", arguments.repetitions)
+                for variant, options in VARIANTS.get(name, {None: []}).items():
+                    bp_stem = stem + (f"-{variant}" if variant else "")
+                    blueprint = measure([arguments.compiler, "-" + level, *options, "--emit-obj", bp_stem + ".o",
+                                         "--emit-exe", bp_stem + "-bp", source],
+                                        bp_stem + "-bp", arguments.repetitions)
+                    outputs_match = blueprint["output_sha256"] == c["output_sha256"]
+                    mismatches += not outputs_match
+                    result = {
+                        "program": name,
+                        "level": level,
+                        "blueprint": blueprint,
+                        "c": c,
+                        "run_ratio": round(blueprint["run_seconds"] / c["run_seconds"], 3) if c["run_seconds"] > 0 else None,
+                        "size_ratio": round(blueprint["binary_bytes"] / c["binary_bytes"], 3),
+                        "outputs_match": outputs_match,
+                    }
+                    if variant:
+                        result["variant"] = variant
+                    results.append(result)
+                    label = f"{name}/{variant}" if variant else name
+                    print(f"{label:<18} -{level}  run {blueprint['run_seconds']:8.3f}s vs C {c['run_seconds']:8.3f}s"
+                          f"  (x{result['run_ratio']})  size x{result['size_ratio']}"
+                          f"  compile {blueprint['compile_seconds']:.3f}s" + ("" if outputs_match else "  OUTPUT MISMATCH"))
+
+    report = {
+        "label": arguments.label or describe_revision(),
+        "date": datetime.datetime.now(datetime.timezone.utc).isoformat(timespec="seconds"),
+        "host": {"system": platform.system(), "machine": platform.machine(), "processor": platform.processor()},
+        "compiler": os.path.abspath(arguments.compiler),
+        "c_compiler": arguments.cc,
+        "repetitions": arguments.repetitions,
+        "results": results,
+    }
+    with open(arguments.output, "w") as output:
+        json.dump(report, output, indent=2)
+        output.write("\n")
+    print(f"Results written to {arguments.output}")
+    return 1 if mismatches else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
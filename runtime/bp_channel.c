@@ -0,0 +1,327 @@
+#include "bp_runtime.h"
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bounded channel on Vyukov's MPMC ring buffer. Every cell carries a sequence number that
+// says which lap of the ring it is ready for: a producer claims position p by moving the tail
+// past it once cell[p].sequence == p, and publishes by setting the sequence to p + 1; a
+// consumer claims p once the sequence is p + 1 and frees the cell for the next lap with
+// p + capacity. Producers and consumers therefore only contend on their own end of the ring.
+//
+// A blocked sender or receiver parks: a green task through the scheduler, any other thread
+// on a condition variable after spinning briefly. The wait lists are only touched on that
+// slow path and by the fast path when the waiter count says someone is parked.
+enum {
+    BP_CHANNEL_CACHE_LINE = 64,
+    BP_CHANNEL_SPIN_LIMIT = 64,
+};
+
+typedef struct bp_channel_waiter {
+    struct bp_channel_waiter* next;
+    // Set for a green task, which is parked and unparked through the scheduler
+    bp_green_task* task;
+    pthread_cond_t wakeup;
+    bool woken;
+} bp_channel_waiter;
+
+typedef struct {
+    bp_channel_waiter* head;
+    bp_channel_waiter* tail;
+    // Waiters in the list, read without the lock by the other side's fast path
+    _Atomic uint32_t count;
+} bp_channel_wait_list;
+
+struct bp_channel {
+    // Each end on its own cache line so producers and consumers do not false-share.
+    alignas(BP_CHANNEL_CACHE_LINE) _Atomic uint64_t tail;
+    alignas(BP_CHANNEL_CACHE_LINE) _Atomic uint64_t head;
+
+    alignas(BP_CHANNEL_CACHE_LINE) uint64_t mask;
+    uint64_t element_size;
+    uint64_t cell_stride;
+    uint32_t flags;
+    _Atomic bool closed;
+    char* cells;
+
+    pthread_mutex_t wait_lock;
+    bp_channel_wait_list senders;
+    bp_channel_wait_list receivers;
+};
+
+typedef struct {
+    _Atomic uint64_t sequence;
+} bp_channel_cell;
+
+static bp_channel_cell* bp_channel_get_cell(bp_channel* channel, uint64_t position) {
+    return (bp_channel_cell*)(channel->cells + (position & channel->mask) * channel->cell_stride);
+}
+
+static void bp_channel_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+bp_channel* __bp_channel_create(uint64_t capacity, uint64_t element_size, uint32_t flags) {
+    if (capacity == 0 || capacity > (UINT64_C(1) << 32)) {
+        return NULL;
+    }
+    uint64_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    const uint64_t align = alignof(max_align_t);
+    const uint64_t stride = (sizeof(bp_channel_cell) + element_size + align - 1) / align * align;
+    if (element_size > SIZE_MAX / 2 || stride > SIZE_MAX / rounded) {
+        return NULL;
+    }
+
+    bp_channel* channel = (bp_channel*)aligned_alloc(BP_CHANNEL_CACHE_LINE, sizeof(bp_channel));
+    if (!channel) {
+        return NULL;
+    }
+    channel->cells = (char*)aligned_alloc(BP_CHANNEL_CACHE_LINE, (size_t)((stride * rounded + BP_CHANNEL_CACHE_LINE - 1) & ~(uint64_t)(BP_CHANNEL_CACHE_LINE - 1)));
+    if (!channel->cells) {
+        free(channel);
+        return NULL;
+    }
+
+    atomic_init(&channel->tail, 0);
+    atomic_init(&channel->head, 0);
+    channel->mask = rounded - 1;
+    channel->element_size = element_size;
+    channel->cell_stride = stride;
+    channel->flags = flags;
+    atomic_init(&channel->closed, false);
+    for (uint64_t position = 0; position < rounded; position++) {
+        atomic_init(&bp_channel_get_cell(channel, position)->sequence, position);
+    }
+
+    pthread_mutex_init(&channel->wait_lock, NULL);
+    memset(&channel->senders, 0, sizeof(channel->senders));
+    memset(&channel->receivers, 0, sizeof(channel->receivers));
+    return channel;
+}
+
+void __bp_channel_destroy(bp_channel* channel) {
+    if (!channel) {
+        return;
+    }
+    pthread_mutex_destroy(&channel->wait_lock);
+    free(channel->cells);
+    free(channel);
+}
+
+// Claims the next position at one end. On a single-producer or single-consumer end the
+// claim is a plain store: nobody else moves that index.
+static bool bp_channel_claim(_Atomic uint64_t* index, uint64_t* position, bool exclusive) {
+    if (exclusive) {
+        atomic_store_explicit(index, *position + 1, memory_order_relaxed);
+        return true;
+    }
+    return atomic_compare_exchange_weak_explicit(index, position, *position + 1, memory_order_relaxed, memory_order_relaxed);
+}
+
+static int32_t bp_channel_push(bp_channel* channel, void* element) {
+    if (atomic_load_explicit(&channel->closed, memory_order_relaxed)) {
+        return BP_CHANNEL_CLOSED;
+    }
+
+    const bool exclusive = channel->flags & BP_CHANNEL_SINGLE_PRODUCER;
+    uint64_t position = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+    bp_channel_cell* cell;
+    while (true) {
+        cell = bp_channel_get_cell(channel, position);
+        const uint64_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        const int64_t lag = (int64_t)(sequence - position);
+        if (lag == 0) {
+            if (bp_channel_claim(&channel->tail, &position, exclusive)) {
+                break;
+            }
+        } else if (lag < 0) {
+            return BP_CHANNEL_WOULD_BLOCK;
+        } else {
+            position = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+        }
+    }
+
+    memcpy(cell + 1, element, (size_t)channel->element_size);
+    atomic_store_explicit(&cell->sequence, position + 1, memory_order_release);
+    return BP_CHANNEL_OK;
+}
+
+static int32_t bp_channel_pop(bp_channel* channel, void* element) {
+    const bool exclusive = channel->flags & BP_CHANNEL_SINGLE_CONSUMER;
+    uint64_t position = atomic_load_explicit(&channel->head, memory_order_relaxed);
+    bp_channel_cell* cell;
+    while (true) {
+        cell = bp_channel_get_cell(channel, position);
+        const uint64_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        const int64_t lag = (int64_t)(sequence - (position + 1));
+        if (lag == 0) {
+            if (bp_channel_claim(&channel->head, &position, exclusive)) {
+                break;
+            }
+        } else if (lag < 0) {
+            // Elements sent before close are still delivered, including one a producer has
+            // claimed but not yet published.
+            if (atomic_load_explicit(&channel->closed, memory_order_acquire) && atomic_load_explicit(&channel->tail, memory_order_acquire) == position) {
+                return BP_CHANNEL_CLOSED;
+            }
+            return BP_CHANNEL_WOULD_BLOCK;
+        } else {
+            position = atomic_load_explicit(&channel->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy(element, cell + 1, (size_t)channel->element_size);
+    atomic_store_explicit(&cell->sequence, position + channel->mask + 1, memory_order_release);
+    return BP_CHANNEL_OK;
+}
+
+// Waiting
+
+static void bp_channel_unlock(void* argument) {
+    pthread_mutex_unlock((pthread_mutex_t*)argument);
+}
+
+// Called with wait_lock held.
+static void bp_channel_wake_one(bp_channel_wait_list* list) {
+    bp_channel_waiter* waiter = list->head;
+    if (!waiter) {
+        return;
+    }
+    list->head = waiter->next;
+    if (!list->head) {
+        list->tail = NULL;
+    }
+    atomic_fetch_sub_explicit(&list->count, 1, memory_order_relaxed);
+
+    waiter->woken = true;
+    if (waiter->task) {
+        __bp_green_unpark(waiter->task);
+    } else {
+        pthread_cond_signal(&waiter->wakeup);
+    }
+}
+
+static void bp_channel_wake_all(bp_channel_wait_list* list) {
+    while (list->head) {
+        bp_channel_wake_one(list);
+    }
+}
+
+// Wakes a waiter on the other end after an element was sent or received.
+static void bp_channel_notify(bp_channel* channel, bp_channel_wait_list* list) {
+    // Pairs with the fence in bp_channel_wait: either the waiter's retry sees this operation,
+    // or this sees the waiter.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&list->count, memory_order_relaxed) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&channel->wait_lock);
+    bp_channel_wake_one(list);
+    pthread_mutex_unlock(&channel->wait_lock);
+}
+
+typedef int32_t (*bp_channel_operation)(bp_channel* channel, void* element);
+
+// Retries operation until it stops reporting BP_CHANNEL_WOULD_BLOCK, parking on list in
+// between. other is the opposite end's list, notified after a successful attempt.
+static int32_t bp_channel_wait(bp_channel* channel, bp_channel_operation operation, void* element, bp_channel_wait_list* list,
+    bp_channel_wait_list* other) {
+    // Parking a green task costs about as much as a context switch, so only threads, whose
+    // wakeup goes through the kernel, spin first.
+    bp_green_task* task = __bp_green_current();
+    const int spin_limit = task ? 1 : BP_CHANNEL_SPIN_LIMIT;
+    while (true) {
+        for (int spin = 0; spin < spin_limit; spin++) {
+            const int32_t result = operation(channel, element);
+            if (result != BP_CHANNEL_WOULD_BLOCK) {
+                if (result == BP_CHANNEL_OK) {
+                    bp_channel_notify(channel, other);
+                }
+                return result;
+            }
+            bp_channel_cpu_relax();
+        }
+
+        bp_channel_waiter waiter;
+        waiter.next = NULL;
+        waiter.task = task;
+        waiter.woken = false;
+
+        pthread_mutex_lock(&channel->wait_lock);
+        atomic_fetch_add_explicit(&list->count, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        const int32_t result = operation(channel, element);
+        if (result != BP_CHANNEL_WOULD_BLOCK) {
+            atomic_fetch_sub_explicit(&list->count, 1, memory_order_relaxed);
+            pthread_mutex_unlock(&channel->wait_lock);
+            if (result == BP_CHANNEL_OK) {
+                bp_channel_notify(channel, other);
+            }
+            return result;
+        }
+
+        if (list->tail) {
+            list->tail->next = &waiter;
+        } else {
+            list->head = &waiter;
+        }
+        list->tail = &waiter;
+
+        if (waiter.task) {
+            // Releases wait_lock once this task is off its stack.
+            __bp_green_park(bp_channel_unlock, &channel->wait_lock);
+        } else {
+            pthread_cond_init(&waiter.wakeup, NULL);
+            while (!waiter.woken) {
+                pthread_cond_wait(&waiter.wakeup, &channel->wait_lock);
+            }
+            pthread_mutex_unlock(&channel->wait_lock);
+            pthread_cond_destroy(&waiter.wakeup);
+        }
+    }
+}
+
+int32_t __bp_channel_try_send(bp_channel* channel, const void* element) {
+    const int32_t result = bp_channel_push(channel, (void*)element);
+    if (result == BP_CHANNEL_OK) {
+        bp_channel_notify(channel, &channel->receivers);
+    }
+    return result;
+}
+
+int32_t __bp_channel_try_receive(bp_channel* channel, void* element) {
+    const int32_t result = bp_channel_pop(channel, element);
+    if (result == BP_CHANNEL_OK) {
+        bp_channel_notify(channel, &channel->senders);
+    }
+    return result;
+}
+
+int32_t __bp_channel_send(bp_channel* channel, const void* element) {
+    return bp_channel_wait(channel, bp_channel_push, (void*)element, &channel->senders, &channel->receivers);
+}
+
+int32_t __bp_channel_receive(bp_channel* channel, void* element) {
+    return bp_channel_wait(channel, bp_channel_pop, element, &channel->receivers, &channel->senders);
+}
+
+void __bp_channel_close(bp_channel* channel) {
+    pthread_mutex_lock(&channel->wait_lock);
+    atomic_store_explicit(&channel->closed, true, memory_order_release);
+    bp_channel_wake_all(&channel->senders);
+    bp_channel_wake_all(&channel->receivers);
+    pthread_mutex_unlock(&channel->wait_lock);
+}
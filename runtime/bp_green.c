@@ -0,0 +1,704 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "bp_runtime.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+// M:N scheduler for green threads. Each worker is an OS thread that owns a Chase-Lev deque
+// of runnable tasks: the worker pushes and pops at the bottom without locking, and idle
+// workers steal from the top of a random victim. Tasks spawned from outside the pool, and
+// tasks that yield, go through one global FIFO so a yielding task lets others run instead of
+// being popped straight back. A worker with nothing to run or steal parks on a condition
+// variable until new work is published.
+//
+// A task is suspended only by yielding, so a switch saves just the callee-saved registers.
+// Stacks are mmap'ed with a guard page and kept in a per-worker pool for reuse.
+enum {
+    BP_GREEN_STACK_SIZE = 256 * 1024,
+    BP_GREEN_STACK_POOL_LIMIT = 64,
+    BP_GREEN_INITIAL_DEQUE_CAPACITY = 256,
+    // Every this many scheduling decisions the global queue is served first, so tasks in it
+    // are not starved by workers that keep their own deques busy.
+    BP_GREEN_GLOBAL_QUEUE_INTERVAL = 61,
+};
+
+typedef struct bp_green_worker bp_green_worker;
+
+typedef struct bp_green_stack {
+    struct bp_green_stack* next;
+    char* base;
+} bp_green_stack;
+
+#if defined(__x86_64__)
+// Saved stack pointer; the callee-saved registers and the resume address are on the stack.
+typedef void* bp_green_context;
+
+__attribute__((visibility("hidden"))) void bp_green_switch(bp_green_context* save, bp_green_context resume);
+__attribute__((visibility("hidden"))) void bp_green_trampoline(void);
+
+// Pushes the callee-saved registers, MXCSR and the x87 control word, stores the stack
+// pointer into *save and pops the same frame from resume. Every task's saved frame has the
+// same layout, so one set of CFI directives describes it on either side of the stack switch
+// and debuggers and profilers can unwind through a suspended or resuming task.
+__asm__(
+    ".text\n"
+    ".globl bp_green_switch\n"
+    ".hidden bp_green_switch\n"
+    ".type bp_green_switch,@function\n"
+    "bp_green_switch:\n"
+    "    .cfi_startproc\n"
+    "    pushq %rbp\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    .cfi_offset %rbp, -16\n"
+    "    pushq %rbx\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    .cfi_offset %rbx, -24\n"
+    "    pushq %r12\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    .cfi_offset %r12, -32\n"
+    "    pushq %r13\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    .cfi_offset %r13, -40\n"
+    "    pushq %r14\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    .cfi_offset %r14, -48\n"
+    "    pushq %r15\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    .cfi_offset %r15, -56\n"
+    "    subq $8, %rsp\n"
+    "    .cfi_adjust_cfa_offset 8\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    popq %r15\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    .cfi_restore %r15\n"
+    "    popq %r14\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    .cfi_restore %r14\n"
+    "    popq %r13\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    .cfi_restore %r13\n"
+    "    popq %r12\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    .cfi_restore %r12\n"
+    "    popq %rbx\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    .cfi_restore %rbx\n"
+    "    popq %rbp\n"
+    "    .cfi_adjust_cfa_offset -8\n"
+    "    .cfi_restore %rbp\n"
+    "    ret\n"
+    "    .cfi_endproc\n"
+    ".size bp_green_switch, .-bp_green_switch\n"
+    // First resume of a task: its pointer was placed in the rbx slot. This is the outermost
+    // frame of the task's stack, so its return address is marked undefined to end unwinding.
+    ".globl bp_green_trampoline\n"
+    ".hidden bp_green_trampoline\n"
+    ".type bp_green_trampoline,@function\n"
+    "bp_green_trampoline:\n"
+    "    .cfi_startproc\n"
+    "    .cfi_undefined %rip\n"
+    "    movq %rbx, %rdi\n"
+    "    call bp_green_task_main\n"
+    "    ud2\n"
+    "    .cfi_endproc\n"
+    ".size bp_green_trampoline, .-bp_green_trampoline\n");
+#else
+typedef ucontext_t bp_green_context;
+#endif
+
+struct bp_green_task {
+    bp_green_context context;
+    bp_green_stack* stack;
+    bp_green_entry entry;
+    void* argument;
+    // Link in the global queue
+    bp_green_task* next;
+};
+
+typedef struct bp_green_ring {
+    int64_t capacity;
+    struct bp_green_ring* retired;
+    _Atomic(bp_green_task*) slots[];
+} bp_green_ring;
+
+typedef struct {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    _Atomic(bp_green_ring*) ring;
+} bp_green_deque;
+
+// What the task that just switched back to its worker asked for
+typedef enum {
+    BP_GREEN_RAN_YIELD,
+    BP_GREEN_RAN_PARK,
+    BP_GREEN_RAN_EXIT,
+} bp_green_outcome;
+
+struct bp_green_worker {
+    bp_green_deque deque;
+    pthread_t thread;
+    bp_green_context scheduler;
+    bp_green_task* current;
+    bp_green_outcome outcome;
+    // Run by the worker once a parking task is off its stack
+    void (*park_unlock)(void* argument);
+    void* park_argument;
+    bp_green_stack* stack_pool;
+    uint32_t pooled_stacks;
+    uint32_t ticks;
+    uint64_t random_state;
+};
+
+typedef struct {
+    bp_green_worker* workers;
+    uint32_t worker_count;
+
+    pthread_mutex_t global_lock;
+    bp_green_task* global_head;
+    bp_green_task* global_tail;
+    _Atomic int64_t global_length;
+
+    // Parking. wake_tokens counts wakeups published but not yet consumed by a parked worker.
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;
+    _Atomic uint32_t idle_workers;
+    uint32_t wake_tokens;
+    _Atomic bool stopping;
+
+    // Tasks spawned and not yet finished
+    pthread_mutex_t live_lock;
+    pthread_cond_t live_cond;
+    _Atomic int64_t live_tasks;
+} bp_green_scheduler;
+
+static bp_green_scheduler bp_green;
+static _Atomic bool bp_green_running = false;
+static _Thread_local bp_green_worker* bp_green_current_worker = NULL;
+
+// Chase-Lev deque, after Lê et al., "Correct and Efficient Work-Stealing for Weak Memory
+// Models" (PPoPP 2013). Rings replaced by growth are kept until shutdown because a thief may
+// still be reading from one.
+
+static bp_green_ring* bp_green_ring_create(int64_t capacity, bp_green_ring* retired) {
+    bp_green_ring* ring = (bp_green_ring*)malloc(sizeof(bp_green_ring) + (size_t)capacity * sizeof(_Atomic(bp_green_task*)));
+    if (!ring) {
+        abort();
+    }
+    ring->capacity = capacity;
+    ring->retired = retired;
+    return ring;
+}
+
+static void bp_green_deque_init(bp_green_deque* deque) {
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->ring, bp_green_ring_create(BP_GREEN_INITIAL_DEQUE_CAPACITY, NULL));
+}
+
+static void bp_green_deque_destroy(bp_green_deque* deque) {
+    bp_green_ring* ring = atomic_load_explicit(&deque->ring, memory_order_relaxed);
+    while (ring) {
+        bp_green_ring* retired = ring->retired;
+        free(ring);
+        ring = retired;
+    }
+}
+
+static void bp_green_deque_push(bp_green_deque* deque, bp_green_task* task) {
+    const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    const int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    bp_green_ring* ring = atomic_load_explicit(&deque->ring, memory_order_relaxed);
+    if (bottom - top > ring->capacity - 1) {
+        bp_green_ring* grown = bp_green_ring_create(ring->capacity * 2, ring);
+        for (int64_t i = top; i < bottom; i++) {
+            atomic_store_explicit(&grown->slots[i % grown->capacity],
+                atomic_load_explicit(&ring->slots[i % ring->capacity], memory_order_relaxed), memory_order_relaxed);
+        }
+        atomic_store_explicit(&deque->ring, grown, memory_order_release);
+        ring = grown;
+    }
+    atomic_store_explicit(&ring->slots[bottom % ring->capacity], task, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+static bp_green_task* bp_green_deque_pop(bp_green_deque* deque) {
+    const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    bp_green_ring* ring = atomic_load_explicit(&deque->ring, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    bp_green_task* task = atomic_load_explicit(&ring->slots[bottom % ring->capacity], memory_order_relaxed);
+    if (top == bottom) {
+        // Last element: race the thieves for it.
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            task = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static bp_green_task* bp_green_deque_steal(bp_green_deque* deque) {
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    bp_green_ring* ring = atomic_load_explicit(&deque->ring, memory_order_acquire);
+    bp_green_task* task = atomic_load_explicit(&ring->slots[top % ring->capacity], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return task;
+}
+
+static bool bp_green_deque_is_empty(bp_green_deque* deque) {
+    return atomic_load_explicit(&deque->top, memory_order_acquire) >= atomic_load_explicit(&deque->bottom, memory_order_acquire);
+}
+
+// Global queue
+
+static void bp_green_global_push(bp_green_task* task) {
+    task->next = NULL;
+    pthread_mutex_lock(&bp_green.global_lock);
+    if (bp_green.global_tail) {
+        bp_green.global_tail->next = task;
+    } else {
+        bp_green.global_head = task;
+    }
+    bp_green.global_tail = task;
+    atomic_fetch_add_explicit(&bp_green.global_length, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&bp_green.global_lock);
+}
+
+static bp_green_task* bp_green_global_pop(void) {
+    if (atomic_load_explicit(&bp_green.global_length, memory_order_relaxed) == 0) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&bp_green.global_lock);
+    bp_green_task* task = bp_green.global_head;
+    if (task) {
+        bp_green.global_head = task->next;
+        if (!bp_green.global_head) {
+            bp_green.global_tail = NULL;
+        }
+        atomic_fetch_sub_explicit(&bp_green.global_length, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&bp_green.global_lock);
+    return task;
+}
+
+// Parking
+
+static void bp_green_notify(void) {
+    // Pairs with the fence in bp_green_park: either the parking worker sees the new task, or
+    // this sees the worker counted as idle.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&bp_green.idle_workers, memory_order_relaxed) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&bp_green.park_lock);
+    if (bp_green.wake_tokens < atomic_load_explicit(&bp_green.idle_workers, memory_order_relaxed)) {
+        bp_green.wake_tokens++;
+        pthread_cond_signal(&bp_green.park_cond);
+    }
+    pthread_mutex_unlock(&bp_green.park_lock);
+}
+
+static bool bp_green_has_work(void) {
+    if (atomic_load_explicit(&bp_green.global_length, memory_order_relaxed) != 0) {
+        return true;
+    }
+    for (uint32_t i = 0; i < bp_green.worker_count; i++) {
+        if (!bp_green_deque_is_empty(&bp_green.workers[i].deque)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void bp_green_park(void) {
+    pthread_mutex_lock(&bp_green.park_lock);
+    atomic_fetch_add_explicit(&bp_green.idle_workers, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!bp_green_has_work()) {
+        while (bp_green.wake_tokens == 0 && !atomic_load_explicit(&bp_green.stopping, memory_order_relaxed)) {
+            pthread_cond_wait(&bp_green.park_cond, &bp_green.park_lock);
+        }
+        if (bp_green.wake_tokens > 0) {
+            bp_green.wake_tokens--;
+        }
+    }
+    atomic_fetch_sub_explicit(&bp_green.idle_workers, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&bp_green.park_lock);
+}
+
+// Stacks
+
+static size_t bp_green_page_size(void) {
+    static size_t page_size = 0;
+    if (page_size == 0) {
+        page_size = (size_t)sysconf(_SC_PAGESIZE);
+    }
+    return page_size;
+}
+
+static bp_green_stack* bp_green_stack_acquire(bp_green_worker* worker) {
+    if (worker && worker->stack_pool) {
+        bp_green_stack* stack = worker->stack_pool;
+        worker->stack_pool = stack->next;
+        worker->pooled_stacks--;
+        return stack;
+    }
+
+    // The lowest page stays inaccessible so an overflow faults instead of corrupting memory.
+    const size_t guard = bp_green_page_size();
+    char* base = (char*)mmap(NULL, guard + BP_GREEN_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    if (mprotect(base, guard, PROT_NONE) != 0) {
+        munmap(base, guard + BP_GREEN_STACK_SIZE);
+        return NULL;
+    }
+
+    // The bookkeeping lives at the top of the stack it describes.
+    bp_green_stack* stack = (bp_green_stack*)(base + guard + BP_GREEN_STACK_SIZE) - 1;
+    stack->next = NULL;
+    stack->base = base;
+    return stack;
+}
+
+static void bp_green_stack_release(bp_green_worker* worker, bp_green_stack* stack) {
+    if (worker->pooled_stacks < BP_GREEN_STACK_POOL_LIMIT) {
+        stack->next = worker->stack_pool;
+        worker->stack_pool = stack;
+        worker->pooled_stacks++;
+        return;
+    }
+    munmap(stack->base, bp_green_page_size() + BP_GREEN_STACK_SIZE);
+}
+
+// Tasks
+
+__attribute__((visibility("hidden"))) void bp_green_task_main(bp_green_task* task);
+
+static void bp_green_switch_to_scheduler(bp_green_worker* worker, bp_green_outcome outcome) {
+    bp_green_task* task = worker->current;
+    worker->outcome = outcome;
+#if defined(__x86_64__)
+    bp_green_switch(&task->context, worker->scheduler);
+#else
+    swapcontext(&task->context, &worker->scheduler);
+#endif
+}
+
+__attribute__((used, noreturn, visibility("hidden"))) void bp_green_task_main(bp_green_task* task) {
+    task->entry(task->argument);
+    // The task may have migrated while it ran.
+    bp_green_switch_to_scheduler(bp_green_current_worker, BP_GREEN_RAN_EXIT);
+    __builtin_unreachable();
+}
+
+#if !defined(__x86_64__)
+static void bp_green_context_entry(void) {
+    bp_green_task_main(bp_green_current_worker->current);
+}
+#endif
+
+static bool bp_green_context_init(bp_green_task* task) {
+    char* top = (char*)task->stack;
+#if defined(__x86_64__)
+    // Frame popped by the first bp_green_switch into the task: MXCSR and x87 control word,
+    // r15, r14, r13, r12, rbx (the task), rbp and the return address. The trampoline is
+    // entered with a 16-byte aligned stack pointer, as it would be after a call.
+    uintptr_t* frame = (uintptr_t*)((uintptr_t)top & ~(uintptr_t)15) - 8;
+    frame[0] = (uintptr_t)0x037F << 32 | 0x1F80;
+    frame[1] = 0;
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = 0;
+    frame[5] = (uintptr_t)task;
+    frame[6] = 0;
+    frame[7] = (uintptr_t)&bp_green_trampoline;
+    task->context = frame;
+    return true;
+#else
+    if (getcontext(&task->context) != 0) {
+        return false;
+    }
+    task->context.uc_stack.ss_sp = task->stack->base + bp_green_page_size();
+    task->context.uc_stack.ss_size = (size_t)(top - (char*)task->context.uc_stack.ss_sp);
+    task->context.uc_link = NULL;
+    makecontext(&task->context, bp_green_context_entry, 0);
+    return true;
+#endif
+}
+
+static void bp_green_run_task(bp_green_worker* worker, bp_green_task* task) {
+    worker->current = task;
+#if defined(__x86_64__)
+    bp_green_switch(&worker->scheduler, task->context);
+#else
+    swapcontext(&worker->scheduler, &task->context);
+#endif
+    worker->current = NULL;
+
+    // Only now is the task off its stack, so only now may another worker resume it or its
+    // stack be reused.
+    if (worker->outcome == BP_GREEN_RAN_YIELD) {
+        bp_green_global_push(task);
+        bp_green_notify();
+        return;
+    }
+    if (worker->outcome == BP_GREEN_RAN_PARK) {
+        // Whoever wakes the task runs after this, so it cannot resume a task still on its
+        // stack.
+        worker->park_unlock(worker->park_argument);
+        return;
+    }
+
+    bp_green_stack_release(worker, task->stack);
+    free(task);
+    if (atomic_fetch_sub_explicit(&bp_green.live_tasks, 1, memory_order_acq_rel) == 1) {
+        pthread_mutex_lock(&bp_green.live_lock);
+        pthread_cond_broadcast(&bp_green.live_cond);
+        pthread_mutex_unlock(&bp_green.live_lock);
+    }
+}
+
+// Workers
+
+static uint32_t bp_green_next_random(bp_green_worker* worker) {
+    uint64_t x = worker->random_state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    worker->random_state = x;
+    return (uint32_t)(x >> 32);
+}
+
+static bp_green_task* bp_green_find_task(bp_green_worker* worker) {
+    bp_green_task* task = NULL;
+    if (++worker->ticks % BP_GREEN_GLOBAL_QUEUE_INTERVAL == 0 && (task = bp_green_global_pop())) {
+        return task;
+    }
+    if ((task = bp_green_deque_pop(&worker->deque)) || (task = bp_green_global_pop())) {
+        return task;
+    }
+
+    const uint32_t count = bp_green.worker_count;
+    const uint32_t start = bp_green_next_random(worker) % count;
+    for (uint32_t i = 0; i < count; i++) {
+        bp_green_worker* victim = &bp_green.workers[(start + i) % count];
+        if (victim != worker && (task = bp_green_deque_steal(&victim->deque))) {
+            return task;
+        }
+    }
+    return NULL;
+}
+
+static void* bp_green_worker_main(void* argument) {
+    bp_green_worker* worker = (bp_green_worker*)argument;
+    bp_green_current_worker = worker;
+    while (true) {
+        bp_green_task* task = bp_green_find_task(worker);
+        if (task) {
+            bp_green_run_task(worker, task);
+            continue;
+        }
+        if (atomic_load_explicit(&bp_green.stopping, memory_order_acquire)) {
+            break;
+        }
+        bp_green_park();
+    }
+
+    while (worker->stack_pool) {
+        bp_green_stack* stack = worker->stack_pool;
+        worker->stack_pool = stack->next;
+        munmap(stack->base, bp_green_page_size() + BP_GREEN_STACK_SIZE);
+    }
+    bp_green_current_worker = NULL;
+    return NULL;
+}
+
+// Stops and joins the first started workers, then frees the scheduler.
+static void bp_green_stop_workers(uint32_t started) {
+    pthread_mutex_lock(&bp_green.park_lock);
+    atomic_store_explicit(&bp_green.stopping, true, memory_order_release);
+    pthread_cond_broadcast(&bp_green.park_cond);
+    pthread_mutex_unlock(&bp_green.park_lock);
+
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(bp_green.workers[i].thread, NULL);
+    }
+    for (uint32_t i = 0; i < bp_green.worker_count; i++) {
+        bp_green_deque_destroy(&bp_green.workers[i].deque);
+    }
+    free(bp_green.workers);
+    bp_green.workers = NULL;
+    bp_green.worker_count = 0;
+    pthread_cond_destroy(&bp_green.live_cond);
+    pthread_mutex_destroy(&bp_green.live_lock);
+    pthread_cond_destroy(&bp_green.park_cond);
+    pthread_mutex_destroy(&bp_green.park_lock);
+    pthread_mutex_destroy(&bp_green.global_lock);
+    atomic_store(&bp_green_running, false);
+}
+
+int32_t __bp_green_start(uint32_t workers) {
+    bool expected = false;
+    if (!atomic_compare_exchange_strong(&bp_green_running, &expected, true)) {
+        return -1;
+    }
+
+    if (workers == 0) {
+        const long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (uint32_t)online : 1;
+    }
+
+    bp_green.workers = (bp_green_worker*)calloc(workers, sizeof(bp_green_worker));
+    if (!bp_green.workers) {
+        atomic_store(&bp_green_running, false);
+        return -1;
+    }
+    bp_green.worker_count = workers;
+    pthread_mutex_init(&bp_green.global_lock, NULL);
+    bp_green.global_head = NULL;
+    bp_green.global_tail = NULL;
+    atomic_init(&bp_green.global_length, 0);
+    pthread_mutex_init(&bp_green.park_lock, NULL);
+    pthread_cond_init(&bp_green.park_cond, NULL);
+    atomic_init(&bp_green.idle_workers, 0);
+    bp_green.wake_tokens = 0;
+    atomic_init(&bp_green.stopping, false);
+    pthread_mutex_init(&bp_green.live_lock, NULL);
+    pthread_cond_init(&bp_green.live_cond, NULL);
+    atomic_init(&bp_green.live_tasks, 0);
+
+    for (uint32_t i = 0; i < workers; i++) {
+        bp_green_worker* worker = &bp_green.workers[i];
+        bp_green_deque_init(&worker->deque);
+        worker->random_state = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+    for (uint32_t i = 0; i < workers; i++) {
+        if (pthread_create(&bp_green.workers[i].thread, NULL, bp_green_worker_main, &bp_green.workers[i]) != 0) {
+            bp_green_stop_workers(i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int32_t __bp_green_spawn(bp_green_entry entry, void* argument) {
+    if (!atomic_load_explicit(&bp_green_running, memory_order_acquire) || !entry) {
+        return -1;
+    }
+
+    bp_green_worker* worker = bp_green_current_worker;
+    bp_green_task* task = (bp_green_task*)malloc(sizeof(bp_green_task));
+    if (!task) {
+        return -1;
+    }
+    task->stack = bp_green_stack_acquire(worker);
+    if (!task->stack) {
+        free(task);
+        return -1;
+    }
+    task->entry = entry;
+    task->argument = argument;
+    task->next = NULL;
+    if (!bp_green_context_init(task)) {
+        if (worker) {
+            bp_green_stack_release(worker, task->stack);
+        } else {
+            munmap(task->stack->base, bp_green_page_size() + BP_GREEN_STACK_SIZE);
+        }
+        free(task);
+        return -1;
+    }
+
+    atomic_fetch_add_explicit(&bp_green.live_tasks, 1, memory_order_relaxed);
+    if (worker) {
+        bp_green_deque_push(&worker->deque, task);
+    } else {
+        bp_green_global_push(task);
+    }
+    bp_green_notify();
+    return 0;
+}
+
+void __bp_green_yield(void) {
+    bp_green_worker* worker = bp_green_current_worker;
+    if (!worker || !worker->current) {
+        sched_yield();
+        return;
+    }
+    bp_green_switch_to_scheduler(worker, BP_GREEN_RAN_YIELD);
+}
+
+bp_green_task* __bp_green_current(void) {
+    bp_green_worker* worker = bp_green_current_worker;
+    return worker ? worker->current : NULL;
+}
+
+void __bp_green_park(void (*unlock)(void* argument), void* argument) {
+    bp_green_worker* worker = bp_green_current_worker;
+    worker->park_unlock = unlock;
+    worker->park_argument = argument;
+    bp_green_switch_to_scheduler(worker, BP_GREEN_RAN_PARK);
+}
+
+void __bp_green_unpark(bp_green_task* task) {
+    bp_green_worker* worker = bp_green_current_worker;
+    if (worker) {
+        bp_green_deque_push(&worker->deque, task);
+    } else {
+        bp_green_global_push(task);
+    }
+    bp_green_notify();
+}
+
+void __bp_green_shutdown(void) {
+    if (!atomic_load_explicit(&bp_green_running, memory_order_acquire) || bp_green_current_worker) {
+        return;
+    }
+
+    pthread_mutex_lock(&bp_green.live_lock);
+    while (atomic_load_explicit(&bp_green.live_tasks, memory_order_acquire) != 0) {
+        pthread_cond_wait(&bp_green.live_cond, &bp_green.live_lock);
+    }
+    pthread_mutex_unlock(&bp_green.live_lock);
+
+    bp_green_stop_workers(bp_green.worker_count);
+}
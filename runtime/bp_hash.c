@@ -0,0 +1,102 @@
+#include "bp_runtime.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// Group matching for SwissTable-style control bytes. An SSE2 group is one 16-byte compare
+// and a movemask. NEON has no movemask, so its compare is narrowed to four bits per byte
+// and the mask assembled from those. Other targets compare byte by byte.
+
+#if defined(__SSE2__)
+
+static uint32_t bp_group_mask(__m128i matches) {
+    return (uint32_t)_mm_movemask_epi8(matches);
+}
+
+uint32_t __bp_group_match(const uint8_t* group, uint8_t tag) {
+    const __m128i control = _mm_loadu_si128((const __m128i*)group);
+    return bp_group_mask(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)tag)));
+}
+
+uint32_t __bp_group_match_empty(const uint8_t* group) {
+    const __m128i control = _mm_loadu_si128((const __m128i*)group);
+    return bp_group_mask(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)BP_CONTROL_EMPTY)));
+}
+
+uint32_t __bp_group_match_free(const uint8_t* group) {
+    // Exactly the free bytes have their sign bit set.
+    return bp_group_mask(_mm_loadu_si128((const __m128i*)group));
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+static uint32_t bp_group_mask(uint8x16_t matches) {
+    // Shift-right-narrow keeps four bits of every byte, so byte i becomes nibble i.
+    const uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    uint32_t mask = 0;
+    for (int byte = 0; byte < BP_GROUP_WIDTH; byte++) {
+        mask |= (uint32_t)((nibbles >> (byte * 4)) & 1) << byte;
+    }
+    return mask;
+}
+
+uint32_t __bp_group_match(const uint8_t* group, uint8_t tag) {
+    return bp_group_mask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(tag)));
+}
+
+uint32_t __bp_group_match_empty(const uint8_t* group) {
+    return bp_group_mask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(BP_CONTROL_EMPTY)));
+}
+
+uint32_t __bp_group_match_free(const uint8_t* group) {
+    return bp_group_mask(vcltzq_s8(vreinterpretq_s8_u8(vld1q_u8(group))));
+}
+
+#else
+
+uint32_t __bp_group_match(const uint8_t* group, uint8_t tag) {
+    uint32_t mask = 0;
+    for (int byte = 0; byte < BP_GROUP_WIDTH; byte++) {
+        mask |= (uint32_t)(group[byte] == tag) << byte;
+    }
+    return mask;
+}
+
+uint32_t __bp_group_match_empty(const uint8_t* group) {
+    return __bp_group_match(group, BP_CONTROL_EMPTY);
+}
+
+uint32_t __bp_group_match_free(const uint8_t* group) {
+    uint32_t mask = 0;
+    for (int byte = 0; byte < BP_GROUP_WIDTH; byte++) {
+        mask |= (uint32_t)(group[byte] >> 7) << byte;
+    }
+    return mask;
+}
+
+#endif
+
+int32_t __bp_group_first(uint32_t mask) {
+    return mask ? __builtin_ctz(mask) : BP_GROUP_WIDTH;
+}
+
+int32_t __bp_group_next(uint32_t mask, int32_t index) {
+    if (index + 1 >= BP_GROUP_WIDTH) {
+        return BP_GROUP_WIDTH;
+    }
+    return __bp_group_first(mask & ~((UINT32_C(2) << index) - 1));
+}
+
+// The finalizer of MurmurHash3: every output bit depends on every input bit, so hashCode()
+// results that differ only in their high bits still get distinct tags and probe starts.
+uint64_t __bp_hash_mix(uint64_t hash) {
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+    return hash;
+}
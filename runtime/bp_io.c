@@ -0,0 +1,203 @@
+#include "bp_runtime.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Each thread formats into its own buffer, so writers never take a lock. A buffer is handed
+// to write(2) only at line boundaries (or when a single value would not fit), which keeps
+// lines from different threads intact.
+enum {
+    BP_OUTPUT_CAPACITY = 64 * 1024,
+    BP_OUTPUT_FLUSH_THRESHOLD = BP_OUTPUT_CAPACITY - 4 * 1024,
+    BP_FORMAT_SCRATCH = 512,
+};
+
+typedef struct {
+    size_t length;
+    char data[BP_OUTPUT_CAPACITY];
+} bp_output_buffer;
+
+static int32_t bp_requested_mode = BP_OUTPUT_AUTO;
+static int bp_line_buffered = 0;
+static pthread_once_t bp_output_once = PTHREAD_ONCE_INIT;
+static pthread_key_t bp_output_key;
+static _Thread_local bp_output_buffer* bp_thread_output = NULL;
+
+static void bp_write_all(const char* data, size_t length) {
+    while (length > 0) {
+        const ssize_t written = write(STDOUT_FILENO, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+static void bp_flush_buffer(bp_output_buffer* buffer) {
+    if (buffer->length > 0) {
+        bp_write_all(buffer->data, buffer->length);
+        buffer->length = 0;
+    }
+}
+
+// Runs when a thread that wrote output exits.
+static void bp_release_thread_buffer(void* opaque) {
+    bp_output_buffer* buffer = (bp_output_buffer*)opaque;
+    bp_flush_buffer(buffer);
+    free(buffer);
+}
+
+// Thread-exit destructors do not run for the thread calling exit(), so flush it here.
+static void bp_flush_at_exit(void) {
+    if (bp_thread_output) {
+        bp_flush_buffer(bp_thread_output);
+    }
+}
+
+static void bp_initialize_output(void) {
+    pthread_key_create(&bp_output_key, bp_release_thread_buffer);
+    atexit(bp_flush_at_exit);
+
+    switch (bp_requested_mode) {
+        case BP_OUTPUT_LINE:
+            bp_line_buffered = 1;
+            break;
+        case BP_OUTPUT_FULL:
+            bp_line_buffered = 0;
+            break;
+        default:
+            bp_line_buffered = isatty(STDOUT_FILENO);
+            break;
+    }
+}
+
+static bp_output_buffer* bp_get_buffer(void) {
+    bp_output_buffer* buffer = bp_thread_output;
+    if (buffer) {
+        return buffer;
+    }
+
+    pthread_once(&bp_output_once, bp_initialize_output);
+    buffer = (bp_output_buffer*)malloc(sizeof(bp_output_buffer));
+    if (!buffer) {
+        return NULL;
+    }
+    buffer->length = 0;
+    pthread_setspecific(bp_output_key, buffer);
+    bp_thread_output = buffer;
+    return buffer;
+}
+
+static void bp_append(const char* data, size_t length) {
+    bp_output_buffer* buffer = bp_get_buffer();
+    if (!buffer) {
+        bp_write_all(data, length);
+        return;
+    }
+
+    if (length > BP_OUTPUT_CAPACITY - buffer->length) {
+        bp_flush_buffer(buffer);
+        if (length > BP_OUTPUT_CAPACITY) {
+            bp_write_all(data, length);
+            return;
+        }
+    }
+
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+}
+
+// Formats the magnitude right-aligned into scratch and returns the first digit.
+static char* bp_format_unsigned(uint64_t value, char* end) {
+    char* cursor = end;
+    do {
+        *--cursor = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return cursor;
+}
+
+static char* bp_format_signed(int64_t value, char* end) {
+    // Negate in unsigned arithmetic so INT64_MIN does not overflow.
+    const uint64_t magnitude = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char* cursor = bp_format_unsigned(magnitude, end);
+    if (value < 0) {
+        *--cursor = '-';
+    }
+    return cursor;
+}
+
+void __bp_io_configure(int32_t mode) {
+    bp_requested_mode = mode;
+}
+
+void __bp_write_i64(int64_t value) {
+    char scratch[32];
+    char* end = scratch + sizeof(scratch);
+    char* begin = bp_format_signed(value, end);
+    bp_append(begin, (size_t)(end - begin));
+}
+
+void __bp_write_u64(uint64_t value) {
+    char scratch[32];
+    char* end = scratch + sizeof(scratch);
+    char* begin = bp_format_unsigned(value, end);
+    bp_append(begin, (size_t)(end - begin));
+}
+
+void __bp_write_f64(double value) {
+    char scratch[BP_FORMAT_SCRATCH];
+    const int length = snprintf(scratch, sizeof(scratch), "%f", value);
+    if (length > 0) {
+        bp_append(scratch, (size_t)length < sizeof(scratch) ? (size_t)length : sizeof(scratch) - 1);
+    }
+}
+
+void __bp_write_fraction(int64_t numerator, int64_t denominator) {
+    char scratch[64];
+    char* end = scratch + sizeof(scratch);
+    char* begin = bp_format_signed(denominator, end);
+    *--begin = '/';
+    begin = bp_format_signed(numerator, begin);
+    bp_append(begin, (size_t)(end - begin));
+}
+
+void __bp_write_bool(int32_t value) {
+    if (value) {
+        bp_append("true", 4);
+    } else {
+        bp_append("false", 5);
+    }
+}
+
+void __bp_write_char(int32_t value) {
+    const char character = (char)value;
+    bp_append(&character, 1);
+}
+
+void __bp_write_str(const char* value) {
+    bp_append(value, strlen(value));
+}
+
+void __bp_write_newline(void) {
+    bp_append("\n", 1);
+
+    bp_output_buffer* buffer = bp_thread_output;
+    if (buffer && (bp_line_buffered || buffer->length >= BP_OUTPUT_FLUSH_THRESHOLD)) {
+        bp_flush_buffer(buffer);
+    }
+}
+
+void __bp_flush(void) {
+    if (bp_thread_output) {
+        bp_flush_buffer(bp_thread_output);
+    }
+}
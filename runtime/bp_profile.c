@@ -0,0 +1,109 @@
+#include "bp_runtime.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Layout emitted by the compiler: { ptr name, i64 calls, i64 ticks, ptr next, i32 registered }.
+// Counters are updated with relaxed atomics, so concurrent callers only contend on the cache
+// line of a hot record. The list of registered records is only walked at exit.
+struct bp_function_profile {
+    const char* name;
+    _Atomic uint64_t calls;
+    _Atomic uint64_t ticks;
+    struct bp_function_profile* next;
+    _Atomic int32_t registered;
+};
+
+_Static_assert(sizeof(struct bp_function_profile) == BP_FUNCTION_PROFILE_SIZE, "record size assumed by the compiler");
+_Static_assert(offsetof(struct bp_function_profile, name) == 0, "record layout assumed by the compiler");
+
+static _Atomic(bp_function_profile*) bp_profiles = NULL;
+static pthread_once_t bp_profile_once = PTHREAD_ONCE_INIT;
+
+static uint64_t bp_profile_timestamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * UINT64_C(1000000000) + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static int bp_compare_ticks(const void* left, const void* right) {
+    const uint64_t leftTicks = atomic_load_explicit(&(*(bp_function_profile* const*)left)->ticks, memory_order_relaxed);
+    const uint64_t rightTicks = atomic_load_explicit(&(*(bp_function_profile* const*)right)->ticks, memory_order_relaxed);
+    return leftTicks < rightTicks ? 1 : leftTicks > rightTicks ? -1 : 0;
+}
+
+void __bp_profile_report(void) {
+    bp_function_profile* const profiles = atomic_exchange(&bp_profiles, NULL);
+    if (!profiles) {
+        return;
+    }
+    size_t count = 0;
+    for (bp_function_profile* profile = profiles; profile; profile = profile->next) {
+        count++;
+    }
+    bp_function_profile** sorted = malloc(count * sizeof(bp_function_profile*));
+    if (!sorted) {
+        return;
+    }
+    size_t index = 0;
+    for (bp_function_profile* profile = profiles; profile; profile = profile->next) {
+        sorted[index++] = profile;
+    }
+    qsort(sorted, count, sizeof(bp_function_profile*), bp_compare_ticks);
+
+    const char* path = getenv("BLUEPRINT_PROFILE_OUTPUT");
+    FILE* output = path && *path ? fopen(path, "w") : NULL;
+    if (!output) {
+        output = stderr;
+    }
+    fprintf(output, "%14s %20s %14s  %s\n", "calls", "ticks", "ticks/call", "method");
+    for (index = 0; index < count; index++) {
+        const uint64_t calls = atomic_exchange_explicit(&sorted[index]->calls, 0, memory_order_relaxed);
+        const uint64_t ticks = atomic_exchange_explicit(&sorted[index]->ticks, 0, memory_order_relaxed);
+        fprintf(output, "%14llu %20llu %14llu  %s\n", (unsigned long long)calls, (unsigned long long)ticks,
+            (unsigned long long)(calls ? ticks / calls : 0), sorted[index]->name);
+        atomic_store_explicit(&sorted[index]->registered, 0, memory_order_release);
+    }
+    if (output != stderr) {
+        fclose(output);
+    }
+    free(sorted);
+}
+
+static void bp_profile_install(void) {
+    atexit(__bp_profile_report);
+}
+
+uint64_t __bp_profile_enter(bp_function_profile* profile) {
+    if (atomic_load_explicit(&profile->registered, memory_order_acquire) == 0) {
+        int32_t unregistered = 0;
+        if (atomic_compare_exchange_strong_explicit(&profile->registered, &unregistered, 1, memory_order_acq_rel, memory_order_acquire)) {
+            pthread_once(&bp_profile_once, bp_profile_install);
+            profile->next = atomic_load_explicit(&bp_profiles, memory_order_relaxed);
+            while (!atomic_compare_exchange_weak_explicit(&bp_profiles, &profile->next, profile, memory_order_release, memory_order_relaxed)) {
+            }
+        }
+    }
+    atomic_fetch_add_explicit(&profile->calls, 1, memory_order_relaxed);
+    return bp_profile_timestamp();
+}
+
+void __bp_profile_exit(bp_function_profile* profile, uint64_t start) {
+    atomic_fetch_add_explicit(&profile->ticks, bp_profile_timestamp() - start, memory_order_relaxed);
+}
@@ -0,0 +1,92 @@
+#include "bp_runtime.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// Both paths go through one _Atomic field. The unshared path uses relaxed loads and stores,
+// which compile to ordinary moves; only a shared object pays for read-modify-write
+// instructions. The sign of the count is only changed by __bp_rc_share, on the owning
+// thread, before any other thread can observe the object.
+typedef struct {
+    _Atomic int64_t count;
+    bp_rc_destructor destroy;
+} bp_rc_header;
+
+_Static_assert(sizeof(bp_rc_header) == BP_RC_HEADER_SIZE, "generated code relies on the header size");
+_Static_assert(offsetof(bp_rc_header, count) == 0, "generated code relies on the count being first");
+
+static bp_rc_header* bp_rc_get_header(void* object) {
+    return (bp_rc_header*)((char*)object - sizeof(bp_rc_header));
+}
+
+static void bp_rc_destroy(bp_rc_header* header) {
+    if (header->destroy) {
+        header->destroy(header + 1);
+    }
+    free(header);
+}
+
+void* __bp_rc_alloc(uint64_t size, bp_rc_destructor destroy) {
+    if (size > SIZE_MAX - sizeof(bp_rc_header)) {
+        return NULL;
+    }
+
+    bp_rc_header* header = (bp_rc_header*)calloc(1, sizeof(bp_rc_header) + (size_t)size);
+    if (!header) {
+        return NULL;
+    }
+    atomic_init(&header->count, 1);
+    header->destroy = destroy;
+    return header + 1;
+}
+
+void __bp_rc_retain(void* object) {
+    if (!object) {
+        return;
+    }
+
+    bp_rc_header* header = bp_rc_get_header(object);
+    const int64_t count = atomic_load_explicit(&header->count, memory_order_relaxed);
+    if (count > 0) {
+        atomic_store_explicit(&header->count, count + 1, memory_order_relaxed);
+    } else {
+        atomic_fetch_sub_explicit(&header->count, 1, memory_order_relaxed);
+    }
+}
+
+void __bp_rc_release(void* object) {
+    if (!object) {
+        return;
+    }
+
+    bp_rc_header* header = bp_rc_get_header(object);
+    const int64_t count = atomic_load_explicit(&header->count, memory_order_relaxed);
+    if (count > 0) {
+        if (count == 1) {
+            bp_rc_destroy(header);
+        } else {
+            atomic_store_explicit(&header->count, count - 1, memory_order_relaxed);
+        }
+        return;
+    }
+
+    // Release ordering makes this thread's writes visible to whichever thread destroys it, and
+    // acquire ordering lets that thread see them. A separate acquire fence would do the same,
+    // but thread sanitizers do not model fences.
+    if (atomic_fetch_add_explicit(&header->count, 1, memory_order_acq_rel) == -1) {
+        bp_rc_destroy(header);
+    }
+}
+
+void __bp_rc_share(void* object) {
+    if (!object) {
+        return;
+    }
+
+    bp_rc_header* header = bp_rc_get_header(object);
+    const int64_t count = atomic_load_explicit(&header->count, memory_order_relaxed);
+    if (count > 0) {
+        atomic_store_explicit(&header->count, -count, memory_order_relaxed);
+    }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output buffering modes accepted by __bp_io_configure.
+enum {
+    BP_OUTPUT_AUTO = 0,   // Line-buffered when stdout is a terminal, fully buffered otherwise
+    BP_OUTPUT_LINE = 1,   // Flush after every newline
+    BP_OUTPUT_FULL = 2,   // Flush when a thread's buffer passes its threshold, and at exit
+};
+
+// Selects the buffering mode. Must be called before the first write to take effect.
+void __bp_io_configure(int32_t mode);
+
+// Type-specialized writers used by Defaultlogger.logln. Each appends to a per-thread buffer.
+void __bp_write_i64(int64_t value);
+void __bp_write_u64(uint64_t value);
+void __bp_write_f64(double value);
+void __bp_write_fraction(int64_t numerator, int64_t denominator);
+void __bp_write_bool(int32_t value);
+void __bp_write_char(int32_t value);
+void __bp_write_str(const char* value);
+void __bp_write_newline(void);
+
+// Writes out the calling thread's buffer.
+void __bp_flush(void);
+
+// Reference-counted objects. Each allocation is preceded by a BP_RC_HEADER_SIZE header whose
+// first field is the int64 count, so generated code can inline the unshared fast path:
+//
+//   count > 0   owned by one thread, updated with plain loads and stores
+//   count < 0   shared between threads, holds -(references) and is updated atomically
+//
+// An object starts unshared with one reference. It must be passed to __bp_rc_share before it
+// becomes reachable from a second thread. Sharing does not revert. A release that drops the
+// last reference runs the destructor, if any, on the payload and frees the object.
+enum {
+    BP_RC_HEADER_SIZE = 16,
+};
+
+typedef void (*bp_rc_destructor)(void* object);
+
+// Returns a zeroed payload of size bytes aligned to 16, or NULL if allocation fails.
+void* __bp_rc_alloc(uint64_t size, bp_rc_destructor destroy);
+void __bp_rc_retain(void* object);
+void __bp_rc_release(void* object);
+void __bp_rc_share(void* object);
+
+// Green threads, scheduled M:N onto a pool of worker threads with work stealing. Tasks run
+// until they return or yield; a task that blocks in a system call blocks its worker.
+typedef void (*bp_green_entry)(void* argument);
+typedef struct bp_green_task bp_green_task;
+
+// Starts the given number of workers, or one per online core for 0. Returns 0, or -1 if the
+// scheduler is already running or no worker could be started.
+int32_t __bp_green_start(uint32_t workers);
+// Queues entry(argument) as a new task. Returns 0, or -1 if the scheduler is not running or
+// the task's stack cannot be allocated.
+int32_t __bp_green_spawn(bp_green_entry entry, void* argument);
+// Lets other tasks run before the calling task continues, possibly on another worker.
+// Outside a task this yields the OS thread.
+void __bp_green_yield(void);
+// The task running on the calling thread, or NULL outside the scheduler.
+bp_green_task* __bp_green_current(void);
+// Suspends the calling task until __bp_green_unpark. unlock(argument) runs once the task is
+// fully suspended, so a waker that takes the same lock cannot resume it early. Only valid
+// when __bp_green_current() is not NULL.
+void __bp_green_park(void (*unlock)(void* argument), void* argument);
+// Makes a parked task runnable again.
+void __bp_green_unpark(bp_green_task* task);
+// Waits until every task has finished, then stops the workers. Must be called from outside
+// the scheduler; the scheduler can be started again afterwards.
+void __bp_green_shutdown(void);
+
+// Bounded multi-producer multi-consumer channel of fixed-size elements. Blocking operations
+// park the calling green task, or block the calling thread outside the scheduler.
+typedef struct bp_channel bp_channel;
+
+enum {
+    BP_CHANNEL_OK = 0,
+    BP_CHANNEL_WOULD_BLOCK = 1,
+    BP_CHANNEL_CLOSED = -1,
+};
+
+// Creation flags. A channel promised a single producer (or consumer) claims slots on that
+// end with plain stores instead of compare-and-swap.
+enum {
+    BP_CHANNEL_SINGLE_PRODUCER = 1,
+    BP_CHANNEL_SINGLE_CONSUMER = 2,
+};
+
+// Capacity is rounded up to a power of two. Returns NULL if it is 0, above 2^32 or cannot be
+// allocated.
+bp_channel* __bp_channel_create(uint64_t capacity, uint64_t element_size, uint32_t flags);
+// Must not race with any other operation on the channel.
+void __bp_channel_destroy(bp_channel* channel);
+// Copy element_size bytes in or out. Sends fail with BP_CHANNEL_CLOSED once the channel is
+// closed; receives fail with it once it is closed and drained.
+int32_t __bp_channel_send(bp_channel* channel, const void* element);
+int32_t __bp_channel_receive(bp_channel* channel, void* element);
+// As above, but return BP_CHANNEL_WOULD_BLOCK instead of waiting.
+int32_t __bp_channel_try_send(bp_channel* channel, const void* element);
+int32_t __bp_channel_try_receive(bp_channel* channel, void* element);
+// Wakes every blocked sender and receiver.
+void __bp_channel_close(bp_channel* channel);
+
+// Control bytes of the open-addressing tables behind std.collections HashMap and HashSet.
+// Every slot has one: BP_CONTROL_EMPTY, BP_CONTROL_DELETED, or the low 7 bits of a full
+// slot's mixed hash. Lookups probe groups of BP_GROUP_WIDTH consecutive control bytes, so a
+// miss usually costs one group compare instead of a scan.
+enum {
+    BP_GROUP_WIDTH = 16,
+    BP_CONTROL_EMPTY = 0x80,
+    BP_CONTROL_DELETED = 0xFE,
+};
+
+// Each reads the BP_GROUP_WIDTH control bytes at group, which need not be aligned, and
+// returns a mask with bit i set if group[i] matches: equals tag, is empty, or is empty or
+// deleted.
+uint32_t __bp_group_match(const uint8_t* group, uint8_t tag);
+uint32_t __bp_group_match_empty(const uint8_t* group);
+uint32_t __bp_group_match_free(const uint8_t* group);
+// Walk the set bits of a match mask: the lowest set bit, and the lowest one above index.
+// Both return BP_GROUP_WIDTH when there is none.
+int32_t __bp_group_first(uint32_t mask);
+int32_t __bp_group_next(uint32_t mask, int32_t index);
+// Spreads a hash code over all 64 bits. Tables take the tag from the low 7 bits of the result
+// and the first probed group from the rest.
+uint64_t __bp_hash_mix(uint64_t hash);
+
+// Call counters for --instrument=functions. The compiler emits one record per method, zeroed
+// except for its first field, a pointer to the method's name, and brackets the body with these
+// calls. A record registers itself on its first call. At exit, every called method is listed,
+// most ticks first, on stderr or in the file named by $BLUEPRINT_PROFILE_OUTPUT. Ticks come
+// from the timestamp counter (cycles on x86) and include time spent in callees.
+typedef struct bp_function_profile bp_function_profile;
+
+enum {
+    BP_FUNCTION_PROFILE_SIZE = 40,
+};
+
+// Counts a call and returns its start timestamp.
+uint64_t __bp_profile_enter(bp_function_profile* profile);
+void __bp_profile_exit(bp_function_profile* profile, uint64_t start);
+// Writes the report for the records registered so far and forgets them, so it covers each
+// call once. Runs at exit; a host that unloads instrumented code calls it before.
+void __bp_profile_report(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Allocator.h>
+
+#include "commonAST.hpp"
+
+// Owns the AST of one translation unit. Nodes and their child arrays are bump-allocated and
+// released together when the context is destroyed; names are interned once per unit.
+class ASTContext {
+    public:
+        ASTContext() = default;
+        ASTContext(const ASTContext&) = delete;
+        ASTContext& operator=(const ASTContext&) = delete;
+
+        template <typename NodeT, typename... Args>
+        NodeT* create(Args&&... args) {
+            static_assert(std::is_trivially_destructible<NodeT>::value, "AST nodes are never destroyed");
+            return new (allocator.Allocate<NodeT>()) NodeT(std::forward<Args>(args)...);
+        }
+
+        template <typename T>
+        llvm::ArrayRef<T> copyArray(const std::vector<T>& elements) {
+            static_assert(std::is_trivially_destructible<T>::value, "AST arrays are never destroyed");
+            if (elements.empty()) {
+                return {};
+            }
+            T* storage = allocator.Allocate<T>(elements.size());
+            std::uninitialized_copy(elements.begin(), elements.end(), storage);
+            return llvm::ArrayRef<T>(storage, elements.size());
+        }
+
+        llvm::StringRef copyString(std::string_view text) {
+            if (text.empty()) {
+                return {};
+            }
+            char* storage = allocator.Allocate<char>(text.size());
+            std::copy(text.begin(), text.end(), storage);
+            return llvm::StringRef(storage, text.size());
+        }
+
+        Identifier intern(std::string_view text) {
+            auto inserted = identifiers.try_emplace(llvm::StringRef(text.data(), text.size()));
+            if (inserted.second) {
+                inserted.first->second.assign(text.data(), text.size());
+            }
+            return Identifier(inserted.first->second);
+        }
+
+        size_t getBytesAllocated() const { return allocator.getBytesAllocated(); }
+
+    private:
+        llvm::BumpPtrAllocator allocator;
+        llvm::StringMap<std::string> identifiers;
+};
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "classAST.hpp"
 
 #include "../codegen/CodeGenerator.hpp"
@@ -6,6 +8,28 @@ llvm::Value *MethodImplAST::codegen(CodeGenerator& generator) {
     return generator.visit(*this);
 }
 
-llvm::Value *ClassAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
+bool MethodImplAST::isPublic() const {
+    return std::any_of(accessModifiers.begin(), accessModifiers.end(), [](const AccessModifierAST* modifier) {
+        return modifier->getKind() == AccessModifierAST::PUBLIC;
+    });
+}
+
+bool ClassAST::isApplication() const {
+    return std::find(blueprintNames.begin(), blueprintNames.end(), "Application") != blueprintNames.end();
+}
+
+// The entrypoint has a fixed name so the driver finds it whichever class implements Application.
+std::string ClassAST::getMethodSymbolName(const MethodImplAST& method) const {
+    if (isApplication() && method.getName() == "main") {
+        return "System.Application.main";
+    }
+    return getName() + "." + method.getName();
+}
+
+llvm::Value *ProgramAST::codegen(CodeGenerator& generator) {
+    switch (programKind) {
+        case CLASS:
+            return generator.visit(llvm::cast<ClassAST>(*this));
+    }
+    return nullptr;
 }
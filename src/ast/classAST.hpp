@@ -1,8 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <string>
-#include <vector>
-#include <memory>
+#include <llvm/ADT/ArrayRef.h>
 
 #include "programAST.hpp"
 #include "stmtAST.hpp"
@@ -11,7 +11,7 @@
 class CodeGenerator;
 
 class AccessModifierAST {
-	public: 
+	public:
 		enum AccessModifierKind {
 			PUBLIC,
 		};
@@ -25,45 +25,62 @@ class AccessModifierAST {
 
 class MethodImplAST {
 	public:
-		MethodImplAST() = default;
 		MethodImplAST(
-				std::vector<std::unique_ptr<AccessModifierAST>> accessModifiers,
-				std::unique_ptr<TypeAST> returnType, 
-				const std::string &name, 
-				std::vector<std::unique_ptr<TypedIdentifierAST>> params, 
-				std::vector<std::unique_ptr<StmtAST>> body)
-				: accessModifiers(std::move(accessModifiers)), returnType(std::move(returnType)), name(name), params(std::move(params)), body(std::move(body)) {}
+				llvm::ArrayRef<AccessModifierAST*> accessModifiers,
+				const TypeAST* returnType,
+				Identifier name,
+				llvm::ArrayRef<TypedIdentifierAST*> params,
+				llvm::ArrayRef<StmtAST*> body,
+				llvm::ArrayRef<ExprAST*> preconditions = {},
+				llvm::ArrayRef<ExprAST*> postconditions = {})
+				: accessModifiers(accessModifiers), returnType(returnType), name(name), params(params), body(body),
+				  preconditions(preconditions), postconditions(postconditions) {}
 
-		const std::vector<std::unique_ptr<AccessModifierAST>> &getAccessModifiers() const { return accessModifiers; }
-		const TypeAST *getReturnType() const { return returnType.get(); }
-		const std::string &getName() const { return name; }
-		const std::vector<std::unique_ptr<TypedIdentifierAST>> &getParams() const { return params; }
-		const std::vector<std::unique_ptr<StmtAST>> &getBody() const { return body; }
+		llvm::ArrayRef<AccessModifierAST*> getAccessModifiers() const { return accessModifiers; }
+		const TypeAST *getReturnType() const { return returnType; }
+		const std::string &getName() const { return name.str(); }
+		llvm::ArrayRef<TypedIdentifierAST*> getParams() const { return params; }
+		llvm::ArrayRef<StmtAST*> getBody() const { return body; }
+		// Conditions of the requires clauses, checked on entry, and of the ensures clauses,
+		// checked on exit in the scope at the end of the body
+		llvm::ArrayRef<ExprAST*> getPreconditions() const { return preconditions; }
+		llvm::ArrayRef<ExprAST*> getPostconditions() const { return postconditions; }
+		bool isPublic() const;
 		llvm::Value *codegen(CodeGenerator& generator);
 
 	private:
-		std::vector<std::unique_ptr<AccessModifierAST>> accessModifiers;
-		std::unique_ptr<TypeAST> returnType;
-		std::string name;
-		std::vector<std::unique_ptr<TypedIdentifierAST>> params;
-		std::vector<std::unique_ptr<StmtAST>> body;
+		llvm::ArrayRef<AccessModifierAST*> accessModifiers;
+		const TypeAST* returnType;
+		Identifier name;
+		llvm::ArrayRef<TypedIdentifierAST*> params;
+		llvm::ArrayRef<StmtAST*> body;
+		llvm::ArrayRef<ExprAST*> preconditions;
+		llvm::ArrayRef<ExprAST*> postconditions;
 };
 
 class ClassAST : public ProgramAST {
 	public:
-		ClassAST(const std::string &name, 
-				std::vector<std::unique_ptr<MethodImplAST>> methodImpls, 
-				std::vector<std::string> blueprintNames = {})
-			: name(name), methodImpls(std::move(methodImpls)), blueprintNames(std::move(blueprintNames)) {}
+		ClassAST(Identifier name,
+				llvm::ArrayRef<MethodImplAST*> methodImpls,
+				llvm::ArrayRef<Identifier> blueprintNames = {},
+				std::optional<Identifier> genericName = std::nullopt)
+			: ProgramAST(CLASS), name(name), methodImpls(methodImpls), blueprintNames(blueprintNames), genericName(genericName) {}
 
-		const std::string &getName() const { return name; }
-		const std::vector<std::unique_ptr<MethodImplAST>> &getMethodImpls() const { return methodImpls; }
-		const std::vector<std::string> &getBlueprintNames() const { return blueprintNames; }
-		llvm::Value *codegen(CodeGenerator& generator) override;
+		// An instantiation of a generic class is named with its type arguments, e.g. "Sum<i64>"
+		const std::string &getName() const { return name.str(); }
+		llvm::ArrayRef<MethodImplAST*> getMethodImpls() const { return methodImpls; }
+		llvm::ArrayRef<Identifier> getBlueprintNames() const { return blueprintNames; }
+		bool isApplication() const;
+		bool isInstantiation() const { return genericName.has_value(); }
+		// Name of the generic class this class instantiates, e.g. "Sum"
+		const std::string &getGenericName() const { return genericName->str(); }
+		// Name of the LLVM function the method is lowered to
+		std::string getMethodSymbolName(const MethodImplAST& method) const;
+		static bool classof(const ProgramAST* program) { return program->getProgramKind() == CLASS; }
 
 	private:
-		std::string name;
-		std::vector<std::unique_ptr<MethodImplAST>> methodImpls;
-		std::vector<std::string> blueprintNames;
+		Identifier name;
+		llvm::ArrayRef<MethodImplAST*> methodImpls;
+		llvm::ArrayRef<Identifier> blueprintNames;
+		std::optional<Identifier> genericName;
 };
-
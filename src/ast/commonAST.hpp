@@ -1,11 +1,42 @@
 #pragma once
 
 #include <string>
-#include <memory>
+#include <string_view>
+#include <llvm/Support/Casting.h>
 
+// A name interned in the translation unit's ASTContext. Copies share one string, so nodes can
+// hold names without owning them.
+class Identifier {
+    public:
+        explicit Identifier(const std::string& interned) : text(&interned) {}
+
+        const std::string& str() const { return *text; }
+
+        friend bool operator==(const Identifier& lhs, const Identifier& rhs) { return lhs.text == rhs.text; }
+        friend bool operator!=(const Identifier& lhs, const Identifier& rhs) { return lhs.text != rhs.text; }
+        friend bool operator==(const Identifier& lhs, std::string_view rhs) { return *lhs.text == rhs; }
+        friend bool operator!=(const Identifier& lhs, std::string_view rhs) { return *lhs.text != rhs; }
+
+    private:
+        const std::string* text;
+};
+
+// AST nodes are allocated in an ASTContext and never destroyed individually, so every node
+// type is trivially destructible. Hierarchies carry a kind tag for llvm::isa/dyn_cast.
 class TypeAST {
     public:
-        virtual ~TypeAST() = default;
+        enum TypeKind {
+            PRIMITIVE,
+            ARRAY,
+        };
+
+        TypeKind getTypeKind() const { return typeKind; }
+
+    protected:
+        explicit TypeAST(TypeKind typeKind) : typeKind(typeKind) {}
+
+    private:
+        TypeKind typeKind;
 };
 
 class PrimitiveTypeAST : public TypeAST {
@@ -29,31 +60,35 @@ class PrimitiveTypeAST : public TypeAST {
 			VOID,
         };
 
-		PrimitiveTypeAST() = default;
-        PrimitiveTypeAST(PrimitiveKind kind) : kind(kind) {}
+        PrimitiveTypeAST(PrimitiveKind kind) : TypeAST(PRIMITIVE), kind(kind) {}
         PrimitiveKind getKind() const { return kind; }
 
+        static bool classof(const TypeAST* type) { return type->getTypeKind() == PRIMITIVE; }
+
     private:
 		PrimitiveKind kind;
 };
 
 class ArrayTypeAST : public TypeAST {
     public:
-        ArrayTypeAST(std::unique_ptr<TypeAST> elementType) : elementType(std::move(elementType)) {}
-        const TypeAST* getElementType() const { return elementType.get(); }
+        ArrayTypeAST(const TypeAST* elementType) : TypeAST(ARRAY), elementType(elementType) {}
+        const TypeAST* getElementType() const { return elementType; }
+
+        static bool classof(const TypeAST* type) { return type->getTypeKind() == ARRAY; }
+
     private:
-        std::unique_ptr<TypeAST> elementType;
+        const TypeAST* elementType;
 };
 
 class TypedIdentifierAST {
 	public:
-		TypedIdentifierAST(std::unique_ptr<TypeAST> type, const std::string &name)
-			: type(std::move(type)), name(name) {}
+		TypedIdentifierAST(const TypeAST* type, Identifier name)
+			: type(type), name(name) {}
 
-		const TypeAST *getType() const { return type.get(); }
-		const std::string &getName() const { return name; }
+		const TypeAST *getType() const { return type; }
+		const std::string &getName() const { return name.str(); }
 
 	private:
-		std::unique_ptr<TypeAST> type;
-		std::string name;
+		const TypeAST* type;
+		Identifier name;
 };
@@ -1,57 +1,34 @@
 #include "exprAST.hpp"
 #include "../codegen/CodeGenerator.hpp"
 
-// IntegerExprAST codegen - delegates to visitor
-llvm::Value *IntegerExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
+llvm::Value *ExprAST::codegen(CodeGenerator& generator) {
+    switch (exprKind) {
+        case INTEGER:
+            return generator.visit(llvm::cast<IntegerExprAST>(*this));
+        case FLOAT:
+            return generator.visit(llvm::cast<FloatExprAST>(*this));
+        case BOOL:
+            return generator.visit(llvm::cast<BoolExprAST>(*this));
+        case CHAR:
+            return generator.visit(llvm::cast<CharExprAST>(*this));
+        case STR:
+            return generator.visit(llvm::cast<StrExprAST>(*this));
+        case ARRAY_LITERAL:
+            return generator.visit(llvm::cast<ArrayLiteralExprAST>(*this));
+        case ARRAY_NEW:
+            return generator.visit(llvm::cast<ArrayNewExprAST>(*this));
+        case INDEX:
+            return generator.visit(llvm::cast<IndexExprAST>(*this));
+        case IDENTIFIER:
+            return generator.visit(llvm::cast<IdentifierExprAST>(*this));
+        case BINARY:
+            return generator.visit(llvm::cast<BinaryExprAST>(*this));
+        case UNARY:
+            return generator.visit(llvm::cast<UnaryExprAST>(*this));
+        case ARRAY_LENGTH:
+            return generator.visit(llvm::cast<ArrayLengthExprAST>(*this));
+        case FORALL:
+            return generator.visit(llvm::cast<ForallExprAST>(*this));
+    }
+    return nullptr;
 }
-
-// FloatExprAST codegen - delegates to visitor
-llvm::Value *FloatExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// BoolExprAST codegen - delegates to visitor
-llvm::Value *BoolExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// CharExprAST codegen - delegates to visitor
-llvm::Value *CharExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// StrExprAST codegen - delegates to visitor
-llvm::Value *StrExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// IdentifierExprAST codegen - delegates to visitor
-llvm::Value *IdentifierExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// BinaryExprAST codegen - delegates to visitor
-llvm::Value *BinaryExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// UnaryExprAST codegen - delegates to visitor
-llvm::Value *UnaryExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// ArrayLiteralExprAST codegen - delegates to visitor
-llvm::Value *ArrayLiteralExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// ArrayNewExprAST codegen - delegates to visitor
-llvm::Value *ArrayNewExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-// IndexExprAST codegen - delegates to visitor
-llvm::Value *IndexExprAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
\ No newline at end of file
@@ -1,105 +1,190 @@
 #pragma once
 
 #include "commonAST.hpp"
+#include <cstdint>
 #include <string>
-#include <memory>
-#include <vector>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
 #include <llvm/IR/Value.h>
 
 class CodeGenerator;
 
+// A compile-time value of a primitive kind. Integers, bools and chars keep their bits extended
+// to 64 bits by the kind's signedness, floats keep their value (f32 values are exact as
+// doubles) and fractions keep reduced components with a positive denominator.
+struct ConstantValue {
+    PrimitiveTypeAST::PrimitiveKind kind = PrimitiveTypeAST::VOID;
+    uint64_t integerBits = 0;
+    double floatingValue = 0.0;
+    int64_t numerator = 0;
+    int64_t denominator = 1;
+};
+
 class ExprAST {
     public:
-        virtual ~ExprAST() = default;
-		virtual llvm::Value *codegen(CodeGenerator& generator) = 0;
+        enum ExprKind {
+            INTEGER,
+            FLOAT,
+            BOOL,
+            CHAR,
+            STR,
+            ARRAY_LITERAL,
+            ARRAY_NEW,
+            INDEX,
+            IDENTIFIER,
+            BINARY,
+            UNARY,
+            ARRAY_LENGTH,
+            FORALL,
+        };
+
+        ExprKind getExprKind() const { return exprKind; }
+
+        // Resolved by the TypeChecker. Unset for arrays and for operands it cannot type, which
+        // code generation then rejects.
+        bool hasPrimitiveKind() const { return hasKind; }
+        PrimitiveTypeAST::PrimitiveKind getPrimitiveKind() const { return primitiveKind; }
+        void setPrimitiveKind(PrimitiveTypeAST::PrimitiveKind kind) { primitiveKind = kind; hasKind = true; }
+
+        // Set by the TypeChecker on literals and on expressions it evaluated at compile time
+        bool hasConstantValue() const { return hasConstant; }
+        const ConstantValue& getConstantValue() const { return constantValue; }
+        void setConstantValue(const ConstantValue& value) { constantValue = value; hasConstant = true; }
+
+        // Dispatches on the kind tag to the matching CodeGenerator::visit overload
+        llvm::Value *codegen(CodeGenerator& generator);
+
+    protected:
+        explicit ExprAST(ExprKind exprKind) : exprKind(exprKind) {}
+
+    private:
+        ExprKind exprKind;
+        bool hasKind = false;
+        PrimitiveTypeAST::PrimitiveKind primitiveKind = PrimitiveTypeAST::VOID;
+        bool hasConstant = false;
+        ConstantValue constantValue;
 };
 
 class IntegerExprAST : public ExprAST {
     public:
-        IntegerExprAST(long long value) : value(value) {}
+        IntegerExprAST(long long value) : ExprAST(INTEGER), value(value) {}
         long long getValue() const { return value; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == INTEGER; }
     private:
         long long value;
 };
 
 class FloatExprAST : public ExprAST {
     public:
-        FloatExprAST(double value) : value(value) {}
+        FloatExprAST(double value) : ExprAST(FLOAT), value(value) {}
         double getValue() const { return value; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == FLOAT; }
     private:
         double value;
 };
 
 class BoolExprAST : public ExprAST {
     public:
-        BoolExprAST(bool value) : value(value) {}
+        BoolExprAST(bool value) : ExprAST(BOOL), value(value) {}
         bool getValue() const { return value; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == BOOL; }
     private:
         bool value;
 };
 
 class CharExprAST : public ExprAST {
     public:
-        CharExprAST(char value) : value(value) {}
+        CharExprAST(char value) : ExprAST(CHAR), value(value) {}
         char getValue() const { return value; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == CHAR; }
     private:
         char value;
 };
 
 class StrExprAST : public ExprAST {
     public:
-        StrExprAST(const std::string& value) : value(value) {}
-        const std::string& getValue() const { return value; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        // value must be stored in the ASTContext
+        StrExprAST(llvm::StringRef value) : ExprAST(STR), value(value) {}
+        llvm::StringRef getValue() const { return value; }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == STR; }
     private:
-        std::string value;
+        llvm::StringRef value;
 };
 
 class ArrayLiteralExprAST : public ExprAST {
     public:
-        ArrayLiteralExprAST(std::vector<std::unique_ptr<ExprAST>> elements)
-            : elements(std::move(elements)) {}
-        const std::vector<std::unique_ptr<ExprAST>>& getElements() const { return elements; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        ArrayLiteralExprAST(llvm::ArrayRef<ExprAST*> elements)
+            : ExprAST(ARRAY_LITERAL), elements(elements) {}
+        llvm::ArrayRef<ExprAST*> getElements() const { return elements; }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == ARRAY_LITERAL; }
     private:
-        std::vector<std::unique_ptr<ExprAST>> elements;
+        llvm::ArrayRef<ExprAST*> elements;
 };
 
 class ArrayNewExprAST : public ExprAST {
     public:
-        ArrayNewExprAST(std::unique_ptr<TypeAST> elementType, std::unique_ptr<ExprAST> size)
-            : elementType(std::move(elementType)), size(std::move(size)) {}
-        const TypeAST* getElementType() const { return elementType.get(); }
-        ExprAST* getSize() const { return size.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        ArrayNewExprAST(const TypeAST* elementType, ExprAST* size)
+            : ExprAST(ARRAY_NEW), elementType(elementType), size(size) {}
+        const TypeAST* getElementType() const { return elementType; }
+        ExprAST* getSize() const { return size; }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == ARRAY_NEW; }
     private:
-        std::unique_ptr<TypeAST> elementType;
-        std::unique_ptr<ExprAST> size;
+        const TypeAST* elementType;
+        ExprAST* size;
 };
 
 class IndexExprAST : public ExprAST {
     public:
-        IndexExprAST(const std::string& name, std::unique_ptr<ExprAST> index)
-            : name(name), index(std::move(index)) {}
-        const std::string& getName() const { return name; }
-        ExprAST* getIndex() const { return index.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        IndexExprAST(Identifier name, ExprAST* index)
+            : ExprAST(INDEX), name(name), index(index) {}
+        const std::string& getName() const { return name.str(); }
+        ExprAST* getIndex() const { return index; }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == INDEX; }
+    private:
+        Identifier name;
+        ExprAST* index;
+};
+
+// `name.length`
+class ArrayLengthExprAST : public ExprAST {
+    public:
+        ArrayLengthExprAST(Identifier name) : ExprAST(ARRAY_LENGTH), name(name) {}
+        const std::string& getName() const { return name.str(); }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == ARRAY_LENGTH; }
     private:
-        std::string name;
-        std::unique_ptr<ExprAST> index;
+        Identifier name;
+};
+
+// `forall v: lower <= v < upper ==> body`, true if body holds for every integer v in the
+// range. Either comparison may also be the other of < and <=. v is an i64 scoped to body.
+class ForallExprAST : public ExprAST {
+    public:
+        ForallExprAST(Identifier variable, ExprAST* lower, bool lowerInclusive, ExprAST* upper, bool upperInclusive, ExprAST* body)
+            : ExprAST(FORALL), variable(variable), lower(lower), upper(upper), body(body),
+              lowerInclusive(lowerInclusive), upperInclusive(upperInclusive) {}
+        const std::string& getVariable() const { return variable.str(); }
+        ExprAST* getLower() const { return lower; }
+        ExprAST* getUpper() const { return upper; }
+        ExprAST* getBody() const { return body; }
+        bool isLowerInclusive() const { return lowerInclusive; }
+        bool isUpperInclusive() const { return upperInclusive; }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == FORALL; }
+    private:
+        Identifier variable;
+        ExprAST* lower;
+        ExprAST* upper;
+        ExprAST* body;
+        bool lowerInclusive;
+        bool upperInclusive;
 };
 
 class IdentifierExprAST : public ExprAST {
     public:
-        IdentifierExprAST(const std::string &name) : name(name) {}
-        const std::string &getName() const { return name; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        IdentifierExprAST(Identifier name) : ExprAST(IDENTIFIER), name(name) {}
+        const std::string &getName() const { return name.str(); }
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == IDENTIFIER; }
     private:
-        std::string name;
+        Identifier name;
 };
 
 class BinaryExprAST : public ExprAST {
@@ -122,18 +207,26 @@ class BinaryExprAST : public ExprAST {
 		};
 
 
-        BinaryExprAST(int op, std::unique_ptr<ExprAST> lhs, std::unique_ptr<ExprAST> rhs)
-            : op(op), lhs(std::move(lhs)), rhs(std::move(rhs)) {}
-        
+        BinaryExprAST(int op, ExprAST* lhs, ExprAST* rhs)
+            : ExprAST(BINARY), op(op), lhs(lhs), rhs(rhs) {}
+
         int getOp() const { return op; }
-        ExprAST *getLHS() const { return lhs.get(); }
-        ExprAST *getRHS() const { return rhs.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
-        
+        ExprAST *getLHS() const { return lhs; }
+        ExprAST *getRHS() const { return rhs; }
+
+        // The kind both operands are promoted to; for comparisons it differs from the result
+        bool hasOperandKind() const { return hasOperandKindSet; }
+        PrimitiveTypeAST::PrimitiveKind getOperandKind() const { return operandKind; }
+        void setOperandKind(PrimitiveTypeAST::PrimitiveKind kind) { operandKind = kind; hasOperandKindSet = true; }
+
+        static bool classof(const ExprAST* expr) { return expr->getExprKind() == BINARY; }
+
     private:
         int op;
-        std::unique_ptr<ExprAST> lhs;
-        std::unique_ptr<ExprAST> rhs;
+        bool hasOperandKindSet = false;
+        PrimitiveTypeAST::PrimitiveKind operandKind = PrimitiveTypeAST::VOID;
+        ExprAST* lhs;
+        ExprAST* rhs;
 };
 
 class UnaryExprAST : public ExprAST {
@@ -143,15 +236,14 @@ class UnaryExprAST : public ExprAST {
 			LOGICAL_NOT,
 		};
 
-		UnaryExprAST(int op, std::unique_ptr<ExprAST> operand)
-			: op(op), operand(std::move(operand)) {}
-		
+		UnaryExprAST(int op, ExprAST* operand)
+			: ExprAST(UNARY), op(op), operand(operand) {}
+
 		int getOp() const { return op; }
-		ExprAST *getOperand() const { return operand.get(); }
-		llvm::Value *codegen(CodeGenerator& generator) override;
-		
+		ExprAST *getOperand() const { return operand; }
+		static bool classof(const ExprAST* expr) { return expr->getExprKind() == UNARY; }
+
 	private:
 		int op;
-		std::unique_ptr<ExprAST> operand;
+		ExprAST* operand;
 };
-
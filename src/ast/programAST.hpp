@@ -6,7 +6,18 @@ class CodeGenerator;
 
 class ProgramAST {
     public:
-        virtual ~ProgramAST() = default;
-    virtual llvm::Value *codegen(CodeGenerator& generator) = 0;
-};
+        enum ProgramKind {
+            CLASS,
+        };
+
+        ProgramKind getProgramKind() const { return programKind; }
+
+        // Dispatches on the kind tag to the matching CodeGenerator::visit overload
+        llvm::Value *codegen(CodeGenerator& generator);
 
+    protected:
+        explicit ProgramAST(ProgramKind programKind) : programKind(programKind) {}
+
+    private:
+        ProgramKind programKind;
+};
@@ -3,30 +3,22 @@
 #include "exprAST.hpp"
 #include "../codegen/CodeGenerator.hpp"
 
-llvm::Value *VarDeclStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-llvm::Value *AssignmentStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-llvm::Value *IfStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-llvm::Value *WhileStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-llvm::Value *BlockStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-llvm::Value *PrintStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
-}
-
-llvm::Value *IndexAssignStmtAST::codegen(CodeGenerator& generator) {
-    return generator.visit(*this);
+llvm::Value *StmtAST::codegen(CodeGenerator& generator) {
+    switch (stmtKind) {
+        case VAR_DECL:
+            return generator.visit(llvm::cast<VarDeclStmtAST>(*this));
+        case ASSIGNMENT:
+            return generator.visit(llvm::cast<AssignmentStmtAST>(*this));
+        case IF:
+            return generator.visit(llvm::cast<IfStmtAST>(*this));
+        case WHILE:
+            return generator.visit(llvm::cast<WhileStmtAST>(*this));
+        case BLOCK:
+            return generator.visit(llvm::cast<BlockStmtAST>(*this));
+        case PRINT:
+            return generator.visit(llvm::cast<PrintStmtAST>(*this));
+        case INDEX_ASSIGN:
+            return generator.visit(llvm::cast<IndexAssignStmtAST>(*this));
+    }
+    return nullptr;
 }
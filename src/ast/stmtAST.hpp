@@ -1,10 +1,11 @@
 #pragma once
 
-#include <vector>
-#include <memory>
 #include <string>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/IR/Value.h>
 
+#include "commonAST.hpp"
+
 class ExprAST;
 class TypeAST;
 class PatternAST;
@@ -15,111 +16,134 @@ class CodeGenerator;
 
 class StmtAST {
     public:
-        virtual ~StmtAST() = default;
-    virtual llvm::Value *codegen(CodeGenerator& generator) = 0;
+        enum StmtKind {
+            VAR_DECL,
+            ASSIGNMENT,
+            IF,
+            WHILE,
+            BLOCK,
+            PRINT,
+            INDEX_ASSIGN,
+        };
+
+        StmtKind getStmtKind() const { return stmtKind; }
+
+        // Dispatches on the kind tag to the matching CodeGenerator::visit overload
+        llvm::Value *codegen(CodeGenerator& generator);
+
+    protected:
+        explicit StmtAST(StmtKind stmtKind) : stmtKind(stmtKind) {}
+
+    private:
+        StmtKind stmtKind;
 };
 
 class VarDeclStmtAST : public StmtAST {
     public:
-        VarDeclStmtAST(std::unique_ptr<TypeAST> type, const std::string &name, std::unique_ptr<ExprAST> initializer)
-            : type(std::move(type)), name(name), initializer(std::move(initializer)) {}
-        
-        const TypeAST *getType() const { return type.get(); }
-        const std::string &getName() const { return name; }
-        ExprAST *getInitializer() const { return initializer.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
-        
+        VarDeclStmtAST(const TypeAST* type, Identifier name, ExprAST* initializer)
+            : StmtAST(VAR_DECL), type(type), name(name), initializer(initializer) {}
+
+        const TypeAST *getType() const { return type; }
+        const std::string &getName() const { return name.str(); }
+        ExprAST *getInitializer() const { return initializer; }
+
+        // Arrays only: set by the TypeChecker when any element of this declaration is assigned
+        bool hasAssignedElements() const { return assignedElements; }
+        void setAssignedElements() { assignedElements = true; }
+
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == VAR_DECL; }
+
     private:
-        std::unique_ptr<TypeAST> type;
-        std::string name;
-        std::unique_ptr<ExprAST> initializer;
+        const TypeAST* type;
+        Identifier name;
+        ExprAST* initializer;
+        bool assignedElements = false;
 };
 
 class AssignmentStmtAST : public StmtAST {
     public:
-        AssignmentStmtAST(const std::string &name, std::unique_ptr<ExprAST> value)
-            : name(name), value(std::move(value)) {}
-        
-        const std::string &getName() const { return name; }
-        ExprAST *getValue() const { return value.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
-        
+        AssignmentStmtAST(Identifier name, ExprAST* value)
+            : StmtAST(ASSIGNMENT), name(name), value(value) {}
+
+        const std::string &getName() const { return name.str(); }
+        ExprAST *getValue() const { return value; }
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == ASSIGNMENT; }
+
     private:
-        std::string name;
-        std::unique_ptr<ExprAST> value;
+        Identifier name;
+        ExprAST* value;
 };
 
 class IfStmtAST : public StmtAST {
     public:
-        IfStmtAST(std::unique_ptr<ExprAST> condition, 
-                  std::unique_ptr<StmtAST> thenStmt,
-                  std::unique_ptr<StmtAST> elseStmt = nullptr)
-            : condition(std::move(condition)), thenStmt(std::move(thenStmt)), elseStmt(std::move(elseStmt)) {}
-        
-        ExprAST *getCondition() const { return condition.get(); }
-        StmtAST *getThenStmt() const { return thenStmt.get(); }
-        StmtAST *getElseStmt() const { return elseStmt.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
-        
+        IfStmtAST(ExprAST* condition,
+                  StmtAST* thenStmt,
+                  StmtAST* elseStmt = nullptr)
+            : StmtAST(IF), condition(condition), thenStmt(thenStmt), elseStmt(elseStmt) {}
+
+        ExprAST *getCondition() const { return condition; }
+        StmtAST *getThenStmt() const { return thenStmt; }
+        StmtAST *getElseStmt() const { return elseStmt; }
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == IF; }
+
     private:
-        std::unique_ptr<ExprAST> condition;
-        std::unique_ptr<StmtAST> thenStmt;
-        std::unique_ptr<StmtAST> elseStmt;
+        ExprAST* condition;
+        StmtAST* thenStmt;
+        StmtAST* elseStmt;
 };
 
 class WhileStmtAST : public StmtAST {
     public:
-        WhileStmtAST(std::unique_ptr<ExprAST> condition, std::unique_ptr<StmtAST> body)
-            : condition(std::move(condition)), body(std::move(body)) {}
-        
-        ExprAST *getCondition() const { return condition.get(); }
-        StmtAST *getBody() const { return body.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
-        
+        WhileStmtAST(ExprAST* condition, StmtAST* body)
+            : StmtAST(WHILE), condition(condition), body(body) {}
+
+        ExprAST *getCondition() const { return condition; }
+        StmtAST *getBody() const { return body; }
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == WHILE; }
+
     private:
-        std::unique_ptr<ExprAST> condition;
-        std::unique_ptr<StmtAST> body;
+        ExprAST* condition;
+        StmtAST* body;
 };
 
 class BlockStmtAST : public StmtAST {
     public:
-        BlockStmtAST(std::vector<std::unique_ptr<StmtAST>> statements)
-            : statements(std::move(statements)) {}
-        
-        const std::vector<std::unique_ptr<StmtAST>> &getStatements() const { return statements; }
-        llvm::Value *codegen(CodeGenerator& generator) override;
-        
+        BlockStmtAST(llvm::ArrayRef<StmtAST*> statements)
+            : StmtAST(BLOCK), statements(statements) {}
+
+        llvm::ArrayRef<StmtAST*> getStatements() const { return statements; }
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == BLOCK; }
+
     private:
-        std::vector<std::unique_ptr<StmtAST>> statements;
+        llvm::ArrayRef<StmtAST*> statements;
 };
 
 class PrintStmtAST : public StmtAST {
     public:
-        explicit PrintStmtAST(std::unique_ptr<ExprAST> value)
-            : value(std::move(value)) {}
+        explicit PrintStmtAST(ExprAST* value)
+            : StmtAST(PRINT), value(value) {}
 
-        ExprAST *getValue() const { return value.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        ExprAST *getValue() const { return value; }
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == PRINT; }
 
     private:
-        std::unique_ptr<ExprAST> value;
+        ExprAST* value;
 };
 
 class IndexAssignStmtAST : public StmtAST {
     public:
-        IndexAssignStmtAST(const std::string& name,
-                           std::unique_ptr<ExprAST> index,
-                           std::unique_ptr<ExprAST> value)
-            : name(name), index(std::move(index)), value(std::move(value)) {}
+        IndexAssignStmtAST(Identifier name,
+                           ExprAST* index,
+                           ExprAST* value)
+            : StmtAST(INDEX_ASSIGN), name(name), index(index), value(value) {}
 
-        const std::string& getName() const { return name; }
-        ExprAST* getIndex() const { return index.get(); }
-        ExprAST* getValue() const { return value.get(); }
-        llvm::Value *codegen(CodeGenerator& generator) override;
+        const std::string& getName() const { return name.str(); }
+        ExprAST* getIndex() const { return index; }
+        ExprAST* getValue() const { return value; }
+        static bool classof(const StmtAST* stmt) { return stmt->getStmtKind() == INDEX_ASSIGN; }
 
     private:
-        std::string name;
-        std::unique_ptr<ExprAST> index;
-        std::unique_ptr<ExprAST> value;
+        Identifier name;
+        ExprAST* index;
+        ExprAST* value;
 };
-
@@ -2,8 +2,11 @@
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/FunctionComparator.h>
 #include <cstdio>
 #include <algorithm>
 
@@ -11,76 +14,389 @@
 #include "../ast/exprAST.hpp"
 #include "../ast/stmtAST.hpp"
 #include "../ast/commonAST.hpp"
+#include "../support/PhaseScope.hpp"
 
 namespace {
 
+// Heap array storage is aligned to a cache line so vectorized loops never split a load.
+constexpr uint64_t ArrayStorageAlignment = 64;
+
+// Arrays whose length is known at compile time and whose storage fits in this many bytes are
+// placed in the function's frame instead of on the heap.
+constexpr uint64_t StackArrayByteLimit = 4096;
+
+// --contract-quantifiers=sampled and skip leave ranges of up to this many values fully checked.
+constexpr uint64_t QuantifierSampleLimit = 1024;
+
+// A forall runs its range in blocks of this many values with a branch-free reduction inside
+// each block, so the block vectorizes and a failing value still ends the loop early.
+constexpr uint64_t QuantifierBlockSize = 256;
+
+// A while loop of the form `while (iv < bound) { ...; iv = iv + step; }` where bound is a
+// variable, a literal or `array.length`, and the loop body never otherwise writes iv, bound or
+// the arrays it indexes with iv.
+struct CountedLoopShape {
+    std::string inductionVariable;
+    const ExprAST* bound = nullptr;
+    bool inclusiveBound = false;
+    int64_t step = 0;
+    std::set<std::string> arraysIndexedByInduction;
+};
+
+struct LoopBodyFacts {
+    std::set<std::string> assigned;
+    std::set<std::string> declared;
+    std::set<std::string> arraysIndexedByInduction;
+    bool hasUnknownNode = false;
+};
+
+bool isIntegerPrimitiveKind(PrimitiveTypeAST::PrimitiveKind kind) {
+    switch (kind) {
+        case PrimitiveTypeAST::INT8:
+        case PrimitiveTypeAST::INT16:
+        case PrimitiveTypeAST::INT32:
+        case PrimitiveTypeAST::INT64:
+        case PrimitiveTypeAST::UINT8:
+        case PrimitiveTypeAST::UINT16:
+        case PrimitiveTypeAST::UINT32:
+        case PrimitiveTypeAST::UINT64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Integer literals and integer expressions the TypeChecker folded, e.g. `new i32[4 * 1024]`.
 std::optional<int64_t> getStaticIntegerIndex(const ExprAST* expr) {
-    if (const auto* integerExpr = dynamic_cast<const IntegerExprAST*>(expr)) {
+    if (const auto* integerExpr = llvm::dyn_cast_or_null<IntegerExprAST>(expr)) {
         return integerExpr->getValue();
     }
+    if (expr && expr->hasConstantValue() && isIntegerPrimitiveKind(expr->getConstantValue().kind)) {
+        const ConstantValue& value = expr->getConstantValue();
+        if (value.kind == PrimitiveTypeAST::UINT64 && value.integerBits > static_cast<uint64_t>(INT64_MAX)) {
+            return std::nullopt;
+        }
+        return static_cast<int64_t>(value.integerBits);
+    }
     return std::nullopt;
 }
 
+bool isIdentifierNamed(const ExprAST* expr, const std::string& name) {
+    const auto* identifier = llvm::dyn_cast_or_null<IdentifierExprAST>(expr);
+    return identifier && identifier->getName() == name;
 }
 
-CodeGenerator::CodeGenerator()
-    : TheContext(), Builder(TheContext), TheModule(nullptr), NamedValues(), NamedPrimitiveKinds(), ValuePrimitiveKinds(), ExpectedIntegerResultBits(std::nullopt), ExpectedFractionResultKind(std::nullopt), CurrentFunction(nullptr), CurrentClassName(), CurrentClassIsApplication(false) {
-    TheModule = std::make_unique<llvm::Module>("BluePrint", TheContext);
+// Splits an index of the form `v`, `v + c`, `c + v` or `v - c`, with c an integer constant,
+// into v and c.
+std::optional<std::pair<std::string, int64_t>> matchOffsetIndex(const ExprAST* index) {
+    if (const auto* identifier = llvm::dyn_cast_or_null<IdentifierExprAST>(index)) {
+        return std::make_pair(identifier->getName(), int64_t(0));
+    }
+
+    const auto* binary = llvm::dyn_cast_or_null<BinaryExprAST>(index);
+    if (!binary || (binary->getOp() != BinaryExprAST::PLUS && binary->getOp() != BinaryExprAST::MINUS)) {
+        return std::nullopt;
+    }
+
+    const ExprAST* variable = binary->getLHS();
+    std::optional<int64_t> offset = getStaticIntegerIndex(binary->getRHS());
+    if (!llvm::isa<IdentifierExprAST>(variable) && binary->getOp() == BinaryExprAST::PLUS) {
+        variable = binary->getRHS();
+        offset = getStaticIntegerIndex(binary->getLHS());
+    }
+    if (!llvm::isa<IdentifierExprAST>(variable) || !offset) {
+        return std::nullopt;
+    }
+    if (binary->getOp() == BinaryExprAST::MINUS) {
+        if (*offset == INT64_MIN) {
+            return std::nullopt;
+        }
+        offset = -*offset;
+    }
+    return std::make_pair(llvm::cast<IdentifierExprAST>(variable)->getName(), *offset);
 }
 
-llvm::Value* CodeGenerator::logError(const char* str) {
-    fprintf(stderr, "CodeGen Error: %s\n", str);
-    return nullptr;
+// Collects (array, offset) for every `array[variable + offset]` in expr that refers to this
+// binding of variable.
+void collectOffsetAccesses(const ExprAST* expr, const std::string& variable, std::set<std::pair<std::string, int64_t>>& accesses) {
+    if (const auto* binary = llvm::dyn_cast_or_null<BinaryExprAST>(expr)) {
+        collectOffsetAccesses(binary->getLHS(), variable, accesses);
+        collectOffsetAccesses(binary->getRHS(), variable, accesses);
+    } else if (const auto* unary = llvm::dyn_cast_or_null<UnaryExprAST>(expr)) {
+        collectOffsetAccesses(unary->getOperand(), variable, accesses);
+    } else if (const auto* index = llvm::dyn_cast_or_null<IndexExprAST>(expr)) {
+        const auto access = matchOffsetIndex(index->getIndex());
+        if (access && access->first == variable) {
+            accesses.emplace(index->getName(), access->second);
+        }
+        collectOffsetAccesses(index->getIndex(), variable, accesses);
+    } else if (const auto* forall = llvm::dyn_cast_or_null<ForallExprAST>(expr)) {
+        collectOffsetAccesses(forall->getLower(), variable, accesses);
+        collectOffsetAccesses(forall->getUpper(), variable, accesses);
+        if (forall->getVariable() != variable) {
+            collectOffsetAccesses(forall->getBody(), variable, accesses);
+        }
+    }
 }
 
-void CodeGenerator::dumpIR() const {
-    TheModule->print(llvm::outs(), nullptr);
+void collectLoopExprFacts(const ExprAST* expr, const std::string& inductionVariable, LoopBodyFacts& facts) {
+    if (!expr) {
+        return;
+    }
+
+    if (llvm::isa<IntegerExprAST>(expr) || llvm::isa<FloatExprAST>(expr) ||
+        llvm::isa<BoolExprAST>(expr) || llvm::isa<CharExprAST>(expr) ||
+        llvm::isa<StrExprAST>(expr) || llvm::isa<IdentifierExprAST>(expr) ||
+        llvm::isa<ArrayLengthExprAST>(expr)) {
+        return;
+    }
+
+    if (const auto* binary = llvm::dyn_cast<BinaryExprAST>(expr)) {
+        collectLoopExprFacts(binary->getLHS(), inductionVariable, facts);
+        collectLoopExprFacts(binary->getRHS(), inductionVariable, facts);
+    } else if (const auto* unary = llvm::dyn_cast<UnaryExprAST>(expr)) {
+        collectLoopExprFacts(unary->getOperand(), inductionVariable, facts);
+    } else if (const auto* index = llvm::dyn_cast<IndexExprAST>(expr)) {
+        if (isIdentifierNamed(index->getIndex(), inductionVariable)) {
+            facts.arraysIndexedByInduction.insert(index->getName());
+        }
+        collectLoopExprFacts(index->getIndex(), inductionVariable, facts);
+    } else if (const auto* literal = llvm::dyn_cast<ArrayLiteralExprAST>(expr)) {
+        for (const auto& element : literal->getElements()) {
+            collectLoopExprFacts(element, inductionVariable, facts);
+        }
+    } else if (const auto* newExpr = llvm::dyn_cast<ArrayNewExprAST>(expr)) {
+        collectLoopExprFacts(newExpr->getSize(), inductionVariable, facts);
+    } else {
+        facts.hasUnknownNode = true;
+    }
 }
 
-std::unique_ptr<llvm::Module> CodeGenerator::takeModule() {
-    return std::move(TheModule);
+void collectLoopStmtFacts(const StmtAST* stmt, const std::string& inductionVariable, LoopBodyFacts& facts) {
+    if (!stmt) {
+        return;
+    }
+
+    if (const auto* varDecl = llvm::dyn_cast<VarDeclStmtAST>(stmt)) {
+        facts.declared.insert(varDecl->getName());
+        collectLoopExprFacts(varDecl->getInitializer(), inductionVariable, facts);
+    } else if (const auto* assignment = llvm::dyn_cast<AssignmentStmtAST>(stmt)) {
+        facts.assigned.insert(assignment->getName());
+        collectLoopExprFacts(assignment->getValue(), inductionVariable, facts);
+    } else if (const auto* indexAssign = llvm::dyn_cast<IndexAssignStmtAST>(stmt)) {
+        if (isIdentifierNamed(indexAssign->getIndex(), inductionVariable)) {
+            facts.arraysIndexedByInduction.insert(indexAssign->getName());
+        }
+        collectLoopExprFacts(indexAssign->getIndex(), inductionVariable, facts);
+        collectLoopExprFacts(indexAssign->getValue(), inductionVariable, facts);
+    } else if (const auto* ifStmt = llvm::dyn_cast<IfStmtAST>(stmt)) {
+        collectLoopExprFacts(ifStmt->getCondition(), inductionVariable, facts);
+        collectLoopStmtFacts(ifStmt->getThenStmt(), inductionVariable, facts);
+        collectLoopStmtFacts(ifStmt->getElseStmt(), inductionVariable, facts);
+    } else if (const auto* whileStmt = llvm::dyn_cast<WhileStmtAST>(stmt)) {
+        collectLoopExprFacts(whileStmt->getCondition(), inductionVariable, facts);
+        collectLoopStmtFacts(whileStmt->getBody(), inductionVariable, facts);
+    } else if (const auto* block = llvm::dyn_cast<BlockStmtAST>(stmt)) {
+        for (const auto& nested : block->getStatements()) {
+            collectLoopStmtFacts(nested, inductionVariable, facts);
+        }
+    } else if (const auto* print = llvm::dyn_cast<PrintStmtAST>(stmt)) {
+        collectLoopExprFacts(print->getValue(), inductionVariable, facts);
+    } else {
+        facts.hasUnknownNode = true;
+    }
 }
 
-void CodeGenerator::setNamedValue(const std::string& name, llvm::AllocaInst* value) {
-    NamedValues[name] = value;
+bool containsLoop(const ExprAST* expr) {
+    if (llvm::isa_and_nonnull<ForallExprAST>(expr)) {
+        return true;
+    }
+    if (const auto* binary = llvm::dyn_cast_or_null<BinaryExprAST>(expr)) {
+        return containsLoop(binary->getLHS()) || containsLoop(binary->getRHS());
+    }
+    if (const auto* unary = llvm::dyn_cast_or_null<UnaryExprAST>(expr)) {
+        return containsLoop(unary->getOperand());
+    }
+    if (const auto* index = llvm::dyn_cast_or_null<IndexExprAST>(expr)) {
+        return containsLoop(index->getIndex());
+    }
+    if (const auto* literal = llvm::dyn_cast_or_null<ArrayLiteralExprAST>(expr)) {
+        return std::any_of(literal->getElements().begin(), literal->getElements().end(), [](const ExprAST* element) {
+            return containsLoop(element);
+        });
+    }
+    if (const auto* newExpr = llvm::dyn_cast_or_null<ArrayNewExprAST>(expr)) {
+        return containsLoop(newExpr->getSize());
+    }
+    return false;
 }
 
-void CodeGenerator::setNamedPrimitiveKind(const std::string& name, PrimitiveTypeAST::PrimitiveKind kind) {
-    NamedPrimitiveKinds[name] = kind;
+// True if stmt has a while loop or a forall anywhere inside it.
+bool containsLoop(const StmtAST* stmt) {
+    if (llvm::isa_and_nonnull<WhileStmtAST>(stmt)) {
+        return true;
+    }
+    if (const auto* varDecl = llvm::dyn_cast_or_null<VarDeclStmtAST>(stmt)) {
+        return containsLoop(varDecl->getInitializer());
+    }
+    if (const auto* assignment = llvm::dyn_cast_or_null<AssignmentStmtAST>(stmt)) {
+        return containsLoop(assignment->getValue());
+    }
+    if (const auto* indexAssign = llvm::dyn_cast_or_null<IndexAssignStmtAST>(stmt)) {
+        return containsLoop(indexAssign->getIndex()) || containsLoop(indexAssign->getValue());
+    }
+    if (const auto* ifStmt = llvm::dyn_cast_or_null<IfStmtAST>(stmt)) {
+        return containsLoop(ifStmt->getCondition()) || containsLoop(ifStmt->getThenStmt()) || containsLoop(ifStmt->getElseStmt());
+    }
+    if (const auto* block = llvm::dyn_cast_or_null<BlockStmtAST>(stmt)) {
+        return std::any_of(block->getStatements().begin(), block->getStatements().end(), [](const StmtAST* nested) {
+            return containsLoop(nested);
+        });
+    }
+    if (const auto* print = llvm::dyn_cast_or_null<PrintStmtAST>(stmt)) {
+        return containsLoop(print->getValue());
+    }
+    return false;
 }
 
-bool CodeGenerator::getNamedPrimitiveKind(const std::string& name, PrimitiveTypeAST::PrimitiveKind& outKind) const {
-    auto it = NamedPrimitiveKinds.find(name);
-    if (it == NamedPrimitiveKinds.end()) {
-        return false;
+std::optional<CountedLoopShape> matchCountedLoop(const WhileStmtAST& node) {
+    const auto* condition = llvm::dyn_cast_or_null<BinaryExprAST>(node.getCondition());
+    if (!condition || (condition->getOp() != BinaryExprAST::LESS_THAN && condition->getOp() != BinaryExprAST::LESS_EQUAL)) {
+        return std::nullopt;
     }
 
-    outKind = it->second;
-    return true;
-}
+    const auto* inductionExpr = llvm::dyn_cast_or_null<IdentifierExprAST>(condition->getLHS());
+    if (!inductionExpr) {
+        return std::nullopt;
+    }
 
-void CodeGenerator::setValuePrimitiveKind(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind kind) {
-    if (value) {
-        ValuePrimitiveKinds[value] = kind;
+    const ExprAST* bound = condition->getRHS();
+    const auto* boundIdentifier = llvm::dyn_cast_or_null<IdentifierExprAST>(bound);
+    const auto* boundLength = llvm::dyn_cast_or_null<ArrayLengthExprAST>(bound);
+    if (!boundIdentifier && !boundLength && !llvm::dyn_cast_or_null<IntegerExprAST>(bound)) {
+        return std::nullopt;
     }
+
+    const auto* body = llvm::dyn_cast_or_null<BlockStmtAST>(node.getBody());
+    if (!body || body->getStatements().empty()) {
+        return std::nullopt;
+    }
+
+    // The increment must be the final top-level statement, so iv < bound holds for every
+    // access that precedes it in the iteration.
+    const std::string& inductionVariable = inductionExpr->getName();
+    const auto* increment = llvm::dyn_cast<AssignmentStmtAST>(body->getStatements().back());
+    if (!increment || increment->getName() != inductionVariable) {
+        return std::nullopt;
+    }
+
+    const auto* incrementValue = llvm::dyn_cast_or_null<BinaryExprAST>(increment->getValue());
+    if (!incrementValue || incrementValue->getOp() != BinaryExprAST::PLUS || !isIdentifierNamed(incrementValue->getLHS(), inductionVariable)) {
+        return std::nullopt;
+    }
+
+    const std::optional<int64_t> step = getStaticIntegerIndex(incrementValue->getRHS());
+    if (!step || *step <= 0) {
+        return std::nullopt;
+    }
+
+    LoopBodyFacts facts;
+    collectLoopExprFacts(node.getCondition(), inductionVariable, facts);
+    for (size_t i = 0; i + 1 < body->getStatements().size(); ++i) {
+        collectLoopStmtFacts(body->getStatements()[i], inductionVariable, facts);
+    }
+
+    if (facts.hasUnknownNode || facts.assigned.count(inductionVariable) || facts.declared.count(inductionVariable)) {
+        return std::nullopt;
+    }
+    if (boundIdentifier && (facts.assigned.count(boundIdentifier->getName()) || facts.declared.count(boundIdentifier->getName()))) {
+        return std::nullopt;
+    }
+    // Arrays are never reassigned as a whole, so only a redeclaration could change the length.
+    if (boundLength && facts.declared.count(boundLength->getName())) {
+        return std::nullopt;
+    }
+
+    CountedLoopShape shape;
+    shape.inductionVariable = inductionVariable;
+    shape.bound = bound;
+    shape.inclusiveBound = condition->getOp() == BinaryExprAST::LESS_EQUAL;
+    shape.step = *step;
+    for (const std::string& arrayName : facts.arraysIndexedByInduction) {
+        if (!facts.declared.count(arrayName)) {
+            shape.arraysIndexedByInduction.insert(arrayName);
+        }
+    }
+
+    if (shape.arraysIndexedByInduction.empty()) {
+        return std::nullopt;
+    }
+    return shape;
 }
 
-bool CodeGenerator::getValuePrimitiveKind(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind& outKind) const {
-    if (!value) {
-        return false;
+// The integer last stored to slot in block, if block stores one. Scalar locals never have their
+// address taken, so nothing after that store in the block can have changed the slot.
+std::optional<llvm::APInt> findStoredConstant(llvm::BasicBlock* block, llvm::AllocaInst* slot) {
+    for (auto instruction = block->rbegin(); instruction != block->rend(); ++instruction) {
+        const auto* store = llvm::dyn_cast<llvm::StoreInst>(&*instruction);
+        if (!store || store->getPointerOperand() != slot) {
+            continue;
+        }
+        if (const auto* constant = llvm::dyn_cast<llvm::ConstantInt>(store->getValueOperand())) {
+            return constant->getValue();
+        }
+        return std::nullopt;
     }
+    return std::nullopt;
+}
+
+}
+
+CodeGenerator::CodeGenerator(CodeGenOptions options)
+    : Options(options), OwnedContext(std::make_unique<llvm::LLVMContext>()), TheContext(*OwnedContext), Builder(TheContext), TheModule(nullptr), Symbols(), CurrentFunction(nullptr), CurrentBoundsTrapBlock(nullptr), CurrentClass(nullptr) {
+    TheModule = std::make_unique<llvm::Module>("BluePrint", TheContext);
+}
+
+llvm::Value* CodeGenerator::logError(const char* str) {
+    fprintf(stderr, "CodeGen Error: %s\n", str);
+    return nullptr;
+}
+
+void CodeGenerator::dumpIR() const {
+    TheModule->print(llvm::outs(), nullptr);
+}
+
+// TheContext and Builder still refer to the handed-over context, so nothing may use them once
+// TheModule is gone.
+GeneratedModule CodeGenerator::takeModule() {
+    Builder.ClearInsertionPoint();
+    Symbols = ScopedSymbolTable<Symbol>();
+    ProvenInBoundsAccesses.clear();
+    InstantiatedMethods.clear();
+    CurrentFunctionArrays.clear();
+    CurrentFunction = nullptr;
+    CurrentBoundsTrapBlock = nullptr;
+    return {std::move(OwnedContext), std::move(TheModule)};
+}
+
+Symbol& CodeGenerator::declareNamedValue(const std::string& name, llvm::AllocaInst* value) {
+    Symbol& symbol = Symbols.declare(name);
+    symbol.storage = value;
+    return symbol;
+}
 
-    auto it = ValuePrimitiveKinds.find(value);
-    if (it == ValuePrimitiveKinds.end()) {
+bool CodeGenerator::getNamedPrimitiveKind(const std::string& name, PrimitiveTypeAST::PrimitiveKind& outKind) const {
+    const Symbol* symbol = Symbols.lookup(name);
+    if (!symbol || !symbol->primitiveKind) {
         return false;
     }
 
-    outKind = it->second;
+    outKind = *symbol->primitiveKind;
     return true;
 }
 
 const PrimitiveTypeAST* CodeGenerator::getPrimitiveType(const TypeAST* typeAST) const {
-    return dynamic_cast<const PrimitiveTypeAST*>(typeAST);
+    return llvm::dyn_cast_or_null<PrimitiveTypeAST>(typeAST);
 }
 
 bool CodeGenerator::isUnsignedPrimitiveKind(PrimitiveTypeAST::PrimitiveKind kind) const {
@@ -91,9 +407,9 @@ bool CodeGenerator::isFractionalPrimitiveKind(PrimitiveTypeAST::PrimitiveKind ki
     return kind == PrimitiveTypeAST::FRACTIONAL32 || kind == PrimitiveTypeAST::FRACTIONAL64;
 }
 
+// Fractions are the only {iN, iN} structs the generator emits, so the LLVM type identifies them.
 bool CodeGenerator::isFractionalValue(llvm::Value* value) const {
-    PrimitiveTypeAST::PrimitiveKind kind;
-    return getValuePrimitiveKind(value, kind) && isFractionalPrimitiveKind(kind);
+    return value && isFractionalPrimitiveKind(getFractionalPrimitiveKindForType(value->getType()));
 }
 
 unsigned CodeGenerator::getFractionalComponentBitWidth(PrimitiveTypeAST::PrimitiveKind kind) const {
@@ -143,6 +459,8 @@ llvm::StructType* CodeGenerator::getFractionalLLVMType(PrimitiveTypeAST::Primiti
     return llvm::StructType::get(TheContext, {componentType, componentType});
 }
 
+// Binary (Stein's) GCD: strips common powers of two with cttz and replaces the division
+// loop of Euclid's algorithm with subtractions and shifts.
 llvm::Function* CodeGenerator::getOrCreateGcdFunction(unsigned bitWidth) {
     const std::string name = "__blueprint_gcd_i" + std::to_string(bitWidth);
     if (llvm::Function* existing = TheModule->getFunction(name)) {
@@ -154,46 +472,58 @@ llvm::Function* CodeGenerator::getOrCreateGcdFunction(unsigned bitWidth) {
     llvm::Function* gcdFunc = llvm::Function::Create(
         funcTy, llvm::Function::InternalLinkage, name, TheModule.get());
     gcdFunc->addFnAttr(llvm::Attribute::NoUnwind);
+    gcdFunc->addFnAttr(llvm::Attribute::InlineHint);
 
     llvm::Value* argA = gcdFunc->getArg(0);
     llvm::Value* argB = gcdFunc->getArg(1);
     argA->setName("a");
     argB->setName("b");
 
-    llvm::BasicBlock* entryBB  = llvm::BasicBlock::Create(TheContext, "entry",  gcdFunc);
-    llvm::BasicBlock* loopBB   = llvm::BasicBlock::Create(TheContext, "loop",   gcdFunc);
-    llvm::BasicBlock* bodyBB   = llvm::BasicBlock::Create(TheContext, "body",   gcdFunc);
-    llvm::BasicBlock* returnBB = llvm::BasicBlock::Create(TheContext, "return", gcdFunc);
+    llvm::BasicBlock* entryBB   = llvm::BasicBlock::Create(TheContext, "entry",   gcdFunc);
+    llvm::BasicBlock* trivialBB = llvm::BasicBlock::Create(TheContext, "trivial", gcdFunc);
+    llvm::BasicBlock* prepBB    = llvm::BasicBlock::Create(TheContext, "prep",    gcdFunc);
+    llvm::BasicBlock* loopBB    = llvm::BasicBlock::Create(TheContext, "loop",    gcdFunc);
+    llvm::BasicBlock* returnBB  = llvm::BasicBlock::Create(TheContext, "return",  gcdFunc);
 
-    // entry: take absolute values so negative numerators don't break GCD
+    // entry: take absolute values so negative numerators don't break GCD. The magnitudes are
+    // treated as unsigned from here on, which also covers the minimum signed value.
     llvm::IRBuilder<> b(entryBB);
     llvm::Value* zero = llvm::ConstantInt::get(intTy, 0, true);
+    llvm::Value* one = llvm::ConstantInt::get(intTy, 1, true);
     llvm::Value* absA = b.CreateSelect(b.CreateICmpSLT(argA, zero), b.CreateNeg(argA, "neg.a"), argA, "abs.a");
     llvm::Value* absB = b.CreateSelect(b.CreateICmpSLT(argB, zero), b.CreateNeg(argB, "neg.b"), argB, "abs.b");
+    llvm::Value* anyZero = b.CreateOr(b.CreateICmpEQ(absA, zero), b.CreateICmpEQ(absB, zero), "any.zero");
+    b.CreateCondBr(anyZero, trivialBB, prepBB);
+
+    // trivial: gcd(x, 0) == x; guard against gcd==0 (both inputs were 0)
+    b.SetInsertPoint(trivialBB);
+    llvm::Value* other = b.CreateOr(absA, absB, "other");
+    b.CreateRet(b.CreateSelect(b.CreateICmpEQ(other, zero), one, other, "safe.gcd"));
+
+    // prep: remember the shared power of two, then make a odd
+    b.SetInsertPoint(prepBB);
+    llvm::Value* trueValue = b.getTrue();
+    llvm::Value* sharedShift = b.CreateIntrinsic(llvm::Intrinsic::cttz, {intTy}, {b.CreateOr(absA, absB), trueValue}, nullptr, "shared.shift");
+    llvm::Value* oddA = b.CreateLShr(absA, b.CreateIntrinsic(llvm::Intrinsic::cttz, {intTy}, {absA, trueValue}), "odd.a");
     b.CreateBr(loopBB);
 
-    // loop header: phi nodes for (a, b)
+    // loop: with a odd, strip b's factors of two, then (a, b) = (min, max - min)
     b.SetInsertPoint(loopBB);
     llvm::PHINode* phiA = b.CreatePHI(intTy, 2, "phi.a");
     llvm::PHINode* phiB = b.CreatePHI(intTy, 2, "phi.b");
-    phiA->addIncoming(absA, entryBB);
-    phiB->addIncoming(absB, entryBB);
-    llvm::Value* bIsZero = b.CreateICmpEQ(phiB, zero, "b.is.zero");
-    b.CreateCondBr(bIsZero, returnBB, bodyBB);
-
-    // body: a = b, b = a % b  (Euclidean step)
-    b.SetInsertPoint(bodyBB);
-    llvm::Value* rem = b.CreateSRem(phiA, phiB, "rem");
-    phiA->addIncoming(phiB, bodyBB);
-    phiB->addIncoming(rem,  bodyBB);
-    b.CreateBr(loopBB);
-
-    // return: when b == 0, a holds the GCD; guard against gcd==0 (both inputs were 0)
+    phiA->addIncoming(oddA, prepBB);
+    phiB->addIncoming(absB, prepBB);
+    llvm::Value* oddB = b.CreateLShr(phiB, b.CreateIntrinsic(llvm::Intrinsic::cttz, {intTy}, {phiB, trueValue}), "odd.b");
+    llvm::Value* smaller = b.CreateBinaryIntrinsic(llvm::Intrinsic::umin, phiA, oddB, nullptr, "min");
+    llvm::Value* larger = b.CreateBinaryIntrinsic(llvm::Intrinsic::umax, phiA, oddB, nullptr, "max");
+    llvm::Value* difference = b.CreateSub(larger, smaller, "diff");
+    phiA->addIncoming(smaller, loopBB);
+    phiB->addIncoming(difference, loopBB);
+    b.CreateCondBr(b.CreateICmpEQ(difference, zero, "diff.is.zero"), returnBB, loopBB);
+
+    // return: restore the shared power of two
     b.SetInsertPoint(returnBB);
-    llvm::Value* one = llvm::ConstantInt::get(intTy, 1, true);
-    llvm::Value* gcdIsZero = b.CreateICmpEQ(phiA, zero, "gcd.is.zero");
-    llvm::Value* safeGcd = b.CreateSelect(gcdIsZero, one, phiA, "safe.gcd");
-    b.CreateRet(safeGcd);
+    b.CreateRet(b.CreateShl(smaller, sharedShift, "gcd"));
 
     return gcdFunc;
 }
@@ -204,13 +534,33 @@ llvm::Value* CodeGenerator::buildFractionValue(llvm::Value* numerator, llvm::Val
     }
 
     llvm::Type* componentType = getFractionalComponentType(kind);
+    const unsigned bitWidth = getFractionalComponentBitWidth(kind);
+
+    // Overflow-checked modes reduce at the incoming width, so only values that are still too
+    // wide in lowest terms reach the overflow handling.
+    const unsigned incomingBits = std::max(numerator->getType()->getIntegerBitWidth(), denominator->getType()->getIntegerBitWidth());
+    if (Options.fractionOverflow != FractionOverflowMode::Wrap && incomingBits > bitWidth) {
+        llvm::Type* wideType = llvm::Type::getIntNTy(TheContext, incomingBits);
+        numerator = castValueToType(numerator, wideType);
+        denominator = castValueToType(denominator, wideType);
+        normalizeFractionSign(numerator, denominator);
+
+        llvm::Value* gcd = Builder.CreateCall(getOrCreateGcdFunction(incomingBits), {numerator, denominator}, "fr.gcd");
+        llvm::Value* narrowNumerator = nullptr;
+        llvm::Value* narrowDenominator = nullptr;
+        narrowFractionComponents(
+            Builder.CreateSDiv(numerator, gcd, "fr.red.num"),
+            Builder.CreateSDiv(denominator, gcd, "fr.red.den"),
+            kind, narrowNumerator, narrowDenominator);
+        return assembleFractionValue(narrowNumerator, narrowDenominator, kind);
+    }
+
     numerator = castValueToType(numerator, componentType);
     denominator = castValueToType(denominator, componentType);
     if (!numerator || !denominator) {
         return nullptr;
     }
 
-    const unsigned bitWidth = getFractionalComponentBitWidth(kind);
     llvm::Type* intTy = componentType;
     llvm::Value* zero = llvm::ConstantInt::get(intTy, 0, true);
     llvm::Value* one  = llvm::ConstantInt::get(intTy, 1, true);
@@ -231,14 +581,156 @@ llvm::Value* CodeGenerator::buildFractionValue(llvm::Value* numerator, llvm::Val
     numerator   = Builder.CreateSDiv(numerator,   gcd, "fr.red.num");
     denominator = Builder.CreateSDiv(denominator, gcd, "fr.red.den");
 
+    return assembleFractionValue(numerator, denominator, kind);
+}
+
+llvm::Value* CodeGenerator::assembleFractionValue(llvm::Value* numerator, llvm::Value* denominator, PrimitiveTypeAST::PrimitiveKind kind) {
     llvm::StructType* fractionType = getFractionalLLVMType(kind);
     llvm::Value* result = llvm::UndefValue::get(fractionType);
     result = Builder.CreateInsertValue(result, numerator,   {0}, "fr.set.num");
     result = Builder.CreateInsertValue(result, denominator, {1}, "fr.set.den");
-    setValuePrimitiveKind(result, kind);
     return result;
 }
 
+// Lazy normalization: the widened arithmetic result is only reduced when it does not fit the
+// component width. Otherwise it is narrowed as-is, and normalizeFractionValue reduces it once
+// it is stored or printed. Comparisons cross-multiply in the widened type, so they are exact
+// on unreduced operands.
+llvm::Value* CodeGenerator::buildLazyFractionResult(llvm::Value* wideNumerator, llvm::Value* wideDenominator, PrimitiveTypeAST::PrimitiveKind kind) {
+    llvm::Type* calcType = wideNumerator->getType();
+    llvm::Type* componentType = getFractionalComponentType(kind);
+    normalizeFractionSign(wideNumerator, wideDenominator);
+
+    llvm::Value* narrowNumerator = Builder.CreateTrunc(wideNumerator, componentType, "fr.lazy.num");
+    llvm::Value* narrowDenominator = Builder.CreateTrunc(wideDenominator, componentType, "fr.lazy.den");
+    llvm::Value* numeratorFits = Builder.CreateICmpEQ(Builder.CreateSExt(narrowNumerator, calcType), wideNumerator, "fr.num.fits");
+    llvm::Value* denominatorFits = Builder.CreateICmpEQ(Builder.CreateSExt(narrowDenominator, calcType), wideDenominator, "fr.den.fits");
+    llvm::Value* fits = Builder.CreateAnd(numeratorFits, denominatorFits, "fr.fits");
+
+    llvm::BasicBlock* fitsBlock = Builder.GetInsertBlock();
+    llvm::Function* function = fitsBlock->getParent();
+    llvm::BasicBlock* reduceBlock = llvm::BasicBlock::Create(TheContext, "fr.reduce", function);
+    llvm::BasicBlock* mergeBlock = llvm::BasicBlock::Create(TheContext, "fr.merge", function);
+    llvm::MDBuilder metadataBuilder(TheContext);
+    Builder.CreateCondBr(fits, mergeBlock, reduceBlock, metadataBuilder.createBranchWeights(1u << 20, 1));
+
+    // Too wide: reduce before narrowing so representable results are not wrapped.
+    Builder.SetInsertPoint(reduceBlock);
+    llvm::Function* gcdFunc = getOrCreateGcdFunction(calcType->getIntegerBitWidth());
+    llvm::Value* gcd = Builder.CreateCall(gcdFunc, {wideNumerator, wideDenominator}, "fr.gcd");
+    llvm::Value* reducedNumerator = nullptr;
+    llvm::Value* reducedDenominator = nullptr;
+    narrowFractionComponents(
+        Builder.CreateSDiv(wideNumerator, gcd, "fr.red.num"),
+        Builder.CreateSDiv(wideDenominator, gcd, "fr.red.den"),
+        kind, reducedNumerator, reducedDenominator);
+    llvm::BasicBlock* reducedBlock = Builder.GetInsertBlock();
+    Builder.CreateBr(mergeBlock);
+
+    Builder.SetInsertPoint(mergeBlock);
+    llvm::PHINode* numerator = Builder.CreatePHI(componentType, 2, "fr.num");
+    numerator->addIncoming(narrowNumerator, fitsBlock);
+    numerator->addIncoming(reducedNumerator, reducedBlock);
+    llvm::PHINode* denominator = Builder.CreatePHI(componentType, 2, "fr.den");
+    denominator->addIncoming(narrowDenominator, fitsBlock);
+    denominator->addIncoming(reducedDenominator, reducedBlock);
+
+    return assembleFractionValue(numerator, denominator, kind);
+}
+
+// Makes the denominator positive; a zero denominator becomes 1 (degenerate guard).
+void CodeGenerator::normalizeFractionSign(llvm::Value*& numerator, llvm::Value*& denominator) {
+    llvm::Type* intTy = denominator->getType();
+    llvm::Value* zero = llvm::ConstantInt::get(intTy, 0, true);
+    llvm::Value* one = llvm::ConstantInt::get(intTy, 1, true);
+    llvm::Value* denIsNeg = Builder.CreateICmpSLT(denominator, zero, "den.is.neg");
+    llvm::Value* denIsZero = Builder.CreateICmpEQ(denominator, zero, "den.is.zero");
+    numerator = Builder.CreateSelect(denIsNeg, Builder.CreateNeg(numerator), numerator, "fr.sign.num");
+    denominator = Builder.CreateSelect(denIsNeg, Builder.CreateNeg(denominator), denominator, "fr.sign.den");
+    denominator = Builder.CreateSelect(denIsZero, one, denominator, "fr.den.safe");
+}
+
+// Narrows reduced wide components (positive denominator) to the fraction's component width,
+// applying the configured overflow mode when they do not fit.
+void CodeGenerator::narrowFractionComponents(llvm::Value* wideNumerator, llvm::Value* wideDenominator, PrimitiveTypeAST::PrimitiveKind kind, llvm::Value*& outNumerator, llvm::Value*& outDenominator) {
+    llvm::Type* componentType = getFractionalComponentType(kind);
+    llvm::Type* wideType = wideNumerator->getType();
+    const unsigned componentBits = getFractionalComponentBitWidth(kind);
+
+    if (Options.fractionOverflow == FractionOverflowMode::Trap) {
+        llvm::Value* numeratorFits = Builder.CreateICmpEQ(Builder.CreateSExt(Builder.CreateTrunc(wideNumerator, componentType), wideType), wideNumerator, "fr.num.fits");
+        llvm::Value* denominatorFits = Builder.CreateICmpEQ(Builder.CreateSExt(Builder.CreateTrunc(wideDenominator, componentType), wideType), wideDenominator, "fr.den.fits");
+        createTrapIf(Builder.CreateNot(Builder.CreateAnd(numeratorFits, denominatorFits)), "fr.overflow");
+    } else if (Options.fractionOverflow == FractionOverflowMode::Saturate) {
+        // |value| beyond the component range clamps to +-max/1. In-range values whose
+        // components are too wide drop the same number of low bits from both components.
+        const unsigned wideBits = wideType->getIntegerBitWidth();
+        llvm::Value* zero = llvm::ConstantInt::get(wideType, 0);
+        llvm::Value* one = llvm::ConstantInt::get(wideType, 1);
+        llvm::Value* maxComponent = llvm::ConstantInt::get(wideType, llvm::APInt::getSignedMaxValue(componentBits).zext(wideBits));
+        llvm::Value* isNegative = Builder.CreateICmpSLT(wideNumerator, zero, "fr.sat.neg");
+        llvm::Value* magnitude = Builder.CreateSelect(isNegative, Builder.CreateNeg(wideNumerator), wideNumerator, "fr.sat.mag");
+        llvm::Value* outOfRange = Builder.CreateICmpUGT(Builder.CreateUDiv(magnitude, wideDenominator), maxComponent, "fr.sat.range");
+
+        llvm::Value* leadingZeros = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::umin,
+            Builder.CreateIntrinsic(llvm::Intrinsic::ctlz, {wideType}, {magnitude, Builder.getFalse()}),
+            Builder.CreateIntrinsic(llvm::Intrinsic::ctlz, {wideType}, {wideDenominator, Builder.getFalse()}));
+        llvm::Value* significantBits = Builder.CreateSub(llvm::ConstantInt::get(wideType, wideBits), leadingZeros, "fr.sat.bits");
+        llvm::Value* keptBits = llvm::ConstantInt::get(wideType, componentBits - 1);
+        llvm::Value* shift = Builder.CreateSelect(Builder.CreateICmpUGT(significantBits, keptBits), Builder.CreateSub(significantBits, keptBits), zero, "fr.sat.shift");
+        llvm::Value* shiftedNumerator = Builder.CreateLShr(magnitude, shift);
+        llvm::Value* shiftedDenominator = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::umax, Builder.CreateLShr(wideDenominator, shift), one);
+
+        llvm::Value* clampedNumerator = Builder.CreateSelect(outOfRange, maxComponent, shiftedNumerator, "fr.sat.num");
+        wideDenominator = Builder.CreateSelect(outOfRange, one, shiftedDenominator, "fr.sat.den");
+        wideNumerator = Builder.CreateSelect(isNegative, Builder.CreateNeg(clampedNumerator), clampedNumerator);
+    }
+
+    outNumerator = Builder.CreateTrunc(wideNumerator, componentType, "fr.narrow.num");
+    outDenominator = Builder.CreateTrunc(wideDenominator, componentType, "fr.narrow.den");
+}
+
+// Whether expr lowers to a fraction that lazy arithmetic left unreduced. Only fraction
+// arithmetic produces one: anything loaded from a variable was reduced when it was stored, and
+// folded constants are built reduced.
+bool CodeGenerator::isUnreducedFraction(const ExprAST* expr) const {
+    const auto* binary = llvm::dyn_cast_or_null<BinaryExprAST>(expr);
+    if (Options.fractionNormalization != FractionNormalization::Lazy || !binary || binary->hasConstantValue() || !binary->hasOperandKind()) {
+        return false;
+    }
+
+    switch (binary->getOp()) {
+        case BinaryExprAST::PLUS:
+        case BinaryExprAST::MINUS:
+        case BinaryExprAST::MULTIPLY:
+        case BinaryExprAST::DIVIDE:
+            return isFractionalPrimitiveKind(binary->getOperandKind());
+        default:
+            return false;
+    }
+}
+
+// Returns value, the lowered expr, reduced by its GCD if it is an unreduced fraction, and value
+// itself otherwise.
+llvm::Value* CodeGenerator::normalizeFractionValue(llvm::Value* value, const ExprAST* expr) {
+    if (!value || !isUnreducedFraction(expr)) {
+        return value;
+    }
+
+    const PrimitiveTypeAST::PrimitiveKind kind = getFractionalPrimitiveKindForType(value->getType());
+    llvm::Value* numerator = nullptr;
+    llvm::Value* denominator = nullptr;
+    if (!decomposeFractionValue(value, kind, numerator, denominator)) {
+        return value;
+    }
+
+    llvm::Function* gcdFunc = getOrCreateGcdFunction(getFractionalComponentBitWidth(kind));
+    llvm::Value* gcd = Builder.CreateCall(gcdFunc, {numerator, denominator}, "fr.gcd");
+    numerator = Builder.CreateSDiv(numerator, gcd, "fr.red.num");
+    denominator = Builder.CreateSDiv(denominator, gcd, "fr.red.den");
+    return assembleFractionValue(numerator, denominator, kind);
+}
+
 bool CodeGenerator::decomposeFractionValue(llvm::Value* fractionValue, PrimitiveTypeAST::PrimitiveKind kind, llvm::Value*& numerator, llvm::Value*& denominator) {
     if (!fractionValue || !isFractionalPrimitiveKind(kind)) {
         return false;
@@ -253,18 +745,22 @@ bool CodeGenerator::decomposeFractionValue(llvm::Value* fractionValue, Primitive
     return numerator && denominator;
 }
 
-llvm::Value* CodeGenerator::castIntegerToFraction(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind targetKind) {
+llvm::Value* CodeGenerator::castIntegerToFraction(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind targetKind, bool sourceUnsigned) {
     if (!value || !value->getType()->isIntegerTy() || !isFractionalPrimitiveKind(targetKind)) {
         return nullptr;
     }
 
     llvm::Type* componentType = getFractionalComponentType(targetKind);
-    llvm::Value* numerator = castValueToType(value, componentType);
+    llvm::Value* numerator = castValueToType(value, componentType, sourceUnsigned);
     if (!numerator) {
         return nullptr;
     }
 
     llvm::Value* denominator = llvm::ConstantInt::get(componentType, 1, true);
+    if (Options.fractionNormalization == FractionNormalization::Lazy || llvm::isa<llvm::Constant>(numerator)) {
+        // n/1 is already in lowest terms; constants need no runtime GCD call to confirm it.
+        return assembleFractionValue(numerator, denominator, targetKind);
+    }
     return buildFractionValue(numerator, denominator, targetKind);
 }
 
@@ -273,11 +769,7 @@ llvm::Value* CodeGenerator::castFractionToFloatingPoint(llvm::Value* value, llvm
         return nullptr;
     }
 
-    PrimitiveTypeAST::PrimitiveKind kind;
-    if (!getValuePrimitiveKind(value, kind) || !isFractionalPrimitiveKind(kind)) {
-        return nullptr;
-    }
-
+    const PrimitiveTypeAST::PrimitiveKind kind = getFractionalPrimitiveKindForType(value->getType());
     llvm::Value* numerator = nullptr;
     llvm::Value* denominator = nullptr;
     if (!decomposeFractionValue(value, kind, numerator, denominator)) {
@@ -293,38 +785,18 @@ llvm::Value* CodeGenerator::castFractionToFloatingPoint(llvm::Value* value, llvm
     return Builder.CreateFDiv(numeratorFloat, denominatorFloat, "fr.tofp");
 }
 
-llvm::Value* CodeGenerator::createFractionArithmetic(int op, llvm::Value* leftValue, llvm::Value* rightValue) {
+// targetKind is the operand kind the TypeChecker resolved for the expression.
+llvm::Value* CodeGenerator::createFractionArithmetic(int op, llvm::Value* leftValue, bool leftUnsigned, llvm::Value* rightValue, bool rightUnsigned, PrimitiveTypeAST::PrimitiveKind targetKind) {
     if (!leftValue || !rightValue) {
         return nullptr;
     }
 
-    PrimitiveTypeAST::PrimitiveKind leftKind;
-    PrimitiveTypeAST::PrimitiveKind rightKind;
-    const bool leftHasKind = getValuePrimitiveKind(leftValue, leftKind);
-    const bool rightHasKind = getValuePrimitiveKind(rightValue, rightKind);
-
-    PrimitiveTypeAST::PrimitiveKind targetKind = PrimitiveTypeAST::FRACTIONAL32;
-    if (leftHasKind && leftKind == PrimitiveTypeAST::FRACTIONAL64) {
-        targetKind = PrimitiveTypeAST::FRACTIONAL64;
-    }
-    if (rightHasKind && rightKind == PrimitiveTypeAST::FRACTIONAL64) {
-        targetKind = PrimitiveTypeAST::FRACTIONAL64;
-    }
-    if (ExpectedFractionResultKind.has_value() && ExpectedFractionResultKind.value() == PrimitiveTypeAST::FRACTIONAL64) {
-        targetKind = PrimitiveTypeAST::FRACTIONAL64;
-    }
-
-    if (!leftHasKind || !isFractionalPrimitiveKind(leftKind)) {
-        leftValue = castIntegerToFraction(leftValue, targetKind);
-    } else {
-        leftValue = castValueToType(leftValue, getFractionalLLVMType(targetKind));
-    }
-
-    if (!rightHasKind || !isFractionalPrimitiveKind(rightKind)) {
-        rightValue = castIntegerToFraction(rightValue, targetKind);
-    } else {
-        rightValue = castValueToType(rightValue, getFractionalLLVMType(targetKind));
-    }
+    leftValue = isFractionalValue(leftValue)
+        ? castValueToType(leftValue, getFractionalLLVMType(targetKind))
+        : castIntegerToFraction(leftValue, targetKind, leftUnsigned);
+    rightValue = isFractionalValue(rightValue)
+        ? castValueToType(rightValue, getFractionalLLVMType(targetKind))
+        : castIntegerToFraction(rightValue, targetKind, rightUnsigned);
 
     if (!leftValue || !rightValue) {
         return nullptr;
@@ -339,8 +811,11 @@ llvm::Value* CodeGenerator::createFractionArithmetic(int op, llvm::Value* leftVa
         return nullptr;
     }
 
+    // Overflow-checked modes use four times the component width, so the sum of two cross
+    // products is exact and only the reduced result can overflow.
     const unsigned componentBits = getFractionalComponentBitWidth(targetKind);
-    llvm::Type* calcType = llvm::Type::getIntNTy(TheContext, componentBits * 2);
+    const unsigned widthFactor = Options.fractionOverflow == FractionOverflowMode::Wrap ? 2 : 4;
+    llvm::Type* calcType = llvm::Type::getIntNTy(TheContext, componentBits * widthFactor);
 
     leftNumerator = castValueToType(leftNumerator, calcType);
     leftDenominator = castValueToType(leftDenominator, calcType);
@@ -382,41 +857,31 @@ llvm::Value* CodeGenerator::createFractionArithmetic(int op, llvm::Value* leftVa
             return nullptr;
     }
 
+    if (Options.fractionNormalization == FractionNormalization::Lazy) {
+        return buildLazyFractionResult(resultNumerator, resultDenominator, targetKind);
+    }
+
+    if (Options.fractionOverflow != FractionOverflowMode::Wrap) {
+        return buildFractionValue(resultNumerator, resultDenominator, targetKind);
+    }
+
     llvm::Type* componentType = getFractionalComponentType(targetKind);
     resultNumerator = castValueToType(resultNumerator, componentType);
     resultDenominator = castValueToType(resultDenominator, componentType);
     return buildFractionValue(resultNumerator, resultDenominator, targetKind);
 }
 
-llvm::Value* CodeGenerator::createFractionComparison(int op, llvm::Value* leftValue, llvm::Value* rightValue) {
+llvm::Value* CodeGenerator::createFractionComparison(int op, llvm::Value* leftValue, bool leftUnsigned, llvm::Value* rightValue, bool rightUnsigned, PrimitiveTypeAST::PrimitiveKind targetKind) {
     if (!leftValue || !rightValue) {
         return nullptr;
     }
 
-    PrimitiveTypeAST::PrimitiveKind leftKind;
-    PrimitiveTypeAST::PrimitiveKind rightKind;
-    const bool leftHasKind = getValuePrimitiveKind(leftValue, leftKind);
-    const bool rightHasKind = getValuePrimitiveKind(rightValue, rightKind);
-
-    PrimitiveTypeAST::PrimitiveKind targetKind = PrimitiveTypeAST::FRACTIONAL32;
-    if (leftHasKind && leftKind == PrimitiveTypeAST::FRACTIONAL64) {
-        targetKind = PrimitiveTypeAST::FRACTIONAL64;
-    }
-    if (rightHasKind && rightKind == PrimitiveTypeAST::FRACTIONAL64) {
-        targetKind = PrimitiveTypeAST::FRACTIONAL64;
-    }
-
-    if (!leftHasKind || !isFractionalPrimitiveKind(leftKind)) {
-        leftValue = castIntegerToFraction(leftValue, targetKind);
-    } else {
-        leftValue = castValueToType(leftValue, getFractionalLLVMType(targetKind));
-    }
-
-    if (!rightHasKind || !isFractionalPrimitiveKind(rightKind)) {
-        rightValue = castIntegerToFraction(rightValue, targetKind);
-    } else {
-        rightValue = castValueToType(rightValue, getFractionalLLVMType(targetKind));
-    }
+    leftValue = isFractionalValue(leftValue)
+        ? castValueToType(leftValue, getFractionalLLVMType(targetKind))
+        : castIntegerToFraction(leftValue, targetKind, leftUnsigned);
+    rightValue = isFractionalValue(rightValue)
+        ? castValueToType(rightValue, getFractionalLLVMType(targetKind))
+        : castIntegerToFraction(rightValue, targetKind, rightUnsigned);
 
     if (!leftValue || !rightValue) {
         return nullptr;
@@ -460,45 +925,13 @@ llvm::Value* CodeGenerator::createFractionComparison(int op, llvm::Value* leftVa
     }
 }
 
-bool CodeGenerator::isUnsignedValue(llvm::Value* value) const {
-    PrimitiveTypeAST::PrimitiveKind kind;
-    return getValuePrimitiveKind(value, kind) && isUnsignedPrimitiveKind(kind);
-}
-
-PrimitiveTypeAST::PrimitiveKind CodeGenerator::getIntegerPrimitiveKind(unsigned bitWidth, bool isUnsigned) const {
-    if (isUnsigned) {
-        switch (bitWidth) {
-            case 8:
-                return PrimitiveTypeAST::UINT8;
-            case 16:
-                return PrimitiveTypeAST::UINT16;
-            case 32:
-                return PrimitiveTypeAST::UINT32;
-            case 64:
-            default:
-                return PrimitiveTypeAST::UINT64;
-        }
-    }
-
-    switch (bitWidth) {
-        case 8:
-            return PrimitiveTypeAST::INT8;
-        case 16:
-            return PrimitiveTypeAST::INT16;
-        case 32:
-            return PrimitiveTypeAST::INT32;
-        case 64:
-        default:
-            return PrimitiveTypeAST::INT64;
-    }
+bool CodeGenerator::isUnsignedExpr(const ExprAST* expr) const {
+    return expr && expr->hasPrimitiveKind() && isUnsignedPrimitiveKind(expr->getPrimitiveKind());
 }
 
 llvm::AllocaInst* CodeGenerator::getNamedValue(const std::string& name) {
-    auto it = NamedValues.find(name);
-    if (it != NamedValues.end()) {
-        return it->second;
-    }
-    return nullptr;
+    const Symbol* symbol = Symbols.lookup(name);
+    return symbol ? symbol->storage : nullptr;
 }
 
 llvm::Type* CodeGenerator::getLLVMType(const TypeAST* typeAST) {
@@ -506,8 +939,11 @@ llvm::Type* CodeGenerator::getLLVMType(const TypeAST* typeAST) {
     if (!primitiveType) {
         return nullptr;
     }
+    return getLLVMType(primitiveType->getKind());
+}
 
-    switch (primitiveType->getKind()) {
+llvm::Type* CodeGenerator::getLLVMType(PrimitiveTypeAST::PrimitiveKind kind) {
+    switch (kind) {
         case PrimitiveTypeAST::INT8:
         case PrimitiveTypeAST::UINT8:
             return llvm::Type::getInt8Ty(TheContext);
@@ -546,7 +982,352 @@ llvm::AllocaInst* CodeGenerator::createEntryBlockAlloca(llvm::Function* function
     return tempBuilder.CreateAlloca(type, nullptr, name);
 }
 
-llvm::Value* CodeGenerator::castValueToType(llvm::Value* value, llvm::Type* targetType) {
+// Runtime arrays are a {data, length} header; the elements live in heap storage owned by
+// the declaring function. An array can only be reached through the variable that declared
+// it, so it never escapes the method body. Its storage is therefore freed directly at
+// function exit instead of being an __bp_rc_alloc object with retain/release traffic, and
+// small arrays of static length live in the frame instead (see VarDeclStmtAST).
+llvm::StructType* CodeGenerator::getArrayHeaderType() {
+    return llvm::StructType::get(TheContext, {llvm::PointerType::getUnqual(TheContext), llvm::Type::getInt64Ty(TheContext)});
+}
+
+// The header starts out as {null, 0} so re-executing the declaration (e.g. inside a loop)
+// can always free the previous storage first.
+llvm::AllocaInst* CodeGenerator::createEntryBlockArrayHeader(llvm::Function* function, const std::string& name) {
+    llvm::StructType* headerType = getArrayHeaderType();
+    llvm::AllocaInst* header = createEntryBlockAlloca(function, headerType, name);
+
+    llvm::IRBuilder<> entryBuilder(&function->getEntryBlock());
+    if (llvm::Instruction* next = header->getNextNode()) {
+        entryBuilder.SetInsertPoint(next);
+    }
+    entryBuilder.CreateStore(llvm::Constant::getNullValue(headerType), header);
+    return header;
+}
+
+llvm::Value* CodeGenerator::loadArrayData(llvm::AllocaInst* header, const std::string& name) {
+    llvm::Value* dataField = Builder.CreateStructGEP(getArrayHeaderType(), header, 0, name + ".data.ptr");
+    return Builder.CreateLoad(llvm::PointerType::getUnqual(TheContext), dataField, name + ".data");
+}
+
+llvm::Value* CodeGenerator::loadArrayLength(llvm::AllocaInst* header, const std::string& name) {
+    llvm::Value* lengthField = Builder.CreateStructGEP(getArrayHeaderType(), header, 1, name + ".len.ptr");
+    return Builder.CreateLoad(llvm::Type::getInt64Ty(TheContext), lengthField, name + ".len");
+}
+
+llvm::Value* CodeGenerator::allocateArrayStorage(llvm::Type* elementType, llvm::Value* length, bool zeroInitialize, const std::string& name) {
+    llvm::Type* int64Type = llvm::Type::getInt64Ty(TheContext);
+    llvm::Type* pointerType = llvm::PointerType::getUnqual(TheContext);
+
+    createTrapIf(Builder.CreateICmpSLT(length, llvm::ConstantInt::get(int64Type, 0), name + ".len.neg"), name + ".len");
+
+    llvm::Constant* elementSize = llvm::ConstantExpr::getSizeOf(elementType);
+    llvm::Value* byteCountWithOverflow = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::umul_with_overflow, length, elementSize, nullptr, name + ".bytes");
+    createTrapIf(Builder.CreateExtractValue(byteCountWithOverflow, {1}, name + ".bytes.ovf"), name + ".bytes");
+    llvm::Value* byteCount = Builder.CreateExtractValue(byteCountWithOverflow, {0}, name + ".bytes.val");
+
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    llvm::Value* alignmentMask = llvm::ConstantInt::get(int64Type, ArrayStorageAlignment - 1);
+    llvm::Value* roundedByteCount = Builder.CreateAnd(
+        Builder.CreateAdd(byteCount, alignmentMask, name + ".bytes.pad"),
+        Builder.CreateNot(alignmentMask),
+        name + ".bytes.aligned");
+
+    llvm::FunctionCallee alignedAlloc = TheModule->getOrInsertFunction(
+        "aligned_alloc", llvm::FunctionType::get(pointerType, {int64Type, int64Type}, false));
+    llvm::Value* data = Builder.CreateCall(alignedAlloc, {llvm::ConstantInt::get(int64Type, ArrayStorageAlignment), roundedByteCount}, name + ".storage");
+
+    llvm::Value* allocationFailed = Builder.CreateAnd(
+        Builder.CreateIsNull(data, name + ".storage.null"),
+        Builder.CreateICmpNE(byteCount, llvm::ConstantInt::get(int64Type, 0), name + ".storage.nonempty"),
+        name + ".storage.failed");
+    createTrapIf(allocationFailed, name + ".storage");
+
+    if (zeroInitialize) {
+        Builder.CreateMemSet(data, Builder.getInt8(0), byteCount, llvm::MaybeAlign(ArrayStorageAlignment));
+    }
+    return data;
+}
+
+// Returns a private constant holding the constant elements of an array literal, with zero in
+// place of the others, or null if no element is constant.
+llvm::GlobalVariable* CodeGenerator::createArrayLiteralGlobal(llvm::Type* elementType, llvm::ArrayRef<llvm::Value*> elements, const std::string& name) {
+    std::vector<llvm::Constant*> initializer;
+    bool hasConstantElement = false;
+    for (llvm::Value* element : elements) {
+        auto* constant = llvm::dyn_cast<llvm::Constant>(element);
+        hasConstantElement |= constant != nullptr;
+        initializer.push_back(constant ? constant : llvm::Constant::getNullValue(elementType));
+    }
+    if (!hasConstantElement) {
+        return nullptr;
+    }
+
+    llvm::ArrayType* arrayType = llvm::ArrayType::get(elementType, initializer.size());
+    auto* global = new llvm::GlobalVariable(*TheModule, arrayType, true, llvm::GlobalValue::PrivateLinkage,
+        llvm::ConstantArray::get(arrayType, initializer), name + ".init");
+    global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    global->setAlignment(llvm::Align(ArrayStorageAlignment));
+    return global;
+}
+
+void CodeGenerator::releaseFunctionArrays() {
+    if (CurrentFunctionArrays.empty()) {
+        return;
+    }
+
+    llvm::FunctionCallee freeFunction = TheModule->getOrInsertFunction(
+        "free", llvm::FunctionType::get(llvm::Type::getVoidTy(TheContext), {llvm::PointerType::getUnqual(TheContext)}, false));
+    for (llvm::AllocaInst* header : CurrentFunctionArrays) {
+        Builder.CreateCall(freeFunction, {loadArrayData(header, header->getName().str())});
+    }
+}
+
+// One bp_function_profile record per instrumented method (layout in runtime/bp_runtime.h):
+// the name is "Class.method" and every counter starts at zero.
+llvm::GlobalVariable* CodeGenerator::createFunctionProfileRecord(const std::string& functionName) {
+    llvm::Type* pointerType = llvm::PointerType::getUnqual(TheContext);
+    llvm::Type* counterType = llvm::Type::getInt64Ty(TheContext);
+    llvm::StructType* recordType = llvm::StructType::get(TheContext, {pointerType, counterType, counterType, pointerType, llvm::Type::getInt32Ty(TheContext)});
+    llvm::Constant* name = Builder.CreateGlobalString(functionName, "profile.name", 0, TheModule.get());
+    llvm::Constant* initializer = llvm::ConstantStruct::get(recordType, {
+        name,
+        llvm::ConstantInt::get(counterType, 0),
+        llvm::ConstantInt::get(counterType, 0),
+        llvm::Constant::getNullValue(pointerType),
+        llvm::ConstantInt::get(llvm::Type::getInt32Ty(TheContext), 0),
+    });
+    return new llvm::GlobalVariable(*TheModule, recordType, false, llvm::GlobalValue::PrivateLinkage, initializer, "profile." + functionName);
+}
+
+// Branches to a cold llvm.trap block when failureCondition holds and continues codegen on
+// the success path.
+void CodeGenerator::createTrapIf(llvm::Value* failureCondition, const std::string& name) {
+    if (auto* constantCondition = llvm::dyn_cast<llvm::ConstantInt>(failureCondition)) {
+        if (constantCondition->isZero()) {
+            return;
+        }
+    }
+
+    llvm::Function* function = Builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* trapBlock = llvm::BasicBlock::Create(TheContext, name + ".trap", function);
+    llvm::BasicBlock* continueBlock = llvm::BasicBlock::Create(TheContext, name + ".ok", function);
+
+    llvm::MDBuilder metadataBuilder(TheContext);
+    Builder.CreateCondBr(failureCondition, trapBlock, continueBlock, metadataBuilder.createBranchWeights(1, 1u << 20));
+
+    Builder.SetInsertPoint(trapBlock);
+    Builder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+    Builder.CreateUnreachable();
+
+    Builder.SetInsertPoint(continueBlock);
+}
+
+// A clause whose condition folded to a constant is decided here: a true one emits nothing and
+// a false one is rejected. Any other condition traps when it does not hold, and the optimizer
+// drops checks its range analysis proves redundant.
+bool CodeGenerator::createContractCheck(ExprAST* condition, const std::string& clause, const std::string& methodName) {
+    llvm::Value* conditionValue = castToBoolean(condition->codegen(*this));
+    if (!conditionValue) {
+        logError(("Contract '" + clause + "' of method '" + methodName + "' is not boolean-compatible").c_str());
+        return false;
+    }
+
+    if (auto* constantCondition = llvm::dyn_cast<llvm::ConstantInt>(conditionValue)) {
+        if (constantCondition->isZero()) {
+            logError(("Contract '" + clause + "' of method '" + methodName + "' can never hold").c_str());
+            return false;
+        }
+        return true;
+    }
+
+    createTrapIf(Builder.CreateNot(conditionValue, clause + ".failed"), "contract." + clause);
+    return true;
+}
+
+// All bounds checks of a function share one trap block to keep the fast path compact.
+llvm::BasicBlock* CodeGenerator::getBoundsTrapBlock() {
+    if (!CurrentBoundsTrapBlock) {
+        CurrentBoundsTrapBlock = llvm::BasicBlock::Create(TheContext, "bounds.trap", CurrentFunction);
+        llvm::IRBuilder<> trapBuilder(CurrentBoundsTrapBlock);
+        trapBuilder.CreateIntrinsic(llvm::Intrinsic::trap, {}, {});
+        trapBuilder.CreateUnreachable();
+    }
+    return CurrentBoundsTrapBlock;
+}
+
+// Records accesses as in bounds while condition holds (always, for a nullptr condition). An
+// access an enclosing loop already proved unconditionally keeps that proof.
+void CodeGenerator::assumeInBounds(const std::vector<BoundsProvenAccess>& accesses, llvm::Value* condition) {
+    for (const auto& access : accesses) {
+        auto [entry, inserted] = ProvenInBoundsAccesses.emplace(access, condition);
+        if (!inserted && !condition) {
+            entry->second = nullptr;
+        }
+    }
+}
+
+void CodeGenerator::createBoundsCheck(llvm::AllocaInst* header, llvm::Value* index, const std::string& arrayName, const ExprAST* indexExpr) {
+    if (Options.boundsChecks == BoundsCheckMode::Off) {
+        return;
+    }
+
+    // Constant indices into arrays of known length were already validated at compile time.
+    const Symbol* array = Symbols.lookup(arrayName);
+    if (getStaticIntegerIndex(indexExpr) && array && array->arrayStaticLength) {
+        return;
+    }
+
+    llvm::Value* provenCondition = nullptr;
+    if (const auto access = matchOffsetIndex(indexExpr)) {
+        const auto proven = ProvenInBoundsAccesses.find({arrayName, access->first, access->second});
+        if (proven != ProvenInBoundsAccesses.end()) {
+            if (!proven->second) {
+                return;
+            }
+            provenCondition = proven->second;
+        }
+    }
+
+    // Negative signed indices were sign-extended, so one unsigned compare covers both ends.
+    llvm::Value* length = loadArrayLength(header, arrayName);
+    llvm::Value* outOfBounds = Builder.CreateICmpUGE(index, length, arrayName + ".oob");
+    if (provenCondition) {
+        // Loop-invariant, so the optimizer can unswitch the loop on it
+        outOfBounds = Builder.CreateAnd(outOfBounds, Builder.CreateNot(provenCondition), arrayName + ".unproven.oob");
+    }
+
+    llvm::BasicBlock* continueBlock = llvm::BasicBlock::Create(TheContext, arrayName + ".inbounds", CurrentFunction);
+    llvm::MDBuilder metadataBuilder(TheContext);
+    Builder.CreateCondBr(outOfBounds, getBoundsTrapBlock(), continueBlock, metadataBuilder.createBranchWeights(1, 1u << 20));
+    Builder.SetInsertPoint(continueBlock);
+}
+
+// For a counted loop `while (iv < bound) { ...; iv = iv + step; }` emits one condition that,
+// when true on entry, proves every `array[iv]` in the body is in bounds for all iterations:
+// iv starts non-negative, bound fits every indexed array, and iv + step cannot wrap. Terms that
+// hold statically are left out, such as a bound that is the indexed array's own length; when
+// none remain the condition is the constant true. Returns nullptr when the loop does not have
+// that shape or a term can never hold.
+llvm::Value* CodeGenerator::createHoistedBoundsCondition(WhileStmtAST& node, std::vector<BoundsProvenAccess>& outProvenAccesses) {
+    if (Options.boundsChecks != BoundsCheckMode::Hoisted) {
+        return nullptr;
+    }
+
+    const std::optional<CountedLoopShape> shape = matchCountedLoop(node);
+    if (!shape) {
+        return nullptr;
+    }
+
+    llvm::AllocaInst* inductionAlloca = getNamedValue(shape->inductionVariable);
+    PrimitiveTypeAST::PrimitiveKind inductionKind;
+    if (!inductionAlloca || !getNamedPrimitiveKind(shape->inductionVariable, inductionKind) || !isIntegerPrimitiveKind(inductionKind)) {
+        return nullptr;
+    }
+
+    llvm::Type* inductionType = inductionAlloca->getAllocatedType();
+    llvm::Type* int64Type = llvm::Type::getInt64Ty(TheContext);
+    const unsigned bits = inductionType->getIntegerBitWidth();
+    const bool isUnsigned = isUnsignedPrimitiveKind(inductionKind);
+    const llvm::APInt maxValue = isUnsigned ? llvm::APInt::getMaxValue(bits) : llvm::APInt::getSignedMaxValue(bits);
+    if (static_cast<uint64_t>(shape->step) > maxValue.getZExtValue()) {
+        return nullptr;
+    }
+
+    // iv < bound <= max - (step - 1) (or iv <= bound <= max - step) keeps iv + step from wrapping.
+    const llvm::APInt stepValue(bits, static_cast<uint64_t>(shape->step));
+    const llvm::APInt limit = maxValue - (shape->inclusiveBound ? stepValue : stepValue - 1);
+    std::vector<llvm::Value*> terms;
+
+    llvm::Value* bound64 = nullptr;
+    const auto* boundLength = llvm::dyn_cast<ArrayLengthExprAST>(shape->bound);
+    if (boundLength) {
+        const Symbol* boundArray = Symbols.lookup(boundLength->getName());
+        if (!boundArray || !boundArray->isArray()) {
+            return nullptr;
+        }
+        bound64 = boundArray->arrayStaticLength
+            ? llvm::ConstantInt::get(int64Type, *boundArray->arrayStaticLength)
+            : loadArrayLength(boundArray->storage, boundLength->getName());
+        // Lengths are never negative, so they are always within a limit of INT64_MAX or more.
+        const llvm::APInt limit64 = limit.zext(64);
+        if (limit64.ult(llvm::APInt::getSignedMaxValue(64))) {
+            terms.push_back(Builder.CreateICmpULE(bound64, llvm::ConstantInt::get(int64Type, limit64), "hoist.nowrap"));
+        }
+    } else {
+        llvm::Value* boundValue = nullptr;
+        if (const auto* boundIdentifier = llvm::dyn_cast<IdentifierExprAST>(shape->bound)) {
+            llvm::AllocaInst* boundAlloca = getNamedValue(boundIdentifier->getName());
+            PrimitiveTypeAST::PrimitiveKind boundKind;
+            if (!boundAlloca || !getNamedPrimitiveKind(boundIdentifier->getName(), boundKind) || boundKind != inductionKind) {
+                return nullptr;
+            }
+            boundValue = Builder.CreateLoad(inductionType, boundAlloca, boundIdentifier->getName() + ".bound");
+        } else {
+            const int64_t literalBound = *getStaticIntegerIndex(shape->bound);
+            const bool fits = isUnsigned
+                ? literalBound >= 0 && (bits == 64 || static_cast<uint64_t>(literalBound) <= maxValue.getZExtValue())
+                : llvm::isIntN(bits, literalBound);
+            if (!fits) {
+                return nullptr;
+            }
+            boundValue = llvm::ConstantInt::get(inductionType, static_cast<uint64_t>(literalBound), !isUnsigned);
+        }
+
+        llvm::Value* limitValue = llvm::ConstantInt::get(inductionType, limit);
+        terms.push_back(isUnsigned
+            ? Builder.CreateICmpULE(boundValue, limitValue, "hoist.nowrap")
+            : Builder.CreateICmpSLE(boundValue, limitValue, "hoist.nowrap"));
+        bound64 = Builder.CreateIntCast(boundValue, int64Type, !isUnsigned, "hoist.bound");
+    }
+
+    if (!isUnsigned) {
+        if (const std::optional<llvm::APInt> start = findStoredConstant(Builder.GetInsertBlock(), inductionAlloca)) {
+            terms.push_back(llvm::ConstantInt::getBool(TheContext, !start->isNegative()));
+        } else {
+            llvm::Value* initialInduction = Builder.CreateLoad(inductionType, inductionAlloca, shape->inductionVariable + ".start");
+            terms.push_back(Builder.CreateICmpSGE(initialInduction, llvm::ConstantInt::get(inductionType, 0), "hoist.start"));
+        }
+    }
+
+    for (const std::string& arrayName : shape->arraysIndexedByInduction) {
+        const Symbol* array = Symbols.lookup(arrayName);
+        if (!array || !array->isArray()) {
+            continue;
+        }
+        outProvenAccesses.emplace_back(arrayName, shape->inductionVariable, 0);
+
+        // iv < array.length is the access's own bounds check.
+        if (boundLength && boundLength->getName() == arrayName && !shape->inclusiveBound) {
+            continue;
+        }
+
+        llvm::Value* length = loadArrayLength(array->storage, arrayName);
+        terms.push_back(shape->inclusiveBound
+            ? Builder.CreateICmpULT(bound64, length, arrayName + ".hoist.fits")
+            : Builder.CreateICmpULE(bound64, length, arrayName + ".hoist.fits"));
+    }
+
+    if (outProvenAccesses.empty()) {
+        return nullptr;
+    }
+
+    llvm::Value* safe = llvm::ConstantInt::getTrue(TheContext);
+    for (llvm::Value* term : terms) {
+        if (const auto* constant = llvm::dyn_cast<llvm::ConstantInt>(term)) {
+            if (constant->isZero()) {
+                outProvenAccesses.clear();
+                return nullptr;
+            }
+            continue;
+        }
+        safe = llvm::isa<llvm::Constant>(safe) ? term : Builder.CreateAnd(safe, term, "hoist.safe");
+    }
+    return safe;
+}
+
+// sourceUnsigned selects zero extension and unsigned conversion for integer sources.
+llvm::Value* CodeGenerator::castValueToType(llvm::Value* value, llvm::Type* targetType, bool sourceUnsigned) {
     if (!value || !targetType) {
         return nullptr;
     }
@@ -556,17 +1337,30 @@ llvm::Value* CodeGenerator::castValueToType(llvm::Value* value, llvm::Type* targ
         return value;
     }
 
-    PrimitiveTypeAST::PrimitiveKind sourceKind;
-    const bool hasSourceKind = getValuePrimitiveKind(value, sourceKind);
+    const PrimitiveTypeAST::PrimitiveKind sourceKind = getFractionalPrimitiveKindForType(sourceType);
+    const bool sourceIsFraction = isFractionalPrimitiveKind(sourceKind);
 
     if (sourceType->isStructTy() && targetType->isStructTy()) {
         const PrimitiveTypeAST::PrimitiveKind targetKind = getFractionalPrimitiveKindForType(targetType);
-        if (hasSourceKind && isFractionalPrimitiveKind(sourceKind) && isFractionalPrimitiveKind(targetKind)) {
+        if (sourceIsFraction && isFractionalPrimitiveKind(targetKind)) {
+            const bool widening = getFractionalComponentBitWidth(targetKind) > getFractionalComponentBitWidth(sourceKind);
+            const bool lazy = Options.fractionNormalization == FractionNormalization::Lazy;
+
             llvm::Value* numerator = nullptr;
             llvm::Value* denominator = nullptr;
             if (!decomposeFractionValue(value, sourceKind, numerator, denominator)) {
                 return nullptr;
             }
+
+            // Sign extension keeps the value (and its reduced-ness) unchanged. A narrowed value
+            // must already be reduced; callers normalize an unreduced one first.
+            if (lazy && widening) {
+                llvm::Type* componentType = getFractionalComponentType(targetKind);
+                return assembleFractionValue(
+                    Builder.CreateSExt(numerator, componentType, "fr.widen.num"),
+                    Builder.CreateSExt(denominator, componentType, "fr.widen.den"),
+                    targetKind);
+            }
             return buildFractionValue(numerator, denominator, targetKind);
         }
     }
@@ -574,18 +1368,18 @@ llvm::Value* CodeGenerator::castValueToType(llvm::Value* value, llvm::Type* targ
     if (sourceType->isIntegerTy() && targetType->isStructTy()) {
         const PrimitiveTypeAST::PrimitiveKind targetKind = getFractionalPrimitiveKindForType(targetType);
         if (isFractionalPrimitiveKind(targetKind)) {
-            return castIntegerToFraction(value, targetKind);
+            return castIntegerToFraction(value, targetKind, sourceUnsigned);
         }
     }
 
     if (sourceType->isStructTy() && targetType->isFloatingPointTy()) {
-        if (hasSourceKind && isFractionalPrimitiveKind(sourceKind)) {
+        if (sourceIsFraction) {
             return castFractionToFloatingPoint(value, targetType);
         }
     }
 
     if (sourceType->isStructTy() && targetType->isIntegerTy()) {
-        if (hasSourceKind && isFractionalPrimitiveKind(sourceKind)) {
+        if (sourceIsFraction) {
             llvm::Value* numerator = nullptr;
             llvm::Value* denominator = nullptr;
             if (!decomposeFractionValue(value, sourceKind, numerator, denominator)) {
@@ -603,7 +1397,6 @@ llvm::Value* CodeGenerator::castValueToType(llvm::Value* value, llvm::Type* targ
     if (sourceType->isIntegerTy() && targetType->isIntegerTy()) {
         const unsigned sourceBits = sourceType->getIntegerBitWidth();
         const unsigned targetBits = targetType->getIntegerBitWidth();
-        const bool sourceUnsigned = hasSourceKind && isUnsignedPrimitiveKind(sourceKind);
         if (sourceBits < targetBits) {
             return sourceUnsigned
                 ? Builder.CreateZExt(value, targetType, "zexttmp")
@@ -616,7 +1409,7 @@ llvm::Value* CodeGenerator::castValueToType(llvm::Value* value, llvm::Type* targ
     }
 
     if (sourceType->isIntegerTy() && targetType->isFloatingPointTy()) {
-        return isUnsignedValue(value)
+        return sourceUnsigned
             ? Builder.CreateUIToFP(value, targetType, "uitofptmp")
             : Builder.CreateSIToFP(value, targetType, "sitofptmp");
     }
@@ -656,11 +1449,7 @@ llvm::Value* CodeGenerator::castToBoolean(llvm::Value* value) {
     }
 
     if (isFractionalValue(value)) {
-        PrimitiveTypeAST::PrimitiveKind kind;
-        if (!getValuePrimitiveKind(value, kind)) {
-            return nullptr;
-        }
-
+        const PrimitiveTypeAST::PrimitiveKind kind = getFractionalPrimitiveKindForType(type);
         llvm::Value* numerator = nullptr;
         llvm::Value* denominator = nullptr;
         if (!decomposeFractionValue(value, kind, numerator, denominator)) {
@@ -684,34 +1473,73 @@ llvm::FunctionCallee CodeGenerator::getPrintfFunction() {
     return TheModule->getOrInsertFunction("printf", printfType);
 }
 
+llvm::FunctionCallee CodeGenerator::getOutputRuntimeFunction(const std::string& name, llvm::ArrayRef<llvm::Type*> parameterTypes) {
+    llvm::FunctionType* writerType = llvm::FunctionType::get(llvm::Type::getVoidTy(TheContext), parameterTypes, false);
+    return TheModule->getOrInsertFunction(name, writerType);
+}
+
+// Lowers one logln to a type-specialized runtime writer plus a newline. The runtime decides
+// when the per-thread buffer reaches stdout, so no format string is parsed at run time.
+llvm::Value* CodeGenerator::emitRuntimePrint(llvm::Value* value, bool hasPrimitiveKind, PrimitiveTypeAST::PrimitiveKind primitiveKind) {
+    llvm::Type* type = value->getType();
+    llvm::Type* int32Type = llvm::Type::getInt32Ty(TheContext);
+    llvm::Type* int64Type = llvm::Type::getInt64Ty(TheContext);
+    llvm::Type* doubleType = llvm::Type::getDoubleTy(TheContext);
+
+    if (hasPrimitiveKind && isFractionalPrimitiveKind(primitiveKind)) {
+        llvm::Value* numerator = nullptr;
+        llvm::Value* denominator = nullptr;
+        if (!decomposeFractionValue(value, primitiveKind, numerator, denominator)) {
+            return logError("Could not print fractional value");
+        }
+
+        llvm::Value* widenedNum = Builder.CreateSExt(numerator, int64Type, "fr_num_i64");
+        llvm::Value* widenedDen = Builder.CreateSExt(denominator, int64Type, "fr_den_i64");
+        Builder.CreateCall(getOutputRuntimeFunction("__bp_write_fraction", {int64Type, int64Type}), {widenedNum, widenedDen});
+    } else if (hasPrimitiveKind && primitiveKind == PrimitiveTypeAST::STR) {
+        Builder.CreateCall(getOutputRuntimeFunction("__bp_write_str", {value->getType()}), {value});
+    } else if (type->isDoubleTy()) {
+        Builder.CreateCall(getOutputRuntimeFunction("__bp_write_f64", {doubleType}), {value});
+    } else if (type->isFloatTy()) {
+        llvm::Value* widened = Builder.CreateFPExt(value, doubleType, "f32todouble");
+        Builder.CreateCall(getOutputRuntimeFunction("__bp_write_f64", {doubleType}), {widened});
+    } else if (type->isIntegerTy(1)) {
+        llvm::Value* widened = Builder.CreateZExt(value, int32Type, "bool_to_i32");
+        Builder.CreateCall(getOutputRuntimeFunction("__bp_write_bool", {int32Type}), {widened});
+    } else if (type->isIntegerTy(8) && hasPrimitiveKind && primitiveKind == PrimitiveTypeAST::CHAR) {
+        llvm::Value* widened = Builder.CreateSExt(value, int32Type, "char_to_i32");
+        Builder.CreateCall(getOutputRuntimeFunction("__bp_write_char", {int32Type}), {widened});
+    } else if (type->isIntegerTy(8) || type->isIntegerTy(16) || type->isIntegerTy(32) || type->isIntegerTy(64)) {
+        const bool isUnsigned = hasPrimitiveKind && isUnsignedPrimitiveKind(primitiveKind);
+        llvm::Value* widened = isUnsigned
+            ? Builder.CreateZExt(value, int64Type, "int_to_u64")
+            : Builder.CreateSExt(value, int64Type, "int_to_i64");
+        Builder.CreateCall(getOutputRuntimeFunction(isUnsigned ? "__bp_write_u64" : "__bp_write_i64", {int64Type}), {widened});
+    } else {
+        return logError("Defaultlogger.log only supports primitive scalar values");
+    }
+
+    return Builder.CreateCall(getOutputRuntimeFunction("__bp_write_newline", {}), {});
+}
+
 llvm::Value* CodeGenerator::visit(IntegerExprAST& node) {
-    llvm::Value* value = llvm::ConstantInt::get(TheContext, llvm::APInt(64, static_cast<uint64_t>(node.getValue()), false));
-    setValuePrimitiveKind(value, PrimitiveTypeAST::INT64);
-    return value;
+    return llvm::ConstantInt::get(TheContext, llvm::APInt(64, static_cast<uint64_t>(node.getValue()), false));
 }
 
 llvm::Value* CodeGenerator::visit(FloatExprAST& node) {
-    llvm::Value* value = llvm::ConstantFP::get(TheContext, llvm::APFloat(static_cast<double>(node.getValue())));
-    setValuePrimitiveKind(value, PrimitiveTypeAST::FLOAT64);
-    return value;
+    return llvm::ConstantFP::get(TheContext, llvm::APFloat(static_cast<double>(node.getValue())));
 }
 
 llvm::Value* CodeGenerator::visit(BoolExprAST& node) {
-    llvm::Value* value = llvm::ConstantInt::get(TheContext, llvm::APInt(1, node.getValue() ? 1 : 0, false));
-    setValuePrimitiveKind(value, PrimitiveTypeAST::BOOL);
-    return value;
+    return llvm::ConstantInt::get(TheContext, llvm::APInt(1, node.getValue() ? 1 : 0, false));
 }
 
 llvm::Value* CodeGenerator::visit(CharExprAST& node) {
-    llvm::Value* value = llvm::ConstantInt::get(TheContext, llvm::APInt(8, static_cast<uint8_t>(node.getValue()), false));
-    setValuePrimitiveKind(value, PrimitiveTypeAST::CHAR);
-    return value;
+    return llvm::ConstantInt::get(TheContext, llvm::APInt(8, static_cast<uint8_t>(node.getValue()), false));
 }
 
 llvm::Value* CodeGenerator::visit(StrExprAST& node) {
-    llvm::Value* strPtr = Builder.CreateGlobalString(node.getValue(), "str.literal");
-    setValuePrimitiveKind(strPtr, PrimitiveTypeAST::STR);
-    return strPtr;
+    return Builder.CreateGlobalString(node.getValue(), "str.literal");
 }
 
 llvm::Value* CodeGenerator::visit(IdentifierExprAST& node) {
@@ -720,45 +1548,65 @@ llvm::Value* CodeGenerator::visit(IdentifierExprAST& node) {
         return logError("Unknown variable name");
     }
 
-    llvm::Value* loadedValue = Builder.CreateLoad(alloca->getAllocatedType(), alloca, node.getName() + ".val");
-    PrimitiveTypeAST::PrimitiveKind primitiveKind;
-    if (getNamedPrimitiveKind(node.getName(), primitiveKind)) {
-        setValuePrimitiveKind(loadedValue, primitiveKind);
+    return Builder.CreateLoad(alloca->getAllocatedType(), alloca, node.getName() + ".val");
+}
+
+llvm::Constant* CodeGenerator::createConstant(const ConstantValue& value) {
+    if (isFractionalPrimitiveKind(value.kind)) {
+        llvm::Type* componentType = getFractionalComponentType(value.kind);
+        return llvm::ConstantStruct::get(getFractionalLLVMType(value.kind), {
+            llvm::ConstantInt::get(componentType, static_cast<uint64_t>(value.numerator), true),
+            llvm::ConstantInt::get(componentType, static_cast<uint64_t>(value.denominator), true)});
     }
 
-    return loadedValue;
+    llvm::Type* type = getLLVMType(value.kind);
+    if (type->isFloatingPointTy()) {
+        return llvm::ConstantFP::get(type, value.floatingValue);
+    }
+    return llvm::ConstantInt::get(type, value.integerBits, !isUnsignedPrimitiveKind(value.kind));
 }
 
 llvm::Value* CodeGenerator::visit(BinaryExprAST& node) {
+    if (node.hasConstantValue()) {
+        return createConstant(node.getConstantValue());
+    }
+
     llvm::Value* leftValue = node.getLHS()->codegen(*this);
     llvm::Value* rightValue = node.getRHS()->codegen(*this);
     if (!leftValue || !rightValue) {
         return nullptr;
     }
 
-    const bool hasFloatOperand = leftValue->getType()->isFloatingPointTy() || rightValue->getType()->isFloatingPointTy();
-    const bool hasFractionalOperand = isFractionalValue(leftValue) || isFractionalValue(rightValue);
+    // Operands are promoted to the kind the TypeChecker resolved; it is unset when an operand
+    // is not numeric.
+    const bool hasOperandKind = node.hasOperandKind();
+    const PrimitiveTypeAST::PrimitiveKind operandKind = node.getOperandKind();
+    const bool hasFractionalOperands = hasOperandKind && isFractionalPrimitiveKind(operandKind);
+    const bool leftUnsigned = isUnsignedExpr(node.getLHS());
+    const bool rightUnsigned = isUnsignedExpr(node.getRHS());
+    const bool useUnsignedIntegerOps = hasOperandKind && isUnsignedPrimitiveKind(operandKind);
+    llvm::Type* operandType = hasOperandKind && !hasFractionalOperands ? getLLVMType(operandKind) : nullptr;
 
     switch (node.getOp()) {
         case BinaryExprAST::PLUS:
         case BinaryExprAST::MINUS:
         case BinaryExprAST::MULTIPLY:
         case BinaryExprAST::DIVIDE: {
-            const bool expectsFractionResult = ExpectedFractionResultKind.has_value() && node.getOp() == BinaryExprAST::DIVIDE && !hasFloatOperand;
-            if ((hasFractionalOperand || expectsFractionResult) && !hasFloatOperand) {
-                llvm::Value* result = createFractionArithmetic(node.getOp(), leftValue, rightValue);
+            if (!hasOperandKind) {
+                return logError("Arithmetic operators require numeric operands");
+            }
+
+            if (hasFractionalOperands) {
+                llvm::Value* result = createFractionArithmetic(node.getOp(), leftValue, leftUnsigned, rightValue, rightUnsigned, operandKind);
                 if (!result) {
                     return logError("Type conversion failed for fractional arithmetic");
                 }
                 return result;
             }
 
-            if (hasFloatOperand) {
-                llvm::Type* floatType = (leftValue->getType()->isDoubleTy() || rightValue->getType()->isDoubleTy())
-                    ? llvm::Type::getDoubleTy(TheContext)
-                    : llvm::Type::getFloatTy(TheContext);
-                leftValue = castValueToType(leftValue, floatType);
-                rightValue = castValueToType(rightValue, floatType);
+            leftValue = castValueToType(leftValue, operandType, leftUnsigned);
+            rightValue = castValueToType(rightValue, operandType, rightUnsigned);
+            if (operandType->isFloatingPointTy()) {
                 if (!leftValue || !rightValue) {
                     return logError("Type conversion failed for floating-point arithmetic");
                 }
@@ -777,46 +1625,17 @@ llvm::Value* CodeGenerator::visit(BinaryExprAST& node) {
                 }
             }
 
-            if (!leftValue->getType()->isIntegerTy() || !rightValue->getType()->isIntegerTy()) {
-                return logError("Arithmetic operators require numeric operands");
-            }
-
-            unsigned maxBits = std::max(leftValue->getType()->getIntegerBitWidth(), rightValue->getType()->getIntegerBitWidth());
-            if (ExpectedIntegerResultBits.has_value()) {
-                maxBits = std::max(maxBits, *ExpectedIntegerResultBits);
-            }
-            llvm::Type* targetType = llvm::Type::getIntNTy(TheContext, maxBits);
-            const bool useUnsignedIntegerOps = isUnsignedValue(leftValue) || isUnsignedValue(rightValue);
-            leftValue = castValueToType(leftValue, targetType);
-            rightValue = castValueToType(rightValue, targetType);
-
             switch (node.getOp()) {
                 case BinaryExprAST::PLUS:
-                    {
-                        llvm::Value* result = Builder.CreateAdd(leftValue, rightValue, "addtmp");
-                        setValuePrimitiveKind(result, getIntegerPrimitiveKind(maxBits, useUnsignedIntegerOps));
-                        return result;
-                    }
+                    return Builder.CreateAdd(leftValue, rightValue, "addtmp");
                 case BinaryExprAST::MINUS:
-                    {
-                        llvm::Value* result = Builder.CreateSub(leftValue, rightValue, "subtmp");
-                        setValuePrimitiveKind(result, getIntegerPrimitiveKind(maxBits, useUnsignedIntegerOps));
-                        return result;
-                    }
+                    return Builder.CreateSub(leftValue, rightValue, "subtmp");
                 case BinaryExprAST::MULTIPLY:
-                    {
-                        llvm::Value* result = Builder.CreateMul(leftValue, rightValue, "multmp");
-                        setValuePrimitiveKind(result, getIntegerPrimitiveKind(maxBits, useUnsignedIntegerOps));
-                        return result;
-                    }
+                    return Builder.CreateMul(leftValue, rightValue, "multmp");
                 case BinaryExprAST::DIVIDE:
-                    {
-                        llvm::Value* result = useUnsignedIntegerOps
-                            ? Builder.CreateUDiv(leftValue, rightValue, "udivtmp")
-                            : Builder.CreateSDiv(leftValue, rightValue, "sdivtmp");
-                        setValuePrimitiveKind(result, getIntegerPrimitiveKind(maxBits, useUnsignedIntegerOps));
-                        return result;
-                    }
+                    return useUnsignedIntegerOps
+                        ? Builder.CreateUDiv(leftValue, rightValue, "udivtmp")
+                        : Builder.CreateSDiv(leftValue, rightValue, "sdivtmp");
                 default:
                     break;
             }
@@ -824,23 +1643,15 @@ llvm::Value* CodeGenerator::visit(BinaryExprAST& node) {
         }
 
         case BinaryExprAST::MODULO: {
-            if (!leftValue->getType()->isIntegerTy() || !rightValue->getType()->isIntegerTy()) {
+            if (!hasOperandKind) {
                 return logError("Modulo requires integer operands");
             }
 
-            unsigned maxBits = std::max(leftValue->getType()->getIntegerBitWidth(), rightValue->getType()->getIntegerBitWidth());
-            if (ExpectedIntegerResultBits.has_value()) {
-                maxBits = std::max(maxBits, *ExpectedIntegerResultBits);
-            }
-            llvm::Type* targetType = llvm::Type::getIntNTy(TheContext, maxBits);
-            const bool useUnsignedIntegerOps = isUnsignedValue(leftValue) || isUnsignedValue(rightValue);
-            leftValue = castValueToType(leftValue, targetType);
-            rightValue = castValueToType(rightValue, targetType);
-            llvm::Value* result = useUnsignedIntegerOps
+            leftValue = castValueToType(leftValue, operandType, leftUnsigned);
+            rightValue = castValueToType(rightValue, operandType, rightUnsigned);
+            return useUnsignedIntegerOps
                 ? Builder.CreateURem(leftValue, rightValue, "uremtmp")
                 : Builder.CreateSRem(leftValue, rightValue, "sremtmp");
-            setValuePrimitiveKind(result, getIntegerPrimitiveKind(maxBits, useUnsignedIntegerOps));
-            return result;
         }
 
         case BinaryExprAST::LESS_THAN:
@@ -849,20 +1660,21 @@ llvm::Value* CodeGenerator::visit(BinaryExprAST& node) {
         case BinaryExprAST::GREATER_EQUAL:
         case BinaryExprAST::EQUAL:
         case BinaryExprAST::NOT_EQUAL: {
-            if (hasFractionalOperand && !hasFloatOperand) {
-                llvm::Value* result = createFractionComparison(node.getOp(), leftValue, rightValue);
+            if (!hasOperandKind) {
+                return logError("Comparison requires numeric operands");
+            }
+
+            if (hasFractionalOperands) {
+                llvm::Value* result = createFractionComparison(node.getOp(), leftValue, leftUnsigned, rightValue, rightUnsigned, operandKind);
                 if (!result) {
                     return logError("Type conversion failed for fractional comparison");
                 }
                 return result;
             }
 
-            if (hasFloatOperand) {
-                llvm::Type* floatType = (leftValue->getType()->isDoubleTy() || rightValue->getType()->isDoubleTy())
-                    ? llvm::Type::getDoubleTy(TheContext)
-                    : llvm::Type::getFloatTy(TheContext);
-                leftValue = castValueToType(leftValue, floatType);
-                rightValue = castValueToType(rightValue, floatType);
+            leftValue = castValueToType(leftValue, operandType, leftUnsigned);
+            rightValue = castValueToType(rightValue, operandType, rightUnsigned);
+            if (operandType->isFloatingPointTy()) {
                 if (!leftValue || !rightValue) {
                     return logError("Type conversion failed for floating-point comparison");
                 }
@@ -885,16 +1697,6 @@ llvm::Value* CodeGenerator::visit(BinaryExprAST& node) {
                 }
             }
 
-            if (!leftValue->getType()->isIntegerTy() || !rightValue->getType()->isIntegerTy()) {
-                return logError("Comparison requires numeric operands");
-            }
-
-            const unsigned maxBits = std::max(leftValue->getType()->getIntegerBitWidth(), rightValue->getType()->getIntegerBitWidth());
-            llvm::Type* targetType = llvm::Type::getIntNTy(TheContext, maxBits);
-            const bool useUnsignedIntegerOps = isUnsignedValue(leftValue) || isUnsignedValue(rightValue);
-            leftValue = castValueToType(leftValue, targetType);
-            rightValue = castValueToType(rightValue, targetType);
-
             switch (node.getOp()) {
                 case BinaryExprAST::LESS_THAN:
                     return useUnsignedIntegerOps
@@ -946,6 +1748,10 @@ llvm::Value* CodeGenerator::visit(BinaryExprAST& node) {
 }
 
 llvm::Value* CodeGenerator::visit(UnaryExprAST& node) {
+    if (node.hasConstantValue()) {
+        return createConstant(node.getConstantValue());
+    }
+
     llvm::Value* operandValue = node.getOperand()->codegen(*this);
     if (!operandValue) {
         return nullptr;
@@ -980,56 +1786,99 @@ llvm::Value* CodeGenerator::visit(VarDeclStmtAST& node) {
     }
 
     // Array declaration
-    if (const auto* arrTypeAST = dynamic_cast<const ArrayTypeAST*>(node.getType())) {
+    if (const auto* arrTypeAST = llvm::dyn_cast<ArrayTypeAST>(node.getType())) {
         llvm::Type* elemLLVMType = getLLVMType(arrTypeAST->getElementType());
         if (!elemLLVMType) return logError("Invalid array element type");
 
-        uint64_t arraySize = 0;
+        llvm::Type* int64Type = llvm::Type::getInt64Ty(TheContext);
+        llvm::Value* lengthValue = nullptr;
+        std::optional<uint64_t> staticLength;
         std::vector<llvm::Value*> initValues;
 
-        if (const auto* literal = dynamic_cast<const ArrayLiteralExprAST*>(node.getInitializer())) {
-            arraySize = literal->getElements().size();
-            const std::optional<unsigned> prevBits = ExpectedIntegerResultBits;
-            if (elemLLVMType->isIntegerTy() && !elemLLVMType->isIntegerTy(1))
-                ExpectedIntegerResultBits = elemLLVMType->getIntegerBitWidth();
-            else
-                ExpectedIntegerResultBits = std::nullopt;
+        if (const auto* literal = llvm::dyn_cast_or_null<ArrayLiteralExprAST>(node.getInitializer())) {
+            staticLength = literal->getElements().size();
+            lengthValue = llvm::ConstantInt::get(int64Type, *staticLength);
             for (const auto& elem : literal->getElements()) {
                 llvm::Value* val = elem->codegen(*this);
-                if (!val) { ExpectedIntegerResultBits = prevBits; return nullptr; }
-                val = castValueToType(val, elemLLVMType);
-                if (!val) { ExpectedIntegerResultBits = prevBits; return logError("Array literal element type mismatch"); }
+                if (!val) return nullptr;
+                val = castValueToType(normalizeFractionValue(val, elem), elemLLVMType, isUnsignedExpr(elem));
+                if (!val) return logError("Array literal element type mismatch");
                 initValues.push_back(val);
             }
-            ExpectedIntegerResultBits = prevBits;
-        } else if (const auto* newExpr = dynamic_cast<const ArrayNewExprAST*>(node.getInitializer())) {
-            const auto* sizeInt = dynamic_cast<const IntegerExprAST*>(newExpr->getSize());
-            if (!sizeInt) return logError("Array size must be an integer literal");
-            arraySize = static_cast<uint64_t>(sizeInt->getValue());
+        } else if (const auto* newExpr = llvm::dyn_cast_or_null<ArrayNewExprAST>(node.getInitializer())) {
+            if (const std::optional<int64_t> literalSize = getStaticIntegerIndex(newExpr->getSize())) {
+                if (*literalSize < 0) return logError("Array size must not be negative");
+                staticLength = static_cast<uint64_t>(*literalSize);
+            }
+
+            llvm::Value* sizeValue = newExpr->getSize()->codegen(*this);
+            if (!sizeValue) return nullptr;
+            if (!sizeValue->getType()->isIntegerTy() || sizeValue->getType()->isIntegerTy(1) || isFractionalValue(sizeValue)) {
+                return logError("Array size must be an integer expression");
+            }
+            lengthValue = castValueToType(sizeValue, int64Type, isUnsignedExpr(newExpr->getSize()));
         } else {
             return logError("Array variable requires a literal {} or new[] initializer");
         }
 
-        llvm::ArrayType* arrType = llvm::ArrayType::get(elemLLVMType, arraySize);
-        llvm::AllocaInst* arrAlloca = createEntryBlockAlloca(CurrentFunction, arrType, node.getName());
+        llvm::AllocaInst* header = createEntryBlockArrayHeader(CurrentFunction, node.getName());
+
+        // Constant literal elements come from one private global. A fully constant array whose
+        // elements are never assigned uses the global in place and owns no storage; otherwise
+        // the global is copied into fresh storage and the remaining elements are stored.
+        llvm::GlobalVariable* literalGlobal = createArrayLiteralGlobal(elemLLVMType, initValues, node.getName());
+        const bool allElementsConstant = std::all_of(initValues.begin(), initValues.end(), [](llvm::Value* value) { return llvm::isa<llvm::Constant>(value); });
+        const bool ownsStorage = !literalGlobal || !allElementsConstant || node.hasAssignedElements();
+
+        // The array cannot outlive the method, so fresh storage of static size can be a frame
+        // slot. A declaration that executes again reuses the slot: the previous array is no
+        // longer reachable once the variable is redeclared.
+        const uint64_t elementBytes = TheModule->getDataLayout().getTypeAllocSize(elemLLVMType);
+        const bool stackStorage = ownsStorage && staticLength && *staticLength <= StackArrayByteLimit / elementBytes;
+
+        llvm::Value* data = literalGlobal;
+        if (stackStorage) {
+            llvm::AllocaInst* slot = createEntryBlockAlloca(CurrentFunction, llvm::ArrayType::get(elemLLVMType, *staticLength), node.getName() + ".storage");
+            slot->setAlignment(llvm::Align(ArrayStorageAlignment));
+            data = slot;
+            if (initValues.empty() && *staticLength > 0) {
+                Builder.CreateMemSet(data, Builder.getInt8(0), *staticLength * elementBytes, llvm::MaybeAlign(ArrayStorageAlignment));
+            }
+        } else if (ownsStorage) {
+            // Free the storage of a previous execution of this declaration before replacing it.
+            llvm::FunctionCallee freeFunction = TheModule->getOrInsertFunction(
+                "free", llvm::FunctionType::get(llvm::Type::getVoidTy(TheContext), {llvm::PointerType::getUnqual(TheContext)}, false));
+            Builder.CreateCall(freeFunction, {loadArrayData(header, node.getName())});
+
+            data = allocateArrayStorage(elemLLVMType, lengthValue, initValues.empty(), node.getName());
+        }
 
-        if (!initValues.empty()) {
-            llvm::Value* zero64 = llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), 0);
-            for (uint64_t i = 0; i < arraySize; i++) {
-                llvm::Value* idx64 = llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), i);
-                llvm::Value* gep = Builder.CreateGEP(arrType, arrAlloca, {zero64, idx64}, "arr.init.ptr");
+        if (ownsStorage) {
+            if (literalGlobal) {
+                Builder.CreateMemCpy(data, llvm::MaybeAlign(ArrayStorageAlignment), literalGlobal, llvm::MaybeAlign(ArrayStorageAlignment),
+                    llvm::ConstantExpr::getSizeOf(literalGlobal->getValueType()));
+            }
+            for (uint64_t i = 0; i < initValues.size(); i++) {
+                if (literalGlobal && llvm::isa<llvm::Constant>(initValues[i])) {
+                    continue;
+                }
+                llvm::Value* gep = Builder.CreateInBoundsGEP(elemLLVMType, data, {llvm::ConstantInt::get(int64Type, i)}, "arr.init.ptr");
                 Builder.CreateStore(initValues[i], gep);
             }
-        } else {
-            Builder.CreateStore(llvm::ConstantAggregateZero::get(arrType), arrAlloca);
         }
 
-        setNamedValue(node.getName(), arrAlloca);
-        NamedArrayTypes[node.getName()] = arrType;
-        if (const auto* primitiveElementType = getPrimitiveType(arrTypeAST->getElementType())) {
-            NamedArrayElementKinds[node.getName()] = primitiveElementType->getKind();
+        llvm::Value* headerValue = llvm::UndefValue::get(getArrayHeaderType());
+        headerValue = Builder.CreateInsertValue(headerValue, data, {0}, "arr.header.data");
+        headerValue = Builder.CreateInsertValue(headerValue, lengthValue, {1}, "arr.header.len");
+        Builder.CreateStore(headerValue, header);
+
+        if (ownsStorage && !stackStorage) {
+            CurrentFunctionArrays.push_back(header);
         }
-        return arrAlloca;
+        Symbol& symbol = declareNamedValue(node.getName(), header);
+        symbol.arrayElementType = elemLLVMType;
+        symbol.arrayStaticLength = staticLength;
+        return header;
     }
 
     llvm::Type* variableType = getLLVMType(node.getType());
@@ -1042,28 +1891,11 @@ llvm::Value* CodeGenerator::visit(VarDeclStmtAST& node) {
 
     llvm::Value* initValue = nullptr;
     if (node.getInitializer()) {
-        const std::optional<unsigned> previousExpectedBits = ExpectedIntegerResultBits;
-        const std::optional<PrimitiveTypeAST::PrimitiveKind> previousExpectedFractionKind = ExpectedFractionResultKind;
-        if (variableType->isIntegerTy() && !variableType->isIntegerTy(1)) {
-            ExpectedIntegerResultBits = variableType->getIntegerBitWidth();
-        } else {
-            ExpectedIntegerResultBits = std::nullopt;
-        }
-
-        if (primitiveType && isFractionalPrimitiveKind(primitiveType->getKind())) {
-            ExpectedFractionResultKind = primitiveType->getKind();
-        } else {
-            ExpectedFractionResultKind = std::nullopt;
-        }
-
         initValue = node.getInitializer()->codegen(*this);
-
-        ExpectedIntegerResultBits = previousExpectedBits;
-        ExpectedFractionResultKind = previousExpectedFractionKind;
         if (!initValue) {
             return nullptr;
         }
-        initValue = castValueToType(initValue, variableType);
+        initValue = castValueToType(normalizeFractionValue(initValue, node.getInitializer()), variableType, isUnsignedExpr(node.getInitializer()));
         if (!initValue) {
             return logError("Cannot cast initializer to variable type");
         }
@@ -1072,44 +1904,30 @@ llvm::Value* CodeGenerator::visit(VarDeclStmtAST& node) {
     }
 
     Builder.CreateStore(initValue, variableAlloca);
-    setNamedValue(node.getName(), variableAlloca);
+    Symbol& symbol = declareNamedValue(node.getName(), variableAlloca);
     if (primitiveType) {
-        setNamedPrimitiveKind(node.getName(), primitiveType->getKind());
+        symbol.primitiveKind = primitiveType->getKind();
     }
     return initValue;
 }
 
 llvm::Value* CodeGenerator::visit(AssignmentStmtAST& node) {
-    llvm::AllocaInst* variableAlloca = getNamedValue(node.getName());
-    if (!variableAlloca) {
+    const Symbol* variable = Symbols.lookup(node.getName());
+    if (!variable) {
         return logError("Assignment to unknown variable");
     }
+    llvm::AllocaInst* variableAlloca = variable->storage;
 
-    const std::optional<unsigned> previousExpectedBits = ExpectedIntegerResultBits;
-    const std::optional<PrimitiveTypeAST::PrimitiveKind> previousExpectedFractionKind = ExpectedFractionResultKind;
-    PrimitiveTypeAST::PrimitiveKind variableKind;
-    const bool hasVariableKind = getNamedPrimitiveKind(node.getName(), variableKind);
-    if (variableAlloca->getAllocatedType()->isIntegerTy() && !variableAlloca->getAllocatedType()->isIntegerTy(1)) {
-        ExpectedIntegerResultBits = variableAlloca->getAllocatedType()->getIntegerBitWidth();
-    } else {
-        ExpectedIntegerResultBits = std::nullopt;
-    }
-
-    if (hasVariableKind && isFractionalPrimitiveKind(variableKind)) {
-        ExpectedFractionResultKind = variableKind;
-    } else {
-        ExpectedFractionResultKind = std::nullopt;
+    if (variable->isArray()) {
+        return logError("Array variables cannot be reassigned; assign individual elements with array[i]");
     }
 
     llvm::Value* assignedValue = node.getValue()->codegen(*this);
-
-    ExpectedIntegerResultBits = previousExpectedBits;
-    ExpectedFractionResultKind = previousExpectedFractionKind;
     if (!assignedValue) {
         return nullptr;
     }
 
-    assignedValue = castValueToType(assignedValue, variableAlloca->getAllocatedType());
+    assignedValue = castValueToType(normalizeFractionValue(assignedValue, node.getValue()), variableAlloca->getAllocatedType(), isUnsignedExpr(node.getValue()));
     if (!assignedValue) {
         return logError("Cannot cast assigned value to variable type");
     }
@@ -1119,36 +1937,43 @@ llvm::Value* CodeGenerator::visit(AssignmentStmtAST& node) {
 }
 
 llvm::Value* CodeGenerator::visit(BlockStmtAST& node) {
+    Symbols.pushScope();
     llvm::Value* lastValue = nullptr;
     for (const auto& statement : node.getStatements()) {
         lastValue = statement->codegen(*this);
         if (!lastValue && !Builder.GetInsertBlock()->getTerminator()) {
-            return nullptr;
+            break;
         }
         if (Builder.GetInsertBlock()->getTerminator()) {
             break;
         }
     }
+    Symbols.popScope();
 
     return lastValue;
 }
 
 llvm::Value* CodeGenerator::visit(PrintStmtAST& node) {
-    llvm::Value* value = node.getValue()->codegen(*this);
+    llvm::Value* value = normalizeFractionValue(node.getValue()->codegen(*this), node.getValue());
     if (!value) {
         return nullptr;
     }
 
-    llvm::FunctionCallee printfFunction = getPrintfFunction();
     llvm::Type* type = value->getType();
-    PrimitiveTypeAST::PrimitiveKind primitiveKind;
-    const bool hasPrimitiveKind = getValuePrimitiveKind(value, primitiveKind);
+    const bool hasPrimitiveKind = node.getValue()->hasPrimitiveKind();
+    const PrimitiveTypeAST::PrimitiveKind primitiveKind = node.getValue()->getPrimitiveKind();
 
     // Guard: arrays cannot be printed directly
-    if (type->isArrayTy()) {
+    if (type == getArrayHeaderType()) {
         return logError("Defaultlogger.logln does not support array values directly; print individual elements with array[i]");
     }
 
+    if (Options.useOutputRuntime) {
+        return emitRuntimePrint(value, hasPrimitiveKind, primitiveKind);
+    }
+
+    llvm::FunctionCallee printfFunction = getPrintfFunction();
+
     if (hasPrimitiveKind && isFractionalPrimitiveKind(primitiveKind)) {
         llvm::Value* numerator = nullptr;
         llvm::Value* denominator = nullptr;
@@ -1285,39 +2110,328 @@ llvm::Value* CodeGenerator::visit(WhileStmtAST& node) {
         return logError("While statement outside of function");
     }
 
+    llvm::Function* function = Builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(TheContext, "while.end");
+
+    // Loop versioning: when the hoisted condition holds, run a copy of the loop whose
+    // induction-indexed accesses carry no per-iteration checks; otherwise fall back to the
+    // fully checked copy. Only innermost loops are copied, so no statement is generated more
+    // than twice. A loop with nested loops keeps one body, whose checks on the proven accesses
+    // also test the hoisted condition.
+    const auto outerProvenAccesses = ProvenInBoundsAccesses;
+    std::vector<BoundsProvenAccess> provenAccesses;
+    llvm::Value* hoistedCondition = createHoistedBoundsCondition(node, provenAccesses);
+    if (hoistedCondition && llvm::isa<llvm::Constant>(hoistedCondition)) {
+        // Proven without an entry check, so the loop is not copied.
+        assumeInBounds(provenAccesses, nullptr);
+    } else if (hoistedCondition && containsLoop(node.getBody())) {
+        assumeInBounds(provenAccesses, hoistedCondition);
+    } else if (hoistedCondition) {
+        llvm::BasicBlock* uncheckedBlock = llvm::BasicBlock::Create(TheContext, "while.unchecked", function);
+        llvm::BasicBlock* checkedBlock = llvm::BasicBlock::Create(TheContext, "while.checked", function);
+        llvm::MDBuilder metadataBuilder(TheContext);
+        Builder.CreateCondBr(hoistedCondition, uncheckedBlock, checkedBlock, metadataBuilder.createBranchWeights(1u << 20, 1));
+
+        Builder.SetInsertPoint(uncheckedBlock);
+        assumeInBounds(provenAccesses, nullptr);
+        const bool emitted = emitWhileLoop(node, exitBlock);
+        ProvenInBoundsAccesses = outerProvenAccesses;
+        if (!emitted) {
+            delete exitBlock;
+            return nullptr;
+        }
+
+        Builder.SetInsertPoint(checkedBlock);
+    }
+
+    const bool emitted = emitWhileLoop(node, exitBlock);
+    ProvenInBoundsAccesses = outerProvenAccesses;
+    if (!emitted) {
+        if (!exitBlock->getParent()) {
+            delete exitBlock;
+        }
+        return nullptr;
+    }
+
+    exitBlock->insertInto(function);
+    Builder.SetInsertPoint(exitBlock);
+
+    return llvm::ConstantInt::getTrue(TheContext);
+}
+
+bool CodeGenerator::emitWhileLoop(WhileStmtAST& node, llvm::BasicBlock* exitBlock) {
     llvm::Function* function = Builder.GetInsertBlock()->getParent();
 
     llvm::BasicBlock* conditionBlock = llvm::BasicBlock::Create(TheContext, "while.cond", function);
     llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(TheContext, "while.body", function);
-    llvm::BasicBlock* exitBlock = llvm::BasicBlock::Create(TheContext, "while.end", function);
 
     Builder.CreateBr(conditionBlock);
 
     Builder.SetInsertPoint(conditionBlock);
     llvm::Value* conditionValue = node.getCondition()->codegen(*this);
     if (!conditionValue) {
-        return nullptr;
+        return false;
     }
     conditionValue = castToBoolean(conditionValue);
     if (!conditionValue) {
-        return logError("While condition is not boolean-compatible");
+        logError("While condition is not boolean-compatible");
+        return false;
     }
     Builder.CreateCondBr(conditionValue, bodyBlock, exitBlock);
 
     Builder.SetInsertPoint(bodyBlock);
     if (!node.getBody()->codegen(*this) && !Builder.GetInsertBlock()->getTerminator()) {
-        return nullptr;
+        return false;
     }
     if (!Builder.GetInsertBlock()->getTerminator()) {
         Builder.CreateBr(conditionBlock);
     }
 
-    Builder.SetInsertPoint(exitBlock);
+    return true;
+}
 
-    return llvm::ConstantInt::getTrue(TheContext);
+// Lowers to the counted loop of emitForallLoop. The bounds are evaluated once and widened to
+// 128 bits, so normalizing them to the half-open [lower, upper) and taking the range length
+// cannot wrap; values past i64, which v could not hold, are clamped away.
+llvm::Value* CodeGenerator::visit(ForallExprAST& node) {
+    if (!CurrentFunction) {
+        return logError("Forall expression outside of function");
+    }
+
+    llvm::Type* int64Type = llvm::Type::getInt64Ty(TheContext);
+    llvm::Type* wideType = llvm::Type::getInt128Ty(TheContext);
+    ExprAST* boundExprs[] = {node.getLower(), node.getUpper()};
+    llvm::Value* bounds[2] = {};
+    for (int bound = 0; bound < 2; ++bound) {
+        llvm::Value* value = boundExprs[bound]->codegen(*this);
+        if (!value) {
+            return nullptr;
+        }
+        if (!value->getType()->isIntegerTy() || value->getType()->getIntegerBitWidth() == 1) {
+            return logError("Forall bounds must be integer expressions");
+        }
+        bounds[bound] = Builder.CreateIntCast(value, wideType, !isUnsignedExpr(boundExprs[bound]), bound == 0 ? "forall.lo" : "forall.hi");
+    }
+
+    llvm::Value* one = llvm::ConstantInt::get(wideType, 1);
+    llvm::Value* lower = node.isLowerInclusive() ? bounds[0] : Builder.CreateAdd(bounds[0], one, "forall.lo.next");
+    llvm::Value* upper = node.isUpperInclusive() ? Builder.CreateAdd(bounds[1], one, "forall.hi.next") : bounds[1];
+    llvm::Value* int64End = llvm::ConstantInt::get(wideType, llvm::APInt::getSignedMinValue(64).zext(128));
+    lower = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::smin, lower, int64End, nullptr, "forall.lower");
+    upper = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::smin, upper, int64End, nullptr, "forall.upper");
+
+    llvm::Value* length = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::smax, Builder.CreateSub(upper, lower, "forall.span"), llvm::ConstantInt::get(wideType, 0), nullptr, "forall.length");
+    length = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::umin, length, llvm::ConstantInt::get(wideType, llvm::APInt::getMaxValue(64).zext(128)));
+    llvm::Value* count = Builder.CreateTrunc(length, int64Type, "forall.count");
+
+    llvm::Value* iterations = count;
+    llvm::Value* step = llvm::ConstantInt::get(int64Type, 1);
+    llvm::Value* lastOffset = nullptr;
+    if (Options.quantifiers != QuantifierMode::Full) {
+        llvm::Value* limit = llvm::ConstantInt::get(int64Type, QuantifierSampleLimit);
+        llvm::Value* large = Builder.CreateICmpUGT(count, limit, "forall.large");
+        if (Options.quantifiers == QuantifierMode::Sampled) {
+            // The stride never reaches the end of the range, so the last sample is moved onto
+            // its final value, where an off-by-one in the clause most often shows.
+            iterations = Builder.CreateSelect(large, limit, count, "forall.samples");
+            step = Builder.CreateSelect(large, Builder.CreateUDiv(count, limit), step, "forall.stride");
+            lastOffset = Builder.CreateSub(count, llvm::ConstantInt::get(int64Type, 1), "forall.last");
+        } else {
+            iterations = Builder.CreateSelect(large, llvm::ConstantInt::get(int64Type, 0), count, "forall.checked");
+        }
+    }
+
+    llvm::AllocaInst* variable = createEntryBlockAlloca(CurrentFunction, int64Type, node.getVariable());
+    Symbols.pushScope();
+    declareNamedValue(node.getVariable(), variable).primitiveKind = PrimitiveTypeAST::INT64;
+
+    // Accesses proven for an outer binding of the same name do not apply to this one.
+    const auto outerProvenAccesses = ProvenInBoundsAccesses;
+    for (auto access = ProvenInBoundsAccesses.begin(); access != ProvenInBoundsAccesses.end();) {
+        if (std::get<1>(access->first) == node.getVariable()) {
+            access = ProvenInBoundsAccesses.erase(access);
+        } else {
+            ++access;
+        }
+    }
+    const auto visibleProvenAccesses = ProvenInBoundsAccesses;
+
+    llvm::Value* lower64 = Builder.CreateTrunc(lower, int64Type, "forall.first");
+    llvm::BasicBlock* mergeBlock = llvm::BasicBlock::Create(TheContext, "forall.end");
+    std::vector<std::pair<llvm::Value*, llvm::BasicBlock*>> results;
+
+    // Loop versioning as for while loops: the copy for a range that fits every array the
+    // body indexes with v carries no checks, which keeps its blocks vectorizable. A body with
+    // a nested forall is only generated once.
+    std::vector<BoundsProvenAccess> provenAccesses;
+    llvm::Value* result = nullptr;
+    bool emitted = true;
+    llvm::Value* inBounds = createForallBoundsCondition(node, lower, upper, provenAccesses);
+    if (inBounds && containsLoop(node.getBody())) {
+        assumeInBounds(provenAccesses, inBounds);
+    } else if (inBounds) {
+        llvm::BasicBlock* uncheckedBlock = llvm::BasicBlock::Create(TheContext, "forall.unchecked", CurrentFunction);
+        llvm::BasicBlock* checkedBlock = llvm::BasicBlock::Create(TheContext, "forall.checked", CurrentFunction);
+        llvm::MDBuilder metadataBuilder(TheContext);
+        Builder.CreateCondBr(inBounds, uncheckedBlock, checkedBlock, metadataBuilder.createBranchWeights(1u << 20, 1));
+
+        Builder.SetInsertPoint(uncheckedBlock);
+        assumeInBounds(provenAccesses, nullptr);
+        result = emitForallLoop(node, variable, lower64, iterations, step, lastOffset);
+        ProvenInBoundsAccesses = visibleProvenAccesses;
+        emitted = result != nullptr;
+        if (emitted) {
+            results.emplace_back(result, Builder.GetInsertBlock());
+            Builder.CreateBr(mergeBlock);
+            Builder.SetInsertPoint(checkedBlock);
+        }
+    }
+    if (emitted) {
+        result = emitForallLoop(node, variable, lower64, iterations, step, lastOffset);
+    }
+
+    Symbols.popScope();
+    ProvenInBoundsAccesses = outerProvenAccesses;
+    if (!result) {
+        delete mergeBlock;
+        return nullptr;
+    }
+
+    results.emplace_back(result, Builder.GetInsertBlock());
+    Builder.CreateBr(mergeBlock);
+    mergeBlock->insertInto(CurrentFunction);
+    Builder.SetInsertPoint(mergeBlock);
+    llvm::PHINode* holds = Builder.CreatePHI(Builder.getInt1Ty(), results.size(), "forall.holds");
+    for (const auto& [value, block] : results) {
+        holds->addIncoming(value, block);
+    }
+    return holds;
+}
+
+// When true on entry, every `array[v + c]` in the body of a forall over [lower, upper) is in
+// bounds for each value of v: the range is empty, or lower + c >= 0 and upper + c <= length
+// for each such access. lower and upper are the 128-bit bounds, so none of this wraps.
+// Returns nullptr when the body has no such access.
+llvm::Value* CodeGenerator::createForallBoundsCondition(ForallExprAST& node, llvm::Value* lower, llvm::Value* upper, std::vector<BoundsProvenAccess>& outProvenAccesses) {
+    if (Options.boundsChecks != BoundsCheckMode::Hoisted) {
+        return nullptr;
+    }
+
+    std::set<std::pair<std::string, int64_t>> accesses;
+    collectOffsetAccesses(node.getBody(), node.getVariable(), accesses);
+
+    llvm::Type* wideType = llvm::Type::getInt128Ty(TheContext);
+    llvm::Value* safe = nullptr;
+    for (const auto& [arrayName, offset] : accesses) {
+        const Symbol* array = Symbols.lookup(arrayName);
+        if (!array || !array->isArray()) {
+            continue;
+        }
+
+        llvm::Value* offsetValue = llvm::ConstantInt::get(wideType, static_cast<uint64_t>(offset), true);
+        llvm::Value* length = Builder.CreateZExt(loadArrayLength(array->storage, arrayName), wideType, arrayName + ".forall.len");
+        llvm::Value* fits = Builder.CreateAnd(
+            Builder.CreateICmpSGE(Builder.CreateAdd(lower, offsetValue), llvm::ConstantInt::get(wideType, 0), arrayName + ".forall.first"),
+            Builder.CreateICmpSLE(Builder.CreateAdd(upper, offsetValue), length, arrayName + ".forall.last"),
+            arrayName + ".forall.fits");
+        safe = safe ? Builder.CreateAnd(safe, fits, "forall.safe") : fits;
+        outProvenAccesses.emplace_back(arrayName, node.getVariable(), offset);
+    }
+
+    if (!safe) {
+        return nullptr;
+    }
+    return Builder.CreateOr(Builder.CreateICmpSGE(lower, upper, "forall.empty"), safe, "forall.inbounds");
+}
+
+// Evaluates body for v = lower + k * step, k in [0, iterations), and returns whether it held
+// for all of them. A lastOffset replaces k * step for the last k. The outer loop walks blocks of QuantifierBlockSize values and stops at the
+// first block with a failure; the inner loop and-reduces the block without branching out, so
+// together with its vectorize metadata it becomes a SIMD compare and reduction.
+llvm::Value* CodeGenerator::emitForallLoop(ForallExprAST& node, llvm::AllocaInst* variable, llvm::Value* lower, llvm::Value* iterations, llvm::Value* step, llvm::Value* lastOffset) {
+    llvm::Type* int64Type = llvm::Type::getInt64Ty(TheContext);
+    llvm::BasicBlock* entryBlock = Builder.GetInsertBlock();
+    llvm::BasicBlock* conditionBlock = llvm::BasicBlock::Create(TheContext, "forall.cond", CurrentFunction);
+    llvm::BasicBlock* blockStart = llvm::BasicBlock::Create(TheContext, "forall.block", CurrentFunction);
+    llvm::BasicBlock* bodyBlock = llvm::BasicBlock::Create(TheContext, "forall.body", CurrentFunction);
+    llvm::BasicBlock* blockEnd = llvm::BasicBlock::Create(TheContext, "forall.block.end", CurrentFunction);
+    llvm::BasicBlock* doneBlock = llvm::BasicBlock::Create(TheContext, "forall.done", CurrentFunction);
+    Builder.CreateBr(conditionBlock);
+
+    Builder.SetInsertPoint(conditionBlock);
+    llvm::PHINode* start = Builder.CreatePHI(int64Type, 2, "forall.start");
+    start->addIncoming(llvm::ConstantInt::get(int64Type, 0), entryBlock);
+    Builder.CreateCondBr(Builder.CreateICmpULT(start, iterations, "forall.more"), blockStart, doneBlock);
+
+    Builder.SetInsertPoint(blockStart);
+    llvm::Value* blockLimit = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::uadd_sat, start, llvm::ConstantInt::get(int64Type, QuantifierBlockSize));
+    llvm::Value* end = Builder.CreateBinaryIntrinsic(llvm::Intrinsic::umin, blockLimit, iterations, nullptr, "forall.block.limit");
+    Builder.CreateBr(bodyBlock);
+
+    Builder.SetInsertPoint(bodyBlock);
+    llvm::PHINode* position = Builder.CreatePHI(int64Type, 2, "forall.k");
+    position->addIncoming(start, blockStart);
+    llvm::PHINode* holdsSoFar = Builder.CreatePHI(Builder.getInt1Ty(), 2, "forall.acc");
+    holdsSoFar->addIncoming(Builder.getTrue(), blockStart);
+
+    auto* constantStep = llvm::dyn_cast<llvm::ConstantInt>(step);
+    llvm::Value* offset = constantStep && constantStep->isOne() ? position : Builder.CreateMul(position, step, "forall.offset");
+    if (lastOffset) {
+        llvm::Value* isLast = Builder.CreateICmpEQ(position, Builder.CreateSub(iterations, llvm::ConstantInt::get(int64Type, 1)), "forall.is.last");
+        offset = Builder.CreateSelect(isLast, lastOffset, offset, "forall.offset.last");
+    }
+    Builder.CreateStore(Builder.CreateAdd(lower, offset, node.getVariable()), variable);
+
+    llvm::Value* holds = node.getBody()->codegen(*this);
+    if (!holds) {
+        return nullptr;
+    }
+    holds = castToBoolean(holds);
+    if (!holds) {
+        logError("Forall body is not boolean-compatible");
+        return nullptr;
+    }
+
+    llvm::Value* holdsThrough = Builder.CreateAnd(holdsSoFar, holds, "forall.acc.next");
+    llvm::Value* next = Builder.CreateNUWAdd(position, llvm::ConstantInt::get(int64Type, 1), "forall.k.next");
+    llvm::BasicBlock* latchBlock = Builder.GetInsertBlock();
+    position->addIncoming(next, latchBlock);
+    holdsSoFar->addIncoming(holdsThrough, latchBlock);
+    llvm::BranchInst* latch = Builder.CreateCondBr(Builder.CreateICmpULT(next, end, "forall.block.more"), bodyBlock, blockEnd);
+    latch->setMetadata(llvm::LLVMContext::MD_loop, createVectorizedLoopMetadata());
+
+    Builder.SetInsertPoint(blockEnd);
+    start->addIncoming(end, blockEnd);
+    llvm::MDBuilder metadataBuilder(TheContext);
+    Builder.CreateCondBr(holdsThrough, conditionBlock, doneBlock, metadataBuilder.createBranchWeights(1u << 20, 1));
+
+    Builder.SetInsertPoint(doneBlock);
+    llvm::PHINode* result = Builder.CreatePHI(Builder.getInt1Ty(), 2, "forall.result");
+    result->addIncoming(Builder.getTrue(), conditionBlock);
+    result->addIncoming(Builder.getFalse(), blockEnd);
+    return result;
+}
+
+// A distinct loop ID that asks the loop vectorizer to vectorize the loop it is attached to.
+llvm::MDNode* CodeGenerator::createVectorizedLoopMetadata() {
+    llvm::Metadata* properties[] = {
+        nullptr,
+        llvm::MDNode::get(TheContext, llvm::MDString::get(TheContext, "llvm.loop.mustprogress")),
+        llvm::MDNode::get(TheContext, {
+            llvm::MDString::get(TheContext, "llvm.loop.vectorize.enable"),
+            llvm::ConstantAsMetadata::get(llvm::ConstantInt::getTrue(TheContext))}),
+    };
+    llvm::MDNode* loopID = llvm::MDNode::getDistinct(TheContext, properties);
+    loopID->replaceOperandWith(0, loopID);
+    return loopID;
 }
 
 llvm::Value* CodeGenerator::visit(MethodImplAST& node) {
+    // Qualified by unit and class, so methods of the same name never share a timer, not even
+    // when two units declaring the same class are generated concurrently.
+    const std::string qualifiedName = CurrentClass ? CurrentClass->getName() + "." + node.getName() : node.getName();
+    PhaseScope codegenScope("CodeGenMethod", TheModule->getModuleIdentifier() + ": " + qualifiedName, PhaseScope::Report::CodeGenDetail);
+
     llvm::Type* returnType = getLLVMType(node.getReturnType());
     if (!returnType) {
         return logError("Unknown method return type");
@@ -1333,53 +2447,77 @@ llvm::Value* CodeGenerator::visit(MethodImplAST& node) {
         parameterTypes.push_back(parameterType);
     }
 
-    std::string functionName;
-    if (CurrentClassIsApplication && node.getName() == "main") {
-        functionName = "System.Application.main";
-    } else if (!CurrentClassName.empty()) {
-        functionName = CurrentClassName + "." + node.getName();
-    } else {
-        functionName = node.getName();
-    }
+    const std::string functionName = CurrentClass ? CurrentClass->getMethodSymbolName(node) : node.getName();
 
     llvm::FunctionType* functionType = llvm::FunctionType::get(returnType, parameterTypes, false);
-    llvm::Function* function = llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, functionName, TheModule.get());
+    // Every unit that instantiates a generic class with the same type arguments emits the same
+    // definition, so the linker may keep any one of them.
+    const bool isInstantiation = CurrentClass && CurrentClass->isInstantiation();
+    const llvm::GlobalValue::LinkageTypes linkage = isInstantiation ? llvm::Function::WeakODRLinkage : llvm::Function::ExternalLinkage;
+    llvm::Function* function = llvm::Function::Create(functionType, linkage, functionName, TheModule.get());
 
     llvm::BasicBlock* entryBlock = llvm::BasicBlock::Create(TheContext, "entry", function);
     Builder.SetInsertPoint(entryBlock);
 
-    std::map<std::string, llvm::AllocaInst*> previousNamedValues = NamedValues;
-    std::map<std::string, PrimitiveTypeAST::PrimitiveKind> previousNamedPrimitiveKinds = NamedPrimitiveKinds;
-    std::map<std::string, PrimitiveTypeAST::PrimitiveKind> previousNamedArrayElementKinds = NamedArrayElementKinds;
-    std::map<std::string, llvm::ArrayType*> previousNamedArrayTypes = NamedArrayTypes;
+    std::vector<llvm::AllocaInst*> previousFunctionArrays = CurrentFunctionArrays;
     llvm::Function* previousFunction = CurrentFunction;
+    llvm::BasicBlock* previousBoundsTrapBlock = CurrentBoundsTrapBlock;
     CurrentFunction = function;
-    NamedValues.clear();
-    NamedPrimitiveKinds.clear();
-    NamedArrayElementKinds.clear();
-    NamedArrayTypes.clear();
+    CurrentBoundsTrapBlock = nullptr;
+    Symbols.pushScope();
+    CurrentFunctionArrays.clear();
 
     auto argumentIterator = function->arg_begin();
     for (const auto& parameter : node.getParams()) {
         argumentIterator->setName(parameter->getName());
         llvm::AllocaInst* parameterAlloca = createEntryBlockAlloca(function, argumentIterator->getType(), parameter->getName());
         Builder.CreateStore(argumentIterator, parameterAlloca);
-        setNamedValue(parameter->getName(), parameterAlloca);
+        Symbol& symbol = declareNamedValue(parameter->getName(), parameterAlloca);
         const PrimitiveTypeAST* parameterPrimitiveType = getPrimitiveType(parameter->getType());
         if (parameterPrimitiveType) {
-            setNamedPrimitiveKind(parameter->getName(), parameterPrimitiveType->getKind());
+            symbol.primitiveKind = parameterPrimitiveType->getKind();
         }
         ++argumentIterator;
     }
 
+    // Ticks run from here to the fall-through return, so they include the contract checks
+    llvm::GlobalVariable* profileRecord = nullptr;
+    llvm::Value* profileStart = nullptr;
+    if (Options.instrumentFunctions) {
+        llvm::Type* counterType = llvm::Type::getInt64Ty(TheContext);
+        profileRecord = createFunctionProfileRecord(functionName);
+        llvm::FunctionCallee profileEnter = TheModule->getOrInsertFunction(
+            "__bp_profile_enter", llvm::FunctionType::get(counterType, {profileRecord->getType()}, false));
+        profileStart = Builder.CreateCall(profileEnter, {profileRecord}, "profile.start");
+    }
+
+    auto abandonFunction = [&]() {
+        function->eraseFromParent();
+        if (profileRecord) {
+            profileRecord->eraseFromParent();
+        }
+        Symbols.popScope();
+        CurrentFunctionArrays = previousFunctionArrays;
+        CurrentFunction = previousFunction;
+        CurrentBoundsTrapBlock = previousBoundsTrapBlock;
+    };
+
+    const bool checkPreconditions = Options.contracts == ContractMode::Full || Options.contracts == ContractMode::Preconditions
+        || (Options.contracts == ContractMode::Boundary && node.isPublic());
+    const bool checkPostconditions = Options.contracts == ContractMode::Full
+        || (Options.contracts == ContractMode::Boundary && node.isPublic());
+    if (checkPreconditions) {
+        for (ExprAST* precondition : node.getPreconditions()) {
+            if (!createContractCheck(precondition, "requires", node.getName())) {
+                abandonFunction();
+                return nullptr;
+            }
+        }
+    }
+
     for (const auto& statement : node.getBody()) {
         if (!statement->codegen(*this) && !Builder.GetInsertBlock()->getTerminator()) {
-            function->eraseFromParent();
-            NamedValues = previousNamedValues;
-            NamedPrimitiveKinds = previousNamedPrimitiveKinds;
-            NamedArrayElementKinds = previousNamedArrayElementKinds;
-            NamedArrayTypes = previousNamedArrayTypes;
-            CurrentFunction = previousFunction;
+            abandonFunction();
             return nullptr;
         }
 
@@ -1389,6 +2527,20 @@ llvm::Value* CodeGenerator::visit(MethodImplAST& node) {
     }
 
     if (!Builder.GetInsertBlock()->getTerminator()) {
+        if (checkPostconditions) {
+            for (ExprAST* postcondition : node.getPostconditions()) {
+                if (!createContractCheck(postcondition, "ensures", node.getName())) {
+                    abandonFunction();
+                    return nullptr;
+                }
+            }
+        }
+        if (profileRecord) {
+            llvm::FunctionCallee profileExit = TheModule->getOrInsertFunction("__bp_profile_exit", llvm::FunctionType::get(
+                llvm::Type::getVoidTy(TheContext), {profileRecord->getType(), profileStart->getType()}, false));
+            Builder.CreateCall(profileExit, {profileRecord, profileStart});
+        }
+        releaseFunctionArrays();
         if (returnType->isVoidTy()) {
             Builder.CreateRetVoid();
         } else {
@@ -1397,23 +2549,61 @@ llvm::Value* CodeGenerator::visit(MethodImplAST& node) {
     }
 
     if (llvm::verifyFunction(*function, &llvm::errs())) {
-        function->eraseFromParent();
-        NamedValues = previousNamedValues;
-        NamedPrimitiveKinds = previousNamedPrimitiveKinds;
-        NamedArrayElementKinds = previousNamedArrayElementKinds;
-        NamedArrayTypes = previousNamedArrayTypes;
-        CurrentFunction = previousFunction;
+        abandonFunction();
         return logError("Function verification failed");
     }
 
-    NamedValues = previousNamedValues;
-    NamedPrimitiveKinds = previousNamedPrimitiveKinds;
-    NamedArrayElementKinds = previousNamedArrayElementKinds;
-    NamedArrayTypes = previousNamedArrayTypes;
+    if (isInstantiation) {
+        mergeIdenticalInstantiation(function, node.getName());
+    }
+
+    Symbols.popScope();
+    CurrentFunctionArrays = previousFunctionArrays;
     CurrentFunction = previousFunction;
+    CurrentBoundsTrapBlock = previousBoundsTrapBlock;
     return function;
 }
 
+// Instantiations whose type arguments lower to the same storage, such as i64 and u64 in a class
+// that only adds and stores them, often produce identical IR. The later copy becomes a thunk
+// that tail-calls the first, which keeps its symbol for other units while its body costs one
+// jump. The call is an ordinary one: the inliner copies the body back only where it would
+// inline it anyway, and a caller that inlines the thunk can go on to inline the body, just as
+// it could for an instantiation that was not merged.
+//
+// A thunk rather than an alias, as MergeFunctions also does by default: both methods are
+// weak_odr, and the linker may keep another unit's copy of either one. An alias would be bound
+// to this unit's body of the first instantiation, which the linker is free to discard, while a
+// thunk refers to it by symbol and works with whichever copy survives. Aliases to weak
+// definitions are also not supported on every object format, such as Mach-O.
+void CodeGenerator::mergeIdenticalInstantiation(llvm::Function* function, const std::string& methodName) {
+    std::vector<llvm::Function*>& instantiations = InstantiatedMethods[CurrentClass->getGenericName() + "." + methodName];
+    for (llvm::Function* existing : instantiations) {
+        llvm::GlobalNumberState numbering;
+        if (llvm::FunctionComparator(existing, function, &numbering).compare() != 0) {
+            continue;
+        }
+
+        const llvm::GlobalValue::LinkageTypes linkage = function->getLinkage();
+        function->deleteBody();
+        function->setLinkage(linkage);
+        Builder.SetInsertPoint(llvm::BasicBlock::Create(TheContext, "entry", function));
+        std::vector<llvm::Value*> arguments;
+        for (llvm::Argument& argument : function->args()) {
+            arguments.push_back(&argument);
+        }
+        llvm::CallInst* call = Builder.CreateCall(existing, arguments);
+        call->setTailCallKind(llvm::CallInst::TCK_Tail);
+        if (function->getReturnType()->isVoidTy()) {
+            Builder.CreateRetVoid();
+        } else {
+            Builder.CreateRet(call);
+        }
+        return;
+    }
+    instantiations.push_back(function);
+}
+
 // Array visitor implementations
 
 llvm::Value* CodeGenerator::visit(ArrayLiteralExprAST& node) {
@@ -1425,103 +2615,104 @@ llvm::Value* CodeGenerator::visit(ArrayNewExprAST& node) {
 }
 
 llvm::Value* CodeGenerator::visit(IndexExprAST& node) {
-    llvm::AllocaInst* arrAlloca = getNamedValue(node.getName());
-    if (!arrAlloca) return logError("Unknown array variable in index expression");
+    const Symbol* array = Symbols.lookup(node.getName());
+    if (!array) return logError("Unknown array variable in index expression");
 
-    auto it = NamedArrayTypes.find(node.getName());
-    if (it == NamedArrayTypes.end()) return logError("Variable is not an array");
-    llvm::ArrayType* arrType = it->second;
+    if (!array->isArray()) return logError("Variable is not an array");
+    llvm::AllocaInst* header = array->storage;
+    llvm::Type* elemType = array->arrayElementType;
 
-    const uint64_t arraySize = arrType->getNumElements();
-    if (arraySize == 0) {
-        return logError("Array index is out of bounds: cannot index into a zero-length array");
-    }
+    if (array->arrayStaticLength) {
+        const uint64_t arraySize = *array->arrayStaticLength;
+        if (arraySize == 0) {
+            return logError("Array index is out of bounds: cannot index into a zero-length array");
+        }
 
-    if (const std::optional<int64_t> staticIndex = getStaticIntegerIndex(node.getIndex())) {
-        if (*staticIndex < 0 || static_cast<uint64_t>(*staticIndex) >= arraySize) {
-            return logError("Array index is out of bounds for a compile-time known array size");
+        if (const std::optional<int64_t> staticIndex = getStaticIntegerIndex(node.getIndex())) {
+            if (*staticIndex < 0 || static_cast<uint64_t>(*staticIndex) >= arraySize) {
+                return logError("Array index is out of bounds for a compile-time known array size");
+            }
         }
     }
 
     llvm::Value* idxVal = node.getIndex()->codegen(*this);
     if (!idxVal) return nullptr;
-    idxVal = castValueToType(idxVal, llvm::Type::getInt64Ty(TheContext));
+    idxVal = castValueToType(idxVal, llvm::Type::getInt64Ty(TheContext), isUnsignedExpr(node.getIndex()));
+    if (!idxVal) return logError("Array index must be an integer expression");
+    createBoundsCheck(header, idxVal, node.getName(), node.getIndex());
 
-    llvm::Value* zero64 = llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), 0);
-    llvm::Value* gep = Builder.CreateGEP(arrType, arrAlloca, {zero64, idxVal}, "arr.idx.ptr");
-    llvm::Value* loaded = Builder.CreateLoad(arrType->getElementType(), gep, "arr.idx.val");
+    llvm::Value* data = loadArrayData(header, node.getName());
+    llvm::Value* gep = Builder.CreateInBoundsGEP(elemType, data, {idxVal}, "arr.idx.ptr");
+    return Builder.CreateLoad(elemType, gep, "arr.idx.val");
+}
 
-    // Propagate element primitive kind so print/cast paths work correctly
-    auto elemKindIt = NamedArrayElementKinds.find(node.getName());
-    if (elemKindIt != NamedArrayElementKinds.end()) {
-        setValuePrimitiveKind(loaded, elemKindIt->second);
-    } else if (arrType->getElementType()->isIntegerTy()) {
-        const unsigned bits = arrType->getElementType()->getIntegerBitWidth();
-        setValuePrimitiveKind(loaded, getIntegerPrimitiveKind(bits, false));
+llvm::Value* CodeGenerator::visit(ArrayLengthExprAST& node) {
+    const Symbol* array = Symbols.lookup(node.getName());
+    if (!array) return logError("Unknown array variable in length expression");
+
+    if (!array->isArray()) return logError("Variable is not an array");
+    if (array->arrayStaticLength) {
+        return llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), *array->arrayStaticLength);
     }
-    return loaded;
+    return loadArrayLength(array->storage, node.getName());
 }
 
 llvm::Value* CodeGenerator::visit(IndexAssignStmtAST& node) {
-    llvm::AllocaInst* arrAlloca = getNamedValue(node.getName());
-    if (!arrAlloca) return logError("Unknown array variable in index assignment");
+    const Symbol* array = Symbols.lookup(node.getName());
+    if (!array) return logError("Unknown array variable in index assignment");
 
-    auto it = NamedArrayTypes.find(node.getName());
-    if (it == NamedArrayTypes.end()) return logError("Variable is not an array");
-    llvm::ArrayType* arrType = it->second;
+    if (!array->isArray()) return logError("Variable is not an array");
+    llvm::AllocaInst* header = array->storage;
+    llvm::Type* elemType = array->arrayElementType;
 
-    const uint64_t arraySize = arrType->getNumElements();
-    if (arraySize == 0) {
-        return logError("Array index assignment is out of bounds: cannot write into a zero-length array");
-    }
+    if (array->arrayStaticLength) {
+        const uint64_t arraySize = *array->arrayStaticLength;
+        if (arraySize == 0) {
+            return logError("Array index assignment is out of bounds: cannot write into a zero-length array");
+        }
 
-    if (const std::optional<int64_t> staticIndex = getStaticIntegerIndex(node.getIndex())) {
-        if (*staticIndex < 0 || static_cast<uint64_t>(*staticIndex) >= arraySize) {
-            return logError("Array index assignment is out of bounds for a compile-time known array size");
+        if (const std::optional<int64_t> staticIndex = getStaticIntegerIndex(node.getIndex())) {
+            if (*staticIndex < 0 || static_cast<uint64_t>(*staticIndex) >= arraySize) {
+                return logError("Array index assignment is out of bounds for a compile-time known array size");
+            }
         }
     }
 
     llvm::Value* idxVal = node.getIndex()->codegen(*this);
     if (!idxVal) return nullptr;
-    idxVal = castValueToType(idxVal, llvm::Type::getInt64Ty(TheContext));
-
-    const std::optional<unsigned> prevBits = ExpectedIntegerResultBits;
-    if (arrType->getElementType()->isIntegerTy() && !arrType->getElementType()->isIntegerTy(1))
-        ExpectedIntegerResultBits = arrType->getElementType()->getIntegerBitWidth();
-    else
-        ExpectedIntegerResultBits = std::nullopt;
+    idxVal = castValueToType(idxVal, llvm::Type::getInt64Ty(TheContext), isUnsignedExpr(node.getIndex()));
+    if (!idxVal) return logError("Array index must be an integer expression");
+    createBoundsCheck(header, idxVal, node.getName(), node.getIndex());
 
     llvm::Value* val = node.getValue()->codegen(*this);
-    ExpectedIntegerResultBits = prevBits;
     if (!val) return nullptr;
-    val = castValueToType(val, arrType->getElementType());
+    val = castValueToType(normalizeFractionValue(val, node.getValue()), elemType, isUnsignedExpr(node.getValue()));
     if (!val) return logError("Cannot cast value to array element type");
 
-    llvm::Value* zero64 = llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), 0);
-    llvm::Value* gep = Builder.CreateGEP(arrType, arrAlloca, {zero64, idxVal}, "arr.idx.ptr");
+    llvm::Value* data = loadArrayData(header, node.getName());
+    llvm::Value* gep = Builder.CreateInBoundsGEP(elemType, data, {idxVal}, "arr.idx.ptr");
     Builder.CreateStore(val, gep);
     return val;
 }
 
 llvm::Value* CodeGenerator::visit(ClassAST& node) {
+    if (!TheModule) {
+        return logError("Code generator used after its module was taken");
+    }
+    PhaseScope codegenScope("CodeGenClass", node.getName(), PhaseScope::Report::TraceOnly);
     llvm::Value* lastMethod = nullptr;
 
-    const std::string previousClassName = CurrentClassName;
-    const bool previousClassIsApplication = CurrentClassIsApplication;
-
-    CurrentClassName = node.getName();
-    CurrentClassIsApplication = std::find(node.getBlueprintNames().begin(), node.getBlueprintNames().end(), "Application") != node.getBlueprintNames().end();
+    const ClassAST* previousClass = CurrentClass;
+    CurrentClass = &node;
 
     for (const auto& method : node.getMethodImpls()) {
         lastMethod = method->codegen(*this);
         if (!lastMethod) {
-            CurrentClassName = previousClassName;
-            CurrentClassIsApplication = previousClassIsApplication;
+            CurrentClass = previousClass;
             return nullptr;
         }
     }
 
-    CurrentClassName = previousClassName;
-    CurrentClassIsApplication = previousClassIsApplication;
+    CurrentClass = previousClass;
     return lastMethod;
 }
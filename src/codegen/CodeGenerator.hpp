@@ -7,17 +7,83 @@
 #include <llvm/IR/Type.h>
 #include <memory>
 #include <map>
+#include <vector>
 #include <string>
 #include <optional>
+#include <set>
+#include <tuple>
+#include <utility>
 
 #include "../ast/exprAST.hpp"
 #include "../ast/stmtAST.hpp"
 #include "../ast/classAST.hpp"
 #include "../ast/commonAST.hpp"
+#include "../support/ScopedSymbolTable.hpp"
+
+enum class BoundsCheckMode {
+    Off,        // No runtime checks; only compile-time known indices are validated
+    On,         // Every dynamic index is checked before the access
+    Hoisted,    // Like On, but counted while loops get one pre-loop check per array
+};
+
+enum class ContractMode {
+    Off,            // Clauses are type-checked but not evaluated
+    Preconditions,  // Only requires clauses are checked
+    Boundary,       // requires and ensures are checked on public methods only
+    Full,           // Every requires and ensures clause is checked
+};
+
+enum class QuantifierMode {
+    Full,       // A forall checks every value of its range
+    Sampled,    // Ranges of more than 1024 values check 1024 spaced ones, always including the last
+    Skip,       // Ranges of more than 1024 values are assumed to hold
+};
+
+enum class FractionNormalization {
+    Eager,      // Reduce every fraction result by its GCD immediately
+    Lazy,       // Keep results unreduced while they fit; reduce on store and print
+};
+
+enum class FractionOverflowMode {
+    Wrap,       // Products at twice the component width, truncated on overflow (fastest)
+    Trap,       // Products at four times the component width, reduced, trap if still too wide
+    Saturate,   // Like Trap, but clamp out-of-range values and approximate over-wide ones
+};
+
+struct CodeGenOptions {
+    BoundsCheckMode boundsChecks = BoundsCheckMode::Hoisted;
+    ContractMode contracts = ContractMode::Full;
+    QuantifierMode quantifiers = QuantifierMode::Full;
+    // Lower Defaultlogger.logln to the buffered writers in runtime/bp_runtime.h instead of printf
+    bool useOutputRuntime = true;
+    FractionNormalization fractionNormalization = FractionNormalization::Lazy;
+    FractionOverflowMode fractionOverflow = FractionOverflowMode::Wrap;
+    // Count calls and timestamp ticks of every method through __bp_profile_enter/exit
+    bool instrumentFunctions = false;
+};
+
+// Everything the code generator knows about one local variable or parameter.
+struct Symbol {
+    llvm::AllocaInst* storage = nullptr;
+    std::optional<PrimitiveTypeAST::PrimitiveKind> primitiveKind;
+    // Arrays only: storage holds the {data, length} header
+    llvm::Type* arrayElementType = nullptr;
+    std::optional<uint64_t> arrayStaticLength;
+
+    bool isArray() const { return arrayElementType != nullptr; }
+};
+
+// A generated module together with the context that owns it
+struct GeneratedModule {
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> module;
+};
+
+using BoundsProvenAccess = std::tuple<std::string, std::string, int64_t>;
 
 class CodeGenerator {
 public:
-    CodeGenerator();
+    explicit CodeGenerator(CodeGenOptions options = CodeGenOptions());
     ~CodeGenerator() = default;
 
     // Visitor methods for expression AST nodes
@@ -29,6 +95,7 @@ public:
     llvm::Value* visit(IdentifierExprAST& node);
     llvm::Value* visit(BinaryExprAST& node);
     llvm::Value* visit(UnaryExprAST& node);
+    llvm::Value* visit(ForallExprAST& node);
 
     // Visitor methods for statement AST nodes
     llvm::Value* visit(VarDeclStmtAST& node);
@@ -44,6 +111,7 @@ public:
     llvm::Value* visit(ArrayLiteralExprAST& node);
     llvm::Value* visit(ArrayNewExprAST& node);
     llvm::Value* visit(IndexExprAST& node);
+    llvm::Value* visit(ArrayLengthExprAST& node);
     llvm::Value* visit(IndexAssignStmtAST& node);
 
     // Visitor methods for class/program AST nodes
@@ -54,42 +122,65 @@ public:
     llvm::LLVMContext& getContext() { return TheContext; }
     llvm::IRBuilder<>& getBuilder() { return Builder; }
     llvm::Module* getModule() { return TheModule.get(); }
-    std::unique_ptr<llvm::Module> takeModule();
+    // Hands over the module and its context. The generator is unusable afterwards: getModule
+    // returns nullptr and visiting a class reports an error.
+    GeneratedModule takeModule();
     void dumpIR() const;
     
-    void setNamedValue(const std::string& name, llvm::AllocaInst* value);
+    Symbol& declareNamedValue(const std::string& name, llvm::AllocaInst* value);
     llvm::AllocaInst* getNamedValue(const std::string& name);
 
 private:
-    llvm::LLVMContext TheContext;
+    CodeGenOptions Options;
+    std::unique_ptr<llvm::LLVMContext> OwnedContext;
+    llvm::LLVMContext& TheContext;
     llvm::IRBuilder<> Builder;
     std::unique_ptr<llvm::Module> TheModule;
-    std::map<std::string, llvm::AllocaInst*> NamedValues;
-    std::map<std::string, PrimitiveTypeAST::PrimitiveKind> NamedPrimitiveKinds;
-    std::map<const llvm::Value*, PrimitiveTypeAST::PrimitiveKind> ValuePrimitiveKinds;
-    std::map<std::string, PrimitiveTypeAST::PrimitiveKind> NamedArrayElementKinds;
-    std::map<std::string, llvm::ArrayType*> NamedArrayTypes;
-    std::optional<unsigned> ExpectedIntegerResultBits;
-    std::optional<PrimitiveTypeAST::PrimitiveKind> ExpectedFractionResultKind;
+    ScopedSymbolTable<Symbol> Symbols;
+    std::vector<llvm::AllocaInst*> CurrentFunctionArrays;
+    // (array, variable, offset) for every `array[variable + offset]` known to be in bounds, with
+    // the hoisted condition that proves it, or nullptr where it is in bounds unconditionally
+    std::map<BoundsProvenAccess, llvm::Value*> ProvenInBoundsAccesses;
     llvm::Function* CurrentFunction;
-    std::string CurrentClassName;
-    bool CurrentClassIsApplication;
+    llvm::BasicBlock* CurrentBoundsTrapBlock;
+    const ClassAST* CurrentClass;
+    // Methods of generic class instantiations, by generic class and method name
+    std::map<std::string, std::vector<llvm::Function*>> InstantiatedMethods;
 
     // Helper function for logging errors
     llvm::Value* logError(const char* str);
     llvm::Type* getLLVMType(const TypeAST* typeAST);
+    llvm::Type* getLLVMType(PrimitiveTypeAST::PrimitiveKind kind);
+    llvm::Constant* createConstant(const ConstantValue& value);
     llvm::AllocaInst* createEntryBlockAlloca(llvm::Function* function, llvm::Type* type, const std::string& name);
-    llvm::Value* castValueToType(llvm::Value* value, llvm::Type* targetType);
+    llvm::StructType* getArrayHeaderType();
+    llvm::AllocaInst* createEntryBlockArrayHeader(llvm::Function* function, const std::string& name);
+    llvm::Value* loadArrayData(llvm::AllocaInst* header, const std::string& name);
+    llvm::Value* loadArrayLength(llvm::AllocaInst* header, const std::string& name);
+    llvm::GlobalVariable* createArrayLiteralGlobal(llvm::Type* elementType, llvm::ArrayRef<llvm::Value*> elements, const std::string& name);
+    llvm::Value* allocateArrayStorage(llvm::Type* elementType, llvm::Value* length, bool zeroInitialize, const std::string& name);
+    void releaseFunctionArrays();
+    llvm::GlobalVariable* createFunctionProfileRecord(const std::string& functionName);
+    void mergeIdenticalInstantiation(llvm::Function* function, const std::string& methodName);
+    void createTrapIf(llvm::Value* failureCondition, const std::string& name);
+    bool createContractCheck(ExprAST* condition, const std::string& clause, const std::string& methodName);
+    llvm::BasicBlock* getBoundsTrapBlock();
+    void assumeInBounds(const std::vector<BoundsProvenAccess>& accesses, llvm::Value* condition);
+    void createBoundsCheck(llvm::AllocaInst* header, llvm::Value* index, const std::string& arrayName, const ExprAST* indexExpr);
+    llvm::Value* createHoistedBoundsCondition(WhileStmtAST& node, std::vector<BoundsProvenAccess>& outProvenAccesses);
+    bool emitWhileLoop(WhileStmtAST& node, llvm::BasicBlock* exitBlock);
+    llvm::Value* createForallBoundsCondition(ForallExprAST& node, llvm::Value* lower, llvm::Value* upper, std::vector<BoundsProvenAccess>& outProvenAccesses);
+    llvm::Value* emitForallLoop(ForallExprAST& node, llvm::AllocaInst* variable, llvm::Value* lower, llvm::Value* iterations, llvm::Value* step, llvm::Value* lastOffset);
+    llvm::MDNode* createVectorizedLoopMetadata();
+    llvm::Value* castValueToType(llvm::Value* value, llvm::Type* targetType, bool sourceUnsigned = false);
     llvm::Value* castToBoolean(llvm::Value* value);
     llvm::FunctionCallee getPrintfFunction();
+    llvm::FunctionCallee getOutputRuntimeFunction(const std::string& name, llvm::ArrayRef<llvm::Type*> parameterTypes);
+    llvm::Value* emitRuntimePrint(llvm::Value* value, bool hasPrimitiveKind, PrimitiveTypeAST::PrimitiveKind primitiveKind);
     const PrimitiveTypeAST* getPrimitiveType(const TypeAST* typeAST) const;
     bool isUnsignedPrimitiveKind(PrimitiveTypeAST::PrimitiveKind kind) const;
-    void setNamedPrimitiveKind(const std::string& name, PrimitiveTypeAST::PrimitiveKind kind);
     bool getNamedPrimitiveKind(const std::string& name, PrimitiveTypeAST::PrimitiveKind& outKind) const;
-    void setValuePrimitiveKind(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind kind);
-    bool getValuePrimitiveKind(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind& outKind) const;
-    bool isUnsignedValue(llvm::Value* value) const;
-    PrimitiveTypeAST::PrimitiveKind getIntegerPrimitiveKind(unsigned bitWidth, bool isUnsigned) const;
+    bool isUnsignedExpr(const ExprAST* expr) const;
     bool isFractionalPrimitiveKind(PrimitiveTypeAST::PrimitiveKind kind) const;
     bool isFractionalValue(llvm::Value* value) const;
     unsigned getFractionalComponentBitWidth(PrimitiveTypeAST::PrimitiveKind kind) const;
@@ -98,9 +189,15 @@ private:
     llvm::StructType* getFractionalLLVMType(PrimitiveTypeAST::PrimitiveKind kind);
     llvm::Function* getOrCreateGcdFunction(unsigned bitWidth);
     llvm::Value* buildFractionValue(llvm::Value* numerator, llvm::Value* denominator, PrimitiveTypeAST::PrimitiveKind kind);
+    llvm::Value* assembleFractionValue(llvm::Value* numerator, llvm::Value* denominator, PrimitiveTypeAST::PrimitiveKind kind);
+    llvm::Value* buildLazyFractionResult(llvm::Value* wideNumerator, llvm::Value* wideDenominator, PrimitiveTypeAST::PrimitiveKind kind);
+    bool isUnreducedFraction(const ExprAST* expr) const;
+    llvm::Value* normalizeFractionValue(llvm::Value* value, const ExprAST* expr);
+    void normalizeFractionSign(llvm::Value*& numerator, llvm::Value*& denominator);
+    void narrowFractionComponents(llvm::Value* wideNumerator, llvm::Value* wideDenominator, PrimitiveTypeAST::PrimitiveKind kind, llvm::Value*& outNumerator, llvm::Value*& outDenominator);
     bool decomposeFractionValue(llvm::Value* fractionValue, PrimitiveTypeAST::PrimitiveKind kind, llvm::Value*& numerator, llvm::Value*& denominator);
-    llvm::Value* castIntegerToFraction(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind targetKind);
+    llvm::Value* castIntegerToFraction(llvm::Value* value, PrimitiveTypeAST::PrimitiveKind targetKind, bool sourceUnsigned = false);
     llvm::Value* castFractionToFloatingPoint(llvm::Value* value, llvm::Type* targetType);
-    llvm::Value* createFractionArithmetic(int op, llvm::Value* leftValue, llvm::Value* rightValue);
-    llvm::Value* createFractionComparison(int op, llvm::Value* leftValue, llvm::Value* rightValue);
+    llvm::Value* createFractionArithmetic(int op, llvm::Value* leftValue, bool leftUnsigned, llvm::Value* rightValue, bool rightUnsigned, PrimitiveTypeAST::PrimitiveKind targetKind);
+    llvm::Value* createFractionComparison(int op, llvm::Value* leftValue, bool leftUnsigned, llvm::Value* rightValue, bool rightUnsigned, PrimitiveTypeAST::PrimitiveKind targetKind);
 };
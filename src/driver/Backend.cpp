@@ -0,0 +1,242 @@
+#include <iostream>
+#include <optional>
+
+#include <llvm/Analysis/ModuleSummaryAnalysis.h>
+#include <llvm/Analysis/ProfileSummaryInfo.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/Type.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/PGOOptions.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "Backend.hpp"
+#include "Target.hpp"
+#include "../support/PhaseScope.hpp"
+
+namespace {
+
+// A ThinLTO input is bitcode that carries a module summary; without one the LTO link treats
+// the module as a full LTO input.
+void writeBitcode(const llvm::Module& module, llvm::raw_ostream& out, bool withSummary) {
+    if (!withSummary) {
+        llvm::WriteBitcodeToFile(module, out);
+        return;
+    }
+
+    llvm::ProfileSummaryInfo profileSummary(module);
+    const llvm::ModuleSummaryIndex summary = llvm::buildModuleSummaryIndex(module, nullptr, &profileSummary);
+    llvm::WriteBitcodeToFile(module, out, /*ShouldPreserveUseListOrder=*/false, &summary);
+}
+
+}
+
+bool ensureApplicationEntrypoint(llvm::Module& module, int32_t outputBuffering) {
+    llvm::Function* appMain = module.getFunction("System.Application.main");
+    if (!appMain) {
+        return false;
+    }
+
+    if (module.getFunction("main")) {
+        return true;
+    }
+
+    if (!appMain->getReturnType()->isVoidTy() || !appMain->arg_empty()) {
+        return false;
+    }
+
+    llvm::LLVMContext& context = module.getContext();
+    llvm::FunctionType* entryType = llvm::FunctionType::get(llvm::Type::getInt32Ty(context), false);
+    llvm::Function* entry = llvm::Function::Create(entryType, llvm::Function::ExternalLinkage, "main", module);
+
+    llvm::BasicBlock* block = llvm::BasicBlock::Create(context, "entry", entry);
+    llvm::IRBuilder<> builder(block);
+    if (outputBuffering != BP_OUTPUT_AUTO) {
+        llvm::FunctionCallee configure = module.getOrInsertFunction("__bp_io_configure",
+            llvm::FunctionType::get(llvm::Type::getVoidTy(context), {llvm::Type::getInt32Ty(context)}, false));
+        builder.CreateCall(configure, {llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), outputBuffering)});
+    }
+    builder.CreateCall(appMain);
+    builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0));
+
+    return !llvm::verifyFunction(*entry, &llvm::errs());
+}
+
+bool emitIRFile(const llvm::Module& module, const std::string& outputPath) {
+    PhaseScope emitScope("EmitIR", outputPath);
+    std::error_code errorCode;
+    llvm::raw_fd_ostream outFile(outputPath, errorCode, llvm::sys::fs::OF_Text);
+    if (errorCode) {
+        std::cerr << "Error: Could not open IR output file '" << outputPath << "': " << errorCode.message() << std::endl;
+        return false;
+    }
+
+    module.print(outFile, nullptr);
+    outFile.flush();
+    return true;
+}
+
+bool emitBitcodeFile(const llvm::Module& module, const std::string& outputPath, bool withSummary) {
+    PhaseScope emitScope("EmitBitcode", outputPath);
+    std::error_code errorCode;
+    llvm::raw_fd_ostream outFile(outputPath, errorCode, llvm::sys::fs::OF_None);
+    if (errorCode) {
+        std::cerr << "Error: Could not open bitcode output file '" << outputPath << "': " << errorCode.message() << std::endl;
+        return false;
+    }
+
+    writeBitcode(module, outFile, withSummary);
+    outFile.flush();
+    return true;
+}
+
+bool optimizeModule(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::OptimizationLevel level, LinkTimeOptimization linkTimeOptimization, const ProfileSettings& profile) {
+    {
+        PhaseScope verifyScope("Verify", module.getModuleIdentifier());
+        if (llvm::verifyModule(module, &llvm::errs())) {
+            std::cerr << "Error: Internal compiler error: generated module failed verification." << std::endl;
+            return false;
+        }
+    }
+
+    const bool instrumentProfile = profile.mode == ProfileGuidedOptimization::Generate;
+    if (level == llvm::OptimizationLevel::O0 && !instrumentProfile) {
+        return true;
+    }
+
+    PhaseScope optimizeScope("Optimize", module.getModuleIdentifier());
+    llvm::LoopAnalysisManager loopAnalysisManager;
+    llvm::FunctionAnalysisManager functionAnalysisManager;
+    llvm::CGSCCAnalysisManager cgsccAnalysisManager;
+    llvm::ModuleAnalysisManager moduleAnalysisManager;
+
+    llvm::PipelineTuningOptions tuningOptions;
+    tuningOptions.LoopUnrolling = true;
+    tuningOptions.LoopInterleaving = level.getSpeedupLevel() >= 2;
+    tuningOptions.LoopVectorization = level.getSpeedupLevel() >= 2;
+    tuningOptions.SLPVectorization = level.getSpeedupLevel() >= 2;
+
+    // Reports individual passes under --time-passes and --time-trace.
+    llvm::PassInstrumentationCallbacks instrumentationCallbacks;
+    llvm::StandardInstrumentations standardInstrumentations(module.getContext(), /*DebugLogging=*/false);
+    standardInstrumentations.registerCallbacks(instrumentationCallbacks, &moduleAnalysisManager);
+
+    std::optional<llvm::PGOOptions> pgoOptions;
+    if (profile.mode != ProfileGuidedOptimization::Off) {
+        pgoOptions.emplace(profile.profilePath, "", "", "", llvm::vfs::getRealFileSystem(),
+            instrumentProfile ? llvm::PGOOptions::IRInstr : llvm::PGOOptions::IRUse);
+    }
+
+    llvm::PassBuilder passBuilder(&targetMachine, tuningOptions, pgoOptions, &instrumentationCallbacks);
+    passBuilder.registerModuleAnalyses(moduleAnalysisManager);
+    passBuilder.registerCGSCCAnalyses(cgsccAnalysisManager);
+    passBuilder.registerFunctionAnalyses(functionAnalysisManager);
+    passBuilder.registerLoopAnalyses(loopAnalysisManager);
+    passBuilder.crossRegisterProxies(loopAnalysisManager, functionAnalysisManager, cgsccAnalysisManager, moduleAnalysisManager);
+
+    llvm::ModulePassManager modulePassManager;
+    if (level == llvm::OptimizationLevel::O0) {
+        modulePassManager = passBuilder.buildO0DefaultPipeline(level, linkTimeOptimization == LinkTimeOptimization::Off
+            ? llvm::ThinOrFullLTOPhase::None
+            : linkTimeOptimization == LinkTimeOptimization::Full ? llvm::ThinOrFullLTOPhase::FullLTOPreLink : llvm::ThinOrFullLTOPhase::ThinLTOPreLink);
+        modulePassManager.run(module, moduleAnalysisManager);
+        return true;
+    }
+
+    switch (linkTimeOptimization) {
+        case LinkTimeOptimization::Off:
+            modulePassManager = passBuilder.buildPerModuleDefaultPipeline(level);
+            break;
+        case LinkTimeOptimization::Full:
+            modulePassManager = passBuilder.buildLTOPreLinkDefaultPipeline(level);
+            break;
+        case LinkTimeOptimization::Thin:
+            modulePassManager = passBuilder.buildThinLTOPreLinkDefaultPipeline(level);
+            break;
+    }
+    modulePassManager.run(module, moduleAnalysisManager);
+    return true;
+}
+
+bool emitObjectFile(llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& outputPath) {
+    PhaseScope emitScope("EmitObject", outputPath);
+    std::error_code errorCode;
+    llvm::raw_fd_ostream destination(outputPath, errorCode, llvm::sys::fs::OF_None);
+    if (errorCode) {
+        std::cerr << "Error: Could not open object output file '" << outputPath << "': " << errorCode.message() << std::endl;
+        return false;
+    }
+
+    llvm::legacy::PassManager passManager;
+    if (targetMachine.addPassesToEmitFile(passManager, destination, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+        std::cerr << "Error: LLVM target machine cannot emit object file for this target." << std::endl;
+        return false;
+    }
+
+    passManager.run(module);
+    destination.flush();
+    return true;
+}
+
+bool runBackend(TranslationUnit& unit, const TargetSelection& selection, llvm::OptimizationLevel level, const ProfileSettings& profile, const std::string& emitIRPath, const std::string& emitBitcodePath, ProfilingSession& profiling) {
+    ProfilingSession::WorkerTrace workerTrace(profiling);
+
+    std::unique_ptr<llvm::TargetMachine> targetMachine = createTargetMachine(*unit.module, selection, level);
+    if (!targetMachine) {
+        return false;
+    }
+
+    if (!optimizeModule(*unit.module, *targetMachine, level, LinkTimeOptimization::Off, profile)) {
+        return false;
+    }
+    profiling.recordOptimizedModule(*unit.module);
+
+    if (!emitIRPath.empty() && !emitIRFile(*unit.module, emitIRPath)) {
+        return false;
+    }
+
+    if (!emitBitcodePath.empty() && !emitBitcodeFile(*unit.module, emitBitcodePath, false)) {
+        return false;
+    }
+
+    return emitObjectFile(*unit.module, *targetMachine, unit.objectPath);
+}
+
+bool runPreLinkBackend(TranslationUnit& unit, const TargetSelection& selection, llvm::OptimizationLevel level, LinkTimeOptimization linkTimeOptimization, const ProfileSettings& profile, bool serialize, const std::string& emitIRPath, const std::string& emitBitcodePath, ProfilingSession& profiling) {
+    ProfilingSession::WorkerTrace workerTrace(profiling);
+
+    std::unique_ptr<llvm::TargetMachine> targetMachine = createTargetMachine(*unit.module, selection, level);
+    if (!targetMachine) {
+        return false;
+    }
+
+    if (!optimizeModule(*unit.module, *targetMachine, level, linkTimeOptimization, profile)) {
+        return false;
+    }
+    profiling.recordOptimizedModule(*unit.module);
+
+    const bool withSummary = linkTimeOptimization == LinkTimeOptimization::Thin;
+    if (!emitIRPath.empty() && !emitIRFile(*unit.module, emitIRPath)) {
+        return false;
+    }
+
+    if (!emitBitcodePath.empty() && !emitBitcodeFile(*unit.module, emitBitcodePath, withSummary)) {
+        return false;
+    }
+
+    if (serialize) {
+        PhaseScope serializeScope("SerializeBitcode", unit.sourcePath);
+        llvm::raw_svector_ostream bitcodeStream(unit.bitcode);
+        writeBitcode(*unit.module, bitcodeStream, withSummary);
+    }
+    unit.module.reset();
+    unit.context.reset();
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "Driver.hpp"
+#include "ProfilingSession.hpp"
+
+// Adds the C `main` that runs System.Application.main, configuring the output runtime's
+// buffering first unless it is BP_OUTPUT_AUTO. Returns false if the module has no suitable
+// System.Application.main.
+bool ensureApplicationEntrypoint(llvm::Module& module, int32_t outputBuffering);
+
+bool emitIRFile(const llvm::Module& module, const std::string& outputPath);
+
+// withSummary adds the module summary that makes the bitcode a ThinLTO input.
+bool emitBitcodeFile(const llvm::Module& module, const std::string& outputPath, bool withSummary);
+
+// Runs the new pass manager's default per-module pipeline for the requested level, or under
+// --lto the pre-link pipeline, which leaves inlining across modules and the late loop and
+// vectorization passes to the LTO link. -O0 leaves the module untouched so the emitted IR
+// still mirrors CodeGenerator output, unless --profile-generate needs its counters inserted.
+bool optimizeModule(llvm::Module& module, llvm::TargetMachine& targetMachine, llvm::OptimizationLevel level, LinkTimeOptimization linkTimeOptimization, const ProfileSettings& profile);
+
+bool emitObjectFile(llvm::Module& module, llvm::TargetMachine& targetMachine, const std::string& outputPath);
+
+// Optimizes one unit and emits its object file (and IR and bitcode, when requested).
+bool runBackend(TranslationUnit& unit, const TargetSelection& selection, llvm::OptimizationLevel level, const ProfileSettings& profile, const std::string& emitIRPath, const std::string& emitBitcodePath, ProfilingSession& profiling);
+
+// Under --lto, optimizes one unit with the pre-link pipeline and, when it is to be linked,
+// serializes it for the LTO link. The module is released once it has been written.
+bool runPreLinkBackend(TranslationUnit& unit, const TargetSelection& selection, llvm::OptimizationLevel level, LinkTimeOptimization linkTimeOptimization, const ProfileSettings& profile, bool serialize, const std::string& emitIRPath, const std::string& emitBitcodePath, ProfilingSession& profiling);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "../support/InterfaceFile.hpp"
+#include "bp_runtime.h"
+
+// Settings and per-source state shared by the compiler driver's phases. main.cpp fills them
+// in from the command line and hands them to the frontend, backend, linker and JIT.
+
+// Set by the build to the BluePrintRuntime archive that --emit-exe links against.
+#ifndef BLUEPRINT_RUNTIME_LIBRARY
+#define BLUEPRINT_RUNTIME_LIBRARY ""
+#endif
+
+// Set by the build to compiler-rt's profile runtime, which --profile-generate executables link.
+#ifndef BLUEPRINT_PROFILE_RUNTIME_LIBRARY
+#define BLUEPRINT_PROFILE_RUNTIME_LIBRARY ""
+#endif
+
+struct TargetSelection {
+    std::string triple;
+    std::string cpu = "generic";
+    std::string features;
+};
+
+enum class LinkTimeOptimization {
+    Off,
+    Full,
+    Thin,
+};
+
+enum class ProfileGuidedOptimization {
+    Off,
+    Generate,
+    Use,
+};
+
+// Generate instruments the IR with counters that the program writes to profilePath (a raw
+// profile; %m expands to a per-binary id). Use reads profilePath, an indexed profile merged
+// with llvm-profdata, and steers inlining, block layout and unrolling by it.
+struct ProfileSettings {
+    ProfileGuidedOptimization mode = ProfileGuidedOptimization::Off;
+    std::string profilePath;
+    std::string runtimeLibraryPath = BLUEPRINT_PROFILE_RUNTIME_LIBRARY;
+};
+
+struct OutputRuntimeSettings {
+    int32_t buffering = BP_OUTPUT_AUTO;
+    std::string libraryPath = BLUEPRINT_RUNTIME_LIBRARY;
+};
+
+// One source file and the module generated from it. Every unit owns its LLVMContext so the
+// frontends of different files can run concurrently. Sources ending in .bc are prebuilt
+// bitcode, such as a stdlib bundle, and are loaded instead of compiled.
+struct TranslationUnit {
+    std::string sourcePath;
+    std::string objectPath;
+    std::unique_ptr<llvm::MemoryBuffer> source;
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> module;
+    // Under --lto, the pre-link optimized module serialized for the LTO link
+    llvm::SmallVector<char, 0> bitcode;
+    // Under --emit-interface, the classes the frontend compiled
+    std::vector<ClassInterface> interfaces;
+    // Set when --cache-dir is used; a unit restored from the cache has no module
+    std::string cacheKey;
+    bool restoredFromCache = false;
+};
@@ -0,0 +1,119 @@
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+
+#include "Frontend.hpp"
+#include "../lexer/lexer.hpp"
+#include "../parser/parser.hpp"
+#include "../support/PhaseScope.hpp"
+
+namespace {
+
+bool isBitcodeSource(const std::string& sourcePath) {
+    return std::filesystem::path(sourcePath).extension() == ".bc";
+}
+
+// Prebuilt bitcode was optimized when it was built; it only needs its own context.
+bool loadBitcodeUnit(TranslationUnit& unit, ProfilingSession& profiling) {
+    PhaseScope loadScope("LoadBitcode", unit.sourcePath);
+    auto context = std::make_unique<llvm::LLVMContext>();
+    llvm::Expected<std::unique_ptr<llvm::Module>> module = llvm::parseBitcodeFile(unit.source->getMemBufferRef(), *context);
+    if (!module) {
+        std::cerr << "Error: Could not read bitcode from " << unit.sourcePath << ": " << llvm::toString(module.takeError()) << std::endl;
+        return false;
+    }
+
+    unit.module = std::move(*module);
+    unit.context = std::move(context);
+    unit.source.reset();
+    profiling.recordGeneratedModule(*unit.module);
+    return true;
+}
+
+}
+
+bool loadSource(TranslationUnit& unit) {
+    if (unit.source) {
+        return true;
+    }
+
+    PhaseScope readScope("ReadSource", unit.sourcePath);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> sourceBuffer =
+        llvm::MemoryBuffer::getFile(unit.sourcePath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!sourceBuffer) {
+        std::cerr << "Error: Could not open file " << unit.sourcePath << ": " << sourceBuffer.getError().message() << std::endl;
+        return false;
+    }
+
+    unit.source = std::move(*sourceBuffer);
+    return true;
+}
+
+bool runFrontend(TranslationUnit& unit, const CodeGenOptions& codeGenOptions, const std::vector<const InterfaceFile*>& importedInterfaces, bool describeInterfaces, bool verbose, ProfilingSession& profiling) {
+    ProfilingSession::WorkerTrace workerTrace(profiling);
+    PhaseScope frontendScope("Frontend", unit.sourcePath, PhaseScope::Report::TraceOnly);
+
+    if (!loadSource(unit)) {
+        return false;
+    }
+
+    if (isBitcodeSource(unit.sourcePath)) {
+        return loadBitcodeUnit(unit, profiling);
+    }
+
+    const std::string_view text = unit.source->getBuffer();
+
+    // The parser lexes on demand, so lexing is only timed on its own through this extra pass.
+    Lexer lexer = Lexer(text);
+    if (verbose || profiling.isTimingPhases())
+    {
+        PhaseScope lexScope("Lex", unit.sourcePath);
+        if (verbose) {
+            std::cout << "Tokens:" << std::endl;
+        }
+        while (true) {
+            int16_t token = lexer.getNextToken();
+            if (token == tok_eof) {
+                break;
+            }
+            if (verbose) {
+                std::cout << "\t" << static_cast<Token>(token) << std::endl;
+            }
+        }
+
+        lexer = Lexer(text);
+    }
+
+    Parser parser = Parser(lexer, verbose, unit.sourcePath);
+    parser.setImportedInterfaces(importedInterfaces);
+    CodeGenerator generator(codeGenOptions);
+    // Named before code generation, whose per-method timers are qualified by the unit.
+    generator.getModule()->setModuleIdentifier(unit.sourcePath);
+    generator.getModule()->setSourceFileName(unit.sourcePath);
+    const bool parsed = parser.parse(generator);
+    profiling.recordFrontend(parser);
+    if (!parsed) {
+        std::cerr << "Error: Compilation of " << unit.sourcePath << " failed." << std::endl;
+        return false;
+    }
+
+    if (!generator.getModule()) {
+        std::cerr << "Error: Internal compiler error: code generator produced no module for " << unit.sourcePath << "." << std::endl;
+        return false;
+    }
+
+    if (describeInterfaces) {
+        for (const ClassAST* classAST : parser.getClasses()) {
+            unit.interfaces.push_back(describeClass(*classAST));
+        }
+    }
+
+    GeneratedModule generated = generator.takeModule();
+    unit.context = std::move(generated.context);
+    unit.module = std::move(generated.module);
+    unit.source.reset();
+    profiling.recordGeneratedModule(*unit.module);
+    return true;
+}
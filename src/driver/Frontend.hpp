@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+
+#include "Driver.hpp"
+#include "ProfilingSession.hpp"
+#include "../codegen/CodeGenerator.hpp"
+#include "../support/InterfaceFile.hpp"
+
+// Large sources are memory-mapped rather than read; the lexer works directly on the buffer.
+bool loadSource(TranslationUnit& unit);
+
+// Parses and generates code for one unit, or loads it if it is prebuilt bitcode. Under
+// describeInterfaces the unit also records the interfaces of the classes it compiled.
+bool runFrontend(TranslationUnit& unit, const CodeGenOptions& codeGenOptions, const std::vector<const InterfaceFile*>& importedInterfaces, bool describeInterfaces, bool verbose, ProfilingSession& profiling);
+
+// Runs task once per unit, on up to `jobs` threads (0 = one per hardware thread). Every unit
+// is attempted even after a failure so that all diagnostics are reported.
+template <typename Task>
+bool runOnUnits(std::vector<TranslationUnit>& units, unsigned jobs, Task task) {
+    if (units.size() == 1 || jobs == 1) {
+        bool succeeded = true;
+        for (TranslationUnit& unit : units) {
+            succeeded = task(unit) && succeeded;
+        }
+        return succeeded;
+    }
+
+    std::vector<char> results(units.size(), 0);
+    llvm::DefaultThreadPool pool(llvm::hardware_concurrency(jobs));
+    for (size_t index = 0; index < units.size(); ++index) {
+        pool.async([&units, &results, &task, index]() {
+            results[index] = task(units[index]) ? 1 : 0;
+        });
+    }
+    pool.wait();
+    return std::find(results.begin(), results.end(), 0) == results.end();
+}
@@ -0,0 +1,79 @@
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include "Interfaces.hpp"
+#include "UnitCache.hpp"
+
+namespace {
+
+// Interface files the compile server opened before forking its requests, by absolute path,
+// with the identity each had then. A request importing one of them unchanged uses the server's
+// mapping instead of opening and validating the file again.
+struct PreloadedInterface {
+    std::string identity;
+    std::unique_ptr<InterfaceFile> file;
+};
+std::map<std::string, PreloadedInterface> preloadedInterfaces;
+
+std::string getAbsolutePath(const std::string& path) {
+    llvm::SmallString<256> absolutePath(path);
+    llvm::sys::fs::make_absolute(absolutePath);
+    llvm::sys::path::remove_dots(absolutePath, /*remove_dot_dot=*/true);
+    return std::string(absolutePath);
+}
+
+}
+
+bool preloadInterface(const std::string& path) {
+    std::unique_ptr<InterfaceFile> file = InterfaceFile::open(path);
+    if (!file) {
+        return false;
+    }
+    preloadedInterfaces[getAbsolutePath(path)] = PreloadedInterface{getFileIdentity(path), std::move(file)};
+    return true;
+}
+
+const InterfaceFile* findPreloadedInterface(const std::string& path) {
+    const auto preloaded = preloadedInterfaces.find(getAbsolutePath(path));
+    if (preloaded == preloadedInterfaces.end() || preloaded->second.identity != getFileIdentity(path)) {
+        return nullptr;
+    }
+    return preloaded->second.file.get();
+}
+
+int printInterfaceFile(const std::string& path) {
+    std::unique_ptr<InterfaceFile> file = InterfaceFile::open(path);
+    if (!file) {
+        return 1;
+    }
+
+    for (size_t index = 0; index < file->getClassCount(); ++index) {
+        const llvm::StringRef className = file->getClassName(index);
+        const std::optional<ClassInterface> description = file->lookup(className);
+        if (!description) {
+            std::cerr << "Error: Interface file '" << path << "' has a corrupt record for class '" << className.str() << "'." << std::endl;
+            return 1;
+        }
+
+        std::cout << "class " << description->name;
+        for (size_t blueprint = 0; blueprint < description->blueprints.size(); ++blueprint) {
+            std::cout << (blueprint == 0 ? " : " : ", ") << description->blueprints[blueprint];
+        }
+        std::cout << std::endl;
+
+        for (const MethodInterface& method : description->methods) {
+            std::cout << "\t" << formatInterfaceType(method.returnType) << " " << method.name << "(";
+            for (size_t parameter = 0; parameter < method.parameters.size(); ++parameter) {
+                std::cout << (parameter == 0 ? "" : ", ") << formatInterfaceType(method.parameters[parameter].type) << " " << method.parameters[parameter].name;
+            }
+            std::cout << ") -> " << method.symbol << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "../support/InterfaceFile.hpp"
+
+// Opens the interface file at path for the lifetime of the compile server, so that requests
+// forked from it can use it through findPreloadedInterface. Returns false and reports the
+// error if the file cannot be opened.
+bool preloadInterface(const std::string& path);
+
+// The file preloaded for path, or null if none was or the file has changed since.
+const InterfaceFile* findPreloadedInterface(const std::string& path);
+
+// Lists every class through the symbol index, decoding each record on its own as an import
+// would. Returns the exit status for --print-interface.
+int printInterfaceFile(const std::string& path);
@@ -0,0 +1,219 @@
+#include <iostream>
+#include <utility>
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ExecutionEngine/Orc/AbsoluteSymbols.h>
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+
+#include "JIT.hpp"
+#include "Backend.hpp"
+#include "Target.hpp"
+#include "../support/PhaseScope.hpp"
+#include "bp_runtime.h"
+
+namespace {
+
+// JIT targets always default to the host CPU with its detected features; an explicit
+// --mcpu/--mattr selection replaces them.
+llvm::Expected<llvm::orc::JITTargetMachineBuilder> createJITTargetMachineBuilder(const TargetSelection& selection, llvm::OptimizationLevel level) {
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> builder = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!builder) {
+        return builder.takeError();
+    }
+
+    if (selection.cpu != "generic") {
+        builder->setCPU(selection.cpu);
+        builder->getFeatures() = llvm::SubtargetFeatures(selection.features);
+    } else if (!selection.features.empty()) {
+        std::vector<std::string> explicitFeatures;
+        for (llvm::StringRef feature : llvm::split(selection.features, ',')) {
+            if (!feature.empty()) {
+                explicitFeatures.push_back(feature.str());
+            }
+        }
+        builder->addFeatures(explicitFeatures);
+    }
+
+    builder->setCodeGenOptLevel(getCodeGenOptLevel(level));
+    return builder;
+}
+
+// The runtime is linked into the compiler itself, so JIT-ed code binds directly to it.
+llvm::Error defineOutputRuntimeSymbols(llvm::orc::LLJIT& jit) {
+    const std::pair<const char*, llvm::orc::ExecutorAddr> runtimeSymbols[] = {
+        {"__bp_io_configure", llvm::orc::ExecutorAddr::fromPtr(&__bp_io_configure)},
+        {"__bp_write_i64", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_i64)},
+        {"__bp_write_u64", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_u64)},
+        {"__bp_write_f64", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_f64)},
+        {"__bp_write_fraction", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_fraction)},
+        {"__bp_write_bool", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_bool)},
+        {"__bp_write_char", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_char)},
+        {"__bp_write_str", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_str)},
+        {"__bp_write_newline", llvm::orc::ExecutorAddr::fromPtr(&__bp_write_newline)},
+        {"__bp_flush", llvm::orc::ExecutorAddr::fromPtr(&__bp_flush)},
+        {"__bp_rc_alloc", llvm::orc::ExecutorAddr::fromPtr(&__bp_rc_alloc)},
+        {"__bp_rc_retain", llvm::orc::ExecutorAddr::fromPtr(&__bp_rc_retain)},
+        {"__bp_rc_release", llvm::orc::ExecutorAddr::fromPtr(&__bp_rc_release)},
+        {"__bp_rc_share", llvm::orc::ExecutorAddr::fromPtr(&__bp_rc_share)},
+        {"__bp_green_start", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_start)},
+        {"__bp_green_spawn", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_spawn)},
+        {"__bp_green_yield", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_yield)},
+        {"__bp_green_shutdown", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_shutdown)},
+        {"__bp_green_current", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_current)},
+        {"__bp_green_park", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_park)},
+        {"__bp_green_unpark", llvm::orc::ExecutorAddr::fromPtr(&__bp_green_unpark)},
+        {"__bp_channel_create", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_create)},
+        {"__bp_channel_destroy", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_destroy)},
+        {"__bp_channel_send", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_send)},
+        {"__bp_channel_receive", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_receive)},
+        {"__bp_channel_try_send", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_try_send)},
+        {"__bp_channel_try_receive", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_try_receive)},
+        {"__bp_channel_close", llvm::orc::ExecutorAddr::fromPtr(&__bp_channel_close)},
+        {"__bp_group_match", llvm::orc::ExecutorAddr::fromPtr(&__bp_group_match)},
+        {"__bp_group_match_empty", llvm::orc::ExecutorAddr::fromPtr(&__bp_group_match_empty)},
+        {"__bp_group_match_free", llvm::orc::ExecutorAddr::fromPtr(&__bp_group_match_free)},
+        {"__bp_group_first", llvm::orc::ExecutorAddr::fromPtr(&__bp_group_first)},
+        {"__bp_group_next", llvm::orc::ExecutorAddr::fromPtr(&__bp_group_next)},
+        {"__bp_hash_mix", llvm::orc::ExecutorAddr::fromPtr(&__bp_hash_mix)},
+        {"__bp_profile_enter", llvm::orc::ExecutorAddr::fromPtr(&__bp_profile_enter)},
+        {"__bp_profile_exit", llvm::orc::ExecutorAddr::fromPtr(&__bp_profile_exit)},
+    };
+
+    llvm::orc::MangleAndInterner mangle(jit.getExecutionSession(), jit.getDataLayout());
+    llvm::orc::SymbolMap symbols;
+    for (const auto& [name, address] : runtimeSymbols) {
+        symbols[mangle(name)] = llvm::orc::ExecutorSymbolDef(address, llvm::JITSymbolFlags::Exported);
+    }
+    return jit.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(symbols)));
+}
+
+}
+
+int runInJIT(std::vector<TranslationUnit> units, const TargetSelection& selection, llvm::OptimizationLevel level, const ProfileSettings& profile, unsigned compileThreads, const std::string& emitIRPath, const std::string& emitBitcodePath, const OutputRuntimeSettings& outputRuntime, ProfilingSession& profiling) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    llvm::Expected<llvm::orc::JITTargetMachineBuilder> targetMachineBuilder = createJITTargetMachineBuilder(selection, level);
+    if (!targetMachineBuilder) {
+        std::cerr << "Error: Failed to configure JIT target: " << llvm::toString(targetMachineBuilder.takeError()) << std::endl;
+        return 1;
+    }
+
+    llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> jit = llvm::orc::LLJITBuilder()
+        .setJITTargetMachineBuilder(*targetMachineBuilder)
+        .setNumCompileThreads(compileThreads)
+        .create();
+    if (!jit) {
+        std::cerr << "Error: Failed to create JIT: " << llvm::toString(jit.takeError()) << std::endl;
+        return 1;
+    }
+
+    // Resolve libc functions referenced by generated code (printf, ...) from this process.
+    llvm::Expected<std::unique_ptr<llvm::orc::DynamicLibrarySearchGenerator>> processSymbols =
+        llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+    if (!processSymbols) {
+        std::cerr << "Error: Failed to expose host process symbols to the JIT: " << llvm::toString(processSymbols.takeError()) << std::endl;
+        return 1;
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*processSymbols));
+
+    if (llvm::Error error = defineOutputRuntimeSymbols(**jit)) {
+        std::cerr << "Error: Failed to expose the BluePrint runtime to the JIT: " << llvm::toString(std::move(error)) << std::endl;
+        return 1;
+    }
+
+    // Optimization runs inside the IR transform layer so it happens on the JIT's compile
+    // threads alongside instruction selection. --emit-ir and --emit-bc instead optimize and
+    // write the module here, once, before the JIT sees it: the JIT may materialize modules on
+    // several threads, and those options link all sources into a single module anyway.
+    const bool emitBeforeJIT = !emitIRPath.empty() || !emitBitcodePath.empty();
+    const llvm::orc::JITTargetMachineBuilder optimizerTargetBuilder = *targetMachineBuilder;
+    if (!emitBeforeJIT) {
+        (*jit)->getIRTransformLayer().setTransform(
+            [optimizerTargetBuilder, level, profile, &profiling](llvm::orc::ThreadSafeModule threadSafeModule, llvm::orc::MaterializationResponsibility&) -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+                ProfilingSession::WorkerTrace workerTrace(profiling);
+                llvm::orc::JITTargetMachineBuilder builder = optimizerTargetBuilder;
+                llvm::Expected<std::unique_ptr<llvm::TargetMachine>> targetMachine = builder.createTargetMachine();
+                if (!targetMachine) {
+                    return targetMachine.takeError();
+                }
+
+                bool succeeded = true;
+                threadSafeModule.withModuleDo([&](llvm::Module& jitModule) {
+                    succeeded = optimizeModule(jitModule, **targetMachine, level, LinkTimeOptimization::Off, profile);
+                    profiling.recordOptimizedModule(jitModule);
+                });
+                if (!succeeded) {
+                    return llvm::make_error<llvm::StringError>("failed to prepare module for JIT execution", llvm::inconvertibleErrorCode());
+                }
+                return std::move(threadSafeModule);
+            });
+    }
+
+    // Each unit keeps its own context, so the modules are added without linking them first.
+    for (TranslationUnit& unit : units) {
+        unit.module->setDataLayout((*jit)->getDataLayout());
+        unit.module->setTargetTriple((*jit)->getTargetTriple());
+
+        if (emitBeforeJIT) {
+            llvm::orc::JITTargetMachineBuilder builder = optimizerTargetBuilder;
+            llvm::Expected<std::unique_ptr<llvm::TargetMachine>> targetMachine = builder.createTargetMachine();
+            if (!targetMachine) {
+                std::cerr << "Error: Failed to create JIT target machine: " << llvm::toString(targetMachine.takeError()) << std::endl;
+                return 1;
+            }
+            if (!optimizeModule(*unit.module, **targetMachine, level, LinkTimeOptimization::Off, profile)
+                || (!emitIRPath.empty() && !emitIRFile(*unit.module, emitIRPath))
+                || (!emitBitcodePath.empty() && !emitBitcodeFile(*unit.module, emitBitcodePath, false))) {
+                return 1;
+            }
+            profiling.recordOptimizedModule(*unit.module);
+        }
+
+        llvm::orc::ThreadSafeModule threadSafeModule(std::move(unit.module), llvm::orc::ThreadSafeContext(std::move(unit.context)));
+        if (llvm::Error error = (*jit)->addIRModule(std::move(threadSafeModule))) {
+            std::cerr << "Error: Failed to add " << unit.sourcePath << " to JIT: " << llvm::toString(std::move(error)) << std::endl;
+            return 1;
+        }
+    }
+
+    if (llvm::Error error = (*jit)->initialize((*jit)->getMainJITDylib())) {
+        std::cerr << "Error: Failed to run JIT initializers: " << llvm::toString(std::move(error)) << std::endl;
+        return 1;
+    }
+
+    // The first lookup materializes the module. Its optimization is timed by optimizeModule
+    // and instruction selection by the pass timers, so the enclosing scope is trace-only.
+    llvm::Expected<llvm::orc::ExecutorAddr> entryAddress = [&]() {
+        PhaseScope compileScope("JITCompile", "", PhaseScope::Report::TraceOnly);
+        return (*jit)->lookup("System.Application.main");
+    }();
+    if (!entryAddress) {
+        std::cerr << "Error: Unable to find System.Application.main: " << llvm::toString(entryAddress.takeError()) << std::endl;
+        return 1;
+    }
+
+    {
+        PhaseScope executeScope("Execute");
+        __bp_io_configure(outputRuntime.buffering);
+        auto entry = entryAddress->toPtr<void (*)()>();
+        entry();
+        __bp_flush();
+        // The method records live in JIT memory, which is gone by the time atexit runs.
+        __bp_profile_report();
+    }
+
+    if (llvm::Error error = (*jit)->deinitialize((*jit)->getMainJITDylib())) {
+        std::cerr << "Error: Failed to run JIT deinitializers: " << llvm::toString(std::move(error)) << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
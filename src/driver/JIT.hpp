@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <llvm/Passes/OptimizationLevel.h>
+
+#include "Driver.hpp"
+#include "ProfilingSession.hpp"
+
+// Compiles the units with ORC's LLJIT on compileThreads threads (0 = in-line) and runs
+// System.Application.main in this process, bound to the runtime linked into the compiler.
+// --emit-ir and --emit-bc write the optimized module first. Returns the exit status for --run.
+int runInJIT(std::vector<TranslationUnit> units, const TargetSelection& selection, llvm::OptimizationLevel level, const ProfileSettings& profile, unsigned compileThreads, const std::string& emitIRPath, const std::string& emitBitcodePath, const OutputRuntimeSettings& outputRuntime, ProfilingSession& profiling);
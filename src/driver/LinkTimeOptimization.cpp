@@ -0,0 +1,89 @@
+#include <iostream>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/LTO/LTO.h>
+#include <llvm/Support/Caching.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "LinkTimeOptimization.hpp"
+#include "Target.hpp"
+#include "../support/PhaseScope.hpp"
+
+bool runLinkTimeOptimization(std::vector<TranslationUnit>& units, const TargetSelection& selection, llvm::OptimizationLevel level, unsigned jobs, std::vector<std::string>& outObjectPaths) {
+    PhaseScope ltoScope("LTO");
+
+    llvm::lto::Config config;
+    config.CPU = selection.cpu;
+    for (llvm::StringRef feature : llvm::split(selection.features, ',')) {
+        if (!feature.empty()) {
+            config.MAttrs.push_back(feature.str());
+        }
+    }
+    // The executable is linked with -no-pie.
+    config.RelocModel = llvm::Reloc::Static;
+    config.OptLevel = level.getSpeedupLevel();
+    config.CGOptLevel = getCodeGenOptLevel(level);
+
+    llvm::lto::LTO lto(std::move(config), llvm::lto::createInProcessThinBackend(llvm::hardware_concurrency(jobs)));
+
+    llvm::StringSet<> definedSymbols;
+    for (const TranslationUnit& unit : units) {
+        llvm::Expected<std::unique_ptr<llvm::lto::InputFile>> input = llvm::lto::InputFile::create(
+            llvm::MemoryBufferRef(llvm::StringRef(unit.bitcode.data(), unit.bitcode.size()), unit.sourcePath));
+        if (!input) {
+            std::cerr << "Error: Internal compiler error: could not read bitcode for " << unit.sourcePath << ": " << llvm::toString(input.takeError()) << std::endl;
+            return false;
+        }
+
+        std::vector<llvm::lto::SymbolResolution> resolutions;
+        for (const llvm::lto::InputFile::Symbol& symbol : (*input)->symbols()) {
+            llvm::lto::SymbolResolution resolution;
+            if (!symbol.isUndefined()) {
+                const bool firstDefinition = definedSymbols.insert(symbol.getName()).second;
+                if (!firstDefinition && !symbol.isWeak()) {
+                    std::cerr << "Error: Symbol '" << symbol.getName().str() << "' in " << unit.sourcePath << " is already defined by another source." << std::endl;
+                    return false;
+                }
+                resolution.Prevailing = firstDefinition;
+                resolution.FinalDefinitionInLinkageUnit = true;
+            }
+            // Only the C entrypoint is referenced from outside the link; the runtime calls
+            // into no generated code, so everything else may be internalized.
+            resolution.VisibleToRegularObj = symbol.getName() == "main";
+            resolutions.push_back(resolution);
+        }
+
+        if (llvm::Error error = lto.add(std::move(*input), resolutions)) {
+            std::cerr << "Error: Failed to add " << unit.sourcePath << " to the LTO link: " << llvm::toString(std::move(error)) << std::endl;
+            return false;
+        }
+    }
+
+    // Every task writes its own slot, so the backend threads need no lock.
+    std::vector<std::string> taskObjectPaths(lto.getMaxTasks());
+    const llvm::AddStreamFn addStream = [&taskObjectPaths](unsigned task, const llvm::Twine&) -> llvm::Expected<std::unique_ptr<llvm::CachedFileStream>> {
+        int descriptor = -1;
+        llvm::SmallString<128> path;
+        if (std::error_code errorCode = llvm::sys::fs::createTemporaryFile("blueprint-lto", "o", descriptor, path)) {
+            return llvm::errorCodeToError(errorCode);
+        }
+        taskObjectPaths[task] = path.str().str();
+        return std::make_unique<llvm::CachedFileStream>(std::make_unique<llvm::raw_fd_ostream>(descriptor, /*shouldClose=*/true), taskObjectPaths[task]);
+    };
+
+    llvm::Error error = lto.run(addStream);
+    for (const std::string& objectPath : taskObjectPaths) {
+        if (!objectPath.empty()) {
+            outObjectPaths.push_back(objectPath);
+        }
+    }
+    if (error) {
+        std::cerr << "Error: Link-time optimization failed: " << llvm::toString(std::move(error)) << std::endl;
+        return false;
+    }
+    return true;
+}
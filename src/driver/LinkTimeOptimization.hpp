@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <llvm/Passes/OptimizationLevel.h>
+
+#include "Driver.hpp"
+
+// Links and optimizes the pre-link bitcode of every unit together and compiles the result
+// to temporary objects, which are appended to outObjectPaths even when the link fails so the
+// caller can remove them. Units with a module summary are linked by ThinLTO, which imports
+// functions across modules and then optimizes each module on its own thread; the others are
+// merged into a single module first.
+bool runLinkTimeOptimization(std::vector<TranslationUnit>& units, const TargetSelection& selection, llvm::OptimizationLevel level, unsigned jobs, std::vector<std::string>& outObjectPaths);
@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <iostream>
+
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "Linker.hpp"
+#include "../support/PhaseScope.hpp"
+
+bool linkTranslationUnits(std::vector<TranslationUnit>& units) {
+    PhaseScope linkScope("LinkModules");
+    TranslationUnit& destination = units.front();
+    llvm::Linker linker(*destination.module);
+
+    for (size_t index = 1; index < units.size(); ++index) {
+        TranslationUnit& unit = units[index];
+        llvm::SmallVector<char, 0> bitcode;
+        {
+            llvm::raw_svector_ostream bitcodeStream(bitcode);
+            llvm::WriteBitcodeToFile(*unit.module, bitcodeStream);
+        }
+        unit.module.reset();
+        unit.context.reset();
+
+        llvm::Expected<std::unique_ptr<llvm::Module>> imported = llvm::parseBitcodeFile(
+            llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode.size()), unit.sourcePath), *destination.context);
+        if (!imported) {
+            std::cerr << "Error: Internal compiler error: could not reload module for " << unit.sourcePath << ": " << llvm::toString(imported.takeError()) << std::endl;
+            return false;
+        }
+
+        if (linker.linkInModule(std::move(*imported))) {
+            std::cerr << "Error: Failed to link " << unit.sourcePath << " into " << destination.sourcePath << "." << std::endl;
+            return false;
+        }
+    }
+
+    units.resize(1);
+    return true;
+}
+
+bool linkExecutable(const std::vector<std::string>& objectPaths, const std::string& executablePath, const std::string& runtimeLibraryPath, const ProfileSettings& profile) {
+    PhaseScope linkScope("Link", executablePath);
+    std::string command = "cc -no-pie";
+    for (const std::string& objectPath : objectPaths) {
+        command += " \"" + objectPath + "\"";
+    }
+    if (!runtimeLibraryPath.empty()) {
+        command += " \"" + runtimeLibraryPath + "\" -lpthread";
+    }
+    // Instrumented objects only reference the counters; the undefined symbol pulls in the
+    // runtime's constructor that writes them out at exit, as clang's driver does on ELF.
+    if (profile.mode == ProfileGuidedOptimization::Generate) {
+        command += " -Wl,-u,__llvm_profile_runtime \"" + profile.runtimeLibraryPath + "\"";
+    }
+    command += " -o \"" + executablePath + "\"";
+    const int result = std::system(command.c_str());
+    if (result != 0) {
+        std::cerr << "Error: Linker failed while creating executable. Command: " << command << std::endl;
+        return false;
+    }
+    return true;
+}
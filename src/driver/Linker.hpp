@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Driver.hpp"
+
+// Links every unit into the first. Modules in different contexts cannot be linked directly,
+// so each is moved into the destination context through an in-memory bitcode round trip.
+bool linkTranslationUnits(std::vector<TranslationUnit>& units);
+
+// Links objectPaths, the runtime library (unless runtimeLibraryPath is empty) and, under
+// --profile-generate, the profile runtime into an executable with the host's cc.
+bool linkExecutable(const std::vector<std::string>& objectPaths, const std::string& executablePath, const std::string& runtimeLibraryPath, const ProfileSettings& profile);
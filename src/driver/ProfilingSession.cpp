@@ -0,0 +1,99 @@
+#include <iostream>
+
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Function.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "ProfilingSession.hpp"
+#include "../parser/parser.hpp"
+
+ModuleCounts countModule(const llvm::Module& module) {
+    ModuleCounts counts;
+    for (const llvm::Function& function : module) {
+        if (function.isDeclaration()) {
+            continue;
+        }
+        counts.functions++;
+        for (const llvm::BasicBlock& block : function) {
+            counts.basicBlocks++;
+            counts.instructions += block.size();
+        }
+    }
+    return counts;
+}
+
+ProfilingSession::ProfilingSession(const ProfilingOptions& options, const char* executableName) : options(options) {
+    llvm::TimePassesIsEnabled = options.timePasses;
+    if (options.timeTrace) {
+        llvm::timeTraceProfilerInitialize(options.timeTraceGranularity, executableName);
+    }
+}
+
+ProfilingSession::~ProfilingSession() {
+    if (options.statistics) {
+        printStatistics();
+    }
+
+    if (options.timePasses) {
+        llvm::TimerGroup::printAll(llvm::errs());
+        llvm::TimerGroup::clearAll();
+    }
+
+    if (llvm::timeTraceProfilerEnabled()) {
+        if (llvm::Error error = llvm::timeTraceProfilerWrite(options.timeTraceFile, "blueprint")) {
+            std::cerr << "Error: Could not write time trace '" << options.timeTraceFile << "': " << llvm::toString(std::move(error)) << std::endl;
+        }
+        llvm::timeTraceProfilerCleanup();
+    }
+}
+
+void ProfilingSession::recordFrontend(const Parser& parser) {
+    std::lock_guard<std::mutex> lock(mutex);
+    tokens += parser.getTokenCount();
+    astNodes += parser.getAstNodeCount();
+    astBytes += parser.getAstBytes();
+}
+
+void ProfilingSession::recordGeneratedModule(const llvm::Module& module) {
+    if (options.statistics) {
+        const ModuleCounts counts = countModule(module);
+        std::lock_guard<std::mutex> lock(mutex);
+        generated = generated.value_or(ModuleCounts()) += counts;
+    }
+}
+
+void ProfilingSession::recordOptimizedModule(const llvm::Module& module) {
+    if (options.statistics) {
+        const ModuleCounts counts = countModule(module);
+        std::lock_guard<std::mutex> lock(mutex);
+        optimized = optimized.value_or(ModuleCounts()) += counts;
+    }
+}
+
+void ProfilingSession::printStatistics() const {
+    llvm::raw_ostream& out = llvm::errs();
+    out << "===-------------------------------------------------------------------------===\n";
+    out << "                        BluePrint compilation statistics\n";
+    out << "===-------------------------------------------------------------------------===\n";
+    out << llvm::format("%12zu  tokens\n", tokens);
+    out << llvm::format("%12zu  AST nodes\n", astNodes);
+    out << llvm::format("%12zu  AST arena bytes\n", astBytes);
+
+    const auto printCounts = [&out](const char* stage, const ModuleCounts& counts) {
+        out << llvm::format("%12zu  functions (%s)\n", counts.functions, stage);
+        out << llvm::format("%12zu  basic blocks (%s)\n", counts.basicBlocks, stage);
+        out << llvm::format("%12zu  instructions (%s)\n", counts.instructions, stage);
+    };
+    if (generated) {
+        printCounts("after codegen", *generated);
+    }
+    if (optimized) {
+        printCounts("after optimization", *optimized);
+    }
+    out << "\n";
+    out.flush();
+}
+
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/TimeProfiler.h>
+
+class Parser;
+
+struct ProfilingOptions {
+    bool timePasses = false;
+    bool timeTrace = false;
+    std::string timeTraceFile;
+    unsigned timeTraceGranularity = 500;
+    bool statistics = false;
+};
+
+struct ModuleCounts {
+    size_t functions = 0;
+    size_t basicBlocks = 0;
+    size_t instructions = 0;
+
+    ModuleCounts& operator+=(const ModuleCounts& other) {
+        functions += other.functions;
+        basicBlocks += other.basicBlocks;
+        instructions += other.instructions;
+        return *this;
+    }
+};
+
+// Declarations are not counted; they cost nothing to compile.
+ModuleCounts countModule(const llvm::Module& module);
+
+// Owns the --time-passes, --time-trace and --stats reports for one compilation. Reports are
+// written when the session is destroyed, after every PhaseScope has closed, so a compilation
+// that fails part-way still reports the phases that ran. Statistics from several translation
+// units are summed; the record methods may be called from worker threads.
+class ProfilingSession {
+    public:
+        ProfilingSession(const ProfilingOptions& options, const char* executableName);
+        ~ProfilingSession();
+
+        ProfilingSession(const ProfilingSession&) = delete;
+        ProfilingSession& operator=(const ProfilingSession&) = delete;
+
+        bool isTimingPhases() const {
+            return options.timePasses || options.timeTrace;
+        }
+
+        void recordFrontend(const Parser& parser);
+        void recordGeneratedModule(const llvm::Module& module);
+        void recordOptimizedModule(const llvm::Module& module);
+
+        // The trace profiler records per thread. A worker thread joins the trace for the
+        // lifetime of this scope; on a thread that is already tracing it does nothing.
+        class WorkerTrace {
+            public:
+                explicit WorkerTrace(const ProfilingSession& session)
+                    : active(session.options.timeTrace && !llvm::timeTraceProfilerEnabled()) {
+                    if (active) {
+                        llvm::timeTraceProfilerInitialize(session.options.timeTraceGranularity, "blueprint");
+                    }
+                }
+
+                ~WorkerTrace() {
+                    if (active) {
+                        llvm::timeTraceProfilerFinishThread();
+                    }
+                }
+
+                WorkerTrace(const WorkerTrace&) = delete;
+                WorkerTrace& operator=(const WorkerTrace&) = delete;
+
+            private:
+                bool active;
+        };
+
+    private:
+        void printStatistics() const;
+
+        ProfilingOptions options;
+        std::mutex mutex;
+        size_t tokens = 0;
+        size_t astNodes = 0;
+        size_t astBytes = 0;
+        std::optional<ModuleCounts> generated;
+        std::optional<ModuleCounts> optimized;
+};
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <optional>
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/MC/TargetRegistry.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+#include <llvm/TargetParser/Triple.h>
+
+#include "Target.hpp"
+
+llvm::CodeGenOptLevel getCodeGenOptLevel(llvm::OptimizationLevel level) {
+    switch (level.getSpeedupLevel()) {
+        case 0:
+            return llvm::CodeGenOptLevel::None;
+        case 1:
+            return llvm::CodeGenOptLevel::Less;
+        case 2:
+            return llvm::CodeGenOptLevel::Default;
+        default:
+            return llvm::CodeGenOptLevel::Aggressive;
+    }
+}
+
+bool isHostTarget(const TargetSelection& selection) {
+    return selection.triple.empty()
+        || llvm::Triple(llvm::Triple::normalize(selection.triple)) == llvm::Triple(llvm::sys::getDefaultTargetTriple());
+}
+
+bool resolveTargetSelection(TargetSelection& selection) {
+    if (selection.cpu != "native") {
+        return true;
+    }
+
+    if (!isHostTarget(selection)) {
+        std::cerr << "Error: --mcpu native cannot be combined with a non-host --target." << std::endl;
+        return false;
+    }
+
+    selection.cpu = llvm::sys::getHostCPUName().str();
+
+    llvm::SubtargetFeatures hostFeatures;
+    for (const auto& feature : llvm::sys::getHostCPUFeatures()) {
+        hostFeatures.AddFeature(feature.first(), feature.second);
+    }
+
+    if (!selection.features.empty()) {
+        for (llvm::StringRef explicitFeature : llvm::split(selection.features, ',')) {
+            if (!explicitFeature.empty()) {
+                hostFeatures.AddFeature(explicitFeature);
+            }
+        }
+    }
+
+    selection.features = hostFeatures.getString();
+    return true;
+}
+
+void initializeAllTargets() {
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    llvm::InitializeAllAsmParsers();
+}
+
+void initializeTargets(const TargetSelection& selection) {
+    if (isHostTarget(selection)) {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    } else {
+        initializeAllTargets();
+    }
+}
+
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(llvm::Module& module, const TargetSelection& selection, llvm::OptimizationLevel level) {
+    const std::string targetTripleString = selection.triple.empty()
+        ? llvm::sys::getDefaultTargetTriple()
+        : llvm::Triple::normalize(selection.triple);
+    llvm::Triple targetTriple(targetTripleString);
+    module.setTargetTriple(targetTriple);
+
+    std::string targetError;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTripleString, targetError);
+    if (!target) {
+        std::cerr << "Error: Failed to lookup target '" << targetTripleString << "': " << targetError << std::endl;
+        return nullptr;
+    }
+
+    llvm::TargetOptions options;
+    auto relocationModel = std::optional<llvm::Reloc::Model>();
+    std::unique_ptr<llvm::TargetMachine> targetMachine(
+        target->createTargetMachine(targetTriple, selection.cpu, selection.features, options, relocationModel, std::nullopt, getCodeGenOptLevel(level))
+    );
+
+    if (!targetMachine) {
+        std::cerr << "Error: Failed to create LLVM target machine." << std::endl;
+        return nullptr;
+    }
+
+    module.setDataLayout(targetMachine->createDataLayout());
+    return targetMachine;
+}
+
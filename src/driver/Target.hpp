@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/OptimizationLevel.h>
+#include <llvm/Support/CodeGen.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "Driver.hpp"
+
+llvm::CodeGenOptLevel getCodeGenOptLevel(llvm::OptimizationLevel level);
+
+bool isHostTarget(const TargetSelection& selection);
+
+// Expands "--mcpu native" into the host CPU name plus every feature the host reports.
+// Explicit --mattr features are appended afterwards so they override detected ones.
+bool resolveTargetSelection(TargetSelection& selection);
+
+void initializeAllTargets();
+
+// Target registration is not thread-safe, so it happens once before any backend runs.
+void initializeTargets(const TargetSelection& selection);
+
+// Sets the module's triple and data layout for selection. Returns null and reports the error
+// if the target is unknown.
+std::unique_ptr<llvm::TargetMachine> createTargetMachine(llvm::Module& module, const TargetSelection& selection, llvm::OptimizationLevel level);
@@ -0,0 +1,104 @@
+#include <iostream>
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
+
+#include "UnitCache.hpp"
+#include "Frontend.hpp"
+#include "../support/PhaseScope.hpp"
+
+namespace {
+
+// Reads back the interface records cached with a unit's object. A missing or unreadable
+// entry only turns the lookup into a miss, which --verbose explains; it is not an error.
+bool restoreCachedInterfaces(TranslationUnit& unit, const ObjectCache& cache, bool verbose) {
+    const std::string interfacePath = unit.objectPath + ".bpi";
+    if (!cache.fetch(unit.cacheKey, interfacePath, ObjectCache::Entry::Interface)) {
+        return false;
+    }
+
+    std::string error;
+    std::unique_ptr<InterfaceFile> file = InterfaceFile::open(interfacePath, error);
+    bool complete = file != nullptr;
+    for (size_t index = 0; complete && index < file->getClassCount(); ++index) {
+        std::optional<ClassInterface> description = file->lookup(file->getClassName(index));
+        complete = description.has_value();
+        if (complete) {
+            unit.interfaces.push_back(std::move(*description));
+        }
+    }
+    file.reset();
+    llvm::sys::fs::remove(interfacePath);
+    if (!complete) {
+        unit.interfaces.clear();
+        if (verbose) {
+            std::cout << "Ignoring unreadable cached interface for " << unit.sourcePath << (error.empty() ? "" : ": " + error) << std::endl;
+        }
+    }
+    return complete;
+}
+
+}
+
+std::string getFileIdentity(const std::string& path) {
+    llvm::sys::fs::file_status status;
+    if (path.empty() || llvm::sys::fs::status(path, status)) {
+        return "";
+    }
+    return std::to_string(status.getSize()) + "@" + std::to_string(llvm::sys::toTimeT(status.getLastModificationTime()));
+}
+
+std::string getCompilerIdentity(const char* argv0) {
+    static int identityAnchor = 0;
+    return getFileIdentity(llvm::sys::fs::getMainExecutable(argv0, &identityAnchor));
+}
+
+std::string describeObjectConfiguration(const std::string& compilerIdentity, const TargetSelection& selection, llvm::OptimizationLevel level, const CodeGenOptions& codeGenOptions, std::optional<int32_t> entrypointBuffering, const std::vector<const InterfaceFile*>& importedInterfaces, const ProfileSettings& profile) {
+    std::string configuration;
+    llvm::raw_string_ostream out(configuration);
+    out << "compiler=" << compilerIdentity << ";llvm=" << LLVM_VERSION_STRING
+        << ";triple=" << (selection.triple.empty() ? llvm::sys::getDefaultTargetTriple() : llvm::Triple::normalize(selection.triple))
+        << ";cpu=" << selection.cpu << ";features=" << selection.features
+        << ";opt=" << level.getSpeedupLevel() << "," << level.getSizeLevel()
+        << ";bounds=" << static_cast<int>(codeGenOptions.boundsChecks)
+        << ";contracts=" << static_cast<int>(codeGenOptions.contracts) << "," << static_cast<int>(codeGenOptions.quantifiers)
+        << ";runtime=" << codeGenOptions.useOutputRuntime
+        << ";fraction=" << static_cast<int>(codeGenOptions.fractionNormalization) << "," << static_cast<int>(codeGenOptions.fractionOverflow)
+        << ";entry=" << (entrypointBuffering ? std::to_string(*entrypointBuffering) : "none")
+        << ";instrument=" << codeGenOptions.instrumentFunctions
+        << ";pgo=" << static_cast<int>(profile.mode) << "," << profile.profilePath;
+    if (profile.mode == ProfileGuidedOptimization::Use) {
+        out << "," << getFileIdentity(profile.profilePath);
+    }
+    for (const InterfaceFile* interface : importedInterfaces) {
+        out << ";interface=" << ObjectCache::computeDigest(interface->getContents());
+    }
+    return out.str();
+}
+
+void storeCachedInterfaces(const TranslationUnit& unit, const ObjectCache& cache) {
+    const std::string interfacePath = unit.objectPath + ".bpi";
+    if (InterfaceFile::write(unit.interfaces, interfacePath)) {
+        cache.store(unit.cacheKey, interfacePath, ObjectCache::Entry::Interface);
+    }
+    llvm::sys::fs::remove(interfacePath);
+}
+
+bool restoreCachedObject(TranslationUnit& unit, const ObjectCache& cache, const std::string& configuration, bool describeInterfaces, bool verbose) {
+    if (!loadSource(unit)) {
+        return false;
+    }
+
+    PhaseScope cacheScope("CacheLookup", unit.sourcePath);
+    unit.cacheKey = ObjectCache::computeKey(unit.source->getBuffer(), configuration);
+    unit.restoredFromCache = (!describeInterfaces || restoreCachedInterfaces(unit, cache, verbose)) && cache.fetch(unit.cacheKey, unit.objectPath);
+    if (!unit.restoredFromCache) {
+        unit.interfaces.clear();
+    } else if (verbose) {
+        std::cout << "Reused cached object for " << unit.sourcePath << std::endl;
+    }
+    return unit.restoredFromCache;
+}
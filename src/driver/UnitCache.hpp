@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <llvm/Passes/OptimizationLevel.h>
+
+#include "Driver.hpp"
+#include "../codegen/CodeGenerator.hpp"
+#include "../support/InterfaceFile.hpp"
+#include "../support/ObjectCache.hpp"
+
+// Identifies a file by its size and modification time, or returns an empty string if it
+// cannot be read.
+std::string getFileIdentity(const std::string& path);
+
+// Identifies the running compiler build by its executable, so cache entries are invalidated
+// whenever the compiler is rebuilt.
+std::string getCompilerIdentity(const char* argv0);
+
+// Everything besides the source bytes that can change a unit's object. Every CodeGenOptions
+// field must be listed here. Of the other files, each imported interface contributes a digest
+// of its contents, which decide the instantiations a unit skips, and a --profile-use profile
+// its identity, so that merging new runs into it recompiles. Editing a library's source only
+// changes its dependents' keys if it changes the library's emitted interface.
+std::string describeObjectConfiguration(const std::string& compilerIdentity, const TargetSelection& selection, llvm::OptimizationLevel level, const CodeGenOptions& codeGenOptions, std::optional<int32_t> entrypointBuffering, const std::vector<const InterfaceFile*>& importedInterfaces, const ProfileSettings& profile);
+
+// Caches the interface records runFrontend collected next to the unit's object.
+void storeCachedInterfaces(const TranslationUnit& unit, const ObjectCache& cache);
+
+// On a hit the unit's object is already in place and it needs neither frontend nor backend.
+// Under --emit-interface a hit also needs the unit's cached interface records.
+bool restoreCachedObject(TranslationUnit& unit, const ObjectCache& cache, const std::string& configuration, bool describeInterfaces, bool verbose);
@@ -1,125 +1,114 @@
 #include <iostream>
-#include <unordered_map>
 #include <cctype>
+#include <charconv>
+#include <cstdlib>
 
 #include "lexer.hpp"
 #include "tokens.hpp"
 
-// Initialize the keyword lookup table
-std::unordered_map<std::string, Token> Lexer::keywords = {
-    // Primitive types
-    {"i8", tok_i8},
-    {"i16", tok_i16},
-    {"i32", tok_i32},
-    {"i64", tok_i64},
-    {"u8", tok_u8},
-    {"u16", tok_u16},
-    {"u32", tok_u32},
-    {"u64", tok_u64},
-    {"f32", tok_f32},
-    {"f64", tok_f64},
-    {"fr32", tok_fr32},
-    {"fr64", tok_fr64},
-    {"bool", tok_bool}, 
-	{"char", tok_char}, 
-	{"void", tok_void},
-    {"str",  tok_str},
-    
-    // Literals
-    {"true", tok_true}, 
-	{"false", tok_false},
-    
-    // Declaration keywords
-    {"class", tok_class},
-    {"new",   tok_new},
-    
-    // Control flow
-    {"if", tok_if}, 
-	{"else", tok_else}, 
-	{"while", tok_while}, 
-
-	// Access modifiers
-	{"public", tok_public},
-	};
-
-Lexer::Lexer(std::string sourceCode) : source(sourceCode) {
+Lexer::Lexer(std::string_view sourceCode) : source(sourceCode) {
 	this->currentToken = 0;
 }
 
-char Lexer::getchar() {
+// Returns the next byte as an unsigned char value, or EOF. The index advances even past the
+// end so that ungetCurrentToken always undoes exactly one getchar.
+int Lexer::getchar() {
 	if (currentIndex >= source.size()) {
+		currentIndex++;
 		return EOF;
 	}
-	return source[currentIndex++];
+	return static_cast<unsigned char>(source[currentIndex++]);
 }
 
 int16_t Lexer::getNextToken() {
+	this->currentToken = lexToken();
+	const size_t tokenEnd = currentIndex < source.size() ? currentIndex : source.size();
+	this->tokenSpan.length = tokenEnd > tokenSpan.offset ? tokenEnd - tokenSpan.offset : 0;
+	if (this->currentToken != tok_eof) {
+		this->tokenCount++;
+	}
+	return this->currentToken;
+}
+
+int16_t Lexer::lexToken() {
     int lastChar = ' ';
 
     while (isspace(lastChar))
         lastChar = this->getchar();
 
+    this->tokenSpan.offset = currentIndex - 1;
+
     if (lastChar == EOF) {
+        this->tokenSpan.offset = source.size();
         return tok_eof;
 	}
 
     if (isalpha(lastChar)) {
-        std::string identifierStr;
-        do {
-            identifierStr += lastChar;
-            lastChar = this->getchar();
-        } while (isalnum(lastChar));
-		ungetCurrentToken(); // Put back the last read character
-
-        this->currentToken = getKeywordToken(identifierStr);
-		if (this->currentToken == tok_true) {
+        const size_t start = currentIndex - 1;
+        while (currentIndex < source.size() && isalnum(static_cast<unsigned char>(source[currentIndex]))) {
+            currentIndex++;
+        }
+
+        const Token token = getKeywordToken(source.substr(start, currentIndex - start));
+		if (token == tok_true) {
 			this->boolValue = true;
-		} else if (this->currentToken == tok_false) {
+		} else if (token == tok_false) {
 			this->boolValue = false;
 		}
-		return this->currentToken;
+		return token;
     }
 
-    const bool dotStartsFloat = lastChar == '.' && currentIndex < source.size() && isdigit(source[currentIndex]);
+    const bool dotStartsFloat = lastChar == '.' && currentIndex < source.size() && isdigit(static_cast<unsigned char>(source[currentIndex]));
     if (isdigit(lastChar) || dotStartsFloat) {
-        std::string numStr;
-        bool isFloat = false;
-        do {
-            if (lastChar == '.' && !isFloat) {
+        const size_t start = currentIndex - 1;
+        bool isFloat = lastChar == '.';
+        while (currentIndex < source.size()) {
+            const char c = source[currentIndex];
+            if (c == '.') {
+                if (isFloat) {
+					std::cerr << "Error: Invalid number format with multiple decimal points." << std::endl;
+					return tok_eof;
+                }
                 isFloat = true;
-            } else if (lastChar == '.' && isFloat) {
-				std::cerr << "Error: Invalid number format with multiple decimal points." << std::endl;
-				return tok_eof;
+            } else if (!isdigit(static_cast<unsigned char>(c))) {
+                break;
             }
+            currentIndex++;
+        }
 
-            numStr += lastChar;
-            lastChar = this->getchar();
-        } while (isdigit(lastChar) || lastChar == '.');
-
-		ungetCurrentToken();
+        const char* first = source.data() + start;
+        const char* last = source.data() + currentIndex;
 
         // Handle number conversion and return appropriate token
         if (isFloat) {
-            this->floatValue = strtod(numStr.c_str(), nullptr);
-            this->currentToken = tok_float_literal;
-            return this->currentToken;
-        } else {
-            this->integerValue = strtoll(numStr.c_str(), nullptr, 10);
-            this->currentToken = tok_integer_literal;
-            return this->currentToken;
+            const std::from_chars_result result = std::from_chars(first, last, this->floatValue);
+            if (result.ec != std::errc()) {
+                // Out-of-range literals keep strtod's overflow/underflow behaviour.
+                this->floatValue = strtod(std::string(first, last).c_str(), nullptr);
+            }
+            return tok_float_literal;
+        }
+
+        const std::from_chars_result result = std::from_chars(first, last, this->integerValue);
+        if (result.ec == std::errc::result_out_of_range) {
+            this->integerValue = INT64_MAX;
         }
+        return tok_integer_literal;
     }
 
     if (lastChar == '/') {
-        char nextChar = this->getchar();
+        int nextChar = this->getchar();
         if (nextChar == '/') {
             // Single line comment
             do {
                 lastChar = this->getchar();
             } while (lastChar != EOF && lastChar != '\n' && lastChar != '\r');
 
-            if (lastChar != EOF)
-                return getNextToken();
+            if (lastChar == EOF) {
+                this->tokenSpan.offset = source.size();
+                return tok_eof;
+            }
+            return lexToken();
         } else if (nextChar == '*') {
             // Multi-line comment
             while (true) {
@@ -130,115 +119,126 @@ int16_t Lexer::getNextToken() {
                     lastChar = this->getchar();
                     if (lastChar == '/')
                         break;
+                    ungetCurrentToken(); // "**/" must still close the comment
                 }
             }
-            return getNextToken();
+            return lexToken();
         }
 
 		ungetCurrentToken();
-		this->currentToken = '/';
-		return this->currentToken;
+		return '/';
     }
 
     if (lastChar == '\'') {
-        char value = this->getchar();
-        char closing = this->getchar();
+        int value = this->getchar();
+        int closing = this->getchar();
         if (value == EOF || closing != '\'') {
             std::cerr << "Error: Invalid char literal." << std::endl;
             return tok_eof;
         }
 
-        this->charValue = value;
-        this->currentToken = tok_char_literal;
-        return this->currentToken;
+        this->charValue = static_cast<char>(value);
+        return tok_char_literal;
     }
 
     if (lastChar == '=') {
-        char nextChar = this->getchar();
-        if (nextChar == '=') {
-            this->currentToken = tok_equal_equal;
-            return this->currentToken;
+        if (this->getchar() == '=') {
+            if (this->getchar() == '>') {
+                return tok_implies;
+            }
+            ungetCurrentToken();
+            return tok_equal_equal;
         }
         ungetCurrentToken();
     }
 
     if (lastChar == '!') {
-        char nextChar = this->getchar();
-        if (nextChar == '=') {
-            this->currentToken = tok_not_equal;
-            return this->currentToken;
+        if (this->getchar() == '=') {
+            return tok_not_equal;
         }
         ungetCurrentToken();
     }
 
     if (lastChar == '<') {
-        char nextChar = this->getchar();
-        if (nextChar == '=') {
-            this->currentToken = tok_less_equal;
-            return this->currentToken;
+        if (this->getchar() == '=') {
+            return tok_less_equal;
         }
         ungetCurrentToken();
     }
 
     if (lastChar == '>') {
-        char nextChar = this->getchar();
-        if (nextChar == '=') {
-            this->currentToken = tok_greater_equal;
-            return this->currentToken;
+        if (this->getchar() == '=') {
+            return tok_greater_equal;
         }
         ungetCurrentToken();
     }
 
     if (lastChar == '&') {
-        char nextChar = this->getchar();
-        if (nextChar == '&') {
-            this->currentToken = '&';
-            return this->currentToken;
+        if (this->getchar() == '&') {
+            return '&';
         }
         ungetCurrentToken();
     }
 
     if (lastChar == '|') {
-        char nextChar = this->getchar();
-        if (nextChar == '|') {
-            this->currentToken = '|';
-            return this->currentToken;
+        if (this->getchar() == '|') {
+            return '|';
         }
         ungetCurrentToken();
     }
 
     if (lastChar == '"') {
-        std::string strContent;
+        // Literals without escapes are returned as a view of the source; only escaped
+        // literals are copied.
+        const size_t start = currentIndex;
+        bool hasEscape = false;
         while (true) {
-            char c = this->getchar();
+            int c = this->getchar();
             if (c == EOF || c == '\n') {
                 std::cerr << "Error: Unterminated string literal." << std::endl;
                 return tok_eof;
             }
             if (c == '"') break;
             if (c == '\\') {
-                char escaped = this->getchar();
-                switch (escaped) {
-                    case '"':  strContent += '"';  break;
-                    case '\\': strContent += '\\'; break;
-                    case 'n':  strContent += '\n'; break;
-                    case 't':  strContent += '\t'; break;
-                    case 'r':  strContent += '\r'; break;
-                    default:
-                        strContent += '\\';
-                        strContent += escaped;
-                        break;
+                hasEscape = true;
+                if (this->getchar() == EOF) {
+                    std::cerr << "Error: Unterminated string literal." << std::endl;
+                    return tok_eof;
                 }
-            } else {
-                strContent += c;
             }
         }
-        this->stringValue = strContent;
-        this->currentToken = tok_str_literal;
-        return this->currentToken;
+
+        const std::string_view raw = source.substr(start, currentIndex - 1 - start);
+        if (!hasEscape) {
+            this->stringValue = raw;
+            return tok_str_literal;
+        }
+
+        unescapedString.clear();
+        unescapedString.reserve(raw.size());
+        for (size_t i = 0; i < raw.size(); i++) {
+            if (raw[i] != '\\') {
+                unescapedString += raw[i];
+                continue;
+            }
+
+            const char escaped = raw[++i];
+            switch (escaped) {
+                case '"':  unescapedString += '"';  break;
+                case '\\': unescapedString += '\\'; break;
+                case 'n':  unescapedString += '\n'; break;
+                case 't':  unescapedString += '\t'; break;
+                case 'r':  unescapedString += '\r'; break;
+                default:
+                    unescapedString += '\\';
+                    unescapedString += escaped;
+                    break;
+            }
+        }
+        this->stringValue = unescapedString;
+        return tok_str_literal;
     }
 
-	this->currentToken = lastChar;
     return lastChar;
 }
 
@@ -250,6 +250,18 @@ int16_t Lexer::getCurrentToken() {
     return this->currentToken;
 }
 
+SourceSpan Lexer::getTokenSpan() const {
+    return this->tokenSpan;
+}
+
+std::string_view Lexer::getTokenText() const {
+    return source.substr(tokenSpan.offset, tokenSpan.length);
+}
+
+size_t Lexer::getTokenCount() const {
+    return this->tokenCount;
+}
+
 int64_t Lexer::getIntegerValue() {
 	return this->integerValue;
 }
@@ -266,20 +278,56 @@ char Lexer::getCharValue() {
     return this->charValue;
 }
 
-std::string Lexer::getStringValue() {
+std::string_view Lexer::getStringValue() {
     return this->stringValue;
 }
 
-std::string Lexer::getIdentifierName() {
+std::string_view Lexer::getIdentifierName() {
     return this->identifierName;
 }
 
-Token Lexer::getKeywordToken(const std::string& identifier) {
-    auto it = keywords.find(identifier);
-    if (it != keywords.end()) {
-        return it->second;
-    } else { 
-        this->identifierName = identifier;
-        return tok_identifier;              
+// Keywords are few and short, so dispatching on length and comparing in place beats hashing
+// every identifier.
+Token Lexer::getKeywordToken(std::string_view identifier) {
+    switch (identifier.size()) {
+        case 2:
+            if (identifier == "i8") return tok_i8;
+            if (identifier == "u8") return tok_u8;
+            if (identifier == "if") return tok_if;
+            break;
+        case 3:
+            if (identifier == "i16") return tok_i16;
+            if (identifier == "i32") return tok_i32;
+            if (identifier == "i64") return tok_i64;
+            if (identifier == "u16") return tok_u16;
+            if (identifier == "u32") return tok_u32;
+            if (identifier == "u64") return tok_u64;
+            if (identifier == "f32") return tok_f32;
+            if (identifier == "f64") return tok_f64;
+            if (identifier == "str") return tok_str;
+            if (identifier == "new") return tok_new;
+            break;
+        case 4:
+            if (identifier == "fr32") return tok_fr32;
+            if (identifier == "fr64") return tok_fr64;
+            if (identifier == "bool") return tok_bool;
+            if (identifier == "char") return tok_char;
+            if (identifier == "void") return tok_void;
+            if (identifier == "true") return tok_true;
+            if (identifier == "else") return tok_else;
+            break;
+        case 5:
+            if (identifier == "false") return tok_false;
+            if (identifier == "class") return tok_class;
+            if (identifier == "while") return tok_while;
+            break;
+        case 6:
+            if (identifier == "public") return tok_public;
+            break;
+        default:
+            break;
     }
+
+    this->identifierName = identifier;
+    return tok_identifier;
 }
@@ -1,54 +1,70 @@
 #pragma once
 
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <cstddef>
 #include <cstdint>
 
 #include "tokens.hpp"
 
+// Location of a token in the source buffer
+struct SourceSpan {
+    size_t offset = 0;
+    size_t length = 0;
+};
+
 class Lexer {
 
     public:
-        Lexer(std::string sourceCode);
+        // The lexer does not copy the source; sourceCode must outlive the lexer.
+        Lexer(std::string_view sourceCode);
         ~Lexer() = default;
 
         // Token management
         int16_t getNextToken();
 		void ungetCurrentToken();
         int16_t getCurrentToken();
+        SourceSpan getTokenSpan() const;
+        std::string_view getTokenText() const;
+        // Number of tokens produced so far, not counting end of file
+        size_t getTokenCount() const;
+        std::string_view getSource() const { return source; }
 
         // Value retrieval based on token type
         int64_t getIntegerValue();
         double getFloatValue();
         bool getBoolValue();
         char getCharValue();
-        std::string getStringValue();
+        // Valid until the next call to getNextToken
+        std::string_view getStringValue();
 
-        // Identifier retrieval
-        std::string getIdentifierName();
+        // Identifier retrieval; points into the source
+        std::string_view getIdentifierName();
 
     private:
 		// Source code to be tokenized
-		std::string source;
+		std::string_view source;
 		size_t currentIndex = 0;
-		char getchar();
+		int getchar();
 
-        // Token state 
+        // Token state
         int16_t currentToken;
+        SourceSpan tokenSpan;
+        size_t tokenCount = 0;
 
         // Value storage for different token types
         int64_t integerValue;
         double floatValue;
         bool boolValue;
         char charValue;
-        std::string stringValue;
+        std::string_view stringValue;
+        // Backing storage for string literals that contain escape sequences
+        std::string unescapedString;
 
         // Identifier storage
-        std::string identifierName;
-        
-        // Keyword lookup table
-        static std::unordered_map<std::string, Token> keywords;
-        
+        std::string_view identifierName;
+
         // Helper methods
-        Token getKeywordToken(const std::string& identifier);
+        int16_t lexToken();
+        Token getKeywordToken(std::string_view identifier);
 };
@@ -53,6 +53,7 @@ enum Token : int16_t {
 	tok_not_equal = -301,
 	tok_less_equal = -302,
 	tok_greater_equal = -303,
+	tok_implies = -304,
 };
 
 namespace TokenUtils {
@@ -78,6 +79,29 @@ namespace TokenUtils {
 		return false;
 	}
 
+	// Source spelling of a primitive type token, or nullptr for any other token
+	inline static const char* getPrimitiveTypeSpelling(int16_t token) {
+		switch (token) {
+			case tok_i8: return "i8";
+			case tok_i16: return "i16";
+			case tok_i32: return "i32";
+			case tok_i64: return "i64";
+			case tok_u8: return "u8";
+			case tok_u16: return "u16";
+			case tok_u32: return "u32";
+			case tok_u64: return "u64";
+			case tok_f32: return "f32";
+			case tok_f64: return "f64";
+			case tok_fr32: return "fr32";
+			case tok_fr64: return "fr64";
+			case tok_bool: return "bool";
+			case tok_char: return "char";
+			case tok_void: return "void";
+			case tok_str: return "str";
+			default: return nullptr;
+		}
+	}
+
 	inline std::array<Token, 6> getLiteralTokens() {
 		return {tok_integer_literal, tok_float_literal, tok_char_literal, tok_str_literal, tok_true, tok_false};
 	}
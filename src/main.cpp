@@ -1,144 +1,217 @@
 #include <iostream>
 #include <string>
-#include <fstream>
 #include <filesystem>
+#include <iterator>
 #include <optional>
-#include <cstdlib>
+#include <algorithm>
+#include <vector>
 
-#include <llvm/IR/LegacyPassManager.h>
-#include <llvm/IR/Verifier.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/IR/Module.h>
-#include <llvm/IR/Function.h>
-#include <llvm/IR/Type.h>
-#include <llvm/IR/BasicBlock.h>
-#include <llvm/IR/IRBuilder.h>
+#include <llvm/Passes/OptimizationLevel.h>
 #include <llvm/Support/FileSystem.h>
-#include <llvm/TargetParser/Host.h>
-#include <llvm/Support/TargetSelect.h>
-#include <llvm/Support/raw_ostream.h>
-#include <llvm/Target/TargetMachine.h>
-#include <llvm/MC/TargetRegistry.h>
-
-#include "lexer/lexer.hpp"
-#include "parser/parser.hpp"
+
 #include "codegen/CodeGenerator.hpp"
+#include "driver/Backend.hpp"
+#include "driver/Driver.hpp"
+#include "driver/Frontend.hpp"
+#include "driver/Interfaces.hpp"
+#include "driver/JIT.hpp"
+#include "driver/LinkTimeOptimization.hpp"
+#include "driver/Linker.hpp"
+#include "driver/ProfilingSession.hpp"
+#include "driver/Target.hpp"
+#include "driver/UnitCache.hpp"
+#include "support/CompileServer.hpp"
+#include "support/InterfaceFile.hpp"
+#include "support/ObjectCache.hpp"
+#include "bp_runtime.h"
 
 namespace {
 
 void printUsage(const char* executableName) {
-	std::cout << "Usage: " << executableName << " [options] <source_file>" << std::endl;
+	std::cout << "Usage: " << executableName << " [options] <source_file>..." << std::endl;
+	std::cout << "Source files ending in .bc are read as prebuilt LLVM bitcode (see --emit-bc)." << std::endl;
 	std::cout << "Options:" << std::endl;
 	std::cout << "  --help, -h             Show this help message and exit" << std::endl;
 	std::cout << "  --verbose, -v          Enable verbose output during lexing/parsing" << std::endl;
-	std::cout << "  --emit-obj <path>      Emit AOT object file (default: <source>.o)" << std::endl;
-	std::cout << "  --emit-ir <path>       Emit LLVM IR (.ll) file" << std::endl;
-	std::cout << "  --emit-exe <path>      Link object file into native executable" << std::endl;
+	std::cout << "  --emit-obj <path>      Emit AOT object file (default: <source>.o, one per source unless --link-modules)" << std::endl;
+	std::cout << "  --emit-ir <path>       Emit LLVM IR (.ll) file; implies --link-modules for multiple sources" << std::endl;
+	std::cout << "  --emit-bc <path>       Emit LLVM bitcode (.bc) file; implies --link-modules for multiple sources" << std::endl;
+	std::cout << "  --emit-exe <path>      Link object files into native executable" << std::endl;
+	std::cout << "  --emit-interface <path> Write the binary interface (classes, method symbols and signatures) of all sources" << std::endl;
+	std::cout << "  --print-interface <path> Print the classes recorded in an interface file and exit" << std::endl;
+	std::cout << "  --interface <path>     Link against the classes in an interface file; explicit instantiations it provides are not generated again (repeatable)" << std::endl;
+	std::cout << "  --lto <mode>           Link-time optimization for --emit-exe: full, thin (default: off); --emit-bc then writes pre-link bitcode" << std::endl;
+	std::cout << "  --jobs <n>, -j <n>     Compile up to <n> source files in parallel (default: 0, one per hardware thread)" << std::endl;
+	std::cout << "  --cache-dir <dir>      Reuse object files (and --emit-interface records) from <dir> for sources compiled with identical inputs and options" << std::endl;
+	std::cout << "  --link-modules         Link all sources into one module before optimization instead of compiling each to its own object" << std::endl;
+	std::cout << "  --run                  JIT-compile the program in-process and run System.Application.main" << std::endl;
+	std::cout << "  --jit-threads <n>      Optimize and compile JIT modules on a pool of <n> threads (default: 0, in-line)" << std::endl;
+	std::cout << "  --bounds-checks <mode> Array bounds checking: on, hoisted (hoist checks out of counted loops), off (default: hoisted)" << std::endl;
+	std::cout << "  --contracts <mode>     Contract checking: full, preconditions (requires only), boundary (public methods only), off (default: full)" << std::endl;
+	std::cout << "  --contract-quantifiers <mode> forall ranges over 1024 values: full, sampled (check 1024 of them), skip (default: full)" << std::endl;
+	std::cout << "  --fraction-normalization <mode> Fraction GCD reduction: eager (after every operation), lazy (on store/print) (default: lazy)" << std::endl;
+	std::cout << "  --fraction-overflow <mode> Fraction overflow: wrap, trap, saturate (trap/saturate compute at 4x width) (default: wrap)" << std::endl;
+	std::cout << "  --output-buffering <mode> Program output buffering: auto (line-buffered on a terminal), line, full (default: auto)" << std::endl;
+	std::cout << "  --printf-output        Lower Defaultlogger.logln to printf instead of the BluePrint output runtime" << std::endl;
+	std::cout << "  --runtime-lib <path>   BluePrint runtime archive linked by --emit-exe (default: the one built with the compiler)" << std::endl;
+	std::cout << "  --profile-generate[=<path>] Instrument the program to write an LLVM IR profile to <path> at exit (default: default_%m.profraw)" << std::endl;
+	std::cout << "  --profile-use=<path>   Optimize with an indexed profile merged from --profile-generate runs by llvm-profdata" << std::endl;
+	std::cout << "  --profile-runtime-lib <path> Profile runtime linked by --emit-exe under --profile-generate (default: compiler-rt's clang_rt.profile)" << std::endl;
+	std::cout << "  --instrument=functions Count calls and timestamp ticks of every method and print them, hottest first, at exit" << std::endl;
+	std::cout << "  --time-passes          Print the time spent in each compiler phase and LLVM pass to stderr" << std::endl;
+	std::cout << "  --time-trace           Write a Chrome trace (chrome://tracing, Perfetto) of the compiler phases" << std::endl;
+	std::cout << "  --time-trace-file <path> Time trace output path (default: <source>.time-trace.json)" << std::endl;
+	std::cout << "  --time-trace-granularity <us> Minimum duration of a recorded trace event in microseconds (default: 500)" << std::endl;
+	std::cout << "  --stats                Print token, AST node, function, basic block and instruction counts to stderr" << std::endl;
+	std::cout << "  -O0, -O1, -O2, -O3     Optimization level applied before IR/object emission (default: -O0)" << std::endl;
+	std::cout << "  --target <triple>      Target triple to compile for (default: host)" << std::endl;
+	std::cout << "  --mcpu <cpu>           Target CPU, or 'native' for the host CPU and its features (default: generic)" << std::endl;
+	std::cout << "  --mattr <features>     Comma-separated target features, e.g. +avx2,-fma" << std::endl;
+	std::cout << "  --server <socket>      Serve compile requests on a Unix socket instead of compiling; takes only --interface options, whose files it opens once for all requests" << std::endl;
+	std::cout << "  --connect <socket>     Send this compilation to the server on <socket>; compiles in-process if none is listening" << std::endl;
 }
 
-std::string defaultObjectPathForSource(const std::string& sourcePath) {
-	std::filesystem::path path(sourcePath);
-	return (path.parent_path() / path.stem()).string() + ".o";
+enum class OptionMatch {
+	NoMatch,
+	Matched,
+	MissingValue,
+};
+
+bool parseBoundsCheckMode(const std::string& value, BoundsCheckMode& outMode) {
+	if (value == "on") {
+		outMode = BoundsCheckMode::On;
+	} else if (value == "hoisted") {
+		outMode = BoundsCheckMode::Hoisted;
+	} else if (value == "off") {
+		outMode = BoundsCheckMode::Off;
+	} else {
+		return false;
+	}
+	return true;
 }
 
-bool ensureApplicationEntrypoint(llvm::Module& module) {
-	llvm::Function* appMain = module.getFunction("System.Application.main");
-	if (!appMain) {
+bool parseContractMode(const std::string& value, ContractMode& outMode) {
+	if (value == "full") {
+		outMode = ContractMode::Full;
+	} else if (value == "preconditions") {
+		outMode = ContractMode::Preconditions;
+	} else if (value == "boundary") {
+		outMode = ContractMode::Boundary;
+	} else if (value == "off") {
+		outMode = ContractMode::Off;
+	} else {
 		return false;
 	}
+	return true;
+}
 
-	if (module.getFunction("main")) {
-		return true;
+bool parseQuantifierMode(const std::string& value, QuantifierMode& outMode) {
+	if (value == "full") {
+		outMode = QuantifierMode::Full;
+	} else if (value == "sampled") {
+		outMode = QuantifierMode::Sampled;
+	} else if (value == "skip") {
+		outMode = QuantifierMode::Skip;
+	} else {
+		return false;
 	}
+	return true;
+}
 
-	if (!appMain->getReturnType()->isVoidTy() || !appMain->arg_empty()) {
+bool parseFractionNormalization(const std::string& value, FractionNormalization& outMode) {
+	if (value == "eager") {
+		outMode = FractionNormalization::Eager;
+	} else if (value == "lazy") {
+		outMode = FractionNormalization::Lazy;
+	} else {
 		return false;
 	}
-
-	llvm::LLVMContext& context = module.getContext();
-	llvm::FunctionType* entryType = llvm::FunctionType::get(llvm::Type::getInt32Ty(context), false);
-	llvm::Function* entry = llvm::Function::Create(entryType, llvm::Function::ExternalLinkage, "main", module);
-
-	llvm::BasicBlock* block = llvm::BasicBlock::Create(context, "entry", entry);
-	llvm::IRBuilder<> builder(block);
-	builder.CreateCall(appMain);
-	builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), 0));
-
-	return !llvm::verifyFunction(*entry, &llvm::errs());
+	return true;
 }
 
-bool emitIRFile(const llvm::Module& module, const std::string& outputPath) {
-	std::error_code errorCode;
-	llvm::raw_fd_ostream outFile(outputPath, errorCode, llvm::sys::fs::OF_Text);
-	if (errorCode) {
-		std::cerr << "Error: Could not open IR output file '" << outputPath << "': " << errorCode.message() << std::endl;
+bool parseFractionOverflowMode(const std::string& value, FractionOverflowMode& outMode) {
+	if (value == "wrap") {
+		outMode = FractionOverflowMode::Wrap;
+	} else if (value == "trap") {
+		outMode = FractionOverflowMode::Trap;
+	} else if (value == "saturate") {
+		outMode = FractionOverflowMode::Saturate;
+	} else {
 		return false;
 	}
-
-	module.print(outFile, nullptr);
-	outFile.flush();
 	return true;
 }
 
-bool emitObjectFile(llvm::Module& module, const std::string& outputPath) {
-	llvm::InitializeNativeTarget();
-	llvm::InitializeNativeTargetAsmPrinter();
-	llvm::InitializeNativeTargetAsmParser();
-
-	const std::string targetTripleString = llvm::sys::getDefaultTargetTriple();
-	llvm::Triple targetTriple(targetTripleString);
-	module.setTargetTriple(targetTriple);
-
-	std::string targetError;
-	const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTripleString, targetError);
-	if (!target) {
-		std::cerr << "Error: Failed to lookup target '" << targetTripleString << "': " << targetError << std::endl;
+bool parseLinkTimeOptimization(const std::string& value, LinkTimeOptimization& outMode) {
+	if (value == "full") {
+		outMode = LinkTimeOptimization::Full;
+	} else if (value == "thin") {
+		outMode = LinkTimeOptimization::Thin;
+	} else {
 		return false;
 	}
+	return true;
+}
 
-	llvm::TargetOptions options;
-	auto relocationModel = std::optional<llvm::Reloc::Model>();
-	std::unique_ptr<llvm::TargetMachine> targetMachine(
-		target->createTargetMachine(targetTriple, "generic", "", options, relocationModel)
-	);
-
-	if (!targetMachine) {
-		std::cerr << "Error: Failed to create LLVM target machine." << std::endl;
+bool parseOutputBuffering(const std::string& value, int32_t& outMode) {
+	if (value == "auto") {
+		outMode = BP_OUTPUT_AUTO;
+	} else if (value == "line") {
+		outMode = BP_OUTPUT_LINE;
+	} else if (value == "full") {
+		outMode = BP_OUTPUT_FULL;
+	} else {
 		return false;
 	}
+	return true;
+}
 
-	module.setDataLayout(targetMachine->createDataLayout());
-
-	std::error_code errorCode;
-	llvm::raw_fd_ostream destination(outputPath, errorCode, llvm::sys::fs::OF_None);
-	if (errorCode) {
-		std::cerr << "Error: Could not open object output file '" << outputPath << "': " << errorCode.message() << std::endl;
-		return false;
+// Accepts both "--name value" and "--name=value" spellings.
+OptionMatch matchValueOption(const std::string& argument, const std::string& name, int& index, int argc, char* argv[], std::string& outValue) {
+	if (argument == name) {
+		if (index + 1 >= argc) {
+			return OptionMatch::MissingValue;
+		}
+		outValue = argv[++index];
+		return OptionMatch::Matched;
 	}
 
-	llvm::legacy::PassManager passManager;
-	if (targetMachine->addPassesToEmitFile(passManager, destination, nullptr, llvm::CodeGenFileType::ObjectFile)) {
-		std::cerr << "Error: LLVM target machine cannot emit object file for this target." << std::endl;
-		return false;
+	if (argument.size() > name.size() && argument.compare(0, name.size(), name) == 0 && argument[name.size()] == '=') {
+		outValue = argument.substr(name.size() + 1);
+		return outValue.empty() ? OptionMatch::MissingValue : OptionMatch::Matched;
 	}
 
-	passManager.run(module);
-	destination.flush();
-	return true;
+	return OptionMatch::NoMatch;
 }
 
-bool linkExecutable(const std::string& objectPath, const std::string& executablePath) {
-	std::string command = "cc -no-pie \"" + objectPath + "\" -o \"" + executablePath + "\"";
-	const int result = std::system(command.c_str());
-	if (result != 0) {
-		std::cerr << "Error: Linker failed while creating executable. Command: " << command << std::endl;
+bool parseOptimizationLevel(const std::string& argument, llvm::OptimizationLevel& outLevel) {
+	if (argument == "-O0") {
+		outLevel = llvm::OptimizationLevel::O0;
+	} else if (argument == "-O1") {
+		outLevel = llvm::OptimizationLevel::O1;
+	} else if (argument == "-O2" || argument == "-O") {
+		outLevel = llvm::OptimizationLevel::O2;
+	} else if (argument == "-O3") {
+		outLevel = llvm::OptimizationLevel::O3;
+	} else {
 		return false;
 	}
 	return true;
 }
 
+std::string defaultObjectPathForSource(const std::string& sourcePath) {
+	std::filesystem::path path(sourcePath);
+	return (path.parent_path() / path.stem()).string() + ".o";
 }
 
-int main (int argc, char *argv[])
+std::string defaultTimeTracePathForSource(const std::string& sourcePath) {
+	std::filesystem::path path(sourcePath);
+	return (path.parent_path() / path.stem()).string() + ".time-trace.json";
+}
+
+int compile(int argc, char *argv[])
 {
 	if (argc <= 1) {
 		printUsage(argv[0]);
@@ -146,10 +219,27 @@ int main (int argc, char *argv[])
 	}
 
 	bool verbose = false;
-	std::string sourceFile;
+	std::vector<std::string> sourceFiles;
 	std::string emitObjectPath;
 	std::string emitIRPath;
+	std::string emitBitcodePath;
 	std::string emitExecutablePath;
+	std::string emitInterfacePath;
+	std::string printInterfacePath;
+	std::vector<std::string> importedInterfacePaths;
+	LinkTimeOptimization linkTimeOptimization = LinkTimeOptimization::Off;
+	llvm::OptimizationLevel optimizationLevel = llvm::OptimizationLevel::O0;
+	TargetSelection targetSelection;
+	bool runInProcess = false;
+	unsigned jitCompileThreads = 0;
+	unsigned jobs = 0;
+	bool linkModules = false;
+	std::string cacheDirectory;
+	CodeGenOptions codeGenOptions;
+	OutputRuntimeSettings outputRuntime;
+	bool outputBufferingRequested = false;
+	ProfileSettings profile;
+	ProfilingOptions profilingOptions;
 
 	for (int i = 1; i < argc; ++i) {
 		std::string argument = argv[i];
@@ -164,6 +254,248 @@ int main (int argc, char *argv[])
 			continue;
 		}
 
+		if (parseOptimizationLevel(argument, optimizationLevel)) {
+			continue;
+		}
+
+		if (argument == "--run") {
+			runInProcess = true;
+			continue;
+		}
+
+		if (argument == "--link-modules") {
+			linkModules = true;
+			continue;
+		}
+
+		std::string jobsValue;
+		OptionMatch jobsMatch = matchValueOption(argument, "--jobs", i, argc, argv, jobsValue);
+		if (jobsMatch == OptionMatch::NoMatch) {
+			jobsMatch = matchValueOption(argument, "-j", i, argc, argv, jobsValue);
+		}
+		if (jobsMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after " << argument << "." << std::endl;
+			return 1;
+		}
+		if (jobsMatch == OptionMatch::Matched) {
+			if (!llvm::to_integer(jobsValue, jobs, 10)) {
+				std::cerr << "Error: Invalid job count '" << jobsValue << "' for --jobs." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string jitThreadsValue;
+		const OptionMatch jitThreadsMatch = matchValueOption(argument, "--jit-threads", i, argc, argv, jitThreadsValue);
+		if (jitThreadsMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --jit-threads." << std::endl;
+			return 1;
+		}
+		if (jitThreadsMatch == OptionMatch::Matched) {
+			if (!llvm::to_integer(jitThreadsValue, jitCompileThreads, 10)) {
+				std::cerr << "Error: Invalid thread count '" << jitThreadsValue << "' for --jit-threads." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		if (argument == "--time-passes") {
+			profilingOptions.timePasses = true;
+			continue;
+		}
+
+		if (argument == "--time-trace") {
+			profilingOptions.timeTrace = true;
+			continue;
+		}
+
+		if (argument == "--stats") {
+			profilingOptions.statistics = true;
+			continue;
+		}
+
+		std::string timeTraceGranularityValue;
+		const OptionMatch timeTraceGranularityMatch = matchValueOption(argument, "--time-trace-granularity", i, argc, argv, timeTraceGranularityValue);
+		if (timeTraceGranularityMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --time-trace-granularity." << std::endl;
+			return 1;
+		}
+		if (timeTraceGranularityMatch == OptionMatch::Matched) {
+			if (!llvm::to_integer(timeTraceGranularityValue, profilingOptions.timeTraceGranularity, 10)) {
+				std::cerr << "Error: Invalid granularity '" << timeTraceGranularityValue << "' for --time-trace-granularity." << std::endl;
+				return 1;
+			}
+			profilingOptions.timeTrace = true;
+			continue;
+		}
+
+		if (argument == "--printf-output") {
+			codeGenOptions.useOutputRuntime = false;
+			continue;
+		}
+
+		if (argument == "--profile-generate" || argument.rfind("--profile-generate=", 0) == 0) {
+			profile.mode = ProfileGuidedOptimization::Generate;
+			profile.profilePath = argument == "--profile-generate" ? "default_%m.profraw" : argument.substr(std::string("--profile-generate=").size());
+			if (profile.profilePath.empty()) {
+				std::cerr << "Error: Missing path after --profile-generate=." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string profileUseValue;
+		const OptionMatch profileUseMatch = matchValueOption(argument, "--profile-use", i, argc, argv, profileUseValue);
+		if (profileUseMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --profile-use." << std::endl;
+			return 1;
+		}
+		if (profileUseMatch == OptionMatch::Matched) {
+			profile.mode = ProfileGuidedOptimization::Use;
+			profile.profilePath = profileUseValue;
+			continue;
+		}
+
+		std::string instrumentValue;
+		const OptionMatch instrumentMatch = matchValueOption(argument, "--instrument", i, argc, argv, instrumentValue);
+		if (instrumentMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --instrument." << std::endl;
+			return 1;
+		}
+		if (instrumentMatch == OptionMatch::Matched) {
+			if (instrumentValue != "functions") {
+				std::cerr << "Error: Invalid mode '" << instrumentValue << "' for --instrument (expected functions)." << std::endl;
+				return 1;
+			}
+			codeGenOptions.instrumentFunctions = true;
+			continue;
+		}
+
+		std::string outputBufferingValue;
+		const OptionMatch outputBufferingMatch = matchValueOption(argument, "--output-buffering", i, argc, argv, outputBufferingValue);
+		if (outputBufferingMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --output-buffering." << std::endl;
+			return 1;
+		}
+		if (outputBufferingMatch == OptionMatch::Matched) {
+			if (!parseOutputBuffering(outputBufferingValue, outputRuntime.buffering)) {
+				std::cerr << "Error: Invalid mode '" << outputBufferingValue << "' for --output-buffering (expected auto, line or full)." << std::endl;
+				return 1;
+			}
+			outputBufferingRequested = true;
+			continue;
+		}
+
+		std::string fractionNormalizationValue;
+		const OptionMatch fractionNormalizationMatch = matchValueOption(argument, "--fraction-normalization", i, argc, argv, fractionNormalizationValue);
+		if (fractionNormalizationMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --fraction-normalization." << std::endl;
+			return 1;
+		}
+		if (fractionNormalizationMatch == OptionMatch::Matched) {
+			if (!parseFractionNormalization(fractionNormalizationValue, codeGenOptions.fractionNormalization)) {
+				std::cerr << "Error: Invalid mode '" << fractionNormalizationValue << "' for --fraction-normalization (expected eager or lazy)." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string fractionOverflowValue;
+		const OptionMatch fractionOverflowMatch = matchValueOption(argument, "--fraction-overflow", i, argc, argv, fractionOverflowValue);
+		if (fractionOverflowMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --fraction-overflow." << std::endl;
+			return 1;
+		}
+		if (fractionOverflowMatch == OptionMatch::Matched) {
+			if (!parseFractionOverflowMode(fractionOverflowValue, codeGenOptions.fractionOverflow)) {
+				std::cerr << "Error: Invalid mode '" << fractionOverflowValue << "' for --fraction-overflow (expected wrap, trap or saturate)." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string linkTimeOptimizationValue;
+		const OptionMatch linkTimeOptimizationMatch = matchValueOption(argument, "--lto", i, argc, argv, linkTimeOptimizationValue);
+		if (linkTimeOptimizationMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --lto." << std::endl;
+			return 1;
+		}
+		if (linkTimeOptimizationMatch == OptionMatch::Matched) {
+			if (!parseLinkTimeOptimization(linkTimeOptimizationValue, linkTimeOptimization)) {
+				std::cerr << "Error: Invalid mode '" << linkTimeOptimizationValue << "' for --lto (expected full or thin)." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string boundsChecksValue;
+		const OptionMatch boundsChecksMatch = matchValueOption(argument, "--bounds-checks", i, argc, argv, boundsChecksValue);
+		if (boundsChecksMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --bounds-checks." << std::endl;
+			return 1;
+		}
+		if (boundsChecksMatch == OptionMatch::Matched) {
+			if (!parseBoundsCheckMode(boundsChecksValue, codeGenOptions.boundsChecks)) {
+				std::cerr << "Error: Invalid mode '" << boundsChecksValue << "' for --bounds-checks (expected on, hoisted or off)." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string contractsValue;
+		const OptionMatch contractsMatch = matchValueOption(argument, "--contracts", i, argc, argv, contractsValue);
+		if (contractsMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --contracts." << std::endl;
+			return 1;
+		}
+		if (contractsMatch == OptionMatch::Matched) {
+			if (!parseContractMode(contractsValue, codeGenOptions.contracts)) {
+				std::cerr << "Error: Invalid mode '" << contractsValue << "' for --contracts (expected full, preconditions, boundary or off)." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		std::string quantifiersValue;
+		const OptionMatch quantifiersMatch = matchValueOption(argument, "--contract-quantifiers", i, argc, argv, quantifiersValue);
+		if (quantifiersMatch == OptionMatch::MissingValue) {
+			std::cerr << "Error: Missing value after --contract-quantifiers." << std::endl;
+			return 1;
+		}
+		if (quantifiersMatch == OptionMatch::Matched) {
+			if (!parseQuantifierMode(quantifiersValue, codeGenOptions.quantifiers)) {
+				std::cerr << "Error: Invalid mode '" << quantifiersValue << "' for --contract-quantifiers (expected full, sampled or skip)." << std::endl;
+				return 1;
+			}
+			continue;
+		}
+
+		// Options whose value is stored as given, without validation here
+		const std::pair<const char*, std::string*> stringOptions[] = {
+			{"--target", &targetSelection.triple},
+			{"--mcpu", &targetSelection.cpu},
+			{"--mattr", &targetSelection.features},
+			{"--runtime-lib", &outputRuntime.libraryPath},
+			{"--profile-runtime-lib", &profile.runtimeLibraryPath},
+			{"--time-trace-file", &profilingOptions.timeTraceFile},
+			{"--cache-dir", &cacheDirectory},
+		};
+		bool matchedStringOption = false;
+		for (const auto& [optionName, optionValue] : stringOptions) {
+			const OptionMatch match = matchValueOption(argument, optionName, i, argc, argv, *optionValue);
+			if (match == OptionMatch::MissingValue) {
+				std::cerr << "Error: Missing value after " << optionName << "." << std::endl;
+				return 1;
+			}
+			if (match == OptionMatch::Matched) {
+				matchedStringOption = true;
+				break;
+			}
+		}
+		if (matchedStringOption) {
+			continue;
+		}
+
 		if (argument == "--emit-obj") {
 			if (i + 1 >= argc) {
 				std::cerr << "Error: Missing path after --emit-obj." << std::endl;
@@ -182,6 +514,33 @@ int main (int argc, char *argv[])
 			continue;
 		}
 
+		if (argument == "--emit-bc") {
+			if (i + 1 >= argc) {
+				std::cerr << "Error: Missing path after --emit-bc." << std::endl;
+				return 1;
+			}
+			emitBitcodePath = argv[++i];
+			continue;
+		}
+
+		if (argument == "--emit-interface" || argument == "--print-interface") {
+			if (i + 1 >= argc) {
+				std::cerr << "Error: Missing path after " << argument << "." << std::endl;
+				return 1;
+			}
+			(argument == "--emit-interface" ? emitInterfacePath : printInterfacePath) = argv[++i];
+			continue;
+		}
+
+		if (argument == "--interface") {
+			if (i + 1 >= argc) {
+				std::cerr << "Error: Missing path after --interface." << std::endl;
+				return 1;
+			}
+			importedInterfacePaths.push_back(argv[++i]);
+			continue;
+		}
+
 		if (argument == "--emit-exe") {
 			if (i + 1 >= argc) {
 				std::cerr << "Error: Missing path after --emit-exe." << std::endl;
@@ -196,85 +555,263 @@ int main (int argc, char *argv[])
 			return 1;
 		}
 
-		if (!sourceFile.empty()) {
-			std::cerr << "Error: Multiple source files provided. Only one is currently supported." << std::endl;
-			return 1;
-		}
+		sourceFiles.push_back(argument);
+	}
 
-		sourceFile = argument;
+	if (!printInterfacePath.empty()) {
+		return printInterfaceFile(printInterfacePath);
 	}
 
-	if (sourceFile.empty()) {
+	if (sourceFiles.empty()) {
 		std::cerr << "Error: Missing source file argument." << std::endl;
 		printUsage(argv[0]);
 		return 1;
 	}
 
-	if (emitObjectPath.empty()) {
-		emitObjectPath = defaultObjectPathForSource(sourceFile);
+	if (runInProcess && (!emitObjectPath.empty() || !emitExecutablePath.empty())) {
+		std::cerr << "Error: --run cannot be combined with --emit-obj or --emit-exe." << std::endl;
+		return 1;
+	}
+
+	if (linkTimeOptimization != LinkTimeOptimization::Off) {
+		if (runInProcess || !emitObjectPath.empty()) {
+			std::cerr << "Error: --lto cannot be combined with --run or --emit-obj; the LTO link writes its objects into the executable." << std::endl;
+			return 1;
+		}
+		if (emitExecutablePath.empty() && emitBitcodePath.empty()) {
+			std::cerr << "Error: --lto requires --emit-exe or --emit-bc." << std::endl;
+			return 1;
+		}
+	}
+
+	if (!codeGenOptions.useOutputRuntime) {
+		if (outputBufferingRequested) {
+			std::cerr << "Error: --output-buffering requires the BluePrint output runtime and cannot be combined with --printf-output." << std::endl;
+			return 1;
+		}
+		outputRuntime.libraryPath.clear();
+	} else if (!emitExecutablePath.empty() && !std::filesystem::exists(outputRuntime.libraryPath)) {
+		std::cerr << "Error: BluePrint runtime library '" << outputRuntime.libraryPath << "' not found; pass --runtime-lib or use --printf-output." << std::endl;
+		return 1;
+	}
+
+	if (profile.mode == ProfileGuidedOptimization::Generate) {
+		if (runInProcess) {
+			std::cerr << "Error: --profile-generate cannot be combined with --run; the JIT does not link the profile runtime that writes the counters." << std::endl;
+			return 1;
+		}
+		if (!emitExecutablePath.empty() && !std::filesystem::exists(profile.runtimeLibraryPath)) {
+			std::cerr << "Error: Profile runtime library '" << profile.runtimeLibraryPath << "' not found; pass --profile-runtime-lib." << std::endl;
+			return 1;
+		}
+	} else if (profile.mode == ProfileGuidedOptimization::Use && !std::filesystem::exists(profile.profilePath)) {
+		std::cerr << "Error: Profile '" << profile.profilePath << "' given to --profile-use not found." << std::endl;
+		return 1;
 	}
 
-	std::ifstream file(sourceFile);
-	if (!file.is_open()) {
-		std::cerr << "Error: Could not open file " << sourceFile << std::endl;
+	// A single IR or bitcode file needs a single module.
+	if (sourceFiles.size() > 1 && (!emitIRPath.empty() || !emitBitcodePath.empty())) {
+		linkModules = true;
+	}
+
+	if (sourceFiles.size() > 1 && !linkModules && !emitObjectPath.empty()) {
+		std::cerr << "Error: --emit-obj names one object but " << sourceFiles.size() << " sources were given; omit it to write <source>.o for each source, or pass --link-modules." << std::endl;
 		return 1;
 	}
 
-	std::string text((std::istreambuf_iterator<char>(file)),
-		std::istreambuf_iterator<char>());
+	// Token dumps from concurrent frontends would interleave.
+	if (verbose) {
+		jobs = 1;
+	}
 
-	Lexer lexer = Lexer(text);
-	if (verbose)
-	{
-		std::cout << "Tokens:" << std::endl;
-		while (true) {
-			int16_t token = lexer.getNextToken();
-			if (token == tok_eof) {
-				break;
+	if (!profilingOptions.timeTraceFile.empty()) {
+		profilingOptions.timeTrace = true;
+	} else if (profilingOptions.timeTrace) {
+		profilingOptions.timeTraceFile = defaultTimeTracePathForSource(sourceFiles.front());
+	}
+
+	if (!resolveTargetSelection(targetSelection)) {
+		return 1;
+	}
+
+	// Opening an interface only reads its header; the frontends look classes up concurrently.
+	std::vector<std::unique_ptr<InterfaceFile>> interfaceFiles;
+	std::vector<const InterfaceFile*> importedInterfaces;
+	for (const std::string& path : importedInterfacePaths) {
+		if (const InterfaceFile* preloaded = findPreloadedInterface(path)) {
+			if (verbose) {
+				std::cout << "Using interface " << path << " preloaded by the compile server" << std::endl;
 			}
-			std::cout << "\t" << static_cast<Token>(token) << std::endl;
+			importedInterfaces.push_back(preloaded);
+			continue;
 		}
+		interfaceFiles.push_back(InterfaceFile::open(path));
+		if (!interfaceFiles.back()) {
+			return 1;
+		}
+		importedInterfaces.push_back(interfaceFiles.back().get());
+	}
 
-		lexer = Lexer(text);
+	if (runInProcess && !isHostTarget(targetSelection)) {
+		std::cerr << "Error: --run executes on the host and cannot be combined with a non-host --target." << std::endl;
+		return 1;
 	}
 
-	Parser parser = Parser(lexer, verbose);
-	CodeGenerator generator;
-	if (!parser.parse(generator)) {
-		std::cerr << "Error: Compilation failed before AOT emission." << std::endl;
+	if (!emitExecutablePath.empty() && !isHostTarget(targetSelection)) {
+		std::cerr << "Error: --emit-exe links with the host toolchain and cannot be combined with a non-host --target; use --emit-obj and a cross linker." << std::endl;
 		return 1;
 	}
 
-	llvm::Module* module = generator.getModule();
-	if (!module) {
-		std::cerr << "Error: Internal compiler error: code generator produced no module." << std::endl;
+	// Declared before everything it measures so its reports are written last.
+	ProfilingSession profiling(profilingOptions, argv[0]);
+
+	std::vector<TranslationUnit> units(sourceFiles.size());
+	std::vector<std::string> objectPaths;
+	for (size_t index = 0; index < sourceFiles.size(); ++index) {
+		units[index].sourcePath = sourceFiles[index];
+		units[index].objectPath = sourceFiles.size() == 1 && !emitObjectPath.empty() ? emitObjectPath : defaultObjectPathForSource(sourceFiles[index]);
+		objectPaths.push_back(units[index].objectPath);
+	}
+
+	// Objects are only cached when each source is compiled to an object of its own.
+	std::optional<ObjectCache> objectCache;
+	std::string objectConfiguration;
+	if (!cacheDirectory.empty() && !runInProcess && !linkModules && emitIRPath.empty() && emitBitcodePath.empty()
+		&& linkTimeOptimization == LinkTimeOptimization::Off) {
+		objectCache.emplace(cacheDirectory);
+		if (!objectCache->initialize()) {
+			return 1;
+		}
+		const std::optional<int32_t> entrypointBuffering = emitExecutablePath.empty() ? std::nullopt : std::optional<int32_t>(outputRuntime.buffering);
+		objectConfiguration = describeObjectConfiguration(getCompilerIdentity(argv[0]), targetSelection, optimizationLevel, codeGenOptions, entrypointBuffering, importedInterfaces, profile);
+	}
+
+	const bool frontendsSucceeded = runOnUnits(units, jobs, [&](TranslationUnit& unit) {
+		ProfilingSession::WorkerTrace workerTrace(profiling);
+		const bool describeInterfaces = !emitInterfacePath.empty();
+		if (objectCache && restoreCachedObject(unit, *objectCache, objectConfiguration, describeInterfaces, verbose)) {
+			return true;
+		}
+		if (!runFrontend(unit, codeGenOptions, importedInterfaces, describeInterfaces, verbose, profiling)) {
+			return false;
+		}
+		// The object is stored once the backend has built it; a hit needs both entries.
+		if (objectCache && describeInterfaces) {
+			storeCachedInterfaces(unit, *objectCache);
+		}
+		return true;
+	});
+	if (!frontendsSucceeded) {
+		std::cerr << "Error: Compilation failed before AOT emission." << std::endl;
 		return 1;
 	}
 
-	if (!emitIRPath.empty() && !emitIRFile(*module, emitIRPath)) {
+	if (!emitInterfacePath.empty()) {
+		std::vector<ClassInterface> interfaces;
+		for (TranslationUnit& unit : units) {
+			std::move(unit.interfaces.begin(), unit.interfaces.end(), std::back_inserter(interfaces));
+			unit.interfaces.clear();
+		}
+		if (!InterfaceFile::write(interfaces, emitInterfacePath)) {
+			return 1;
+		}
+		if (verbose) {
+			std::cout << "Interface emitted: " << emitInterfacePath << std::endl;
+		}
+	}
+
+	if (linkModules && units.size() > 1 && !linkTranslationUnits(units)) {
 		return 1;
 	}
 
+	if (runInProcess) {
+		return runInJIT(std::move(units), targetSelection, optimizationLevel, profile, jitCompileThreads, emitIRPath, emitBitcodePath, outputRuntime, profiling);
+	}
+
+	// A cached object already carries the entrypoint its unit was compiled with.
+	const bool hasCachedUnits = std::any_of(units.begin(), units.end(), [](const TranslationUnit& unit) {
+		return unit.restoredFromCache;
+	});
 	if (!emitExecutablePath.empty()) {
-		if (!ensureApplicationEntrypoint(*module)) {
+		auto entryUnit = std::find_if(units.begin(), units.end(), [](const TranslationUnit& unit) {
+			return unit.module && unit.module->getFunction("System.Application.main") != nullptr;
+		});
+		if (entryUnit != units.end() ? !ensureApplicationEntrypoint(*entryUnit->module, outputRuntime.buffering) : !hasCachedUnits) {
 			std::cerr << "Error: Unable to synthesize native entrypoint from System.Application.main." << std::endl;
 			return 1;
 		}
 	}
 
-	if (!emitObjectFile(*module, emitObjectPath)) {
+	initializeTargets(targetSelection);
+	if (linkTimeOptimization != LinkTimeOptimization::Off) {
+		const bool linkExecutableRequested = !emitExecutablePath.empty();
+		const bool preLinkSucceeded = runOnUnits(units, jobs, [&](TranslationUnit& unit) {
+			return runPreLinkBackend(unit, targetSelection, optimizationLevel, linkTimeOptimization, profile, linkExecutableRequested, emitIRPath, emitBitcodePath, profiling);
+		});
+		if (!preLinkSucceeded) {
+			return 1;
+		}
+
+		if (linkExecutableRequested) {
+			std::vector<std::string> linkObjectPaths;
+			const bool linked = runLinkTimeOptimization(units, targetSelection, optimizationLevel, jobs, linkObjectPaths)
+				&& linkExecutable(linkObjectPaths, emitExecutablePath, outputRuntime.libraryPath, profile);
+			for (const std::string& objectPath : linkObjectPaths) {
+				llvm::sys::fs::remove(objectPath);
+			}
+			if (!linked) {
+				return 1;
+			}
+		}
+
+		if (verbose) {
+			if (!emitIRPath.empty()) {
+				std::cout << "LLVM IR emitted: " << emitIRPath << std::endl;
+			}
+			if (!emitBitcodePath.empty()) {
+				std::cout << "LLVM bitcode emitted: " << emitBitcodePath << std::endl;
+			}
+			if (linkExecutableRequested) {
+				std::cout << "Executable emitted: " << emitExecutablePath << std::endl;
+			}
+		}
+		return 0;
+	}
+
+	const bool backendsSucceeded = runOnUnits(units, jobs, [&](TranslationUnit& unit) {
+		if (unit.restoredFromCache) {
+			return true;
+		}
+		if (!runBackend(unit, targetSelection, optimizationLevel, profile, emitIRPath, emitBitcodePath, profiling)) {
+			return false;
+		}
+		if (objectCache) {
+			objectCache->store(unit.cacheKey, unit.objectPath);
+		}
+		return true;
+	});
+	if (!backendsSucceeded) {
 		return 1;
 	}
 
-	if (!emitExecutablePath.empty() && !linkExecutable(emitObjectPath, emitExecutablePath)) {
+	if (objectCache) {
+		objectCache->prune();
+	}
+
+	if (!emitExecutablePath.empty() && !linkExecutable(objectPaths, emitExecutablePath, outputRuntime.libraryPath, profile)) {
 		return 1;
 	}
 
 	if (verbose) {
-		std::cout << "AOT object emitted: " << emitObjectPath << std::endl;
+		for (const std::string& objectPath : objectPaths) {
+			std::cout << "AOT object emitted: " << objectPath << std::endl;
+		}
 		if (!emitIRPath.empty()) {
 			std::cout << "LLVM IR emitted: " << emitIRPath << std::endl;
 		}
+		if (!emitBitcodePath.empty()) {
+			std::cout << "LLVM bitcode emitted: " << emitBitcodePath << std::endl;
+		}
 		if (!emitExecutablePath.empty()) {
 			std::cout << "Executable emitted: " << emitExecutablePath << std::endl;
 		}
@@ -282,3 +819,62 @@ int main (int argc, char *argv[])
 
 	return 0;
 }
+
+// Runs the compilation for arguments, with executableName as the program name.
+int compileArguments(const char* executableName, const std::vector<std::string>& arguments) {
+	std::vector<std::string> argumentStorage = arguments;
+	std::vector<char*> argv;
+	argv.push_back(const_cast<char*>(executableName));
+	for (std::string& argument : argumentStorage) {
+		argv.push_back(argument.data());
+	}
+	argv.push_back(nullptr);
+	return compile(static_cast<int>(argv.size() - 1), argv.data());
+}
+
+}
+
+int main (int argc, char *argv[])
+{
+	// --server and --connect are taken out before the compiler's own option parsing, which
+	// then sees the remaining arguments in the server's request process or in this one.
+	for (int i = 1; i < argc; ++i) {
+		const std::string argument = argv[i];
+		if (argument != "--server" && argument != "--connect") {
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cerr << "Error: Missing socket path after " << argument << "." << std::endl;
+			return 1;
+		}
+
+		const std::string socketPath = argv[i + 1];
+		std::vector<std::string> arguments(argv + 1, argv + i);
+		arguments.insert(arguments.end(), argv + i + 2, argv + argc);
+
+		if (argument == "--server") {
+			// Everything initialized here is inherited by every request.
+			for (size_t index = 0; index < arguments.size(); index += 2) {
+				if (arguments[index] != "--interface" || index + 1 >= arguments.size()) {
+					std::cerr << "Error: --server only takes --interface <path> options; clients pass the others with each request." << std::endl;
+					return 1;
+				}
+				if (!preloadInterface(arguments[index + 1])) {
+					return 1;
+				}
+			}
+			initializeAllTargets();
+			const char* executableName = argv[0];
+			return runCompileServer(socketPath, [executableName](const std::vector<std::string>& requestArguments) {
+				return compileArguments(executableName, requestArguments);
+			});
+		}
+
+		if (std::optional<int> status = forwardToCompileServer(socketPath, arguments)) {
+			return *status;
+		}
+		return compileArguments(argv[0], arguments);
+	}
+
+	return compile(argc, argv);
+}
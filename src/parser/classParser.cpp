@@ -6,38 +6,239 @@
 #include "parser.hpp"
 #include "../lexer/tokens.hpp"
 
-std::unique_ptr<ClassAST> Parser::parseClassDefinition() {
+// Instantiations are named with their type arguments, e.g. "Map<i32,i64>", which is also how
+// their methods' symbols are mangled.
+static std::string formatInstantiationName(const std::string& genericName, const std::vector<int16_t>& typeArguments) {
+	std::string name = genericName + "<";
+	for (size_t index = 0; index < typeArguments.size(); index++) {
+		name += (index == 0 ? "" : ",");
+		name += TokenUtils::getPrimitiveTypeSpelling(typeArguments[index]);
+	}
+	return name + ">";
+}
+
+bool Parser::parseClassDeclaration(ClassAST*& definedClass) {
 	Parser::logln("Parsing Class Definition...");
+	definedClass = nullptr;
 
 	// Expect 'class' keyword
 	if (lexer.getCurrentToken() != tok_class) {
 		std::cerr << "Error: Expected 'class' keyword." << std::endl;
-		return nullptr;
+		return false;
 	}
+	const size_t declarationOffset = lexer.getTokenSpan().offset;
 
 	// Get class name
 	int16_t currentToken = lexer.getNextToken();
 	if (currentToken != tok_identifier) {
 		std::cerr << "Error: Expected class name identifier." << std::endl;
-		return nullptr;
+		return false;
+	}
+	const Identifier className = context.intern(lexer.getIdentifierName());
+
+	std::vector<std::string_view> typeParameters;
+	std::vector<int16_t> typeArguments;
+	if (lexer.getNextToken() == '<' && !parseTypeList(typeParameters, typeArguments)) {
+		return false;
+	}
+
+	if (!typeParameters.empty()) {
+		if (definedClassNames.count(className.str()) || genericClasses.count(className.str())) {
+			std::cerr << "Error: Class '" << className.str() << "' is defined more than once." << std::endl;
+			return false;
+		}
+		if (!skipGenericClassBody()) {
+			return false;
+		}
+		const size_t declarationEnd = lexer.getTokenSpan().offset + lexer.getTokenSpan().length;
+		genericClasses[className.str()] = {std::move(typeParameters), lexer.getSource().substr(declarationOffset, declarationEnd - declarationOffset)};
+		lexer.getNextToken();
+		return true;
+	}
+
+	// `class Name<i64>;` explicitly instantiates a generic class
+	if (!typeArguments.empty() && lexer.getCurrentToken() == ';') {
+		lexer.getNextToken();
+		return instantiateGenericClass(className, typeArguments, definedClass);
+	}
+
+	// A definition with type arguments is the body of an instantiation or, when written out in
+	// the source, an explicit specialization that later instantiations reuse.
+	std::optional<Identifier> genericName;
+	Identifier definedName = className;
+	if (!typeArguments.empty()) {
+		genericName = className;
+		definedName = context.intern(formatInstantiationName(className.str(), typeArguments));
+	}
+	if (!definedClassNames.insert(definedName.str()).second || genericClasses.count(definedName.str())) {
+		std::cerr << "Error: Class '" << definedName.str() << "' is defined more than once." << std::endl;
+		return false;
+	}
+
+	definedClass = parseClassDefinition(definedName, genericName);
+	return definedClass != nullptr;
+}
+
+bool Parser::parseTypeList(std::vector<std::string_view>& typeParameters, std::vector<int16_t>& typeArguments) {
+	int16_t currentToken = lexer.getNextToken();
+	while (true) {
+		// An instantiation re-parses its generic's header, whose parameters are then arguments
+		currentToken = resolveTypeToken(currentToken);
+		if (currentToken == tok_identifier && typeArguments.empty()) {
+			const std::string_view parameter = lexer.getIdentifierName();
+			if (std::find(typeParameters.begin(), typeParameters.end(), parameter) != typeParameters.end()) {
+				std::cerr << "Error: Duplicate type parameter '" << parameter << "'." << std::endl;
+				return false;
+			}
+			typeParameters.push_back(parameter);
+		} else if (TokenUtils::isPrimitiveTypeToken(currentToken) && currentToken != tok_void && typeParameters.empty()) {
+			typeArguments.push_back(currentToken);
+		} else {
+			std::cerr << "Error: Expected only type parameter names or only primitive type arguments between '<' and '>'." << std::endl;
+			return false;
+		}
+
+		currentToken = lexer.getNextToken();
+		if (currentToken == '>') {
+			break;
+		}
+		if (currentToken != ',') {
+			std::cerr << "Error: Expected ',' or '>' in type parameter list." << std::endl;
+			return false;
+		}
+		currentToken = lexer.getNextToken();
+	}
+
+	lexer.getNextToken(); // Consume '>'
+	return true;
+}
+
+// A generic class is only checked as far as its header until it is instantiated; its body is
+// skipped by matching braces and leaves the lexer on the closing '}'.
+bool Parser::skipGenericClassBody() {
+	if (lexer.getCurrentToken() != ':' || lexer.getNextToken() != tok_identifier) {
+		std::cerr << "Error: Expected ':' and a blueprint name after generic class parameters." << std::endl;
+		return false;
+	}
+	if (lexer.getIdentifierName() == "Application") {
+		std::cerr << "Error: A generic class cannot implement Application." << std::endl;
+		return false;
+	}
+	if (lexer.getNextToken() != '{') {
+		std::cerr << "Error: Expected '{' after class name." << std::endl;
+		return false;
+	}
+
+	size_t depth = 1;
+	while (depth > 0) {
+		const int16_t currentToken = lexer.getNextToken();
+		if (currentToken == tok_eof) {
+			std::cerr << "Error: Expected '}' to end generic class body." << std::endl;
+			return false;
+		}
+		depth += currentToken == '{' ? 1 : 0;
+		depth -= currentToken == '}' ? 1 : 0;
+	}
+	return true;
+}
+
+bool Parser::isProvidedByImport(const std::string& className) const {
+	return std::any_of(importedInterfaces.begin(), importedInterfaces.end(), [&](const InterfaceFile* interface) {
+		return interface->lookup(className).has_value();
+	});
+}
+
+bool Parser::instantiateGenericClass(Identifier genericName, const std::vector<int16_t>& typeArguments, ClassAST*& definedClass) {
+	const auto generic = genericClasses.find(genericName.str());
+	if (generic == genericClasses.end()) {
+		std::cerr << "Error: Unknown generic class '" << genericName.str() << "'." << std::endl;
+		return false;
+	}
+	if (generic->second.typeParameters.size() != typeArguments.size()) {
+		const size_t parameterCount = generic->second.typeParameters.size();
+		std::cerr << "Error: Generic class '" << genericName.str() << "' takes " << parameterCount
+			<< (parameterCount == 1 ? " type argument" : " type arguments") << ", not " << typeArguments.size() << "." << std::endl;
+		return false;
+	}
+
+	// Each set of type arguments is compiled once per unit, and not at all if an imported
+	// interface shows another unit already compiled it.
+	const std::string instantiationName = formatInstantiationName(genericName.str(), typeArguments);
+	if (definedClassNames.count(instantiationName)) {
+		Parser::logln("Reusing instantiation " + instantiationName);
+		return true;
+	}
+	if (isProvidedByImport(instantiationName)) {
+		Parser::logln("Instantiation " + instantiationName + " is provided by an imported interface");
+		definedClassNames.insert(instantiationName);
+		return true;
+	}
+
+	std::vector<std::pair<std::string_view, int16_t>> substitutions;
+	for (size_t index = 0; index < typeArguments.size(); index++) {
+		substitutions.emplace_back(generic->second.typeParameters[index], typeArguments[index]);
 	}
-	std::string className = lexer.getIdentifierName();
 
+	Lexer instantiationLexer(generic->second.text);
+	instantiationLexer.getNextToken();
+	std::swap(lexer, instantiationLexer);
+	std::swap(typeArgumentsInScope, substitutions);
+	const bool parsed = parseClassDeclaration(definedClass);
+	std::swap(typeArgumentsInScope, substitutions);
+	std::swap(lexer, instantiationLexer);
+	instantiationTokenCount += instantiationLexer.getTokenCount();
+
+	if (!parsed) {
+		std::cerr << "Error: Failed to instantiate '" << instantiationName << "'." << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int16_t Parser::resolveTypeToken(int16_t token) {
+	if (token != tok_identifier) {
+		return token;
+	}
+	const std::string_view name = lexer.getIdentifierName();
+	for (const auto& [parameter, argument] : typeArgumentsInScope) {
+		if (name == parameter) {
+			return argument;
+		}
+	}
+	return token;
+}
+
+bool Parser::startsTypedDeclaration() {
+	if (resolveTypeToken(lexer.getCurrentToken()) == tok_identifier) {
+		return false;
+	}
+	// Looks ahead on a copy so that the statement is parsed from its first token either way
+	Lexer lookahead = lexer;
+	const int16_t next = lookahead.getNextToken();
+	return next == tok_identifier || (next == '[' && lookahead.getNextToken() == ']');
+}
+
+ClassAST* Parser::parseClassDefinition(Identifier className, std::optional<Identifier> genericName) {
 	// Expect ':'
-	currentToken = lexer.getNextToken();
+	int16_t currentToken = lexer.getCurrentToken();
 	if (currentToken != ':') {
 		std::cerr << "Error: Expected ':' after class name." << std::endl;
 		return nullptr;
 	}
 
-	// Expect 'Application' as base class for now
+	// Only classes implementing Application provide the program entrypoint; any other
+	// blueprint name makes a library class, so a program can be split across files.
 	currentToken = lexer.getNextToken();
-	if (currentToken != tok_identifier && lexer.getIdentifierName() != "Application") {
-		std::cerr << "Error: Expected 'Application' class name after ':'." << std::endl;
+	if (currentToken != tok_identifier) {
+		std::cerr << "Error: Expected blueprint name after ':'." << std::endl;
 		return nullptr;
 	}
 
-	const std::vector<std::string> blueprintNames = {"Application"};
+	const Identifier blueprintName = context.intern(lexer.getIdentifierName());
+	if (genericName && blueprintName == "Application") {
+		std::cerr << "Error: A generic class cannot implement Application." << std::endl;
+		return nullptr;
+	}
 
 	// Expect '{'
 	currentToken = lexer.getNextToken();
@@ -49,7 +250,7 @@ std::unique_ptr<ClassAST> Parser::parseClassDefinition() {
 	// Move to the next token after '{'
 	lexer.getNextToken(); 
 
-	std::vector<std::unique_ptr<MethodImplAST>> methodImpls;
+	std::vector<MethodImplAST*> methodImpls;
 	while (true) {
 		currentToken = lexer.getCurrentToken();
 		if (currentToken == '}') {
@@ -63,16 +264,16 @@ std::unique_ptr<ClassAST> Parser::parseClassDefinition() {
 		}
 
 		Parser::logln("Parsed Method Implementation");
-		methodImpls.push_back(std::move(implementation));
+		methodImpls.push_back(implementation);
 	}
 
 	// Consume the closing '}'
 	lexer.getNextToken();
 
-	return std::make_unique<ClassAST>(className, std::move(methodImpls), std::move(blueprintNames));
+	return makeNode<ClassAST>(className, context.copyArray(methodImpls), context.copyArray(std::vector<Identifier>{blueprintName}), genericName);
 }
 
-std::unique_ptr<MethodImplAST> Parser::parseMethodImplementation() {
+MethodImplAST* Parser::parseMethodImplementation() {
 	Parser::logln("Parsing Method Implementation...");
 
 	int16_t currentToken = lexer.getCurrentToken();
@@ -82,14 +283,14 @@ std::unique_ptr<MethodImplAST> Parser::parseMethodImplementation() {
 		return nullptr;
 	}
 
-	auto accessModifier = ParserUtils::getAccessModifierFromToken(currentToken);
+	auto accessModifier = countNode(ParserUtils::getAccessModifierFromToken(context, currentToken));
 
-	std::unique_ptr<TypeAST> returnType;
+	TypeAST* returnType;
 	currentToken = lexer.getNextToken();
 
 	switch (currentToken) {
 		case tok_void:
-			returnType = std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::VOID);
+			returnType = makeNode<PrimitiveTypeAST>(PrimitiveTypeAST::VOID);
 			break;
 		default:
 			std::cerr << "Error: Non-void return type." << std::endl;
@@ -102,7 +303,7 @@ std::unique_ptr<MethodImplAST> Parser::parseMethodImplementation() {
 		std::cerr << "Error: Expected method name identifier." << std::endl;
 		return nullptr;
 	}
-	std::string methodName = lexer.getIdentifierName();
+	const Identifier methodName = context.intern(lexer.getIdentifierName());
 	if (methodName != "main") {
 		std::cerr << "Error: Expected method name 'main'." << std::endl;
 		return nullptr;
@@ -116,22 +317,23 @@ std::unique_ptr<MethodImplAST> Parser::parseMethodImplementation() {
 	}
 
 	currentToken = lexer.getNextToken(); // Move to first parameter or ')'
-	std::vector<std::unique_ptr<TypedIdentifierAST>> params;
+	std::vector<TypedIdentifierAST*> params;
 	while (currentToken != ')') {
+		currentToken = resolveTypeToken(currentToken);
 		if (!TokenUtils::isPrimitiveTypeToken(currentToken)) {
 			std::cerr << "Error: Expected parameter type." << std::endl;
 			return nullptr;
 		}
-		std::unique_ptr<TypeAST> paramType = ParserUtils::getPrimitiveTypeFromToken(currentToken);
+		TypeAST* paramType = countNode(ParserUtils::getPrimitiveTypeFromToken(context, currentToken));
 
 		currentToken = lexer.getNextToken();
 		if (currentToken != tok_identifier) {
 			std::cerr << "Error: Expected parameter." << std::endl;
 			return nullptr;
 		}
-		const std::string paramName = lexer.getIdentifierName();
+		const Identifier paramName = context.intern(lexer.getIdentifierName());
 
-		params.push_back(ParserUtils::makeTypedIdentifier(std::move(paramType), paramName));
+		params.push_back(countNode(ParserUtils::makeTypedIdentifier(context, paramType, paramName)));
 
 		currentToken = lexer.getNextToken();
 		if (currentToken == ')') {
@@ -153,15 +355,36 @@ std::unique_ptr<MethodImplAST> Parser::parseMethodImplementation() {
 		return nullptr;
 	}
 
-	std::vector<std::unique_ptr<StmtAST>> body;
+	std::vector<ExprAST*> preconditions;
+	std::vector<ExprAST*> postconditions;
+	std::vector<StmtAST*> body;
 	currentToken = lexer.getNextToken();
 	while (currentToken != '}') {
+		StmtAST* stmt;
+
+		// Contract clauses lead the body, written as in a blueprint method declaration.
+		// requires and ensures are only keywords when followed by ':'.
+		if (body.empty() && currentToken == tok_identifier
+			&& (lexer.getIdentifierName() == "requires" || lexer.getIdentifierName() == "ensures")) {
+			const Identifier clauseName = context.intern(lexer.getIdentifierName());
+			if (lexer.getNextToken() == ':') {
+				ExprAST* condition = parseContractClause();
+				if (!condition) {
+					return nullptr;
+				}
+				(clauseName == "requires" ? preconditions : postconditions).push_back(condition);
+				currentToken = lexer.getCurrentToken();
+				continue;
+			}
+			stmt = parseIdentifierStatement(clauseName);
+		} else {
+			stmt = parseStatement();
+		}
 
-		std::unique_ptr<StmtAST> stmt = parseStatement();
 		if (!stmt) {
 			return nullptr;
 		}
-		body.push_back(std::move(stmt));
+		body.push_back(stmt);
 		currentToken = lexer.getCurrentToken();
 	}
 
@@ -172,11 +395,13 @@ std::unique_ptr<MethodImplAST> Parser::parseMethodImplementation() {
 	}
 	lexer.getNextToken(); // Move to next token after method implementation
 
-	return std::make_unique<MethodImplAST>(
-		std::vector<std::unique_ptr<AccessModifierAST>>{}, 
-		std::move(returnType),
+	return makeNode<MethodImplAST>(
+		context.copyArray(std::vector<AccessModifierAST*>{accessModifier}),
+		returnType,
 		methodName,
-		std::move(params),
-		std::move(body)
+		context.copyArray(params),
+		context.copyArray(body),
+		context.copyArray(preconditions),
+		context.copyArray(postconditions)
 	);
 }
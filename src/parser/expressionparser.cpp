@@ -64,20 +64,20 @@ static int getBinaryOperatorToken(int16_t token) {
     }
 }
 
-std::unique_ptr<ExprAST> Parser::parseExpression() {
+ExprAST* Parser::parseExpression() {
     Parser::logln("Parsing Expression...");
     auto lhs = parseUnaryExpression();
     if (!lhs) {
         return nullptr;
     }
-    return parseBinaryOpRHS(0, std::move(lhs));
+    return parseBinaryOpRHS(0, lhs);
 }
 
-std::unique_ptr<ExprAST> Parser::parseBinaryExpression() {
+ExprAST* Parser::parseBinaryExpression() {
     return parseExpression();
 }
 
-std::unique_ptr<ExprAST> Parser::parseUnaryExpression() {
+ExprAST* Parser::parseUnaryExpression() {
     const int16_t currentToken = lexer.getCurrentToken();
     if (currentToken == '-' || currentToken == '!') {
         const int unaryOperator = (currentToken == '-') ? UnaryExprAST::NEGATE : UnaryExprAST::LOGICAL_NOT;
@@ -86,13 +86,13 @@ std::unique_ptr<ExprAST> Parser::parseUnaryExpression() {
         if (!operand) {
             return nullptr;
         }
-        return std::make_unique<UnaryExprAST>(unaryOperator, std::move(operand));
+        return makeNode<UnaryExprAST>(unaryOperator, operand);
     }
 
     return parsePrimaryExpression();
 }
 
-std::unique_ptr<ExprAST> Parser::parseParenExpression() {
+ExprAST* Parser::parseParenExpression() {
     Parser::logln("Parsing Parenthesized Expression...");
 
     if (lexer.getCurrentToken() != '(') {
@@ -101,7 +101,7 @@ std::unique_ptr<ExprAST> Parser::parseParenExpression() {
     }
 
     lexer.getNextToken();
-    std::unique_ptr<ExprAST> expr = parseExpression();
+    ExprAST* expr = parseExpression();
     if (!expr) {
         return nullptr;
     }
@@ -115,7 +115,58 @@ std::unique_ptr<ExprAST> Parser::parseParenExpression() {
     return expr;
 }
 
-std::unique_ptr<ExprAST> Parser::parseBinaryOpRHS(int exprPrecedence, std::unique_ptr<ExprAST> lhs) {
+// The bounds bind tighter than the comparisons around v, so `0 <= i < n + 1` splits as written.
+ForallExprAST* Parser::parseForallExpression() {
+    Parser::logln("Parsing Forall Expression...");
+
+    const Identifier variable = context.intern(lexer.getIdentifierName());
+    if (lexer.getNextToken() != ':') {
+        std::cerr << "Error: Expected ':' after forall variable." << std::endl;
+        return nullptr;
+    }
+
+    const int boundPrecedence = getTokenPrecedence('<') + 1;
+    lexer.getNextToken();
+    ExprAST* lower = parseUnaryExpression();
+    if (!lower || !(lower = parseBinaryOpRHS(boundPrecedence, lower))) {
+        return nullptr;
+    }
+
+    const int16_t lowerComparison = lexer.getCurrentToken();
+    if (lowerComparison != '<' && lowerComparison != tok_less_equal) {
+        std::cerr << "Error: Expected '<' or '<=' after forall lower bound." << std::endl;
+        return nullptr;
+    }
+    if (lexer.getNextToken() != tok_identifier || lexer.getIdentifierName() != variable.str()) {
+        std::cerr << "Error: Expected forall variable '" << variable.str() << "' in range." << std::endl;
+        return nullptr;
+    }
+
+    const int16_t upperComparison = lexer.getNextToken();
+    if (upperComparison != '<' && upperComparison != tok_less_equal) {
+        std::cerr << "Error: Expected '<' or '<=' after forall variable in range." << std::endl;
+        return nullptr;
+    }
+    lexer.getNextToken();
+    ExprAST* upper = parseUnaryExpression();
+    if (!upper || !(upper = parseBinaryOpRHS(boundPrecedence, upper))) {
+        return nullptr;
+    }
+
+    if (lexer.getCurrentToken() != tok_implies) {
+        std::cerr << "Error: Expected '==>' after forall range." << std::endl;
+        return nullptr;
+    }
+    lexer.getNextToken();
+    ExprAST* body = parseExpression();
+    if (!body) {
+        return nullptr;
+    }
+
+    return makeNode<ForallExprAST>(variable, lower, lowerComparison == tok_less_equal, upper, upperComparison == tok_less_equal, body);
+}
+
+ExprAST* Parser::parseBinaryOpRHS(int exprPrecedence, ExprAST* lhs) {
     while (true) {
         const int16_t currentToken = lexer.getCurrentToken();
         const int tokenPrecedence = getTokenPrecedence(currentToken);
@@ -137,12 +188,12 @@ std::unique_ptr<ExprAST> Parser::parseBinaryOpRHS(int exprPrecedence, std::uniqu
 
         const int nextPrecedence = getTokenPrecedence(lexer.getCurrentToken());
         if (tokenPrecedence < nextPrecedence) {
-            rhs = parseBinaryOpRHS(tokenPrecedence + 1, std::move(rhs));
+            rhs = parseBinaryOpRHS(tokenPrecedence + 1, rhs);
             if (!rhs) {
                 return nullptr;
             }
         }
 
-        lhs = std::make_unique<BinaryExprAST>(binaryOperator, std::move(lhs), std::move(rhs));
+        lhs = makeNode<BinaryExprAST>(binaryOperator, lhs, rhs);
     }
 }
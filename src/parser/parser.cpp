@@ -1,6 +1,8 @@
 #include "parser.hpp"
 #include "../lexer/tokens.hpp"
 #include "../codegen/CodeGenerator.hpp"
+#include "../sema/TypeChecker.hpp"
+#include "../support/PhaseScope.hpp"
 
 bool Parser::parse(CodeGenerator& generator) {
 
@@ -35,22 +37,40 @@ bool Parser::parse(CodeGenerator& generator) {
 				Parser::logln("Parsed Identifier");
 				break;
 			case tok_class:
-				// For now, we can assum this class to inherit from Application
 				{
-					auto classAST = parseClassDefinition();
-					if (!classAST) {
+					ClassAST* classAST = nullptr;
+					bool parsed = false;
+					{
+						PhaseScope parseScope("Parse", sourceName);
+						parsed = parseClassDeclaration(classAST);
+					}
+					if (!parsed) {
 						std::cerr << "Error: Failed to parse class definition." << std::endl;
 						return false;
 					}
 
+					// The declaration has been consumed; generic classes and instantiations
+					// already compiled define nothing new.
+					currentToken = lexer.getCurrentToken();
+					if (!classAST) {
+						continue;
+					}
+
+					{
+						PhaseScope semaScope("Sema", sourceName);
+						TypeChecker().check(*classAST);
+					}
+
+					PhaseScope codegenScope("CodeGen", sourceName);
 					if (!classAST->codegen(generator)) {
 						std::cerr << "Error: Failed to generate LLVM IR for class." << std::endl;
 						return false;
 					}
 
+					classes.push_back(classAST);
 					hasGeneratedIR = true;
 				}
-				break;
+				continue;
 			default:
 				perror("Unknown token encountered during parsing.");
 				return false;
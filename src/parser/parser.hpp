@@ -1,42 +1,74 @@
 #pragma once
 
 #include <iostream>
-#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "../lexer/lexer.hpp"
 #include "../ast/exprAST.hpp"
 #include "../ast/stmtAST.hpp"
 #include "../ast/classAST.hpp"
+#include "../ast/ASTContext.hpp"
+#include "../support/InterfaceFile.hpp"
 
 class CodeGenerator;
 
 class Parser {
     public:
-        Parser(Lexer lexer, bool verbose = false) : lexer(std::move(lexer)), verbose(verbose) {}
+        // sourceName labels this parser's phases in --time-passes and --time-trace output
+        Parser(Lexer lexer, bool verbose = false, std::string sourceName = "")
+            : lexer(std::move(lexer)), verbose(verbose), sourceName(std::move(sourceName)) {}
         ~Parser() = default;
 
 		bool parse(CodeGenerator& generator);
 
-		std::unique_ptr<ExprAST> parseExpression();
-        std::unique_ptr<ExprAST> parseParenExpression();
-		std::unique_ptr<ExprAST> parseBinaryExpression();
-		std::unique_ptr<ExprAST> parseUnaryExpression();
-		std::unique_ptr<ExprAST> parseBinaryOpRHS(int exprPrecedence, std::unique_ptr<ExprAST> lhs);
-
-		std::unique_ptr<ExprAST> parsePrimaryExpression();
-        std::unique_ptr<IntegerExprAST> parseIntegerValue();
-        std::unique_ptr<FloatExprAST> parseFloatValue();
-        std::unique_ptr<BoolExprAST> parseBoolValue();
-        std::unique_ptr<CharExprAST> parseCharValue();
-        std::unique_ptr<StrExprAST> parseStrValue();
-		std::unique_ptr<ArrayLiteralExprAST> parseArrayLiteral();
-		std::unique_ptr<ArrayNewExprAST> parseArrayNew();
-
-        std::unique_ptr<IdentifierExprAST> parseIdentifier();
-
-		std::unique_ptr<ClassAST> parseClassDefinition();
-		std::unique_ptr<MethodImplAST> parseMethodImplementation();
-		std::unique_ptr<StmtAST> parseStatement();
+		ExprAST* parseExpression();
+        ExprAST* parseParenExpression();
+		ExprAST* parseBinaryExpression();
+		ExprAST* parseUnaryExpression();
+		ExprAST* parseBinaryOpRHS(int exprPrecedence, ExprAST* lhs);
+
+		ExprAST* parsePrimaryExpression();
+        IntegerExprAST* parseIntegerValue();
+        FloatExprAST* parseFloatValue();
+        BoolExprAST* parseBoolValue();
+        CharExprAST* parseCharValue();
+        StrExprAST* parseStrValue();
+		ArrayLiteralExprAST* parseArrayLiteral();
+		ArrayNewExprAST* parseArrayNew();
+		// Rest of `forall v: lower <= v < upper ==> body`, from v
+		ForallExprAST* parseForallExpression();
+
+        IdentifierExprAST* parseIdentifier();
+
+		// Parses a class declaration from 'class'. definedClass is set to the class to compile,
+		// or to nullptr for a generic class and for an instantiation already available.
+		bool parseClassDeclaration(ClassAST*& definedClass);
+		// Rest of a class definition, from the ':' after its header
+		ClassAST* parseClassDefinition(Identifier className, std::optional<Identifier> genericName);
+		MethodImplAST* parseMethodImplementation();
+		StmtAST* parseStatement();
+		// Rest of a statement that starts with identifierName, which has been consumed
+		StmtAST* parseIdentifierStatement(Identifier identifierName);
+		// Condition of a requires or ensures clause, after its ':'
+		ExprAST* parseContractClause();
+
+		// Classes parsed and compiled so far; they live as long as the parser
+		llvm::ArrayRef<ClassAST*> getClasses() const { return classes; }
+
+		// Interfaces of compiled classes that this unit links against. An explicit instantiation
+		// one of them already provides is not generated again.
+		void setImportedInterfaces(std::vector<const InterfaceFile*> interfaces) { importedInterfaces = std::move(interfaces); }
+
+		// Compilation statistics for --stats
+		size_t getTokenCount() const { return lexer.getTokenCount() + instantiationTokenCount; }
+		size_t getAstNodeCount() const { return astNodeCount; }
+		size_t getAstBytes() const { return context.getBytesAllocated(); }
 
 		void logln(const std::string &message) {
 			if (verbose) {
@@ -47,57 +79,106 @@ class Parser {
     private:
         Lexer lexer;
 		bool verbose = false;
+		std::string sourceName;
+		// Owns every node parsed from this translation unit
+		ASTContext context;
+		std::vector<ClassAST*> classes;
+		size_t astNodeCount = 0;
+
+		// A class declared with type parameters. Its body is parsed again for every
+		// instantiation, from its source text with the parameters read as the type arguments,
+		// so each instantiation has its own AST with concrete primitive kinds.
+		struct GenericClass {
+			std::vector<std::string_view> typeParameters;
+			std::string_view text;
+		};
+
+		std::unordered_map<std::string, GenericClass> genericClasses;
+		// Names of the classes defined, instantiated or found in an imported interface
+		std::unordered_set<std::string> definedClassNames;
+		std::vector<const InterfaceFile*> importedInterfaces;
+		size_t instantiationTokenCount = 0;
+		// Type parameters of the instantiation being parsed, with the type argument token each
+		// stands for
+		std::vector<std::pair<std::string_view, int16_t>> typeArgumentsInScope;
+
+		// Parses '<' and the type parameters or type arguments of a class header up to '>'
+		bool parseTypeList(std::vector<std::string_view>& typeParameters, std::vector<int16_t>& typeArguments);
+		bool skipGenericClassBody();
+		bool instantiateGenericClass(Identifier genericName, const std::vector<int16_t>& typeArguments, ClassAST*& definedClass);
+		bool isProvidedByImport(const std::string& className) const;
+		// token, or the type argument it names if it is a type parameter in scope. Only called
+		// where a type is expected, so a variable may share a type parameter's name.
+		int16_t resolveTypeToken(int16_t token);
+		// Whether the type parameter at the current token starts a variable declaration, that
+		// is, whether a variable name or '[]' follows it
+		bool startsTypedDeclaration();
+
+		// Every AST node the parser creates goes through one of these so it is counted
+		template <typename NodeT, typename... Args>
+		NodeT* makeNode(Args&&... args) {
+			astNodeCount++;
+			return context.create<NodeT>(std::forward<Args>(args)...);
+		}
+
+		template <typename NodeT>
+		NodeT* countNode(NodeT* node) {
+			if (node) {
+				astNodeCount++;
+			}
+			return node;
+		}
 };
 
 namespace ParserUtils {
 
-	inline static std::unique_ptr<TypeAST> getPrimitiveTypeFromToken(int16_t token) {
+	inline static TypeAST* getPrimitiveTypeFromToken(ASTContext& context, int16_t token) {
 		switch (token) {
 				case tok_i8:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::INT8);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::INT8);
 				case tok_i16:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::INT16);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::INT16);
 			case tok_i32:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::INT32);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::INT32);
 				case tok_i64:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::INT64);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::INT64);
 				case tok_u8:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::UINT8);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::UINT8);
 				case tok_u16:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::UINT16);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::UINT16);
 				case tok_u32:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::UINT32);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::UINT32);
 				case tok_u64:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::UINT64);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::UINT64);
 			case tok_f32:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::FLOAT32);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::FLOAT32);
 				case tok_f64:
-					return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::FLOAT64);
+					return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::FLOAT64);
 			case tok_fr32:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::FRACTIONAL32);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::FRACTIONAL32);
 			case tok_fr64:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::FRACTIONAL64);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::FRACTIONAL64);
 			case tok_bool:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::BOOL);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::BOOL);
 			case tok_char:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::CHAR);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::CHAR);
 			case tok_str:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::STR);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::STR);
 			case tok_void:
-				return std::make_unique<PrimitiveTypeAST>(PrimitiveTypeAST::VOID);
+				return context.create<PrimitiveTypeAST>(PrimitiveTypeAST::VOID);
 			default:
 				return nullptr;
 		}
 	}
 
-	inline static std::unique_ptr<TypedIdentifierAST> makeTypedIdentifier(std::unique_ptr<TypeAST> type, const std::string &name) {
-		return std::make_unique<TypedIdentifierAST>(std::move(type), name);
+	inline static TypedIdentifierAST* makeTypedIdentifier(ASTContext& context, const TypeAST* type, Identifier name) {
+		return context.create<TypedIdentifierAST>(type, name);
 	}
 
-	inline static std::unique_ptr<AccessModifierAST> getAccessModifierFromToken(int16_t token) {
+	inline static AccessModifierAST* getAccessModifierFromToken(ASTContext& context, int16_t token) {
 		switch (token) {
 			case tok_public:
-				return std::make_unique<AccessModifierAST>(AccessModifierAST::PUBLIC);
+				return context.create<AccessModifierAST>(AccessModifierAST::PUBLIC);
 			default:
 				return nullptr;
 		}
@@ -3,24 +3,24 @@
 #include "parser.hpp"
 #include "../lexer/tokens.hpp"
 
-std::unique_ptr<StmtAST> Parser::parseStatement() {
+StmtAST* Parser::parseStatement() {
     Parser::logln("Parsing Statement...");
 
     int16_t currentToken = lexer.getCurrentToken();
 
     if (currentToken == '{') {
         lexer.getNextToken();
-        std::vector<std::unique_ptr<StmtAST>> statements;
+        std::vector<StmtAST*> statements;
         while (lexer.getCurrentToken() != '}') {
             auto nestedStatement = parseStatement();
             if (!nestedStatement) {
                 return nullptr;
             }
-            statements.push_back(std::move(nestedStatement));
+            statements.push_back(nestedStatement);
         }
 
         lexer.getNextToken();
-        return std::make_unique<BlockStmtAST>(std::move(statements));
+        return makeNode<BlockStmtAST>(context.copyArray(statements));
     }
 
     if (currentToken == tok_if) {
@@ -46,7 +46,7 @@ std::unique_ptr<StmtAST> Parser::parseStatement() {
             return nullptr;
         }
 
-        std::unique_ptr<StmtAST> elseStatement = nullptr;
+        StmtAST* elseStatement = nullptr;
         if (lexer.getCurrentToken() == tok_else) {
             lexer.getNextToken();
             elseStatement = parseStatement();
@@ -55,7 +55,7 @@ std::unique_ptr<StmtAST> Parser::parseStatement() {
             }
         }
 
-        return std::make_unique<IfStmtAST>(std::move(condition), std::move(thenStatement), std::move(elseStatement));
+        return makeNode<IfStmtAST>(condition, thenStatement, elseStatement);
     }
 
     if (currentToken == tok_while) {
@@ -81,12 +81,16 @@ std::unique_ptr<StmtAST> Parser::parseStatement() {
             return nullptr;
         }
 
-        return std::make_unique<WhileStmtAST>(std::move(condition), std::move(body));
+        return makeNode<WhileStmtAST>(condition, body);
+    }
+
+    if (currentToken == tok_identifier && startsTypedDeclaration()) {
+        currentToken = resolveTypeToken(currentToken);
     }
 
     if (TokenUtils::isPrimitiveTypeToken(currentToken)) {
-        std::unique_ptr<TypeAST> elementType = ParserUtils::getPrimitiveTypeFromToken(currentToken);
-        std::unique_ptr<TypeAST> variableType;
+        TypeAST* elementType = countNode(ParserUtils::getPrimitiveTypeFromToken(context, currentToken));
+        TypeAST* variableType;
 
         currentToken = lexer.getNextToken();
 
@@ -97,10 +101,10 @@ std::unique_ptr<StmtAST> Parser::parseStatement() {
                 std::cerr << "Error: Expected ']' to close array type." << std::endl;
                 return nullptr;
             }
-            variableType = std::make_unique<ArrayTypeAST>(std::move(elementType));
+            variableType = makeNode<ArrayTypeAST>(elementType);
             currentToken = lexer.getNextToken();
         } else {
-            variableType = std::move(elementType);
+            variableType = elementType;
         }
 
         if (currentToken != tok_identifier) {
@@ -108,7 +112,7 @@ std::unique_ptr<StmtAST> Parser::parseStatement() {
             return nullptr;
         }
 
-        const std::string variableName = lexer.getIdentifierName();
+        const Identifier variableName = context.intern(lexer.getIdentifierName());
 
         currentToken = lexer.getNextToken();
         if (currentToken != '=') {
@@ -128,89 +132,110 @@ std::unique_ptr<StmtAST> Parser::parseStatement() {
         }
 
         lexer.getNextToken();
-        return std::make_unique<VarDeclStmtAST>(std::move(variableType), variableName, std::move(initializer));
+        return makeNode<VarDeclStmtAST>(variableType, variableName, initializer);
     }
 
     if (currentToken == tok_identifier) {
-        const std::string identifierName = lexer.getIdentifierName();
+        const Identifier identifierName = context.intern(lexer.getIdentifierName());
+        lexer.getNextToken();
+        return parseIdentifierStatement(identifierName);
+    }
+
+    std::cerr << "Error: Unknown statement starting token." << std::endl;
+    return nullptr;
+}
+
+StmtAST* Parser::parseIdentifierStatement(Identifier identifierName) {
+    int16_t currentToken = lexer.getCurrentToken();
+
+    if (currentToken == '[') {
+        lexer.getNextToken();
+        auto indexExpr = parseExpression();
+        if (!indexExpr) return nullptr;
+        if (lexer.getCurrentToken() != ']') {
+            std::cerr << "Error: Expected ']' after array index in assignment." << std::endl;
+            return nullptr;
+        }
+        if (lexer.getNextToken() != '=') {
+            std::cerr << "Error: Expected '=' after array index in assignment." << std::endl;
+            return nullptr;
+        }
+        lexer.getNextToken();
+        auto valueExpr = parseExpression();
+        if (!valueExpr) return nullptr;
+        if (lexer.getCurrentToken() != ';') {
+            std::cerr << "Error: Expected ';' after array index assignment." << std::endl;
+            return nullptr;
+        }
+        lexer.getNextToken();
+        return makeNode<IndexAssignStmtAST>(identifierName, indexExpr, valueExpr);
+    }
+
+    if (identifierName == "Defaultlogger" && currentToken == '.') {
         currentToken = lexer.getNextToken();
+        if (currentToken != tok_identifier || lexer.getIdentifierName() != "logln") {
+            std::cerr << "Error: Expected Defaultlogger.logln call." << std::endl;
+            return nullptr;
+        }
 
-        if (currentToken == '[') {
-            lexer.getNextToken();
-            auto indexExpr = parseExpression();
-            if (!indexExpr) return nullptr;
-            if (lexer.getCurrentToken() != ']') {
-                std::cerr << "Error: Expected ']' after array index in assignment." << std::endl;
-                return nullptr;
-            }
-            if (lexer.getNextToken() != '=') {
-                std::cerr << "Error: Expected '=' after array index in assignment." << std::endl;
-                return nullptr;
-            }
-            lexer.getNextToken();
-            auto valueExpr = parseExpression();
-            if (!valueExpr) return nullptr;
-            if (lexer.getCurrentToken() != ';') {
-                std::cerr << "Error: Expected ';' after array index assignment." << std::endl;
-                return nullptr;
-            }
-            lexer.getNextToken();
-            return std::make_unique<IndexAssignStmtAST>(identifierName, std::move(indexExpr), std::move(valueExpr));
+        currentToken = lexer.getNextToken();
+        if (currentToken != '(') {
+            std::cerr << "Error: Expected '(' in Defaultlogger.logln call." << std::endl;
+            return nullptr;
         }
 
-        if (identifierName == "Defaultlogger" && currentToken == '.') {
-            currentToken = lexer.getNextToken();
-            if (currentToken != tok_identifier || lexer.getIdentifierName() != "logln") {
-                std::cerr << "Error: Expected Defaultlogger.logln call." << std::endl;
-                return nullptr;
-            }
+        lexer.getNextToken();
+        auto loggedValue = parseExpression();
+        if (!loggedValue) {
+            return nullptr;
+        }
 
-            currentToken = lexer.getNextToken();
-            if (currentToken != '(') {
-                std::cerr << "Error: Expected '(' in Defaultlogger.logln call." << std::endl;
-                return nullptr;
-            }
+        if (lexer.getCurrentToken() != ')') {
+            std::cerr << "Error: Expected ')' in Defaultlogger.logln call." << std::endl;
+            return nullptr;
+        }
 
-            lexer.getNextToken();
-            auto loggedValue = parseExpression();
-            if (!loggedValue) {
-                return nullptr;
-            }
+        if (lexer.getNextToken() != ';') {
+            std::cerr << "Error: Expected ';' after Defaultlogger.logln call." << std::endl;
+            return nullptr;
+        }
 
-            if (lexer.getCurrentToken() != ')') {
-                std::cerr << "Error: Expected ')' in Defaultlogger.logln call." << std::endl;
-                return nullptr;
-            }
+        lexer.getNextToken();
+        return makeNode<PrintStmtAST>(loggedValue);
+    }
 
-            if (lexer.getNextToken() != ';') {
-                std::cerr << "Error: Expected ';' after Defaultlogger.logln call." << std::endl;
-                return nullptr;
-            }
+    if (currentToken == '=') {
+        lexer.getNextToken();
+        auto assignedValue = parseExpression();
+        if (!assignedValue) {
+            return nullptr;
+        }
 
-            lexer.getNextToken();
-            return std::make_unique<PrintStmtAST>(std::move(loggedValue));
+        if (lexer.getCurrentToken() != ';') {
+            std::cerr << "Error: Expected ';' after assignment." << std::endl;
+            return nullptr;
         }
 
-        if (currentToken == '=') {
-            lexer.getNextToken();
-            auto assignedValue = parseExpression();
-            if (!assignedValue) {
-                return nullptr;
-            }
+        lexer.getNextToken();
+        return makeNode<AssignmentStmtAST>(identifierName, assignedValue);
+    }
 
-            if (lexer.getCurrentToken() != ';') {
-                std::cerr << "Error: Expected ';' after assignment." << std::endl;
-                return nullptr;
-            }
+    std::cerr << "Error: Unsupported identifier statement." << std::endl;
+    return nullptr;
+}
 
-            lexer.getNextToken();
-            return std::make_unique<AssignmentStmtAST>(identifierName, std::move(assignedValue));
-        }
+ExprAST* Parser::parseContractClause() {
+    lexer.getNextToken();
+    auto condition = parseExpression();
+    if (!condition) {
+        return nullptr;
+    }
 
-        std::cerr << "Error: Unsupported identifier statement." << std::endl;
+    if (lexer.getCurrentToken() != ';') {
+        std::cerr << "Error: Expected ';' after contract clause." << std::endl;
         return nullptr;
     }
 
-    std::cerr << "Error: Unknown statement starting token." << std::endl;
-    return nullptr;
+    lexer.getNextToken();
+    return condition;
 }
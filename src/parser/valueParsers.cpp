@@ -5,7 +5,7 @@
 #include "parser.hpp"
 #include "../lexer/tokens.hpp"
 
-std::unique_ptr<ExprAST> Parser::parsePrimaryExpression() {
+ExprAST* Parser::parsePrimaryExpression() {
 	int16_t currentToken = lexer.getCurrentToken();
 	switch (currentToken) {
 		case '(':
@@ -21,8 +21,20 @@ std::unique_ptr<ExprAST> Parser::parsePrimaryExpression() {
 			return parseCharValue();
 		case tok_identifier:
 			{
-				std::string name = lexer.getIdentifierName();
+				const Identifier name = context.intern(lexer.getIdentifierName());
 				lexer.getNextToken();
+				// `forall` is only a keyword where a variable name cannot follow an identifier.
+				if (name.str() == "forall" && lexer.getCurrentToken() == tok_identifier) {
+					return parseForallExpression();
+				}
+				if (lexer.getCurrentToken() == '.') {
+					if (lexer.getNextToken() != tok_identifier || lexer.getIdentifierName() != "length") {
+						std::cerr << "Error: Expected 'length' after '.' in expression." << std::endl;
+						return nullptr;
+					}
+					lexer.getNextToken();
+					return makeNode<ArrayLengthExprAST>(name);
+				}
 				if (lexer.getCurrentToken() == '[') {
 					lexer.getNextToken();
 					auto indexExpr = parseExpression();
@@ -32,9 +44,9 @@ std::unique_ptr<ExprAST> Parser::parsePrimaryExpression() {
 						return nullptr;
 					}
 					lexer.getNextToken();
-					return std::make_unique<IndexExprAST>(name, std::move(indexExpr));
+					return makeNode<IndexExprAST>(name, indexExpr);
 				}
-				return std::make_unique<IdentifierExprAST>(name);
+				return makeNode<IdentifierExprAST>(name);
 			}
 		case tok_str_literal:
 			return parseStrValue();
@@ -49,49 +61,49 @@ std::unique_ptr<ExprAST> Parser::parsePrimaryExpression() {
 	}
 }
 
-std::unique_ptr<IntegerExprAST> Parser::parseIntegerValue() {
+IntegerExprAST* Parser::parseIntegerValue() {
 	int64_t value = lexer.getIntegerValue();
     lexer.getNextToken();
-    return std::make_unique<IntegerExprAST>(value);
+    return makeNode<IntegerExprAST>(value);
 }
 
-std::unique_ptr<FloatExprAST> Parser::parseFloatValue() {
+FloatExprAST* Parser::parseFloatValue() {
     double value = lexer.getFloatValue();
     lexer.getNextToken();
-    return std::make_unique<FloatExprAST>(value);
+    return makeNode<FloatExprAST>(value);
 }
 
-std::unique_ptr<BoolExprAST> Parser::parseBoolValue() {
+BoolExprAST* Parser::parseBoolValue() {
 	bool value = lexer.getCurrentToken() == tok_true;
     lexer.getNextToken();
-    return std::make_unique<BoolExprAST>(value);
+    return makeNode<BoolExprAST>(value);
 }
 
-std::unique_ptr<CharExprAST> Parser::parseCharValue() {
+CharExprAST* Parser::parseCharValue() {
     char value = lexer.getCharValue();
     lexer.getNextToken();
-    return std::make_unique<CharExprAST>(value);
+    return makeNode<CharExprAST>(value);
 }
 
-std::unique_ptr<StrExprAST> Parser::parseStrValue() {
-    std::string value = lexer.getStringValue();
+StrExprAST* Parser::parseStrValue() {
+    const llvm::StringRef value = context.copyString(lexer.getStringValue());
     lexer.getNextToken();
-    return std::make_unique<StrExprAST>(value);
+    return makeNode<StrExprAST>(value);
 }
 
-std::unique_ptr<IdentifierExprAST> Parser::parseIdentifier() {
-    std::string name = lexer.getIdentifierName();
+IdentifierExprAST* Parser::parseIdentifier() {
+    const Identifier name = context.intern(lexer.getIdentifierName());
     lexer.getNextToken();
-    return std::make_unique<IdentifierExprAST>(name);
+    return makeNode<IdentifierExprAST>(name);
 }
 
-std::unique_ptr<ArrayLiteralExprAST> Parser::parseArrayLiteral() {
+ArrayLiteralExprAST* Parser::parseArrayLiteral() {
 	lexer.getNextToken(); // consume '{'
-	std::vector<std::unique_ptr<ExprAST>> elements;
+	std::vector<ExprAST*> elements;
 	while (lexer.getCurrentToken() != '}') {
 		auto elem = parseExpression();
 		if (!elem) return nullptr;
-		elements.push_back(std::move(elem));
+		elements.push_back(elem);
 		if (lexer.getCurrentToken() == ',') {
 			lexer.getNextToken();
 		} else if (lexer.getCurrentToken() != '}') {
@@ -100,13 +112,13 @@ std::unique_ptr<ArrayLiteralExprAST> Parser::parseArrayLiteral() {
 		}
 	}
 	lexer.getNextToken(); // consume '}'
-	return std::make_unique<ArrayLiteralExprAST>(std::move(elements));
+	return makeNode<ArrayLiteralExprAST>(context.copyArray(elements));
 }
 
-std::unique_ptr<ArrayNewExprAST> Parser::parseArrayNew() {
+ArrayNewExprAST* Parser::parseArrayNew() {
 	// current token is tok_new
-	int16_t typeToken = lexer.getNextToken();
-	auto elementType = ParserUtils::getPrimitiveTypeFromToken(typeToken);
+	int16_t typeToken = resolveTypeToken(lexer.getNextToken());
+	auto elementType = countNode(ParserUtils::getPrimitiveTypeFromToken(context, typeToken));
 	if (!elementType) {
 		std::cerr << "Error: Expected element type after 'new'." << std::endl;
 		return nullptr;
@@ -123,5 +135,5 @@ std::unique_ptr<ArrayNewExprAST> Parser::parseArrayNew() {
 		return nullptr;
 	}
 	lexer.getNextToken(); // consume ']'
-	return std::make_unique<ArrayNewExprAST>(std::move(elementType), std::move(sizeExpr));
+	return makeNode<ArrayNewExprAST>(elementType, sizeExpr);
 }
@@ -0,0 +1,371 @@
+#include <llvm/ADT/APFloat.h>
+#include <llvm/ADT/APInt.h>
+
+#include "ConstantEvaluator.hpp"
+#include "PrimitiveKinds.hpp"
+
+namespace {
+
+using PrimitiveKind = PrimitiveTypeAST::PrimitiveKind;
+
+// Fraction arithmetic is evaluated at this width, so cross products of 32-bit components and
+// their sums are exact.
+constexpr unsigned FractionEvaluationBits = 128;
+
+struct Fraction {
+    llvm::APInt numerator;
+    llvm::APInt denominator;
+};
+
+bool isComparisonOperator(int op) {
+    switch (op) {
+        case BinaryExprAST::LESS_THAN:
+        case BinaryExprAST::LESS_EQUAL:
+        case BinaryExprAST::GREATER_THAN:
+        case BinaryExprAST::GREATER_EQUAL:
+        case BinaryExprAST::EQUAL:
+        case BinaryExprAST::NOT_EQUAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const llvm::fltSemantics& getFloatingSemantics(PrimitiveKind kind) {
+    return kind == PrimitiveTypeAST::FLOAT32 ? llvm::APFloat::IEEEsingle() : llvm::APFloat::IEEEdouble();
+}
+
+llvm::APInt getIntegerBits(const ConstantValue& value) {
+    return llvm::APInt(getIntegerBitWidth(value.kind), value.integerBits, !isUnsignedKind(value.kind));
+}
+
+ConstantValue makeInteger(const llvm::APInt& bits, PrimitiveKind kind) {
+    ConstantValue value;
+    value.kind = kind;
+    value.integerBits = isUnsignedKind(kind) ? bits.getZExtValue() : static_cast<uint64_t>(bits.getSExtValue());
+    return value;
+}
+
+ConstantValue makeBool(bool truth) {
+    return makeInteger(llvm::APInt(1, truth ? 1 : 0), PrimitiveTypeAST::BOOL);
+}
+
+ConstantValue makeFloating(llvm::APFloat floating, PrimitiveKind kind) {
+    bool losesInfo = false;
+    floating.convert(llvm::APFloat::IEEEdouble(), llvm::APFloat::rmNearestTiesToEven, &losesInfo);
+    ConstantValue value;
+    value.kind = kind;
+    value.floatingValue = floating.convertToDouble();
+    return value;
+}
+
+// Reduces numerator/denominator to lowest terms with a positive denominator. The unreduced
+// components must already fit the kind: eager normalization in wrapping mode truncates them
+// before reducing, so folding anything wider would depend on the code generation options.
+std::optional<ConstantValue> makeFraction(llvm::APInt numerator, llvm::APInt denominator, PrimitiveKind kind) {
+    if (denominator == 0) {
+        return std::nullopt;
+    }
+    if (denominator.isNegative()) {
+        numerator.negate();
+        denominator.negate();
+    }
+
+    const llvm::APInt limit = llvm::APInt::getSignedMaxValue(getFractionComponentBitWidth(kind)).sext(FractionEvaluationBits);
+    if (numerator.abs().sgt(limit) || denominator.sgt(limit)) {
+        return std::nullopt;
+    }
+
+    const llvm::APInt gcd = llvm::APIntOps::GreatestCommonDivisor(numerator.abs(), denominator);
+    ConstantValue value;
+    value.kind = kind;
+    value.numerator = numerator.sdiv(gcd).getSExtValue();
+    value.denominator = denominator.sdiv(gcd).getSExtValue();
+    return value;
+}
+
+// castValueToType between integers: truncate, or extend by the source's signedness.
+llvm::APInt castToInteger(const ConstantValue& value, unsigned bitWidth) {
+    const llvm::APInt bits = getIntegerBits(value);
+    return isUnsignedKind(value.kind) ? bits.zextOrTrunc(bitWidth) : bits.sextOrTrunc(bitWidth);
+}
+
+llvm::APFloat integerToFloating(const llvm::APInt& bits, bool isSigned, const llvm::fltSemantics& semantics) {
+    llvm::APFloat result = llvm::APFloat::getZero(semantics);
+    result.convertFromAPInt(bits, isSigned, llvm::APFloat::rmNearestTiesToEven);
+    return result;
+}
+
+// Integers convert by their signedness, fractions divide their converted components and
+// floats round to the promoted format.
+std::optional<llvm::APFloat> castToFloating(const ConstantValue& value, PrimitiveKind kind) {
+    const llvm::fltSemantics& semantics = getFloatingSemantics(kind);
+    if (isFloatingKind(value.kind)) {
+        llvm::APFloat result(value.floatingValue);
+        bool losesInfo = false;
+        result.convert(semantics, llvm::APFloat::rmNearestTiesToEven, &losesInfo);
+        return result;
+    }
+    if (isFractionalKind(value.kind)) {
+        llvm::APFloat result = integerToFloating(llvm::APInt(64, static_cast<uint64_t>(value.numerator), true), true, semantics);
+        result.divide(integerToFloating(llvm::APInt(64, static_cast<uint64_t>(value.denominator), true), true, semantics), llvm::APFloat::rmNearestTiesToEven);
+        return result;
+    }
+    if (getIntegerBitWidth(value.kind) != 0) {
+        return integerToFloating(getIntegerBits(value), !isUnsignedKind(value.kind), semantics);
+    }
+    return std::nullopt;
+}
+
+// Integers become n/1 at the component width; narrower fractions widen.
+std::optional<Fraction> castToFraction(const ConstantValue& value, PrimitiveKind kind) {
+    const unsigned componentBits = getFractionComponentBitWidth(kind);
+    if (isFractionalKind(value.kind)) {
+        if (getFractionComponentBitWidth(value.kind) > componentBits) {
+            return std::nullopt;
+        }
+        return Fraction{
+            llvm::APInt(FractionEvaluationBits, static_cast<uint64_t>(value.numerator), true),
+            llvm::APInt(FractionEvaluationBits, static_cast<uint64_t>(value.denominator), true)};
+    }
+    if (getIntegerBitWidth(value.kind) != 0) {
+        return Fraction{castToInteger(value, componentBits).sext(FractionEvaluationBits), llvm::APInt(FractionEvaluationBits, 1)};
+    }
+    return std::nullopt;
+}
+
+// Non-zero test of castToBoolean; NaN is false, like the ordered compare it lowers to.
+std::optional<bool> castToBoolean(const ConstantValue& value) {
+    if (isFloatingKind(value.kind)) {
+        return value.floatingValue < 0.0 || value.floatingValue > 0.0;
+    }
+    if (isFractionalKind(value.kind)) {
+        return value.numerator != 0;
+    }
+    if (getIntegerBitWidth(value.kind) != 0) {
+        return value.integerBits != 0;
+    }
+    return std::nullopt;
+}
+
+bool compareIntegers(int op, const llvm::APInt& left, const llvm::APInt& right, bool isUnsigned) {
+    switch (op) {
+        case BinaryExprAST::LESS_THAN:
+            return isUnsigned ? left.ult(right) : left.slt(right);
+        case BinaryExprAST::LESS_EQUAL:
+            return isUnsigned ? left.ule(right) : left.sle(right);
+        case BinaryExprAST::GREATER_THAN:
+            return isUnsigned ? left.ugt(right) : left.sgt(right);
+        case BinaryExprAST::GREATER_EQUAL:
+            return isUnsigned ? left.uge(right) : left.sge(right);
+        case BinaryExprAST::EQUAL:
+            return left == right;
+        default:
+            return left != right;
+    }
+}
+
+// Ordered comparisons: any comparison with NaN is false.
+bool compareFloating(int op, const llvm::APFloat& left, const llvm::APFloat& right) {
+    const llvm::APFloat::cmpResult order = left.compare(right);
+    switch (op) {
+        case BinaryExprAST::LESS_THAN:
+            return order == llvm::APFloat::cmpLessThan;
+        case BinaryExprAST::LESS_EQUAL:
+            return order == llvm::APFloat::cmpLessThan || order == llvm::APFloat::cmpEqual;
+        case BinaryExprAST::GREATER_THAN:
+            return order == llvm::APFloat::cmpGreaterThan;
+        case BinaryExprAST::GREATER_EQUAL:
+            return order == llvm::APFloat::cmpGreaterThan || order == llvm::APFloat::cmpEqual;
+        case BinaryExprAST::EQUAL:
+            return order == llvm::APFloat::cmpEqual;
+        default:
+            return order == llvm::APFloat::cmpLessThan || order == llvm::APFloat::cmpGreaterThan;
+    }
+}
+
+std::optional<ConstantValue> evaluateFloatingBinary(int op, const ConstantValue& left, const ConstantValue& right, PrimitiveKind operandKind) {
+    std::optional<llvm::APFloat> leftValue = castToFloating(left, operandKind);
+    const std::optional<llvm::APFloat> rightValue = castToFloating(right, operandKind);
+    if (!leftValue || !rightValue) {
+        return std::nullopt;
+    }
+
+    if (isComparisonOperator(op)) {
+        return makeBool(compareFloating(op, *leftValue, *rightValue));
+    }
+
+    const llvm::APFloat::roundingMode rounding = llvm::APFloat::rmNearestTiesToEven;
+    switch (op) {
+        case BinaryExprAST::PLUS:
+            leftValue->add(*rightValue, rounding);
+            break;
+        case BinaryExprAST::MINUS:
+            leftValue->subtract(*rightValue, rounding);
+            break;
+        case BinaryExprAST::MULTIPLY:
+            leftValue->multiply(*rightValue, rounding);
+            break;
+        case BinaryExprAST::DIVIDE:
+            leftValue->divide(*rightValue, rounding);
+            break;
+        default:
+            return std::nullopt;
+    }
+    return makeFloating(*leftValue, operandKind);
+}
+
+std::optional<ConstantValue> evaluateFractionBinary(int op, const ConstantValue& left, const ConstantValue& right, PrimitiveKind operandKind) {
+    const std::optional<Fraction> leftValue = castToFraction(left, operandKind);
+    const std::optional<Fraction> rightValue = castToFraction(right, operandKind);
+    if (!leftValue || !rightValue) {
+        return std::nullopt;
+    }
+
+    const llvm::APInt& leftNumerator = leftValue->numerator;
+    const llvm::APInt& leftDenominator = leftValue->denominator;
+    const llvm::APInt& rightNumerator = rightValue->numerator;
+    const llvm::APInt& rightDenominator = rightValue->denominator;
+
+    // Denominators are positive, so cross products order the values.
+    if (isComparisonOperator(op)) {
+        return makeBool(compareIntegers(op, leftNumerator * rightDenominator, rightNumerator * leftDenominator, false));
+    }
+
+    switch (op) {
+        case BinaryExprAST::PLUS:
+            return makeFraction(leftNumerator * rightDenominator + rightNumerator * leftDenominator, leftDenominator * rightDenominator, operandKind);
+        case BinaryExprAST::MINUS:
+            return makeFraction(leftNumerator * rightDenominator - rightNumerator * leftDenominator, leftDenominator * rightDenominator, operandKind);
+        case BinaryExprAST::MULTIPLY:
+            return makeFraction(leftNumerator * rightNumerator, leftDenominator * rightDenominator, operandKind);
+        case BinaryExprAST::DIVIDE:
+            return makeFraction(leftNumerator * rightDenominator, leftDenominator * rightNumerator, operandKind);
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<ConstantValue> evaluateIntegerBinary(int op, const ConstantValue& left, const ConstantValue& right, PrimitiveKind operandKind) {
+    const unsigned bitWidth = getIntegerBitWidth(operandKind);
+    if (bitWidth == 0 || getIntegerBitWidth(left.kind) == 0 || getIntegerBitWidth(right.kind) == 0) {
+        return std::nullopt;
+    }
+
+    const llvm::APInt leftValue = castToInteger(left, bitWidth);
+    const llvm::APInt rightValue = castToInteger(right, bitWidth);
+    const bool isUnsigned = isUnsignedKind(operandKind);
+
+    if (isComparisonOperator(op)) {
+        return makeBool(compareIntegers(op, leftValue, rightValue, isUnsigned));
+    }
+
+    switch (op) {
+        case BinaryExprAST::PLUS:
+            return makeInteger(leftValue + rightValue, operandKind);
+        case BinaryExprAST::MINUS:
+            return makeInteger(leftValue - rightValue, operandKind);
+        case BinaryExprAST::MULTIPLY:
+            return makeInteger(leftValue * rightValue, operandKind);
+        case BinaryExprAST::DIVIDE:
+        case BinaryExprAST::MODULO:
+            // Both are undefined at runtime; leave them to the generated code.
+            if (rightValue == 0 || (!isUnsigned && leftValue.isMinSignedValue() && rightValue.isAllOnes())) {
+                return std::nullopt;
+            }
+            if (op == BinaryExprAST::DIVIDE) {
+                return makeInteger(isUnsigned ? leftValue.udiv(rightValue) : leftValue.sdiv(rightValue), operandKind);
+            }
+            return makeInteger(isUnsigned ? leftValue.urem(rightValue) : leftValue.srem(rightValue), operandKind);
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<ConstantValue> evaluateBinary(const BinaryExprAST& node) {
+    const ExprAST* lhs = node.getLHS();
+    const ExprAST* rhs = node.getRHS();
+    if (!lhs || !rhs || !lhs->hasConstantValue() || !rhs->hasConstantValue()) {
+        return std::nullopt;
+    }
+
+    const ConstantValue& left = lhs->getConstantValue();
+    const ConstantValue& right = rhs->getConstantValue();
+    const int op = node.getOp();
+
+    if (op == BinaryExprAST::LOGICAL_AND || op == BinaryExprAST::LOGICAL_OR) {
+        const std::optional<bool> leftTruth = castToBoolean(left);
+        const std::optional<bool> rightTruth = castToBoolean(right);
+        if (!leftTruth || !rightTruth) {
+            return std::nullopt;
+        }
+        return makeBool(op == BinaryExprAST::LOGICAL_AND ? *leftTruth && *rightTruth : *leftTruth || *rightTruth);
+    }
+
+    if (!node.hasOperandKind()) {
+        return std::nullopt;
+    }
+
+    const PrimitiveKind operandKind = node.getOperandKind();
+    if (isFloatingKind(operandKind)) {
+        return evaluateFloatingBinary(op, left, right, operandKind);
+    }
+    if (isFractionalKind(operandKind)) {
+        return evaluateFractionBinary(op, left, right, operandKind);
+    }
+    return evaluateIntegerBinary(op, left, right, operandKind);
+}
+
+std::optional<ConstantValue> evaluateUnary(const UnaryExprAST& node) {
+    const ExprAST* operand = node.getOperand();
+    if (!operand || !operand->hasConstantValue()) {
+        return std::nullopt;
+    }
+
+    const ConstantValue& value = operand->getConstantValue();
+    if (node.getOp() == UnaryExprAST::LOGICAL_NOT) {
+        const std::optional<bool> truth = castToBoolean(value);
+        if (!truth) {
+            return std::nullopt;
+        }
+        return makeBool(!*truth);
+    }
+
+    if (node.getOp() != UnaryExprAST::NEGATE || !node.hasPrimitiveKind()) {
+        return std::nullopt;
+    }
+    if (isFloatingKind(value.kind)) {
+        ConstantValue negated = value;
+        negated.floatingValue = -value.floatingValue;
+        return negated;
+    }
+    if (getIntegerBitWidth(value.kind) != 0) {
+        return makeInteger(-getIntegerBits(value), value.kind);
+    }
+    return std::nullopt;
+}
+
+}
+
+std::optional<ConstantValue> evaluateConstant(const ExprAST& expr) {
+    switch (expr.getExprKind()) {
+        case ExprAST::INTEGER:
+            return makeInteger(llvm::APInt(64, static_cast<uint64_t>(llvm::cast<IntegerExprAST>(expr).getValue()), true), PrimitiveTypeAST::INT64);
+        case ExprAST::FLOAT: {
+            ConstantValue value;
+            value.kind = PrimitiveTypeAST::FLOAT64;
+            value.floatingValue = llvm::cast<FloatExprAST>(expr).getValue();
+            return value;
+        }
+        case ExprAST::BOOL:
+            return makeBool(llvm::cast<BoolExprAST>(expr).getValue());
+        case ExprAST::CHAR:
+            return makeInteger(llvm::APInt(8, static_cast<uint8_t>(llvm::cast<CharExprAST>(expr).getValue())), PrimitiveTypeAST::CHAR);
+        case ExprAST::BINARY:
+            return evaluateBinary(llvm::cast<BinaryExprAST>(expr));
+        case ExprAST::UNARY:
+            return evaluateUnary(llvm::cast<UnaryExprAST>(expr));
+        default:
+            return std::nullopt;
+    }
+}
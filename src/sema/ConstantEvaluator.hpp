@@ -0,0 +1,16 @@
+#pragma once
+
+#include <optional>
+
+#include "../ast/exprAST.hpp"
+
+// Evaluates a typed expression at compile time. Literals evaluate to themselves; binary and
+// unary expressions evaluate when the TypeChecker has resolved their kinds and already folded
+// every operand. Results follow the code generator's lowering exactly: integers wrap at the
+// promoted width and extend by the source's signedness, floats round as IEEE arithmetic in the
+// promoted format, and fractions are exact in lowest terms.
+//
+// Returns nullopt when the result is not a compile-time constant, or when the runtime result
+// depends on code generation options: integer division by zero and signed MIN / -1, fractions
+// with a zero denominator, and fraction results whose unreduced components do not fit.
+std::optional<ConstantValue> evaluateConstant(const ExprAST& expr);
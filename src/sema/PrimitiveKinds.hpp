@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../ast/commonAST.hpp"
+
+// Classification of primitive kinds shared by the semantic passes.
+
+inline bool isFloatingKind(PrimitiveTypeAST::PrimitiveKind kind) {
+    return kind == PrimitiveTypeAST::FLOAT32 || kind == PrimitiveTypeAST::FLOAT64;
+}
+
+inline bool isFractionalKind(PrimitiveTypeAST::PrimitiveKind kind) {
+    return kind == PrimitiveTypeAST::FRACTIONAL32 || kind == PrimitiveTypeAST::FRACTIONAL64;
+}
+
+inline bool isUnsignedKind(PrimitiveTypeAST::PrimitiveKind kind) {
+    return kind == PrimitiveTypeAST::UINT8 || kind == PrimitiveTypeAST::UINT16 || kind == PrimitiveTypeAST::UINT32 || kind == PrimitiveTypeAST::UINT64;
+}
+
+// Width of the LLVM integer the kind lowers to, or 0 if it is not an integer. Bools and chars
+// are integers to the arithmetic rules.
+inline unsigned getIntegerBitWidth(PrimitiveTypeAST::PrimitiveKind kind) {
+    switch (kind) {
+        case PrimitiveTypeAST::BOOL:
+            return 1;
+        case PrimitiveTypeAST::INT8:
+        case PrimitiveTypeAST::UINT8:
+        case PrimitiveTypeAST::CHAR:
+            return 8;
+        case PrimitiveTypeAST::INT16:
+        case PrimitiveTypeAST::UINT16:
+            return 16;
+        case PrimitiveTypeAST::INT32:
+        case PrimitiveTypeAST::UINT32:
+            return 32;
+        case PrimitiveTypeAST::INT64:
+        case PrimitiveTypeAST::UINT64:
+            return 64;
+        default:
+            return 0;
+    }
+}
+
+// Width of each of the numerator and denominator of a fraction kind.
+inline unsigned getFractionComponentBitWidth(PrimitiveTypeAST::PrimitiveKind kind) {
+    return kind == PrimitiveTypeAST::FRACTIONAL32 ? 16 : 32;
+}
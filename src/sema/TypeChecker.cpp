@@ -0,0 +1,308 @@
+#include <algorithm>
+
+#include "TypeChecker.hpp"
+#include "ConstantEvaluator.hpp"
+#include "PrimitiveKinds.hpp"
+
+namespace {
+
+using PrimitiveKind = PrimitiveTypeAST::PrimitiveKind;
+
+PrimitiveKind getIntegerKind(unsigned bitWidth, bool isUnsigned) {
+    switch (bitWidth) {
+        case 1:
+            return PrimitiveTypeAST::BOOL;
+        case 8:
+            return isUnsigned ? PrimitiveTypeAST::UINT8 : PrimitiveTypeAST::INT8;
+        case 16:
+            return isUnsigned ? PrimitiveTypeAST::UINT16 : PrimitiveTypeAST::INT16;
+        case 32:
+            return isUnsigned ? PrimitiveTypeAST::UINT32 : PrimitiveTypeAST::INT32;
+        case 64:
+        default:
+            return isUnsigned ? PrimitiveTypeAST::UINT64 : PrimitiveTypeAST::INT64;
+    }
+}
+
+PrimitiveKind getFloatingResultKind(PrimitiveKind left, PrimitiveKind right) {
+    return left == PrimitiveTypeAST::FLOAT64 || right == PrimitiveTypeAST::FLOAT64 ? PrimitiveTypeAST::FLOAT64 : PrimitiveTypeAST::FLOAT32;
+}
+
+std::optional<PrimitiveKind> getPrimitiveKind(const TypeAST* type) {
+    if (const auto* primitiveType = llvm::dyn_cast_or_null<PrimitiveTypeAST>(type)) {
+        return primitiveType->getKind();
+    }
+    return std::nullopt;
+}
+
+}
+
+void TypeChecker::check(ClassAST& node) {
+    for (MethodImplAST* method : node.getMethodImpls()) {
+        checkMethod(*method);
+    }
+}
+
+void TypeChecker::checkMethod(MethodImplAST& node) {
+    Variables.pushScope();
+    for (const TypedIdentifierAST* parameter : node.getParams()) {
+        Variables.declare(parameter->getName()).kind = getPrimitiveKind(parameter->getType());
+    }
+    // Clause conditions fold like any other expression, so a clause proven true here costs
+    // nothing at runtime.
+    for (ExprAST* precondition : node.getPreconditions()) {
+        checkExpr(precondition, std::nullopt);
+    }
+    for (StmtAST* statement : node.getBody()) {
+        checkStmt(statement);
+    }
+    for (ExprAST* postcondition : node.getPostconditions()) {
+        checkExpr(postcondition, std::nullopt);
+    }
+    Variables.popScope();
+}
+
+void TypeChecker::checkStmt(StmtAST* stmt) {
+    if (!stmt) {
+        return;
+    }
+
+    switch (stmt->getStmtKind()) {
+        case StmtAST::VAR_DECL:
+            checkVarDecl(llvm::cast<VarDeclStmtAST>(*stmt));
+            break;
+        case StmtAST::ASSIGNMENT: {
+            auto& assignment = llvm::cast<AssignmentStmtAST>(*stmt);
+            const Variable* variable = Variables.lookup(assignment.getName());
+            checkExpr(assignment.getValue(), variable && !variable->isArray ? variable->kind : std::nullopt);
+            break;
+        }
+        case StmtAST::IF: {
+            auto& ifStmt = llvm::cast<IfStmtAST>(*stmt);
+            checkExpr(ifStmt.getCondition(), std::nullopt);
+            checkStmt(ifStmt.getThenStmt());
+            checkStmt(ifStmt.getElseStmt());
+            break;
+        }
+        case StmtAST::WHILE: {
+            auto& whileStmt = llvm::cast<WhileStmtAST>(*stmt);
+            checkExpr(whileStmt.getCondition(), std::nullopt);
+            checkStmt(whileStmt.getBody());
+            break;
+        }
+        case StmtAST::BLOCK:
+            Variables.pushScope();
+            for (StmtAST* statement : llvm::cast<BlockStmtAST>(*stmt).getStatements()) {
+                checkStmt(statement);
+            }
+            Variables.popScope();
+            break;
+        case StmtAST::PRINT:
+            checkExpr(llvm::cast<PrintStmtAST>(*stmt).getValue(), std::nullopt);
+            break;
+        case StmtAST::INDEX_ASSIGN: {
+            auto& indexAssign = llvm::cast<IndexAssignStmtAST>(*stmt);
+            const Variable* array = Variables.lookup(indexAssign.getName());
+            if (array && array->declaration) {
+                array->declaration->setAssignedElements();
+            }
+            checkExpr(indexAssign.getIndex(), std::nullopt);
+            checkExpr(indexAssign.getValue(), array && array->isArray ? array->elementKind : std::nullopt);
+            break;
+        }
+    }
+}
+
+void TypeChecker::checkVarDecl(VarDeclStmtAST& node) {
+    if (const auto* arrayType = llvm::dyn_cast<ArrayTypeAST>(node.getType())) {
+        const Expectation elementKind = getPrimitiveKind(arrayType->getElementType());
+        if (auto* literal = llvm::dyn_cast_or_null<ArrayLiteralExprAST>(node.getInitializer())) {
+            for (ExprAST* element : literal->getElements()) {
+                checkExpr(element, elementKind);
+            }
+        } else if (auto* newExpr = llvm::dyn_cast_or_null<ArrayNewExprAST>(node.getInitializer())) {
+            checkExpr(newExpr->getSize(), PrimitiveTypeAST::INT64);
+        } else {
+            checkExpr(node.getInitializer(), std::nullopt);
+        }
+
+        Variable& variable = Variables.declare(node.getName());
+        variable.isArray = true;
+        variable.elementKind = elementKind;
+        variable.declaration = &node;
+        return;
+    }
+
+    const Expectation kind = getPrimitiveKind(node.getType());
+    checkExpr(node.getInitializer(), kind);
+    Variables.declare(node.getName()).kind = kind;
+}
+
+// The expectation is the kind of the variable or element an expression is stored into. It
+// reaches every arithmetic node of the expression, including those inside index operands.
+// Expressions whose operands are all constant are evaluated here as well.
+void TypeChecker::checkExpr(ExprAST* expr, Expectation expected) {
+    if (!expr) {
+        return;
+    }
+
+    switch (expr->getExprKind()) {
+        case ExprAST::INTEGER:
+            expr->setPrimitiveKind(PrimitiveTypeAST::INT64);
+            break;
+        case ExprAST::FLOAT:
+            expr->setPrimitiveKind(PrimitiveTypeAST::FLOAT64);
+            break;
+        case ExprAST::BOOL:
+            expr->setPrimitiveKind(PrimitiveTypeAST::BOOL);
+            break;
+        case ExprAST::CHAR:
+            expr->setPrimitiveKind(PrimitiveTypeAST::CHAR);
+            break;
+        case ExprAST::STR:
+            expr->setPrimitiveKind(PrimitiveTypeAST::STR);
+            break;
+        case ExprAST::IDENTIFIER: {
+            const Variable* variable = Variables.lookup(llvm::cast<IdentifierExprAST>(*expr).getName());
+            if (variable && !variable->isArray && variable->kind) {
+                expr->setPrimitiveKind(*variable->kind);
+            }
+            break;
+        }
+        case ExprAST::INDEX: {
+            auto& index = llvm::cast<IndexExprAST>(*expr);
+            checkExpr(index.getIndex(), expected);
+            const Variable* array = Variables.lookup(index.getName());
+            if (array && array->isArray && array->elementKind) {
+                expr->setPrimitiveKind(*array->elementKind);
+            }
+            break;
+        }
+        case ExprAST::BINARY:
+            checkBinary(llvm::cast<BinaryExprAST>(*expr), expected);
+            break;
+        case ExprAST::UNARY:
+            checkUnary(llvm::cast<UnaryExprAST>(*expr), expected);
+            break;
+        case ExprAST::ARRAY_LITERAL:
+            for (ExprAST* element : llvm::cast<ArrayLiteralExprAST>(*expr).getElements()) {
+                checkExpr(element, std::nullopt);
+            }
+            break;
+        case ExprAST::ARRAY_NEW:
+            checkExpr(llvm::cast<ArrayNewExprAST>(*expr).getSize(), std::nullopt);
+            break;
+        case ExprAST::ARRAY_LENGTH: {
+            const Variable* array = Variables.lookup(llvm::cast<ArrayLengthExprAST>(*expr).getName());
+            if (array && array->isArray) {
+                expr->setPrimitiveKind(PrimitiveTypeAST::INT64);
+            }
+            break;
+        }
+        case ExprAST::FORALL: {
+            auto& forall = llvm::cast<ForallExprAST>(*expr);
+            checkExpr(forall.getLower(), PrimitiveTypeAST::INT64);
+            checkExpr(forall.getUpper(), PrimitiveTypeAST::INT64);
+            Variables.pushScope();
+            Variables.declare(forall.getVariable()).kind = PrimitiveTypeAST::INT64;
+            checkExpr(forall.getBody(), std::nullopt);
+            Variables.popScope();
+            expr->setPrimitiveKind(PrimitiveTypeAST::BOOL);
+            break;
+        }
+    }
+
+    // Operands were checked first, so a constant subtree folds bottom-up in one walk.
+    if (const std::optional<ConstantValue> folded = evaluateConstant(*expr)) {
+        expr->setConstantValue(*folded);
+    }
+}
+
+void TypeChecker::checkBinary(BinaryExprAST& node, Expectation expected) {
+    checkExpr(node.getLHS(), expected);
+    checkExpr(node.getRHS(), expected);
+
+    const int op = node.getOp();
+    if (op == BinaryExprAST::LOGICAL_AND || op == BinaryExprAST::LOGICAL_OR) {
+        node.setPrimitiveKind(PrimitiveTypeAST::BOOL);
+        return;
+    }
+
+    if (!node.getLHS()->hasPrimitiveKind() || !node.getRHS()->hasPrimitiveKind()) {
+        return;
+    }
+
+    const PrimitiveKind left = node.getLHS()->getPrimitiveKind();
+    const PrimitiveKind right = node.getRHS()->getPrimitiveKind();
+    const unsigned leftBits = getIntegerBitWidth(left);
+    const unsigned rightBits = getIntegerBitWidth(right);
+    const bool integerOperands = leftBits != 0 && rightBits != 0;
+    const bool isUnsigned = isUnsignedKind(left) || isUnsignedKind(right);
+    const unsigned expectedBits = expected && getIntegerBitWidth(*expected) > 1 ? getIntegerBitWidth(*expected) : 0;
+    const bool expectsFraction = expected && isFractionalKind(*expected);
+
+    switch (op) {
+        case BinaryExprAST::PLUS:
+        case BinaryExprAST::MINUS:
+        case BinaryExprAST::MULTIPLY:
+        case BinaryExprAST::DIVIDE:
+            if (isFloatingKind(left) || isFloatingKind(right)) {
+                node.setOperandKind(getFloatingResultKind(left, right));
+            } else if (isFractionalKind(left) || isFractionalKind(right) || (op == BinaryExprAST::DIVIDE && expectsFraction)) {
+                const bool wide = left == PrimitiveTypeAST::FRACTIONAL64 || right == PrimitiveTypeAST::FRACTIONAL64 || expected == PrimitiveTypeAST::FRACTIONAL64;
+                node.setOperandKind(wide ? PrimitiveTypeAST::FRACTIONAL64 : PrimitiveTypeAST::FRACTIONAL32);
+            } else if (integerOperands) {
+                node.setOperandKind(getIntegerKind(std::max({leftBits, rightBits, expectedBits}), isUnsigned));
+            } else {
+                return;
+            }
+            node.setPrimitiveKind(node.getOperandKind());
+            return;
+
+        case BinaryExprAST::MODULO:
+            if (integerOperands) {
+                node.setOperandKind(getIntegerKind(std::max({leftBits, rightBits, expectedBits}), isUnsigned));
+                node.setPrimitiveKind(node.getOperandKind());
+            }
+            return;
+
+        case BinaryExprAST::LESS_THAN:
+        case BinaryExprAST::LESS_EQUAL:
+        case BinaryExprAST::GREATER_THAN:
+        case BinaryExprAST::GREATER_EQUAL:
+        case BinaryExprAST::EQUAL:
+        case BinaryExprAST::NOT_EQUAL:
+            if (isFloatingKind(left) || isFloatingKind(right)) {
+                node.setOperandKind(getFloatingResultKind(left, right));
+            } else if (isFractionalKind(left) || isFractionalKind(right)) {
+                const bool wide = left == PrimitiveTypeAST::FRACTIONAL64 || right == PrimitiveTypeAST::FRACTIONAL64;
+                node.setOperandKind(wide ? PrimitiveTypeAST::FRACTIONAL64 : PrimitiveTypeAST::FRACTIONAL32);
+            } else if (integerOperands) {
+                node.setOperandKind(getIntegerKind(std::max(leftBits, rightBits), isUnsigned));
+            } else {
+                return;
+            }
+            node.setPrimitiveKind(PrimitiveTypeAST::BOOL);
+            return;
+
+        default:
+            return;
+    }
+}
+
+void TypeChecker::checkUnary(UnaryExprAST& node, Expectation expected) {
+    checkExpr(node.getOperand(), expected);
+
+    if (node.getOp() == UnaryExprAST::LOGICAL_NOT) {
+        node.setPrimitiveKind(PrimitiveTypeAST::BOOL);
+        return;
+    }
+
+    const ExprAST* operand = node.getOperand();
+    if (operand && operand->hasPrimitiveKind()) {
+        const PrimitiveKind kind = operand->getPrimitiveKind();
+        if (isFloatingKind(kind) || getIntegerBitWidth(kind) != 0) {
+            node.setPrimitiveKind(kind);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <optional>
+
+#include "../ast/exprAST.hpp"
+#include "../ast/stmtAST.hpp"
+#include "../ast/classAST.hpp"
+#include "../ast/commonAST.hpp"
+#include "../support/ScopedSymbolTable.hpp"
+
+// Resolves the primitive kind of every expression before code generation and records it on
+// the node, together with the promoted operand kind of each binary expression. The rules
+// mirror the code generator's lowering: integer arithmetic widens to the wider operand and the
+// declared target, is unsigned if either operand is, and an integer division whose target is a
+// fraction produces a fraction.
+//
+// Array declarations record whether any of their elements is ever assigned.
+//
+// Expressions the rules cannot type are left unresolved; the code generator reports them.
+class TypeChecker {
+public:
+    void check(ClassAST& node);
+
+private:
+    struct Variable {
+        std::optional<PrimitiveTypeAST::PrimitiveKind> kind;
+        bool isArray = false;
+        std::optional<PrimitiveTypeAST::PrimitiveKind> elementKind;
+        VarDeclStmtAST* declaration = nullptr;
+    };
+
+    using Expectation = std::optional<PrimitiveTypeAST::PrimitiveKind>;
+
+    ScopedSymbolTable<Variable> Variables;
+
+    void checkMethod(MethodImplAST& node);
+    void checkStmt(StmtAST* stmt);
+    void checkVarDecl(VarDeclStmtAST& node);
+    void checkExpr(ExprAST* expr, Expectation expected);
+    void checkBinary(BinaryExprAST& node, Expectation expected);
+    void checkUnary(UnaryExprAST& node, Expectation expected);
+};
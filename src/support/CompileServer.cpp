@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <optional>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <llvm/Support/raw_ostream.h>
+
+#include "CompileServer.hpp"
+
+// A request is one sendmsg carrying the payload length and the client's stdin, stdout and
+// stderr, followed by the payload: the working directory and then each argument, every one
+// NUL-terminated. The reply is the request's 32-bit exit status, written by the server once
+// the request's process has exited, so a request that crashes still gets an answer.
+
+namespace {
+
+constexpr int ForwardedStreamCount = 3;
+
+// Request processes kept forked and idle, so a request does not wait for fork()
+constexpr size_t WarmWorkerCount = 2;
+
+// Written by the signal handlers so poll() wakes up for them.
+int signalPipe[2] = {-1, -1};
+volatile sig_atomic_t stopRequested = 0;
+
+void handleChildExit(int) {
+    const int savedErrno = errno;
+    const char byte = 0;
+    (void)!write(signalPipe[1], &byte, 1);
+    errno = savedErrno;
+}
+
+void handleStop(int signal) {
+    stopRequested = 1;
+    handleChildExit(signal);
+}
+
+bool writeAll(int descriptor, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t written = write(descriptor, bytes, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int descriptor, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const ssize_t received = read(descriptor, bytes, size);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool makeSocketAddress(const std::string& socketPath, sockaddr_un& outAddress) {
+    std::memset(&outAddress, 0, sizeof(outAddress));
+    outAddress.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(outAddress.sun_path)) {
+        std::cerr << "Error: Socket path '" << socketPath << "' is longer than " << sizeof(outAddress.sun_path) - 1 << " bytes." << std::endl;
+        return false;
+    }
+    std::memcpy(outAddress.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return true;
+}
+
+int connectTo(const sockaddr_un& address) {
+    const int descriptor = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (descriptor < 0) {
+        return -1;
+    }
+    if (connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        close(descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+// Runs in the forked request process. Installs the client's streams and working directory,
+// then hands the arguments to the handler.
+int serveRequest(int connection, const CompileRequestHandler& handler) {
+    uint32_t payloadSize = 0;
+    iovec header = {&payloadSize, sizeof(payloadSize)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * ForwardedStreamCount)];
+    msghdr message = {};
+    message.msg_iov = &header;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    // A client that only probed whether the server is up sends nothing.
+    if (received == 0) {
+        return 1;
+    }
+    const cmsghdr* streams = CMSG_FIRSTHDR(&message);
+    if (received != sizeof(payloadSize) || !streams || streams->cmsg_type != SCM_RIGHTS
+        || streams->cmsg_len != CMSG_LEN(sizeof(int) * ForwardedStreamCount)) {
+        std::cerr << "Error: Malformed compile server request." << std::endl;
+        return 1;
+    }
+
+    int clientStreams[ForwardedStreamCount];
+    std::memcpy(clientStreams, CMSG_DATA(streams), sizeof(clientStreams));
+    for (int stream = 0; stream < ForwardedStreamCount; ++stream) {
+        dup2(clientStreams[stream], stream);
+        close(clientStreams[stream]);
+    }
+
+    std::string payload(payloadSize, '\0');
+    if (!readAll(connection, payload.data(), payload.size()) || payload.empty() || payload.back() != '\0') {
+        std::cerr << "Error: Malformed compile server request." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> fields;
+    for (size_t start = 0; start < payload.size();) {
+        const size_t end = payload.find('\0', start);
+        fields.push_back(payload.substr(start, end - start));
+        start = end + 1;
+    }
+
+    if (chdir(fields.front().c_str()) != 0) {
+        std::cerr << "Error: Could not enter working directory '" << fields.front() << "': " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    return handler(std::vector<std::string>(fields.begin() + 1, fields.end()));
+}
+
+void replyWithStatus(int connection, int waitStatus) {
+    const int32_t status = WIFEXITED(waitStatus) ? WEXITSTATUS(waitStatus) : 128 + WTERMSIG(waitStatus);
+    writeAll(connection, &status, sizeof(status));
+    close(connection);
+}
+
+// Only the user running the server may submit requests; each one runs with the server's
+// privileges in a directory and with streams of the client's choosing.
+bool isOwnUser(int connection) {
+    ucred peer = {};
+    socklen_t size = sizeof(peer);
+    if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &peer, &size) != 0 || size != sizeof(peer)) {
+        return false;
+    }
+    return peer.uid == getuid();
+}
+
+// An idle request process. It was forked before its request arrived and waits on channel for
+// the server to pass it the request's connection.
+struct WarmWorker {
+    pid_t pid;
+    int channel;
+};
+
+bool sendConnection(int channel, int connection) {
+    char byte = 0;
+    iovec data = {&byte, sizeof(byte)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message = {};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* descriptor = CMSG_FIRSTHDR(&message);
+    descriptor->cmsg_level = SOL_SOCKET;
+    descriptor->cmsg_type = SCM_RIGHTS;
+    descriptor->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(descriptor), &connection, sizeof(connection));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(channel, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    return sent == sizeof(byte);
+}
+
+// Returns the connection the server passed on channel, or -1 once the server closes it.
+int receiveConnection(int channel) {
+    char byte = 0;
+    iovec data = {&byte, sizeof(byte)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr message = {};
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(channel, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    const cmsghdr* descriptor = CMSG_FIRSTHDR(&message);
+    if (received != sizeof(byte) || !descriptor || descriptor->cmsg_type != SCM_RIGHTS || descriptor->cmsg_len != CMSG_LEN(sizeof(int))) {
+        return -1;
+    }
+    int connection;
+    std::memcpy(&connection, CMSG_DATA(descriptor), sizeof(connection));
+    return connection;
+}
+
+void flushOutput() {
+    std::cout.flush();
+    std::cerr.flush();
+    llvm::outs().flush();
+    llvm::errs().flush();
+    std::fflush(nullptr);
+}
+
+class RequestServer {
+    public:
+        RequestServer(int listener, const CompileRequestHandler& handler) : listener(listener), handler(handler) {}
+
+        void serve();
+
+        // Ends every request process. Running requests are answered with the status they
+        // were killed with, so no client is left without a reply.
+        void shutDown();
+
+    private:
+        // Forks request processes until WarmWorkerCount are idle.
+        void refillWarmWorkers();
+        std::optional<WarmWorker> forkWarmWorker();
+        void dispatch(int connection);
+        void reapFinished();
+
+        int listener;
+        const CompileRequestHandler& handler;
+        std::deque<WarmWorker> warmWorkers;
+        // Connections of requests still running, by the pid of their process
+        std::map<pid_t, int> runningRequests;
+};
+
+std::optional<WarmWorker> RequestServer::forkWarmWorker() {
+    int channel[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, channel) != 0) {
+        std::cerr << "Error: Could not create compile request channel: " << std::strerror(errno) << std::endl;
+        return std::nullopt;
+    }
+
+    // Buffered output would otherwise be written once more by the child.
+    flushOutput();
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+        close(listener);
+        close(signalPipe[0]);
+        close(signalPipe[1]);
+        close(channel[0]);
+        for (const WarmWorker& worker : warmWorkers) {
+            close(worker.channel);
+        }
+        for (const auto& [otherPid, otherConnection] : runningRequests) {
+            close(otherConnection);
+        }
+        signal(SIGCHLD, SIG_DFL);
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGPIPE, SIG_DFL);
+
+        const int connection = receiveConnection(channel[1]);
+        close(channel[1]);
+        // The server shut down before a request arrived.
+        if (connection < 0) {
+            _exit(0);
+        }
+        const int status = serveRequest(connection, handler);
+        flushOutput();
+        _exit(status);
+    }
+
+    close(channel[1]);
+    if (pid < 0) {
+        std::cerr << "Error: Could not fork compile request: " << std::strerror(errno) << std::endl;
+        close(channel[0]);
+        return std::nullopt;
+    }
+    return WarmWorker{pid, channel[0]};
+}
+
+void RequestServer::refillWarmWorkers() {
+    while (warmWorkers.size() < WarmWorkerCount) {
+        std::optional<WarmWorker> worker = forkWarmWorker();
+        if (!worker) {
+            return;
+        }
+        warmWorkers.push_back(*worker);
+    }
+}
+
+void RequestServer::dispatch(int connection) {
+    if (warmWorkers.empty()) {
+        if (std::optional<WarmWorker> worker = forkWarmWorker()) {
+            warmWorkers.push_back(*worker);
+        }
+    }
+    if (warmWorkers.empty()) {
+        replyWithStatus(connection, 1 << 8);
+        return;
+    }
+
+    const WarmWorker worker = warmWorkers.front();
+    warmWorkers.pop_front();
+    const bool sent = sendConnection(worker.channel, connection);
+    close(worker.channel);
+    if (!sent) {
+        // The worker is gone; reapFinished collects it.
+        replyWithStatus(connection, 1 << 8);
+        return;
+    }
+    runningRequests[worker.pid] = connection;
+}
+
+void RequestServer::reapFinished() {
+    int waitStatus = 0;
+    pid_t finished;
+    while ((finished = waitpid(-1, &waitStatus, WNOHANG)) > 0) {
+        auto request = runningRequests.find(finished);
+        if (request != runningRequests.end()) {
+            replyWithStatus(request->second, waitStatus);
+            runningRequests.erase(request);
+            continue;
+        }
+        // A worker that died while idle is replaced by the next refill.
+        auto worker = std::find_if(warmWorkers.begin(), warmWorkers.end(), [finished](const WarmWorker& candidate) {
+            return candidate.pid == finished;
+        });
+        if (worker != warmWorkers.end()) {
+            close(worker->channel);
+            warmWorkers.erase(worker);
+        }
+    }
+}
+
+void RequestServer::serve() {
+    refillWarmWorkers();
+    while (!stopRequested) {
+        pollfd events[2] = {{listener, POLLIN, 0}, {signalPipe[0], POLLIN, 0}};
+        if (poll(events, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: Compile server poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (events[1].revents & POLLIN) {
+            char drained[64];
+            while (read(signalPipe[0], drained, sizeof(drained)) > 0) {
+            }
+            reapFinished();
+        }
+
+        if (events[0].revents & POLLIN) {
+            const int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (connection >= 0 && !isOwnUser(connection)) {
+                std::cerr << "Error: Rejected a compile request from another user." << std::endl;
+                close(connection);
+            } else if (connection >= 0) {
+                dispatch(connection);
+            }
+        }
+
+        if (!stopRequested) {
+            refillWarmWorkers();
+        }
+    }
+}
+
+void RequestServer::shutDown() {
+    for (const WarmWorker& worker : warmWorkers) {
+        close(worker.channel);
+    }
+    for (const auto& [pid, connection] : runningRequests) {
+        kill(pid, SIGTERM);
+    }
+
+    int waitStatus = 0;
+    pid_t finished;
+    while ((finished = waitpid(-1, &waitStatus, 0)) > 0 || (finished < 0 && errno == EINTR)) {
+        auto request = runningRequests.find(finished);
+        if (request != runningRequests.end()) {
+            replyWithStatus(request->second, waitStatus);
+            runningRequests.erase(request);
+        }
+    }
+    warmWorkers.clear();
+}
+
+}
+
+int runCompileServer(const std::string& socketPath, const CompileRequestHandler& handler) {
+    sockaddr_un address;
+    if (!makeSocketAddress(socketPath, address)) {
+        return 1;
+    }
+
+    // A socket file nobody accepts on is left over from a server that did not shut down.
+    const int existing = connectTo(address);
+    if (existing >= 0) {
+        close(existing);
+        std::cerr << "Error: A compile server is already listening on '" << socketPath << "'." << std::endl;
+        return 1;
+    }
+    unlink(socketPath.c_str());
+
+    // The socket is created accessible to its owner only; the peer check in serve() also
+    // covers a socket in a directory others can reach.
+    const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const mode_t previousMask = umask(0077);
+    const bool bound = listener >= 0 && bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+    umask(previousMask);
+    if (!bound || chmod(socketPath.c_str(), 0600) != 0 || listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Error: Could not listen on '" << socketPath << "': " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    if (pipe2(signalPipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        std::cerr << "Error: Could not create compile server signal pipe: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    struct sigaction childAction = {};
+    childAction.sa_handler = handleChildExit;
+    childAction.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &childAction, nullptr);
+    struct sigaction stopAction = {};
+    stopAction.sa_handler = handleStop;
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+    // A client that disconnects early must not take the server down with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    RequestServer server(listener, handler);
+    server.serve();
+
+    // New clients fall back to compiling in-process while the running requests end.
+    close(listener);
+    unlink(socketPath.c_str());
+    server.shutDown();
+    return 0;
+}
+
+std::optional<int> forwardToCompileServer(const std::string& socketPath, const std::vector<std::string>& arguments) {
+    sockaddr_un address;
+    if (!makeSocketAddress(socketPath, address)) {
+        return std::nullopt;
+    }
+
+    const int connection = connectTo(address);
+    if (connection < 0) {
+        return std::nullopt;
+    }
+
+    std::string payload;
+    char* workingDirectory = getcwd(nullptr, 0);
+    if (workingDirectory) {
+        payload += workingDirectory;
+        std::free(workingDirectory);
+    }
+    payload += '\0';
+    for (const std::string& argument : arguments) {
+        payload += argument;
+        payload += '\0';
+    }
+
+    uint32_t payloadSize = static_cast<uint32_t>(payload.size());
+    iovec header = {&payloadSize, sizeof(payloadSize)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * ForwardedStreamCount)] = {};
+    msghdr message = {};
+    message.msg_iov = &header;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* streams = CMSG_FIRSTHDR(&message);
+    streams->cmsg_level = SOL_SOCKET;
+    streams->cmsg_type = SCM_RIGHTS;
+    streams->cmsg_len = CMSG_LEN(sizeof(int) * ForwardedStreamCount);
+    const int forwardedStreams[ForwardedStreamCount] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+    std::memcpy(CMSG_DATA(streams), forwardedStreams, sizeof(forwardedStreams));
+
+    signal(SIGPIPE, SIG_IGN);
+    int32_t status = 1;
+    ssize_t sent;
+    do {
+        sent = sendmsg(connection, &message, 0);
+    } while (sent < 0 && errno == EINTR);
+    if (sent != sizeof(payloadSize) || !writeAll(connection, payload.data(), payload.size()) || !readAll(connection, &status, sizeof(status))) {
+        std::cerr << "Error: Compile server on '" << socketPath << "' closed the connection before reporting a result." << std::endl;
+        status = 1;
+    }
+    close(connection);
+    return status;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Runs one compilation for the given command-line arguments (without the program name) and
+// returns its exit status.
+using CompileRequestHandler = std::function<int(const std::vector<std::string>& arguments)>;
+
+// Serves compile requests for --server on a Unix domain socket until SIGINT or SIGTERM.
+//
+// Every request is handled in a process forked from the server, so it starts with whatever
+// the server initialized before calling this (registered targets, loaded libraries, opened
+// interface files and LLVM's option registry) and pays none of it again. A few of these
+// processes are kept forked and idle, and an accepted connection is passed to one of them, so
+// a request does not wait for fork() either. A forked request also cannot disturb the server
+// or other requests: it gets the client's working directory and standard streams, and a
+// program that crashes under --run only ends its own process. Requests run concurrently.
+//
+// The socket is only accessible to the server's user, and connections from other users are
+// rejected. When the server is stopped, requests still running are killed and their clients
+// get the resulting status.
+//
+// Returns the server's exit status; failing to create the socket is reported and returns 1.
+int runCompileServer(const std::string& socketPath, const CompileRequestHandler& handler);
+
+// Sends arguments, the working directory and this process's standard streams to the server
+// listening on socketPath and waits for the request to finish. Returns its exit status, or
+// nullopt if no server accepts connections on socketPath.
+std::optional<int> forwardToCompileServer(const std::string& socketPath, const std::vector<std::string>& arguments);
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <iostream>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include "InterfaceFile.hpp"
+
+namespace {
+
+constexpr llvm::StringLiteral Magic = "BPIF";
+
+// Bump when the layout changes; readers reject any other version.
+constexpr uint32_t FormatVersion = 1;
+
+constexpr size_t HeaderSize = 16;
+constexpr size_t IndexEntrySize = 12;
+
+InterfaceType describeType(const TypeAST* type) {
+    InterfaceType description;
+    while (const auto* arrayType = llvm::dyn_cast_or_null<ArrayTypeAST>(type)) {
+        description.arrayRank++;
+        type = arrayType->getElementType();
+    }
+    if (const auto* primitiveType = llvm::dyn_cast_or_null<PrimitiveTypeAST>(type)) {
+        description.kind = primitiveType->getKind();
+    }
+    return description;
+}
+
+uint32_t encodeType(const InterfaceType& type) {
+    return type.arrayRank << 8 | static_cast<uint32_t>(type.kind);
+}
+
+void appendU32(std::string& out, uint32_t value) {
+    char bytes[4];
+    llvm::support::endian::write32le(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+// Strings are stored once however many records reference them.
+class StringTableBuilder {
+    public:
+        void append(std::string& out, llvm::StringRef text) {
+            auto inserted = offsets.try_emplace(text, static_cast<uint32_t>(data.size()));
+            if (inserted.second) {
+                data += text;
+            }
+            appendU32(out, inserted.first->second);
+            appendU32(out, static_cast<uint32_t>(text.size()));
+        }
+
+        const std::string& getData() const { return data; }
+
+    private:
+        llvm::StringMap<uint32_t> offsets;
+        std::string data;
+};
+
+// Bounds-checked reads from one record. Every read fails once any read has failed, so a
+// caller can check the result of a whole sequence at the end.
+class RecordReader {
+    public:
+        RecordReader(llvm::StringRef file, size_t offset, llvm::StringRef strings)
+            : file(file), offset(offset), strings(strings) {}
+
+        bool readU32(uint32_t& out) {
+            if (failed || offset > file.size() || file.size() - offset < 4) {
+                failed = true;
+                return false;
+            }
+            out = llvm::support::endian::read32le(file.data() + offset);
+            offset += 4;
+            return true;
+        }
+
+        bool readString(std::string& out) {
+            uint32_t stringOffset = 0;
+            uint32_t length = 0;
+            if (!readU32(stringOffset) || !readU32(length)) {
+                return false;
+            }
+            if (stringOffset > strings.size() || strings.size() - stringOffset < length) {
+                failed = true;
+                return false;
+            }
+            out = strings.substr(stringOffset, length).str();
+            return true;
+        }
+
+        bool readType(InterfaceType& out) {
+            uint32_t code = 0;
+            if (!readU32(code)) {
+                return false;
+            }
+            if ((code & 0xff) > PrimitiveTypeAST::VOID) {
+                failed = true;
+                return false;
+            }
+            out.kind = static_cast<PrimitiveTypeAST::PrimitiveKind>(code & 0xff);
+            out.arrayRank = code >> 8;
+            return true;
+        }
+
+        bool hasFailed() const { return failed; }
+
+    private:
+        llvm::StringRef file;
+        size_t offset;
+        llvm::StringRef strings;
+        bool failed = false;
+};
+
+}
+
+ClassInterface describeClass(const ClassAST& node) {
+    ClassInterface description;
+    description.name = node.getName();
+    for (const Identifier& blueprint : node.getBlueprintNames()) {
+        description.blueprints.push_back(blueprint.str());
+    }
+    for (const MethodImplAST* method : node.getMethodImpls()) {
+        MethodInterface& methodDescription = description.methods.emplace_back();
+        methodDescription.name = method->getName();
+        methodDescription.symbol = node.getMethodSymbolName(*method);
+        methodDescription.returnType = describeType(method->getReturnType());
+        for (const TypedIdentifierAST* parameter : method->getParams()) {
+            methodDescription.parameters.push_back({parameter->getName(), describeType(parameter->getType())});
+        }
+    }
+    return description;
+}
+
+std::string formatInterfaceType(const InterfaceType& type) {
+    static constexpr const char* primitiveNames[] = {
+        "i8", "i16", "i32", "i64", "u8", "u16", "u32", "u64", "f32", "f64", "fr32", "fr64", "bool", "char", "str", "void",
+    };
+    std::string text = primitiveNames[type.kind];
+    for (unsigned rank = 0; rank < type.arrayRank; ++rank) {
+        text += "[]";
+    }
+    return text;
+}
+
+bool InterfaceFile::write(const std::vector<ClassInterface>& classes, const std::string& outputPath) {
+    std::vector<const ClassInterface*> sorted;
+    for (const ClassInterface& description : classes) {
+        sorted.push_back(&description);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const ClassInterface* lhs, const ClassInterface* rhs) {
+        return lhs->name < rhs->name;
+    });
+    const auto duplicate = std::adjacent_find(sorted.begin(), sorted.end(), [](const ClassInterface* lhs, const ClassInterface* rhs) {
+        return lhs->name == rhs->name;
+    });
+    if (duplicate != sorted.end()) {
+        std::cerr << "Error: Class '" << (*duplicate)->name << "' is defined more than once; cannot write interface '" << outputPath << "'." << std::endl;
+        return false;
+    }
+
+    const size_t recordsOffset = HeaderSize + sorted.size() * IndexEntrySize;
+    StringTableBuilder strings;
+    std::string index;
+    std::string records;
+    for (const ClassInterface* description : sorted) {
+        strings.append(index, description->name);
+        appendU32(index, static_cast<uint32_t>(recordsOffset + records.size()));
+
+        appendU32(records, static_cast<uint32_t>(description->blueprints.size()));
+        for (const std::string& blueprint : description->blueprints) {
+            strings.append(records, blueprint);
+        }
+        appendU32(records, static_cast<uint32_t>(description->methods.size()));
+        for (const MethodInterface& method : description->methods) {
+            strings.append(records, method.name);
+            strings.append(records, method.symbol);
+            appendU32(records, encodeType(method.returnType));
+            appendU32(records, static_cast<uint32_t>(method.parameters.size()));
+            for (const ParameterInterface& parameter : method.parameters) {
+                strings.append(records, parameter.name);
+                appendU32(records, encodeType(parameter.type));
+            }
+        }
+    }
+
+    std::string header(Magic);
+    appendU32(header, FormatVersion);
+    appendU32(header, static_cast<uint32_t>(sorted.size()));
+    appendU32(header, static_cast<uint32_t>(recordsOffset + records.size()));
+
+    // Write next to the target and rename it into place, so a failed write never leaves a
+    // truncated interface behind for a later compilation to import.
+    const std::string model = outputPath + ".tmp-%%%%%%%%";
+    int temporaryFD = -1;
+    llvm::SmallString<256> temporaryPath;
+    if (const std::error_code errorCode = llvm::sys::fs::createUniqueFile(model, temporaryFD, temporaryPath)) {
+        std::cerr << "Error: Could not open interface output file '" << outputPath << "': " << errorCode.message() << std::endl;
+        return false;
+    }
+
+    llvm::raw_fd_ostream outFile(temporaryFD, /*shouldClose=*/true);
+    outFile << header << index << records << strings.getData();
+    outFile.close();
+    if (outFile.has_error()) {
+        std::cerr << "Error: Could not write interface output file '" << outputPath << "': " << outFile.error().message() << std::endl;
+        outFile.clear_error();
+        llvm::sys::fs::remove(temporaryPath);
+        return false;
+    }
+
+    if (const std::error_code errorCode = llvm::sys::fs::rename(temporaryPath, outputPath)) {
+        std::cerr << "Error: Could not replace interface output file '" << outputPath << "': " << errorCode.message() << std::endl;
+        llvm::sys::fs::remove(temporaryPath);
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<InterfaceFile> InterfaceFile::open(const std::string& path) {
+    std::string error;
+    std::unique_ptr<InterfaceFile> file = open(path, error);
+    if (!file) {
+        std::cerr << "Error: " << error << std::endl;
+    }
+    return file;
+}
+
+std::unique_ptr<InterfaceFile> InterfaceFile::open(const std::string& path, std::string& error) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        error = "Could not open interface file '" + path + "': " + buffer.getError().message();
+        return nullptr;
+    }
+
+    const llvm::StringRef data = (*buffer)->getBuffer();
+    if (data.size() < HeaderSize || !data.starts_with(Magic)
+        || llvm::support::endian::read32le(data.data() + 4) != FormatVersion) {
+        error = "'" + path + "' is not a BluePrint interface file of version " + std::to_string(FormatVersion) + ".";
+        return nullptr;
+    }
+
+    std::unique_ptr<InterfaceFile> file(new InterfaceFile(std::move(*buffer)));
+    file->classCount = llvm::support::endian::read32le(data.data() + 8);
+    file->stringTableOffset = llvm::support::endian::read32le(data.data() + 12);
+    if (file->stringTableOffset > data.size() || file->classCount > (file->stringTableOffset - HeaderSize) / IndexEntrySize) {
+        error = "Interface file '" + path + "' is truncated or corrupt.";
+        return nullptr;
+    }
+    return file;
+}
+
+llvm::StringRef InterfaceFile::getClassName(size_t index) const {
+    const llvm::StringRef data = buffer->getBuffer();
+    const llvm::StringRef strings = data.substr(stringTableOffset);
+    const char* entry = data.data() + HeaderSize + index * IndexEntrySize;
+    const uint32_t nameOffset = llvm::support::endian::read32le(entry);
+    const uint32_t nameLength = llvm::support::endian::read32le(entry + 4);
+    if (nameOffset > strings.size() || strings.size() - nameOffset < nameLength) {
+        return {};
+    }
+    return strings.substr(nameOffset, nameLength);
+}
+
+std::optional<ClassInterface> InterfaceFile::lookup(llvm::StringRef className) const {
+    size_t low = 0;
+    size_t high = classCount;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const int order = getClassName(middle).compare(className);
+        if (order == 0) {
+            low = middle;
+            break;
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low >= classCount || getClassName(low) != className) {
+        return std::nullopt;
+    }
+
+    const llvm::StringRef data = buffer->getBuffer();
+    const uint32_t recordOffset = llvm::support::endian::read32le(data.data() + HeaderSize + low * IndexEntrySize + 8);
+    RecordReader reader(data.substr(0, stringTableOffset), recordOffset, data.substr(stringTableOffset));
+
+    ClassInterface description;
+    description.name = className.str();
+    uint32_t blueprintCount = 0;
+    reader.readU32(blueprintCount);
+    for (uint32_t blueprintIndex = 0; blueprintIndex < blueprintCount && !reader.hasFailed(); ++blueprintIndex) {
+        reader.readString(description.blueprints.emplace_back());
+    }
+
+    uint32_t methodCount = 0;
+    reader.readU32(methodCount);
+    for (uint32_t methodIndex = 0; methodIndex < methodCount && !reader.hasFailed(); ++methodIndex) {
+        MethodInterface& method = description.methods.emplace_back();
+        uint32_t parameterCount = 0;
+        reader.readString(method.name);
+        reader.readString(method.symbol);
+        reader.readType(method.returnType);
+        reader.readU32(parameterCount);
+        for (uint32_t parameterIndex = 0; parameterIndex < parameterCount && !reader.hasFailed(); ++parameterIndex) {
+            ParameterInterface& parameter = method.parameters.emplace_back();
+            reader.readString(parameter.name);
+            reader.readType(parameter.type);
+        }
+    }
+
+    if (reader.hasFailed()) {
+        return std::nullopt;
+    }
+    return description;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include "../ast/classAST.hpp"
+
+// The public surface of a compiled class: the blueprints it implements and, for each method,
+// the LLVM symbol it lowers to and its signature. This is what an importer needs to reference
+// a class without reparsing its source.
+struct InterfaceType {
+    PrimitiveTypeAST::PrimitiveKind kind = PrimitiveTypeAST::VOID;
+    // Number of array levels around the primitive element
+    unsigned arrayRank = 0;
+};
+
+struct ParameterInterface {
+    std::string name;
+    InterfaceType type;
+};
+
+struct MethodInterface {
+    std::string name;
+    std::string symbol;
+    InterfaceType returnType;
+    std::vector<ParameterInterface> parameters;
+};
+
+struct ClassInterface {
+    std::string name;
+    std::vector<std::string> blueprints;
+    std::vector<MethodInterface> methods;
+};
+
+ClassInterface describeClass(const ClassAST& node);
+
+// Source spelling of a type, e.g. "i32[]"
+std::string formatInterfaceType(const InterfaceType& type);
+
+// Binary interface file written by --emit-interface. The file is memory-mapped when it is
+// opened and only its header is read; lookup() binary-searches the symbol index and decodes
+// just the requested class, so the cost of an import does not grow with the size of the
+// bundle it comes from.
+//
+// All integers are 32-bit little-endian and offsets are from the start of the file. Strings
+// are (offset, length) references into a deduplicated string table, with offsets relative to
+// the table.
+//
+//   header        "BPIF", version, class count, string table offset
+//   symbol index  per class, sorted by name: name offset, name length, record offset
+//   records       blueprint count, blueprint names,
+//                 method count, per method: name, symbol, return type, parameter count,
+//                 per parameter: name, type
+//   string table
+//
+// A type is encoded as (array rank << 8) | primitive kind.
+class InterfaceFile {
+    public:
+        // Serializes classes to outputPath. Returns false and reports the error if the file
+        // cannot be written or two classes share a name.
+        static bool write(const std::vector<ClassInterface>& classes, const std::string& outputPath);
+
+        // Maps path and validates its header and symbol index. Returns nullptr and reports
+        // the error if the file is missing or malformed.
+        static std::unique_ptr<InterfaceFile> open(const std::string& path);
+        // As open(path), but leaves the error in error instead of reporting it, for callers
+        // that treat an unreadable file as something other than a failure.
+        static std::unique_ptr<InterfaceFile> open(const std::string& path, std::string& error);
+
+        // Decodes one class, or returns nullopt if the file does not define it or its record
+        // is malformed.
+        std::optional<ClassInterface> lookup(llvm::StringRef className) const;
+
+        size_t getClassCount() const { return classCount; }
+        // Name of the index'th class in symbol index (name) order
+        llvm::StringRef getClassName(size_t index) const;
+
+        // The whole file, as hashed into --cache-dir keys
+        llvm::StringRef getContents() const { return buffer->getBuffer(); }
+
+    private:
+        explicit InterfaceFile(std::unique_ptr<llvm::MemoryBuffer> buffer) : buffer(std::move(buffer)) {}
+
+        std::unique_ptr<llvm::MemoryBuffer> buffer;
+        uint32_t classCount = 0;
+        uint32_t stringTableOffset = 0;
+};
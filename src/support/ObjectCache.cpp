@@ -0,0 +1,83 @@
+#include <iostream>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA256.h>
+
+#include "ObjectCache.hpp"
+
+namespace {
+
+// Bump when the entry format or the key material changes.
+constexpr const char* CacheFormatVersion = "bp-object-cache-v2";
+
+// pruneCache only considers files carrying this prefix.
+constexpr const char* EntryPrefix = "llvmcache-bp-";
+
+}
+
+bool ObjectCache::initialize() {
+    if (std::error_code errorCode = llvm::sys::fs::create_directories(directory)) {
+        std::cerr << "Error: Could not create cache directory '" << directory << "': " << errorCode.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string ObjectCache::computeKey(llvm::StringRef source, llvm::StringRef configuration) {
+    llvm::SHA256 hasher;
+    hasher.update(CacheFormatVersion);
+    // Length-prefix each part so no two (configuration, source) pairs hash the same bytes.
+    hasher.update(std::to_string(configuration.size()));
+    hasher.update(":");
+    hasher.update(configuration);
+    hasher.update(std::to_string(source.size()));
+    hasher.update(":");
+    hasher.update(source);
+    return llvm::toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+std::string ObjectCache::computeDigest(llvm::StringRef contents) {
+    return llvm::toHex(llvm::SHA256::hash(llvm::arrayRefFromStringRef(contents)), /*LowerCase=*/true);
+}
+
+std::string ObjectCache::getEntryPath(const std::string& key, Entry entry) const {
+    llvm::SmallString<256> path(directory);
+    llvm::sys::path::append(path, EntryPrefix + key + (entry == Entry::Object ? ".o" : ".bpi"));
+    return std::string(path);
+}
+
+bool ObjectCache::fetch(const std::string& key, const std::string& outputPath, Entry entry) const {
+    const std::string entryPath = getEntryPath(key, entry);
+    if (!llvm::sys::fs::exists(entryPath)) {
+        return false;
+    }
+    return !llvm::sys::fs::copy_file(entryPath, outputPath);
+}
+
+void ObjectCache::store(const std::string& key, const std::string& inputPath, Entry entry) const {
+    // Copy to a unique name first and rename it into place, so a concurrent reader never
+    // sees a partially written entry.
+    llvm::SmallString<256> model(directory);
+    llvm::sys::path::append(model, "tmp-%%%%%%%%");
+
+    int temporaryFD = -1;
+    llvm::SmallString<256> temporaryPath;
+    if (llvm::sys::fs::createUniqueFile(model, temporaryFD, temporaryPath)) {
+        return;
+    }
+
+    const std::error_code copyError = llvm::sys::fs::copy_file(inputPath, temporaryFD);
+    llvm::sys::Process::SafelyCloseFileDescriptor(temporaryFD);
+    if (copyError || llvm::sys::fs::rename(temporaryPath, getEntryPath(key, entry))) {
+        llvm::sys::fs::remove(temporaryPath);
+    }
+}
+
+void ObjectCache::prune() const {
+    llvm::pruneCache(directory, llvm::CachePruningPolicy());
+}
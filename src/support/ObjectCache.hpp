@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include <llvm/ADT/StringRef.h>
+
+// On-disk cache of emitted object files for --cache-dir, keyed by a SHA-256 of a unit's
+// source bytes and everything else that can change its object (compiler build, target,
+// optimization and code generation options). Under --emit-interface a unit's interface
+// records are cached next to its object under the same key. Entries are written atomically,
+// so several compiler processes may share one directory. Cache failures never fail a
+// compilation; they only cost a rebuild.
+class ObjectCache {
+    public:
+        enum class Entry { Object, Interface };
+
+        explicit ObjectCache(std::string directory) : directory(std::move(directory)) {}
+
+        // Creates the cache directory. Returns false and reports the error if that fails.
+        bool initialize();
+
+        static std::string computeKey(llvm::StringRef source, llvm::StringRef configuration);
+
+        // Hex SHA-256 of contents, for files such as imported interfaces that are part of a
+        // unit's configuration.
+        static std::string computeDigest(llvm::StringRef contents);
+
+        // Copies the cached entry for key to outputPath. Returns false on a miss.
+        bool fetch(const std::string& key, const std::string& outputPath, Entry entry = Entry::Object) const;
+
+        // Adds inputPath to the cache under key.
+        void store(const std::string& key, const std::string& inputPath, Entry entry = Entry::Object) const;
+
+        // Removes old entries with LLVM's default cache pruning policy.
+        void prune() const;
+
+        const std::string& getDirectory() const { return directory; }
+
+    private:
+        std::string getEntryPath(const std::string& key, Entry entry) const;
+
+        std::string directory;
+};
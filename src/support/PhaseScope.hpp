@@ -0,0 +1,44 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/Timer.h>
+
+// Times one compiler phase for --time-passes and records it in the --time-trace profile.
+// Both are no-ops unless the corresponding flag enabled them. The detail (a class or method
+// name, a file path) is attached to the trace event and becomes part of the timer name.
+//
+// Timers in one group must not nest, or the group's total counts the nested time twice.
+// Top-level phases report to the phase group, per-method code generation to its own group,
+// and scopes that enclose other timed scopes are recorded in the trace only.
+class PhaseScope {
+    public:
+        enum class Report {
+            Phase,          // Top-level compiler phase
+            CodeGenDetail,  // Code generation of one method
+            TraceOnly,      // Encloses other timed scopes
+        };
+
+        explicit PhaseScope(llvm::StringRef name, llvm::StringRef detail = "", Report report = Report::Phase)
+            : traceScope(name, detail) {
+            if (llvm::TimePassesIsEnabled && report != Report::TraceOnly) {
+                const std::string timerName = detail.empty() ? name.str() : (name + " " + detail).str();
+                if (report == Report::Phase) {
+                    timer.emplace(timerName, timerName, "bp-phases", "BluePrint compiler phases");
+                } else {
+                    timer.emplace(timerName, timerName, "bp-codegen", "BluePrint code generation by method");
+                }
+            }
+        }
+
+        PhaseScope(const PhaseScope&) = delete;
+        PhaseScope& operator=(const PhaseScope&) = delete;
+
+    private:
+        llvm::TimeTraceScope traceScope;
+        std::optional<llvm::NamedRegionTimer> timer;
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/StringRef.h>
+
+// Lexically scoped symbol table. Declarations are kept on one stack and each name maps to its
+// innermost declaration, so lookups are a single hash probe and popScope only unwinds the
+// declarations made since the matching pushScope.
+//
+// Names are not copied: callers declare them straight from the AST, whose ASTContext interns
+// them and outlives every pass over the unit.
+template <typename EntryT>
+class ScopedSymbolTable {
+    public:
+        void pushScope() { scopeStarts.push_back(declarations.size()); }
+
+        void popScope() {
+            const size_t start = scopeStarts.back();
+            scopeStarts.pop_back();
+            while (declarations.size() > start) {
+                const Declaration& declaration = declarations.back();
+                if (declaration.shadowed == NoDeclaration) {
+                    visible.erase(declaration.name);
+                } else {
+                    visible[declaration.name] = declaration.shadowed;
+                }
+                declarations.pop_back();
+            }
+        }
+
+        // Redeclaring a name in the same scope replaces the earlier entry. The returned
+        // reference is invalidated by the next declare.
+        EntryT& declare(llvm::StringRef name) {
+            const unsigned index = static_cast<unsigned>(declarations.size());
+            unsigned shadowed = NoDeclaration;
+            auto inserted = visible.try_emplace(name, index);
+            if (!inserted.second) {
+                unsigned& current = inserted.first->second;
+                if (current >= currentScopeStart()) {
+                    declarations[current].entry = EntryT();
+                    return declarations[current].entry;
+                }
+                shadowed = current;
+                current = index;
+            }
+            declarations.push_back({name, shadowed, EntryT()});
+            return declarations.back().entry;
+        }
+
+        EntryT* lookup(llvm::StringRef name) {
+            auto it = visible.find(name);
+            return it == visible.end() ? nullptr : &declarations[it->second].entry;
+        }
+
+        const EntryT* lookup(llvm::StringRef name) const {
+            auto it = visible.find(name);
+            return it == visible.end() ? nullptr : &declarations[it->second].entry;
+        }
+
+    private:
+        static constexpr unsigned NoDeclaration = ~0u;
+
+        struct Declaration {
+            llvm::StringRef name;
+            unsigned shadowed;  // Index of the outer declaration this one hides
+            EntryT entry;
+        };
+
+        size_t currentScopeStart() const { return scopeStarts.empty() ? 0 : scopeStarts.back(); }
+
+        std::vector<Declaration> declarations;
+        std::vector<size_t> scopeStarts;
+        llvm::DenseMap<llvm::StringRef, unsigned> visible;
+};
@@ -0,0 +1,48 @@
+# Emits the IR of bounds_length.bp and checks that its loops, bounded by the length of the
+# array they index, carry no bounds checks. add_blueprint_script_test in test/CMakeLists.txt
+# invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCE_DIR=<test> -DWORK_DIR=<dir> -P bounds_hoisting.cmake
+#
+# Without optimization every check that is emitted survives into the IR, so a check that the
+# proof failed to remove shows up as an `a.oob` compare or a `while.checked` copy of the loop.
+
+foreach(variable COMPILER SOURCE_DIR WORK_DIR)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "bounds_hoisting.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY_FILE "${SOURCE_DIR}/bounds_length.bp" "${WORK_DIR}/bounds_length.bp")
+
+# run(<command>...) runs a command in WORK_DIR and fails the test if it fails.
+function(run)
+    execute_process(
+        COMMAND ${ARGN}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "'${ARGN}' failed (${result}):\n${output}${errors}")
+    endif()
+endfunction()
+
+run("${COMPILER}" -O0 --emit-ir hoisted.ll bounds_length.bp)
+file(READ "${WORK_DIR}/hoisted.ll" hoisted)
+foreach(check "bounds.trap" "a.oob" "while.checked")
+    string(FIND "${hoisted}" "${check}" found)
+    if (NOT found EQUAL -1)
+        message(FATAL_ERROR "Loops bounded by a.length still contain ${check}:\n${hoisted}")
+    endif()
+endforeach()
+
+# The same accesses are checked when hoisting is turned off, so the absence above is the proof's.
+run("${COMPILER}" -O0 --bounds-checks=on --emit-ir checked.ll bounds_length.bp)
+file(READ "${WORK_DIR}/checked.ll" checked)
+string(FIND "${checked}" "a.oob" found)
+if (found EQUAL -1)
+    message(FATAL_ERROR "--bounds-checks=on emitted no check on a:\n${checked}")
+endif()
@@ -0,0 +1,133 @@
+# Compiles a library and an application importing its interface several times into one
+# --cache-dir and checks which compilations reuse cached objects. add_blueprint_script_test in
+# test/CMakeLists.txt invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCE_DIR=<test> -DWORK_DIR=<dir> -P cache.cmake
+#
+# A hit is recognized by the "Reused cached object for <source>" line of --verbose. The
+# library's interface is cached with its object, so a hit must reproduce the same file, and
+# the application is keyed on the contents of that interface rather than the library's source.
+
+foreach(variable COMPILER SOURCE_DIR WORK_DIR)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "cache.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}/cache")
+file(COPY_FILE "${SOURCE_DIR}/cache_library.bp" "${WORK_DIR}/cache_library.bp")
+file(COPY_FILE "${SOURCE_DIR}/cache_application.bp" "${WORK_DIR}/cache_application.bp")
+
+# An entry nobody has used for years, which the first compilation prunes.
+set(stale_entry "${WORK_DIR}/cache/llvmcache-bp-stale.o")
+file(WRITE "${stale_entry}" "")
+execute_process(COMMAND touch -t 200001010000 "${stale_entry}" RESULT_VARIABLE touch_result)
+if (NOT touch_result EQUAL 0)
+    message(FATAL_ERROR "Could not age ${stale_entry}")
+endif()
+
+# compile(<HIT|MISS> <source> [compiler option]...) compiles source into the cache and checks
+# whether its object came from the cache.
+function(compile outcome source)
+    execute_process(
+        COMMAND "${COMPILER}" --verbose --cache-dir cache ${ARGN} ${source}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "Compiling ${source} ${ARGN} failed (${result}):\n${output}${errors}")
+    endif()
+    string(FIND "${output}" "Reused cached object for ${source}" reused)
+    if (outcome STREQUAL "HIT" AND reused EQUAL -1)
+        message(FATAL_ERROR "Compiling ${source} ${ARGN} missed the cache:\n${output}")
+    elseif (outcome STREQUAL "MISS" AND NOT reused EQUAL -1)
+        message(FATAL_ERROR "Compiling ${source} ${ARGN} reused a stale object:\n${output}")
+    endif()
+endfunction()
+
+function(expect_same_interface reference)
+    file(SHA256 "${WORK_DIR}/cache_library.bpi" actual)
+    file(SHA256 "${WORK_DIR}/${reference}" expected)
+    if (NOT actual STREQUAL expected)
+        message(FATAL_ERROR "cache_library.bpi differs from ${reference}")
+    endif()
+endfunction()
+
+function(run_application)
+    execute_process(
+        COMMAND "${WORK_DIR}/program"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output)
+    file(READ "${SOURCE_DIR}/cache.expected" expected)
+    if (NOT result EQUAL 0 OR NOT output STREQUAL expected)
+        message(FATAL_ERROR "Application printed '${output}' (${result}), expected '${expected}'")
+    endif()
+endfunction()
+
+function(edit_library from to)
+    file(READ "${WORK_DIR}/cache_library.bp" source)
+    string(REPLACE "${from}" "${to}" edited "${source}")
+    if (edited STREQUAL source)
+        message(FATAL_ERROR "cache_library.bp does not contain '${from}'")
+    endif()
+    file(WRITE "${WORK_DIR}/cache_library.bp" "${edited}")
+endfunction()
+
+set(library_options --emit-interface cache_library.bpi)
+set(application_options --interface cache_library.bpi --emit-exe program)
+
+# Misses fill the cache and prune it; the same inputs then hit.
+compile(MISS cache_library.bp ${library_options})
+if (EXISTS "${stale_entry}")
+    message(FATAL_ERROR "Pruning kept ${stale_entry}")
+endif()
+file(COPY_FILE "${WORK_DIR}/cache_library.bpi" "${WORK_DIR}/original.bpi")
+compile(HIT cache_library.bp ${library_options})
+expect_same_interface(original.bpi)
+
+compile(MISS cache_application.bp ${application_options})
+run_application()
+compile(HIT cache_application.bp ${application_options})
+run_application()
+
+# Other options build a different object.
+compile(MISS cache_application.bp ${application_options} -O2)
+compile(HIT cache_application.bp ${application_options} -O2)
+
+# Editing the library's implementation recompiles it but keeps its dependents cached.
+edit_library("x * 2" "x * 3")
+compile(MISS cache_library.bp ${library_options})
+expect_same_interface(original.bpi)
+compile(HIT cache_application.bp ${application_options})
+run_application()
+
+# Changing its interface invalidates them.
+edit_library("i32 x" "i64 x")
+compile(MISS cache_library.bp ${library_options})
+compile(MISS cache_application.bp ${application_options})
+run_application()
+
+# So does editing the application itself.
+file(APPEND "${WORK_DIR}/cache_application.bp" "\n")
+compile(MISS cache_application.bp ${application_options})
+run_application()
+
+# A corrupt cached interface turns the lookup into a miss, explained once under --verbose and
+# not reported as an error.
+file(GLOB cached_interfaces "${WORK_DIR}/cache/llvmcache-bp-*.bpi")
+foreach(cached_interface ${cached_interfaces})
+    file(WRITE "${cached_interface}" "BPIF")
+endforeach()
+execute_process(
+    COMMAND "${COMPILER}" --verbose --cache-dir cache ${library_options} cache_library.bp
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors)
+string(REGEX MATCHALL "Ignoring unreadable cached interface for cache_library\\.bp" explanations "${output}")
+list(LENGTH explanations explanation_count)
+if (NOT result EQUAL 0 OR NOT explanation_count EQUAL 1 OR output MATCHES "Reused cached object" OR errors MATCHES "Error")
+    message(FATAL_ERROR "A corrupt cached interface was not a quiet miss (${result}):\n${output}${errors}")
+endif()
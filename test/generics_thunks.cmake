@@ -0,0 +1,51 @@
+# Emits the unoptimized IR of generics.bp and checks which instantiations were merged into thunks.
+# add_blueprint_script_test in test/CMakeLists.txt invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCE_DIR=<test> -DWORK_DIR=<dir> -P generics_thunks.cmake
+#
+# Pair<u32,i8>.main must be a tail call into its identical twin Pair<i32,u8>.main, and
+# Accumulator<u64>.main, which calls __bp_write_u64 where Accumulator<i64>.main calls
+# __bp_write_i64, must keep its own body.
+
+foreach(variable COMPILER SOURCE_DIR WORK_DIR)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "generics_thunks.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY_FILE "${SOURCE_DIR}/generics.bp" "${WORK_DIR}/generics.bp")
+
+execute_process(
+    COMMAND "${COMPILER}" -O0 --emit-ir generics.ll generics.bp
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "--emit-ir failed (${result}):\n${output}${errors}")
+endif()
+file(READ "${WORK_DIR}/generics.ll" ir)
+
+# function_body(<output variable> <symbol>) extracts the definition of a method from the IR.
+function(function_body output_variable symbol)
+    string(FIND "${ir}" "define weak_odr void @\"${symbol}\"(" start)
+    if (start EQUAL -1)
+        message(FATAL_ERROR "${symbol} is not defined:\n${ir}")
+    endif()
+    string(SUBSTRING "${ir}" ${start} -1 rest)
+    string(FIND "${rest}" "\n}" end)
+    string(SUBSTRING "${rest}" 0 ${end} body)
+    set(${output_variable} "${body}" PARENT_SCOPE)
+endfunction()
+
+function_body(pair "Pair<u32,i8>.main")
+if (NOT pair MATCHES "tail call void @\"Pair<i32,u8>\\.main\"\\(i32 %[0-9a-z.]+, i8 %[0-9a-z.]+\\)[^\n]*\n  ret void$")
+    message(FATAL_ERROR "Pair<u32,i8>.main is not a tail call into Pair<i32,u8>.main:\n${pair}")
+endif()
+
+function_body(accumulator "Accumulator<u64>.main")
+if (accumulator MATCHES "Accumulator<i64>\\.main" OR NOT accumulator MATCHES "__bp_write_u64")
+    message(FATAL_ERROR "Accumulator<u64>.main should keep its own body:\n${accumulator}")
+endif()
@@ -0,0 +1,62 @@
+# Emits the interface of a library, prints it and compiles an application against it.
+# add_blueprint_script_test in test/CMakeLists.txt invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCE_DIR=<test> -DWORK_DIR=<dir> -P interface.cmake
+#
+# --print-interface must list interface_library.expected, and under --verbose the application
+# must report that the instantiation the library compiled is provided by the interface.
+
+foreach(variable COMPILER SOURCE_DIR WORK_DIR)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "interface.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY_FILE "${SOURCE_DIR}/interface_library.bp" "${WORK_DIR}/interface_library.bp")
+file(COPY_FILE "${SOURCE_DIR}/interface_application.bp" "${WORK_DIR}/interface_application.bp")
+
+# run(<output variable> <command>...) runs a command in WORK_DIR and fails the test if it fails.
+function(run output_variable)
+    execute_process(
+        COMMAND ${ARGN}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "'${ARGN}' failed (${result}):\n${output}${errors}")
+    endif()
+    set(${output_variable} "${output}" PARENT_SCOPE)
+endfunction()
+
+function(expect_output actual expected_file)
+    file(READ "${SOURCE_DIR}/${expected_file}" expected)
+    if (NOT actual STREQUAL expected)
+        message(FATAL_ERROR "Output differs from ${expected_file}.\n--- expected\n${expected}--- actual\n${actual}")
+    endif()
+endfunction()
+
+run(ignored "${COMPILER}" --emit-interface interface_library.bpi interface_library.bp)
+run(listing "${COMPILER}" --print-interface interface_library.bpi)
+expect_output("${listing}" interface_library.expected)
+
+run(log "${COMPILER}" --verbose --interface interface_library.bpi --emit-exe program interface_application.bp)
+string(FIND "${log}" "Instantiation Accumulator<i64> is provided by an imported interface" imported)
+string(FIND "${log}" "Instantiation Accumulator<f64> is provided by an imported interface" wrongly_imported)
+if (imported EQUAL -1 OR NOT wrongly_imported EQUAL -1)
+    message(FATAL_ERROR "Only Accumulator<i64> should come from the interface:\n${log}")
+endif()
+run(output "${WORK_DIR}/program")
+expect_output("${output}" interface_application.expected)
+
+# A file that is not an interface is rejected rather than decoded.
+execute_process(
+    COMMAND "${COMPILER}" --print-interface interface_library.bp
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    ERROR_VARIABLE errors)
+if (result EQUAL 0 OR NOT errors MATCHES "is not a BluePrint interface file")
+    message(FATAL_ERROR "--print-interface accepted a source file (${result}):\n${errors}")
+endif()
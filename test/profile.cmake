@@ -0,0 +1,58 @@
+# Builds bounds_loops.bp with --profile-generate, runs it, merges the raw profile with
+# llvm-profdata and rebuilds with --profile-use. add_blueprint_script_test in
+# test/CMakeLists.txt invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCE_DIR=<test> -DWORK_DIR=<dir> -DPROFDATA=<llvm-profdata>
+#         -P profile.cmake
+#
+# Both executables must print bounds_loops.expected, and the IR optimized with the profile must
+# carry the counts it read as function entry counts or branch weights.
+
+foreach(variable COMPILER SOURCE_DIR WORK_DIR PROFDATA)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "profile.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY_FILE "${SOURCE_DIR}/bounds_loops.bp" "${WORK_DIR}/bounds_loops.bp")
+
+# run(<output variable> <command>...) runs a command in WORK_DIR and fails the test if it fails.
+function(run output_variable)
+    execute_process(
+        COMMAND ${ARGN}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE result
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE errors)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "'${ARGN}' failed (${result}):\n${output}${errors}")
+    endif()
+    set(${output_variable} "${output}" PARENT_SCOPE)
+endfunction()
+
+function(expect_output actual expected_file)
+    file(READ "${SOURCE_DIR}/${expected_file}" expected)
+    if (NOT actual STREQUAL expected)
+        message(FATAL_ERROR "Output differs from ${expected_file}.\n--- expected\n${expected}--- actual\n${actual}")
+    endif()
+endfunction()
+
+run(ignored "${COMPILER}" -O2 --profile-generate=bounds_loops.profraw --emit-exe instrumented bounds_loops.bp)
+run(output "${WORK_DIR}/instrumented")
+expect_output("${output}" bounds_loops.expected)
+if (NOT EXISTS "${WORK_DIR}/bounds_loops.profraw")
+    message(FATAL_ERROR "The instrumented program wrote no bounds_loops.profraw")
+endif()
+
+run(ignored "${PROFDATA}" merge -o bounds_loops.profdata bounds_loops.profraw)
+
+run(ignored "${COMPILER}" -O2 --profile-use=bounds_loops.profdata --emit-ir optimized.ll --emit-exe optimized bounds_loops.bp)
+run(output "${WORK_DIR}/optimized")
+expect_output("${output}" bounds_loops.expected)
+
+file(READ "${WORK_DIR}/optimized.ll" ir)
+if (NOT ir MATCHES "!\"function_entry_count\"" AND NOT ir MATCHES "!\"branch_weights\"")
+    message(FATAL_ERROR "The profile left no entry counts or branch weights in the IR:\n${ir}")
+endif()
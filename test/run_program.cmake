@@ -0,0 +1,72 @@
+# Compiles one BluePrint test program, runs it and compares its standard output with an
+# expected file. add_blueprint_test in test/CMakeLists.txt invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCES=<a.bp|b.bp> -DEXPECTED=<name.expected>
+#         -DWORK_DIR=<dir> [-DARGS=<option|option>] [-DEXECUTABLE=ON] [-DWILL_TRAP=ON]
+#         [-DERROR_MATCHES=<regex>] -P run_program.cmake
+#
+# Lists are separated by '|' because ctest would split them at ';'. The program runs under
+# --run unless EXECUTABLE is set, in which case it is linked with --emit-exe first. A test with
+# WILL_TRAP passes only when the program is killed by a signal after printing the expected
+# output, which is how bounds, overflow and contract traps end a program. ERROR_MATCHES is a
+# regular expression the program's standard error must match, for reports whose figures vary
+# between runs.
+
+foreach(variable COMPILER SOURCES EXPECTED WORK_DIR)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "run_program.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+string(REPLACE "|" ";" sources "${SOURCES}")
+string(REPLACE "|" ";" arguments "${ARGS}")
+
+# Sources are copied so that object files written next to them stay out of the source tree.
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+set(copied_sources)
+foreach(source IN LISTS sources)
+    get_filename_component(source_name "${source}" NAME)
+    file(COPY_FILE "${source}" "${WORK_DIR}/${source_name}")
+    list(APPEND copied_sources "${WORK_DIR}/${source_name}")
+endforeach()
+
+if (EXECUTABLE)
+    execute_process(
+        COMMAND "${COMPILER}" ${arguments} --emit-exe "${WORK_DIR}/program" ${copied_sources}
+        WORKING_DIRECTORY "${WORK_DIR}"
+        RESULT_VARIABLE compile_result
+        OUTPUT_VARIABLE compile_output
+        ERROR_VARIABLE compile_output)
+    if (NOT compile_result EQUAL 0)
+        message(FATAL_ERROR "Compilation failed (${compile_result}):\n${compile_output}")
+    endif()
+    set(command "${WORK_DIR}/program")
+else()
+    set(command "${COMPILER}" --run ${arguments} ${copied_sources})
+endif()
+
+execute_process(
+    COMMAND ${command}
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors)
+
+file(READ "${EXPECTED}" expected)
+if (NOT output STREQUAL expected)
+    message(FATAL_ERROR "Output differs from ${EXPECTED}.\n--- expected\n${expected}--- actual\n${output}--- stderr\n${errors}")
+endif()
+
+if (DEFINED ERROR_MATCHES AND NOT ERROR_MATCHES STREQUAL "" AND NOT errors MATCHES "${ERROR_MATCHES}")
+    message(FATAL_ERROR "Standard error does not match '${ERROR_MATCHES}':\n${errors}")
+endif()
+
+# execute_process reports a signal as its name rather than an exit code.
+if (WILL_TRAP)
+    if (result MATCHES "^[0-9]+$")
+        message(FATAL_ERROR "Program exited with ${result} instead of trapping.\n${errors}")
+    endif()
+elseif (NOT result EQUAL 0)
+    message(FATAL_ERROR "Program failed (${result}):\n${errors}")
+endif()
@@ -0,0 +1,207 @@
+// Channels: every element sent by several producers is received exactly once, and in order
+// per producer, over plain threads and over green tasks that park; try operations, close and
+// the single-producer/consumer fast path behave as documented.
+
+#include "bp_runtime.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    PRODUCERS = 4,
+    CONSUMERS = 4,
+    PER_PRODUCER = 50000,
+    // Small enough that both ends block often
+    CAPACITY = 8,
+};
+
+// Elements carry their producer in the high half and a sequence number in the low half.
+typedef struct {
+    bp_channel* channel;
+    _Atomic uint8_t received[PRODUCERS][PER_PRODUCER];
+    _Atomic int producers_left;
+    _Atomic int failures;
+    _Atomic int consumers_done;
+} mpmc_run;
+
+typedef struct {
+    mpmc_run* run;
+    uint32_t index;
+} mpmc_role;
+
+static void produce(void* argument) {
+    mpmc_role* role = (mpmc_role*)argument;
+    for (uint32_t sequence = 0; sequence < PER_PRODUCER; sequence++) {
+        const uint64_t element = (uint64_t)role->index << 32 | sequence;
+        if (__bp_channel_send(role->run->channel, &element) != BP_CHANNEL_OK) {
+            atomic_fetch_add(&role->run->failures, 1);
+        }
+    }
+    // The last producer to finish closes the channel, which ends the consumers once drained.
+    if (atomic_fetch_sub(&role->run->producers_left, 1) == 1) {
+        __bp_channel_close(role->run->channel);
+    }
+}
+
+static void consume(void* argument) {
+    mpmc_role* role = (mpmc_role*)argument;
+    int64_t last[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) {
+        last[i] = -1;
+    }
+    uint64_t element;
+    while (__bp_channel_receive(role->run->channel, &element) == BP_CHANNEL_OK) {
+        const uint32_t producer = (uint32_t)(element >> 32);
+        const uint32_t sequence = (uint32_t)element;
+        if (producer >= PRODUCERS || sequence >= PER_PRODUCER || (int64_t)sequence <= last[producer]) {
+            atomic_fetch_add(&role->run->failures, 1);
+            continue;
+        }
+        last[producer] = sequence;
+        atomic_fetch_add(&role->run->received[producer][sequence], 1);
+    }
+    atomic_fetch_add(&role->run->consumers_done, 1);
+}
+
+static void* produce_thread(void* argument) {
+    produce(argument);
+    return NULL;
+}
+
+static void* consume_thread(void* argument) {
+    consume(argument);
+    return NULL;
+}
+
+static mpmc_run* mpmc_begin(mpmc_role producers[PRODUCERS], mpmc_role consumers[CONSUMERS]) {
+    mpmc_run* run = (mpmc_run*)calloc(1, sizeof(mpmc_run));
+    CHECK(run);
+    run->channel = __bp_channel_create(CAPACITY, sizeof(uint64_t), 0);
+    CHECK(run->channel);
+    atomic_store(&run->producers_left, PRODUCERS);
+    for (uint32_t i = 0; i < PRODUCERS; i++) {
+        producers[i] = (mpmc_role){run, i};
+    }
+    for (uint32_t i = 0; i < CONSUMERS; i++) {
+        consumers[i] = (mpmc_role){run, i};
+    }
+    return run;
+}
+
+static void mpmc_check(mpmc_run* run) {
+    CHECK(atomic_load(&run->failures) == 0);
+    CHECK(atomic_load(&run->consumers_done) == CONSUMERS);
+    for (int producer = 0; producer < PRODUCERS; producer++) {
+        for (int sequence = 0; sequence < PER_PRODUCER; sequence++) {
+            CHECK(atomic_load(&run->received[producer][sequence]) == 1);
+        }
+    }
+    uint64_t element;
+    CHECK(__bp_channel_try_receive(run->channel, &element) == BP_CHANNEL_CLOSED);
+    __bp_channel_destroy(run->channel);
+    free(run);
+}
+
+static void test_mpmc_threads(void) {
+    mpmc_role producers[PRODUCERS];
+    mpmc_role consumers[CONSUMERS];
+    mpmc_run* run = mpmc_begin(producers, consumers);
+    pthread_t threads[PRODUCERS + CONSUMERS];
+    for (int i = 0; i < CONSUMERS; i++) {
+        CHECK(pthread_create(&threads[i], NULL, consume_thread, &consumers[i]) == 0);
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        CHECK(pthread_create(&threads[CONSUMERS + i], NULL, produce_thread, &producers[i]) == 0);
+    }
+    for (int i = 0; i < PRODUCERS + CONSUMERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    mpmc_check(run);
+}
+
+static void test_mpmc_green_tasks(void) {
+    mpmc_role producers[PRODUCERS];
+    mpmc_role consumers[CONSUMERS];
+    mpmc_run* run = mpmc_begin(producers, consumers);
+    // Fewer workers than tasks, so blocked tasks must park for the others to run.
+    CHECK(__bp_green_start(2) == 0);
+    for (int i = 0; i < CONSUMERS; i++) {
+        CHECK(__bp_green_spawn(consume, &consumers[i]) == 0);
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        CHECK(__bp_green_spawn(produce, &producers[i]) == 0);
+    }
+    __bp_green_shutdown();
+    mpmc_check(run);
+}
+
+static void test_try_and_close(void) {
+    CHECK(__bp_channel_create(0, sizeof(uint32_t), 0) == NULL);
+
+    // Capacity is rounded up to a power of two.
+    bp_channel* channel = __bp_channel_create(3, sizeof(uint32_t), 0);
+    CHECK(channel);
+    uint32_t value = 0;
+    CHECK(__bp_channel_try_receive(channel, &value) == BP_CHANNEL_WOULD_BLOCK);
+    for (uint32_t i = 0; i < 4; i++) {
+        CHECK(__bp_channel_try_send(channel, &i) == BP_CHANNEL_OK);
+    }
+    CHECK(__bp_channel_try_send(channel, &value) == BP_CHANNEL_WOULD_BLOCK);
+    CHECK(__bp_channel_receive(channel, &value) == BP_CHANNEL_OK && value == 0);
+    CHECK(__bp_channel_try_send(channel, &value) == BP_CHANNEL_OK);
+
+    // Closing rejects sends but drains what was already sent.
+    __bp_channel_close(channel);
+    CHECK(__bp_channel_send(channel, &value) == BP_CHANNEL_CLOSED);
+    CHECK(__bp_channel_try_send(channel, &value) == BP_CHANNEL_CLOSED);
+    const uint32_t expected[] = {1, 2, 3, 0};
+    for (int i = 0; i < 4; i++) {
+        CHECK(__bp_channel_receive(channel, &value) == BP_CHANNEL_OK && value == expected[i]);
+    }
+    CHECK(__bp_channel_receive(channel, &value) == BP_CHANNEL_CLOSED);
+    CHECK(__bp_channel_try_receive(channel, &value) == BP_CHANNEL_CLOSED);
+    __bp_channel_destroy(channel);
+}
+
+typedef struct {
+    bp_channel* channel;
+    uint32_t count;
+} spsc_run;
+
+static void* spsc_produce(void* argument) {
+    spsc_run* run = (spsc_run*)argument;
+    for (uint32_t i = 0; i < run->count; i++) {
+        CHECK(__bp_channel_send(run->channel, &i) == BP_CHANNEL_OK);
+    }
+    __bp_channel_close(run->channel);
+    return NULL;
+}
+
+static void test_spsc(void) {
+    spsc_run run = {__bp_channel_create(CAPACITY, sizeof(uint32_t), BP_CHANNEL_SINGLE_PRODUCER | BP_CHANNEL_SINGLE_CONSUMER), 200000};
+    CHECK(run.channel);
+    pthread_t producer;
+    CHECK(pthread_create(&producer, NULL, spsc_produce, &run) == 0);
+    uint32_t expected = 0;
+    uint32_t value;
+    while (__bp_channel_receive(run.channel, &value) == BP_CHANNEL_OK) {
+        CHECK(value == expected);
+        expected++;
+    }
+    CHECK(expected == run.count);
+    pthread_join(producer, NULL);
+    __bp_channel_destroy(run.channel);
+}
+
+int main(void) {
+    test_try_and_close();
+    test_spsc();
+    test_mpmc_threads();
+    test_mpmc_green_tasks();
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Green-thread scheduler: tasks spawned from inside and outside the pool all run, tasks are
+// stolen by idle workers, a switch preserves callee-saved registers and floating-point state
+// across yields and migrations, and a task's stack unwinds to its first frame.
+
+#include "bp_runtime.h"
+#include "check.h"
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+enum {
+    WORKERS = 4,
+    YIELDING_TASKS = 200,
+    YIELDS_PER_TASK = 50,
+    STOLEN_TASKS = 64,
+};
+
+static _Atomic int yielding_done;
+static _Atomic int yield_failures;
+
+// Keeps values live across every yield, in callee-saved registers at -O2, and checks them
+// after the task has been resumed, possibly by another worker.
+static void yielding_task(void* argument) {
+    const long seed = (long)(intptr_t)argument;
+    long accumulator = seed;
+    double product = 1.0 + (double)seed;
+    for (int i = 0; i < YIELDS_PER_TASK; i++) {
+        accumulator = accumulator * 31 + i;
+        product *= 1.0001;
+        __bp_green_yield();
+    }
+
+    long expected = seed;
+    double expected_product = 1.0 + (double)seed;
+    for (int i = 0; i < YIELDS_PER_TASK; i++) {
+        expected = expected * 31 + i;
+        expected_product *= 1.0001;
+    }
+    if (accumulator != expected || product != expected_product) {
+        atomic_fetch_add(&yield_failures, 1);
+    }
+    atomic_fetch_add(&yielding_done, 1);
+}
+
+static _Atomic int stolen_done;
+static _Atomic int stolen_elsewhere;
+static pthread_t spawner_thread;
+
+static void stolen_task(void* argument) {
+    (void)argument;
+    if (!pthread_equal(pthread_self(), spawner_thread)) {
+        atomic_fetch_add(&stolen_elsewhere, 1);
+    }
+    atomic_fetch_add(&stolen_done, 1);
+}
+
+// Spawns onto its own worker's deque and then keeps that worker busy without yielding, so the
+// children can only run if other workers steal them.
+static void spawning_task(void* argument) {
+    (void)argument;
+    spawner_thread = pthread_self();
+    for (int i = 0; i < STOLEN_TASKS; i++) {
+        CHECK(__bp_green_spawn(stolen_task, NULL) == 0);
+    }
+    while (atomic_load(&stolen_done) < STOLEN_TASKS) {
+    }
+}
+
+static _Atomic int unwound_depth;
+
+// The unwinder must stop at the trampoline that starts the task instead of walking off the
+// top of the task's stack.
+static void unwinding_task(void* argument) {
+    (void)argument;
+    void* frames[64];
+    __bp_green_yield();
+    atomic_store(&unwound_depth, backtrace(frames, 64));
+}
+
+typedef struct {
+    pthread_mutex_t lock;
+    bp_green_task* waiter;
+    bool signalled;
+    bool resumed;
+} park_state;
+
+static void unlock_park_state(void* argument) {
+    pthread_mutex_unlock(&((park_state*)argument)->lock);
+}
+
+static void parking_task(void* argument) {
+    park_state* state = (park_state*)argument;
+    pthread_mutex_lock(&state->lock);
+    while (!state->signalled) {
+        state->waiter = __bp_green_current();
+        __bp_green_park(unlock_park_state, state);
+        pthread_mutex_lock(&state->lock);
+    }
+    state->resumed = true;
+    pthread_mutex_unlock(&state->lock);
+}
+
+static void waking_task(void* argument) {
+    park_state* state = (park_state*)argument;
+    // Wait until the other task has parked, yielding so it gets to run on a busy pool.
+    while (true) {
+        pthread_mutex_lock(&state->lock);
+        bp_green_task* waiter = state->waiter;
+        if (waiter) {
+            state->signalled = true;
+            state->waiter = NULL;
+            pthread_mutex_unlock(&state->lock);
+            __bp_green_unpark(waiter);
+            return;
+        }
+        pthread_mutex_unlock(&state->lock);
+        __bp_green_yield();
+    }
+}
+
+int main(void) {
+    CHECK(__bp_green_current() == NULL);
+    CHECK(__bp_green_spawn(yielding_task, NULL) == -1);
+    CHECK(__bp_green_start(WORKERS) == 0);
+    CHECK(__bp_green_start(WORKERS) == -1);
+
+    for (intptr_t i = 0; i < YIELDING_TASKS; i++) {
+        CHECK(__bp_green_spawn(yielding_task, (void*)i) == 0);
+    }
+    CHECK(__bp_green_spawn(spawning_task, NULL) == 0);
+
+    park_state state = {PTHREAD_MUTEX_INITIALIZER, NULL, false, false};
+    CHECK(__bp_green_spawn(parking_task, &state) == 0);
+    CHECK(__bp_green_spawn(waking_task, &state) == 0);
+
+    CHECK(__bp_green_spawn(unwinding_task, NULL) == 0);
+
+    __bp_green_shutdown();
+    CHECK(atomic_load(&yielding_done) == YIELDING_TASKS);
+    CHECK(atomic_load(&yield_failures) == 0);
+    CHECK(atomic_load(&stolen_done) == STOLEN_TASKS);
+    CHECK(atomic_load(&stolen_elsewhere) == STOLEN_TASKS);
+    CHECK(state.resumed);
+    CHECK(atomic_load(&unwound_depth) > 1 && atomic_load(&unwound_depth) < 64);
+
+    // The scheduler can be started again after a shutdown.
+    CHECK(__bp_green_start(1) == 0);
+    CHECK(__bp_green_spawn(yielding_task, (void*)(intptr_t)7) == 0);
+    __bp_green_shutdown();
+    CHECK(atomic_load(&yielding_done) == YIELDING_TASKS + 1);
+    CHECK(atomic_load(&yield_failures) == 0);
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Control-byte hash table primitives: group matches and bit walks, and a table built on them
+// the way the grouped HashMap layout probes. Inserts, erases that leave tombstones, and
+// growth are checked against a plain presence array.
+
+#include "bp_runtime.h"
+#include "check.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void test_group_functions(void) {
+    // One spare byte in front so the group is read unaligned.
+    uint8_t storage[BP_GROUP_WIDTH + 1];
+    uint8_t* group = storage + 1;
+    for (int i = 0; i < BP_GROUP_WIDTH; i++) {
+        group[i] = (uint8_t)i;
+    }
+    group[3] = BP_CONTROL_EMPTY;
+    group[9] = BP_CONTROL_DELETED;
+    group[12] = 5;
+
+    CHECK(__bp_group_match(group, 5) == (1u << 5 | 1u << 12));
+    CHECK(__bp_group_match(group, 0x7F) == 0);
+    CHECK(__bp_group_match_empty(group) == 1u << 3);
+    CHECK(__bp_group_match_free(group) == (1u << 3 | 1u << 9));
+
+    const uint32_t mask = 1u << 0 | 1u << 7 | 1u << 15;
+    CHECK(__bp_group_first(mask) == 0);
+    CHECK(__bp_group_next(mask, 0) == 7);
+    CHECK(__bp_group_next(mask, 7) == 15);
+    CHECK(__bp_group_next(mask, 15) == BP_GROUP_WIDTH);
+    CHECK(__bp_group_first(0) == BP_GROUP_WIDTH);
+
+    CHECK(__bp_hash_mix(1) != __bp_hash_mix(2));
+    CHECK((__bp_hash_mix(UINT64_C(1) << 40) & 0x7F) != (__bp_hash_mix(UINT64_C(1) << 41) & 0x7F)
+        || (__bp_hash_mix(UINT64_C(1) << 40) >> 7) != (__bp_hash_mix(UINT64_C(1) << 41) >> 7));
+}
+
+// Open-addressing set of 64-bit keys. Slot i has control byte control[i]; probing visits
+// groups with triangular steps from the group picked by the high bits of the mixed hash.
+typedef struct {
+    uint8_t* control;
+    uint64_t* keys;
+    uint64_t groups;
+    uint64_t count;
+    uint64_t tombstones;
+    // Hash forced for every key, to put them all in one probe sequence
+    bool colliding;
+} table;
+
+static uint64_t table_hash(const table* t, uint64_t key) {
+    return t->colliding ? (key & 0x7F) : __bp_hash_mix(key);
+}
+
+static void table_init(table* t, uint64_t groups, bool colliding) {
+    const uint64_t capacity = groups * BP_GROUP_WIDTH;
+    t->control = (uint8_t*)malloc(capacity);
+    t->keys = (uint64_t*)calloc(capacity, sizeof(uint64_t));
+    CHECK(t->control && t->keys);
+    memset(t->control, BP_CONTROL_EMPTY, capacity);
+    t->groups = groups;
+    t->count = 0;
+    t->tombstones = 0;
+    t->colliding = colliding;
+}
+
+static void table_free(table* t) {
+    free(t->control);
+    free(t->keys);
+}
+
+// Slot of key, or -1
+static int64_t table_find(const table* t, uint64_t key) {
+    const uint64_t hash = table_hash(t, key);
+    uint64_t group = (hash >> 7) & (t->groups - 1);
+    for (uint64_t probe = 1; probe <= t->groups; probe++) {
+        const uint8_t* control = t->control + group * BP_GROUP_WIDTH;
+        const uint32_t matches = __bp_group_match(control, (uint8_t)(hash & 0x7F));
+        for (int32_t bit = __bp_group_first(matches); bit < BP_GROUP_WIDTH; bit = __bp_group_next(matches, bit)) {
+            const uint64_t slot = group * BP_GROUP_WIDTH + (uint64_t)bit;
+            if (t->keys[slot] == key) {
+                return (int64_t)slot;
+            }
+        }
+        if (__bp_group_match_empty(control)) {
+            return -1;
+        }
+        group = (group + probe) & (t->groups - 1);
+    }
+    return -1;
+}
+
+static void table_insert_new(table* t, uint64_t key) {
+    const uint64_t hash = table_hash(t, key);
+    uint64_t group = (hash >> 7) & (t->groups - 1);
+    uint32_t free_slots = __bp_group_match_free(t->control + group * BP_GROUP_WIDTH);
+    for (uint64_t probe = 1; free_slots == 0; probe++) {
+        group = (group + probe) & (t->groups - 1);
+        free_slots = __bp_group_match_free(t->control + group * BP_GROUP_WIDTH);
+    }
+    const uint64_t slot = group * BP_GROUP_WIDTH + (uint64_t)__bp_group_first(free_slots);
+    t->tombstones -= t->control[slot] == BP_CONTROL_DELETED;
+    t->control[slot] = (uint8_t)(hash & 0x7F);
+    t->keys[slot] = key;
+    t->count++;
+}
+
+// Rebuilds the table with the given number of groups, which drops every tombstone.
+static void table_rehash(table* t, uint64_t groups) {
+    table old = *t;
+    table_init(t, groups, old.colliding);
+    for (uint64_t slot = 0; slot < old.groups * BP_GROUP_WIDTH; slot++) {
+        if (!(old.control[slot] & 0x80)) {
+            table_insert_new(t, old.keys[slot]);
+        }
+    }
+    table_free(&old);
+}
+
+// Returns false if key was already present.
+static bool table_insert(table* t, uint64_t key) {
+    if (table_find(t, key) >= 0) {
+        return false;
+    }
+    // Tombstones count towards the 7/8 load limit, since probes cannot stop at them. When
+    // they make up most of it, rehashing at the same size is enough.
+    const uint64_t capacity = t->groups * BP_GROUP_WIDTH;
+    if ((t->count + t->tombstones + 1) * 8 > capacity * 7) {
+        table_rehash(t, t->count * 2 + 2 > capacity ? t->groups * 2 : t->groups);
+    }
+    table_insert_new(t, key);
+    return true;
+}
+
+static bool table_erase(table* t, uint64_t key) {
+    const int64_t slot = table_find(t, key);
+    if (slot < 0) {
+        return false;
+    }
+    // A group that still has an empty slot never ended a probe for another key, so the slot
+    // can become empty again; otherwise it must stay a tombstone.
+    const uint8_t* control = t->control + (uint64_t)slot / BP_GROUP_WIDTH * BP_GROUP_WIDTH;
+    if (__bp_group_match_empty(control)) {
+        t->control[slot] = BP_CONTROL_EMPTY;
+    } else {
+        t->control[slot] = BP_CONTROL_DELETED;
+        t->tombstones++;
+    }
+    t->count--;
+    return true;
+}
+
+static void check_against(const table* t, const bool* present, uint64_t universe) {
+    uint64_t count = 0;
+    for (uint64_t key = 0; key < universe; key++) {
+        CHECK((table_find(t, key) >= 0) == present[key]);
+        count += present[key];
+    }
+    CHECK(t->count == count);
+}
+
+// Keys that all share one probe sequence fill whole groups, so erasing one of the first
+// leaves a tombstone that later lookups must probe past.
+static void test_tombstones(void) {
+    table t;
+    table_init(&t, 4, true);
+    enum { KEYS = 40 };
+    for (uint64_t key = 0; key < KEYS; key++) {
+        CHECK(table_insert(&t, key));
+    }
+    CHECK(t.groups == 4);
+    CHECK(table_erase(&t, 3));
+    CHECK(!table_erase(&t, 3));
+    CHECK(t.tombstones == 1);
+    CHECK(t.control[3] == BP_CONTROL_DELETED);
+    for (uint64_t key = 0; key < KEYS; key++) {
+        CHECK((table_find(&t, key) >= 0) == (key != 3));
+    }
+
+    // Inserting reuses the tombstone.
+    CHECK(table_insert(&t, 1000));
+    CHECK(t.tombstones == 0);
+    CHECK(table_find(&t, 1000) == 3);
+
+    // In a group with empty slots, an erase leaves the slot empty.
+    const int64_t last = table_find(&t, KEYS - 1);
+    CHECK(last >= 0);
+    CHECK(table_erase(&t, KEYS - 1));
+    CHECK(t.control[last] == BP_CONTROL_EMPTY);
+    CHECK(t.tombstones == 0);
+    table_free(&t);
+}
+
+// Random inserts and erases over a small key universe, so that keys come and go many times,
+// tombstones pile up, and the table both grows and rehashes in place.
+static void test_random_operations(void) {
+    enum { UNIVERSE = 4096, OPERATIONS = 200000 };
+    static bool present[UNIVERSE];
+    table t;
+    table_init(&t, 1, false);
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    uint64_t grows = 0;
+    for (int operation = 0; operation < OPERATIONS; operation++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        const uint64_t key = state % UNIVERSE;
+        const uint64_t groups = t.groups;
+        // Inserting slightly more often than erasing fills the table over time.
+        if ((state >> 32) % 5 < 3) {
+            CHECK(table_insert(&t, key) == !present[key]);
+            present[key] = true;
+        } else {
+            CHECK(table_erase(&t, key) == present[key]);
+            present[key] = false;
+        }
+        grows += t.groups > groups;
+        CHECK((t.count + t.tombstones) * 8 <= t.groups * BP_GROUP_WIDTH * 7);
+        if (operation % 10000 == 0) {
+            check_against(&t, present, UNIVERSE);
+        }
+    }
+    check_against(&t, present, UNIVERSE);
+    CHECK(grows >= 4);
+    table_free(&t);
+}
+
+int main(void) {
+    test_group_functions();
+    test_tombstones();
+    test_random_operations();
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Reference counting: an unshared object counts up and down with the positive count that
+// generated code reads at the start of the header, sharing negates it, and an object released
+// concurrently from many threads is destroyed exactly once, after every thread's writes.
+
+#include "bp_runtime.h"
+#include "check.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+enum {
+    THREADS = 8,
+    RETAINS_PER_THREAD = 100000,
+};
+
+typedef struct {
+    int64_t slots[THREADS];
+} shared_payload;
+
+static _Atomic int destroyed;
+static int64_t destroyed_total;
+
+static void count_destroy(void* object) {
+    (void)object;
+    atomic_fetch_add(&destroyed, 1);
+}
+
+static void sum_destroy(void* object) {
+    const shared_payload* payload = (const shared_payload*)object;
+    int64_t total = 0;
+    for (int i = 0; i < THREADS; i++) {
+        total += payload->slots[i];
+    }
+    destroyed_total = total;
+    atomic_fetch_add(&destroyed, 1);
+}
+
+// The count as generated code sees it: the first field of the header before the payload.
+static int64_t count_of(void* object) {
+    return *(const int64_t*)((const char*)object - BP_RC_HEADER_SIZE);
+}
+
+static void test_unshared(void) {
+    atomic_store(&destroyed, 0);
+    unsigned char* object = (unsigned char*)__bp_rc_alloc(40, count_destroy);
+    CHECK(object != NULL);
+    CHECK((uintptr_t)object % 16 == 0);
+    for (int i = 0; i < 40; i++) {
+        CHECK(object[i] == 0);
+    }
+    CHECK(count_of(object) == 1);
+
+    __bp_rc_retain(object);
+    __bp_rc_retain(object);
+    CHECK(count_of(object) == 3);
+    __bp_rc_release(object);
+    __bp_rc_release(object);
+    CHECK(count_of(object) == 1);
+    CHECK(atomic_load(&destroyed) == 0);
+    __bp_rc_release(object);
+    CHECK(atomic_load(&destroyed) == 1);
+
+    // A destructor is optional, and null references are ignored.
+    void* plain = __bp_rc_alloc(8, NULL);
+    CHECK(plain != NULL);
+    __bp_rc_release(plain);
+    __bp_rc_retain(NULL);
+    __bp_rc_release(NULL);
+    __bp_rc_share(NULL);
+
+    CHECK(__bp_rc_alloc(UINT64_MAX, NULL) == NULL);
+}
+
+static void test_share(void) {
+    atomic_store(&destroyed, 0);
+    void* object = __bp_rc_alloc(8, count_destroy);
+    __bp_rc_retain(object);
+    __bp_rc_share(object);
+    CHECK(count_of(object) == -2);
+    // Sharing twice does not flip the count back.
+    __bp_rc_share(object);
+    CHECK(count_of(object) == -2);
+    __bp_rc_retain(object);
+    CHECK(count_of(object) == -3);
+    __bp_rc_release(object);
+    __bp_rc_release(object);
+    CHECK(atomic_load(&destroyed) == 0);
+    __bp_rc_release(object);
+    CHECK(atomic_load(&destroyed) == 1);
+}
+
+typedef struct {
+    shared_payload* payload;
+    int index;
+} release_role;
+
+// Each thread owns one reference, takes and drops many more, writes its slot and releases.
+static void* retain_and_release(void* argument) {
+    release_role* role = (release_role*)argument;
+    for (int i = 0; i < RETAINS_PER_THREAD; i++) {
+        __bp_rc_retain(role->payload);
+        __bp_rc_release(role->payload);
+    }
+    role->payload->slots[role->index] = role->index + 1;
+    __bp_rc_release(role->payload);
+    return NULL;
+}
+
+static void test_shared_release(void) {
+    atomic_store(&destroyed, 0);
+    shared_payload* payload = (shared_payload*)__bp_rc_alloc(sizeof(shared_payload), sum_destroy);
+    for (int i = 1; i < THREADS; i++) {
+        __bp_rc_retain(payload);
+    }
+    __bp_rc_share(payload);
+    CHECK(count_of(payload) == -THREADS);
+
+    pthread_t threads[THREADS];
+    release_role roles[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        roles[i] = (release_role){payload, i};
+        CHECK(pthread_create(&threads[i], NULL, retain_and_release, &roles[i]) == 0);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        CHECK(pthread_join(threads[i], NULL) == 0);
+    }
+
+    CHECK(atomic_load(&destroyed) == 1);
+    CHECK(destroyed_total == THREADS * (THREADS + 1) / 2);
+}
+
+int main(void) {
+    test_unshared();
+    test_share();
+    test_shared_release();
+    return 0;
+}
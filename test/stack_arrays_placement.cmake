@@ -0,0 +1,39 @@
+# Emits the unoptimized IR of stack_arrays.bp and checks where each array's storage lives.
+# add_blueprint_script_test in test/CMakeLists.txt invokes it as
+#
+#   cmake -DCOMPILER=<BluePrint> -DSOURCE_DIR=<test> -DWORK_DIR=<dir> -P stack_arrays_placement.cmake
+#
+# small and edge, at most StackArrayByteLimit (4096) bytes, get a frame slot named
+# <array>.storage; over, 4104 bytes, must not.
+
+foreach(variable COMPILER SOURCE_DIR WORK_DIR)
+    if (NOT DEFINED ${variable})
+        message(FATAL_ERROR "stack_arrays_placement.cmake: ${variable} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(COPY_FILE "${SOURCE_DIR}/stack_arrays.bp" "${WORK_DIR}/stack_arrays.bp")
+
+execute_process(
+    COMMAND "${COMPILER}" -O0 --emit-ir stack_arrays.ll stack_arrays.bp
+    WORKING_DIRECTORY "${WORK_DIR}"
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE errors)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "--emit-ir failed (${result}):\n${output}${errors}")
+endif()
+file(READ "${WORK_DIR}/stack_arrays.ll" ir)
+
+foreach(slot "%small.storage = alloca [4 x i64], align 64" "%edge.storage = alloca [512 x i64], align 64")
+    string(FIND "${ir}" "${slot}" found)
+    if (found EQUAL -1)
+        message(FATAL_ERROR "Missing stack slot '${slot}':\n${ir}")
+    endif()
+endforeach()
+string(FIND "${ir}" "%over.storage" found)
+if (NOT found EQUAL -1)
+    message(FATAL_ERROR "over exceeds the stack array limit but was given a frame slot:\n${ir}")
+endif()